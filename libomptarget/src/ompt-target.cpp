@@ -0,0 +1,157 @@
+//===----- ompt-target.cpp - OMPT target callbacks of libomptarget - C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Connection to the host runtime and dispatch of the OMPT target callbacks.
+//
+//===----------------------------------------------------------------------===//
+
+#ifdef OMPT_SUPPORT
+
+#include <cstring>
+#include <mutex>
+
+#include "ompt-target.h"
+
+// Provided by the host runtime if it supports OMPT.
+extern "C" void ompt_libomp_connect(ompt_fns_t *fns) __attribute__((weak));
+
+ompt_target_callbacks_t ompt_target_callbacks;
+thread_local const void *ompt_target_return_address;
+
+// The target construct that the current thread is in, 0 outside of one.
+static thread_local ompt_id_t ompt_target_id;
+
+static ompt_get_unique_id_t ompt_get_unique_id_fn;
+static ompt_get_task_info_t ompt_get_task_info_fn;
+
+// Devices reported with device_initialize. The host runtime finalizes the tool
+// at exit, possibly after the static objects of this library were destroyed,
+// so the list is never freed.
+struct OmptTargetDevicesTy {
+  std::mutex Mtx;
+  std::vector<int32_t> Devices;
+};
+static OmptTargetDevicesTy *ompt_target_devices;
+
+static int ompt_target_initialize(ompt_function_lookup_t lookup,
+                                  ompt_fns_t *fns) {
+  ompt_get_callback_t get_callback =
+      (ompt_get_callback_t)lookup("ompt_get_callback");
+  ompt_get_unique_id_fn = (ompt_get_unique_id_t)lookup("ompt_get_unique_id");
+  ompt_get_task_info_fn = (ompt_get_task_info_t)lookup("ompt_get_task_info");
+  if (!get_callback || !ompt_get_unique_id_fn || !ompt_get_task_info_fn)
+    return 0;
+
+#define ompt_target_get_callback(name)                                         \
+  get_callback(name, (ompt_callback_t *)&ompt_target_callbacks.name)
+
+  ompt_target_get_callback(ompt_callback_target);
+  ompt_target_get_callback(ompt_callback_target_data_op);
+  ompt_target_get_callback(ompt_callback_target_submit);
+  ompt_target_get_callback(ompt_callback_target_map);
+  ompt_target_get_callback(ompt_callback_device_initialize);
+  ompt_target_get_callback(ompt_callback_device_finalize);
+
+#undef ompt_target_get_callback
+
+  ompt_target_devices = new OmptTargetDevicesTy();
+  return 1;
+}
+
+static void ompt_target_finalize(ompt_fns_t *fns) {
+  if (ompt_target_callbacks.ompt_callback_device_finalize) {
+    std::lock_guard<std::mutex> Lock(ompt_target_devices->Mtx);
+    for (int32_t device_num : ompt_target_devices->Devices)
+      ompt_target_callbacks.ompt_callback_device_finalize(device_num);
+  }
+  // The tool is gone; nothing is dispatched from now on.
+  memset(&ompt_target_callbacks, 0, sizeof(ompt_target_callbacks));
+}
+
+static ompt_fns_t ompt_target_fns = {ompt_target_initialize,
+                                     ompt_target_finalize};
+
+// Register with the host runtime when the library is loaded, before the tool
+// is initialized, so that the host runtime reports the target callbacks as
+// implemented to the tool.
+__attribute__((constructor)) static void ompt_target_connect() {
+  if (ompt_libomp_connect)
+    ompt_libomp_connect(&ompt_target_fns);
+}
+
+// No device tracing interface is provided.
+static ompt_interface_fn_t ompt_target_device_lookup(const char *name) {
+  return NULL;
+}
+
+void ompt_target_device_initialize(int32_t device_num, const char *type) {
+  if (!ompt_target_callbacks.ompt_callback_device_initialize)
+    return;
+  {
+    std::lock_guard<std::mutex> Lock(ompt_target_devices->Mtx);
+    ompt_target_devices->Devices.push_back(device_num);
+  }
+  ompt_target_callbacks.ompt_callback_device_initialize(
+      device_num, type, NULL, ompt_target_device_lookup, NULL);
+}
+
+void ompt_target_data_op(ompt_target_data_op_t optype, void *host_addr,
+                         void *device_addr, size_t bytes) {
+  if (ompt_target_callbacks.ompt_callback_target_data_op)
+    ompt_target_callbacks.ompt_callback_target_data_op(
+        ompt_target_id, ompt_get_unique_id_fn(), optype, host_addr,
+        device_addr, bytes);
+}
+
+void ompt_target_submit() {
+  if (ompt_target_callbacks.ompt_callback_target_submit)
+    ompt_target_callbacks.ompt_callback_target_submit(ompt_target_id,
+                                                      ompt_get_unique_id_fn());
+}
+
+void OmptTargetRegionTy::begin(int32_t device_num) {
+  // The target_id is needed by the other callbacks even if the tool does not
+  // listen to the constructs themselves.
+  if (!ompt_target_devices)
+    return;
+  DeviceNum = device_num;
+  Begun = true;
+  ompt_target_id = ompt_get_unique_id_fn();
+  if (ompt_target_callbacks.ompt_callback_target) {
+    ompt_data_t *task_data = NULL;
+    ompt_get_task_info_fn(0, NULL, &task_data, NULL, NULL, NULL);
+    ompt_target_callbacks.ompt_callback_target(Kind, ompt_scope_begin,
+                                               DeviceNum, task_data,
+                                               ompt_target_id, CodePtr);
+  }
+}
+
+void OmptTargetRegionTy::end() {
+  if (!Begun)
+    return;
+  Begun = false;
+  if (ompt_target_callbacks.ompt_callback_target) {
+    ompt_data_t *task_data = NULL;
+    ompt_get_task_info_fn(0, NULL, &task_data, NULL, NULL, NULL);
+    ompt_target_callbacks.ompt_callback_target(Kind, ompt_scope_end, DeviceNum,
+                                               task_data, ompt_target_id,
+                                               CodePtr);
+  }
+  ompt_target_id = 0;
+}
+
+void OmptTargetMapTy::report() {
+  if (Bytes.empty() || !ompt_target_callbacks.ompt_callback_target_map)
+    return;
+  ompt_target_callbacks.ompt_callback_target_map(
+      ompt_target_id, Bytes.size(), HostAddr.data(), DeviceAddr.data(),
+      Bytes.data(), Flags.data());
+}
+
+#endif // OMPT_SUPPORT
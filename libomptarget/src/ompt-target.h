@@ -0,0 +1,96 @@
+//===------ ompt-target.h - OMPT target callbacks of libomptarget -- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Dispatch of the OMPT target callbacks. libomptarget registers with the host
+// runtime through ompt_libomp_connect() when it is loaded and finds the
+// callbacks registered by the tool with ompt_get_callback().
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef _OMPT_TARGET_H_
+#define _OMPT_TARGET_H_
+
+#ifdef OMPT_SUPPORT
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "ompt.h"
+
+/// Callbacks registered by the tool, NULL if the tool did not register one.
+struct ompt_target_callbacks_t {
+  ompt_callback_target_t ompt_callback_target;
+  ompt_callback_target_data_op_t ompt_callback_target_data_op;
+  ompt_callback_target_submit_t ompt_callback_target_submit;
+  ompt_callback_target_map_t ompt_callback_target_map;
+  ompt_callback_device_initialize_t ompt_callback_device_initialize;
+  ompt_callback_device_finalize_t ompt_callback_device_finalize;
+};
+extern ompt_target_callbacks_t ompt_target_callbacks;
+
+/// Return address of the outermost entry point, so that the nowait variants,
+/// which call the blocking ones, report the code of the user.
+extern thread_local const void *ompt_target_return_address;
+#define OMPT_TARGET_STORE_RETURN_ADDRESS                                       \
+  do {                                                                         \
+    if (!ompt_target_return_address)                                           \
+      ompt_target_return_address = __builtin_return_address(0);                \
+  } while (0)
+
+void ompt_target_device_initialize(int32_t device_num, const char *type);
+void ompt_target_data_op(ompt_target_data_op_t optype, void *host_addr,
+                         void *device_addr, size_t bytes);
+void ompt_target_submit();
+
+/// Dispatches the begin and end of a target construct and provides the
+/// target_id of the data operations, submits and maps in between. Construct
+/// it at the entry point, before the return address is used by anyone else.
+class OmptTargetRegionTy {
+  ompt_target_type_t Kind;
+  int32_t DeviceNum;
+  const void *CodePtr;
+  bool Begun;
+
+public:
+  OmptTargetRegionTy(ompt_target_type_t Kind)
+      : Kind(Kind), DeviceNum(-1), CodePtr(ompt_target_return_address),
+        Begun(false) {
+    ompt_target_return_address = NULL;
+  }
+  ~OmptTargetRegionTy() { end(); }
+
+  void begin(int32_t device_num);
+  void end();
+};
+
+/// Collects the items of one mapping, which is reported with a single
+/// target_map callback; nothing is collected if the tool does not listen.
+class OmptTargetMapTy {
+  std::vector<void *> HostAddr, DeviceAddr;
+  std::vector<size_t> Bytes;
+  std::vector<unsigned int> Flags;
+
+public:
+  bool enabled() const {
+    return ompt_target_callbacks.ompt_callback_target_map != NULL;
+  }
+  void add(void *host_addr, void *device_addr, size_t bytes,
+           unsigned int flags) {
+    HostAddr.push_back(host_addr);
+    DeviceAddr.push_back(device_addr);
+    Bytes.push_back(bytes);
+    Flags.push_back(flags);
+  }
+  void report();
+};
+
+#endif // OMPT_SUPPORT
+
+#endif // _OMPT_TARGET_H_
@@ -26,6 +26,7 @@
 
 // Header file global to this project
 #include "omptarget.h"
+#include "ompt-target.h"
 
 #define DP(...) DEBUGP("Libomptarget", __VA_ARGS__)
 #define INF_REF_CNT (LONG_MAX>>1) // leave room for additions/subtractions
@@ -200,8 +201,8 @@ struct RTLInfoTy {
 
   void *LibraryHandler;
 
-#ifdef OMPTARGET_DEBUG
-  std::string RTLName;
+#if defined(OMPTARGET_DEBUG) || defined(OMPT_SUPPORT)
+  std::string RTLName; // the device type reported to OMPT tools
 #endif
 
   // Functions implemented in the RTL.
@@ -228,7 +229,7 @@ struct RTLInfoTy {
   // We need to provide a copy constructor explicitly.
   RTLInfoTy()
       : Idx(-1), NumberOfDevices(-1), Devices(), LibraryHandler(0),
-#ifdef OMPTARGET_DEBUG
+#if defined(OMPTARGET_DEBUG) || defined(OMPT_SUPPORT)
         RTLName(),
 #endif
         is_valid_binary(0), number_of_devices(0), init_device(0),
@@ -241,7 +242,7 @@ struct RTLInfoTy {
     NumberOfDevices = r.NumberOfDevices;
     Devices = r.Devices;
     LibraryHandler = r.LibraryHandler;
-#ifdef OMPTARGET_DEBUG
+#if defined(OMPTARGET_DEBUG) || defined(OMPT_SUPPORT)
     RTLName = r.RTLName;
 #endif
     is_valid_binary = r.is_valid_binary;
@@ -310,7 +311,7 @@ void RTLsTy::LoadRTLs() {
     R.LibraryHandler = dynlib_handle;
     R.isUsed = false;
 
-#ifdef OMPTARGET_DEBUG
+#if defined(OMPTARGET_DEBUG) || defined(OMPT_SUPPORT)
     R.RTLName = Name;
 #endif
 
@@ -450,6 +451,13 @@ EXTERN int omp_get_initial_device(void) {
   return HOST_DEVICE;
 }
 
+#ifdef OMPT_SUPPORT
+// Sizes of the blocks of omp_target_alloc(), for the delete that
+// omp_target_free() reports.
+static std::map<std::pair<int, void *>, size_t> TargetAllocSizes;
+static std::mutex TargetAllocMtx;
+#endif
+
 EXTERN void *omp_target_alloc(size_t size, int device_num) {
   DP("Call to omp_target_alloc for device %d requesting %zu bytes\n",
       device_num, size);
@@ -474,6 +482,13 @@ EXTERN void *omp_target_alloc(size_t size, int device_num) {
 
   DeviceTy &Device = Devices[device_num];
   rc = Device.RTL->data_alloc(Device.RTLDeviceID, size, NULL);
+#ifdef OMPT_SUPPORT
+  if (rc) {
+    std::lock_guard<std::mutex> Lock(TargetAllocMtx);
+    TargetAllocSizes[std::make_pair(device_num, rc)] = size;
+    ompt_target_data_op(ompt_target_data_alloc, NULL, rc, size);
+  }
+#endif
   DP("omp_target_alloc returns device ptr " DPxMOD "\n", DPxPTR(rc));
   return rc;
 }
@@ -499,6 +514,18 @@ EXTERN void omp_target_free(void *device_ptr, int device_num) {
   }
 
   DeviceTy &Device = Devices[device_num];
+#ifdef OMPT_SUPPORT
+  {
+    std::lock_guard<std::mutex> Lock(TargetAllocMtx);
+    auto It = TargetAllocSizes.find(std::make_pair(device_num, device_ptr));
+    size_t Size = 0; // not from omp_target_alloc()
+    if (It != TargetAllocSizes.end()) {
+      Size = It->second;
+      TargetAllocSizes.erase(It);
+    }
+    ompt_target_data_op(ompt_target_data_delete, NULL, device_ptr, Size);
+  }
+#endif
   Device.RTL->data_delete(Device.RTLDeviceID, (void *)device_ptr);
   DP("omp_target_free deallocated device ptr\n");
 }
@@ -873,6 +900,10 @@ void *DeviceTy::getOrAllocTgtPtr(void *HstPtrBegin, void *HstPtrBase,
   }
 
   DataMapMtx.unlock();
+#ifdef OMPT_SUPPORT
+  if (rc && IsNew)
+    ompt_target_data_op(ompt_target_data_alloc, HstPtrBegin, rc, Size);
+#endif
   return rc;
 }
 
@@ -934,6 +965,10 @@ int DeviceTy::deallocTgtPtr(void *HstPtrBegin, int64_t Size, bool ForceDelete) {
       assert(HT.RefCount == 0 && "did not expect a negative ref count");
       DP("Deleting tgt data " DPxMOD " of size %ld\n",
           DPxPTR(HT.TgtPtrBegin), Size);
+#ifdef OMPT_SUPPORT
+      ompt_target_data_op(ompt_target_data_delete, (void *)HT.HstPtrBegin,
+          (void *)HT.TgtPtrBegin, HT.HstPtrEnd - HT.HstPtrBegin);
+#endif
       RTL->data_delete(RTLDeviceID, (void *)HT.TgtPtrBegin);
       DP("Removing%s mapping with HstPtrBegin=" DPxMOD ", TgtPtrBegin=" DPxMOD
           ", Size=%ld\n", (ForceDelete ? " (forced)" : ""),
@@ -956,6 +991,9 @@ void DeviceTy::init() {
   int32_t rc = RTL->init_device(RTLDeviceID);
   if (rc == OFFLOAD_SUCCESS) {
     IsInit = true;
+#ifdef OMPT_SUPPORT
+    ompt_target_device_initialize(DeviceID, RTL->RTLName.c_str());
+#endif
   }
 }
 
@@ -986,18 +1024,29 @@ __tgt_target_table *DeviceTy::load_binary(void *Img) {
 // Submit data to device.
 int32_t DeviceTy::data_submit(void *TgtPtrBegin, void *HstPtrBegin,
     int64_t Size) {
+#ifdef OMPT_SUPPORT
+  ompt_target_data_op(ompt_target_data_transfer_to_dev, HstPtrBegin,
+      TgtPtrBegin, Size);
+#endif
   return RTL->data_submit(RTLDeviceID, TgtPtrBegin, HstPtrBegin, Size);
 }
 
 // Retrieve data from device.
 int32_t DeviceTy::data_retrieve(void *HstPtrBegin, void *TgtPtrBegin,
     int64_t Size) {
+#ifdef OMPT_SUPPORT
+  ompt_target_data_op(ompt_target_data_transfer_from_dev, HstPtrBegin,
+      TgtPtrBegin, Size);
+#endif
   return RTL->data_retrieve(RTLDeviceID, HstPtrBegin, TgtPtrBegin, Size);
 }
 
 // Run region on device
 int32_t DeviceTy::run_region(void *TgtEntryPtr, void **TgtVarsPtr,
     ptrdiff_t *TgtOffsets, int32_t TgtVarsSize) {
+#ifdef OMPT_SUPPORT
+  ompt_target_submit();
+#endif
   return RTL->run_region(RTLDeviceID, TgtEntryPtr, TgtVarsPtr, TgtOffsets,
       TgtVarsSize);
 }
@@ -1006,6 +1055,9 @@ int32_t DeviceTy::run_region(void *TgtEntryPtr, void **TgtVarsPtr,
 int32_t DeviceTy::run_team_region(void *TgtEntryPtr, void **TgtVarsPtr,
     ptrdiff_t *TgtOffsets, int32_t TgtVarsSize, int32_t NumTeams,
     int32_t ThreadLimit, uint64_t LoopTripCount) {
+#ifdef OMPT_SUPPORT
+  ompt_target_submit();
+#endif
   return RTL->run_team_region(RTLDeviceID, TgtEntryPtr, TgtVarsPtr, TgtOffsets,
       TgtVarsSize, NumTeams, ThreadLimit, LoopTripCount);
 }
@@ -1631,6 +1683,9 @@ static short member_of(int64_t type) {
 /// Internal function to do the mapping and transfer the data to the device
 static int target_data_begin(DeviceTy &Device, int32_t arg_num,
     void **args_base, void **args, int64_t *arg_sizes, int64_t *arg_types) {
+#ifdef OMPT_SUPPORT
+  OmptTargetMapTy OmptMap;
+#endif
   // process each input.
   int rc = OFFLOAD_SUCCESS;
   for (int32_t i = 0; i < arg_num; ++i) {
@@ -1675,6 +1730,12 @@ static int target_data_begin(DeviceTy &Device, int32_t arg_num,
     DP("There are %" PRId64 " bytes allocated at target address " DPxMOD
         " - is%s new\n", arg_sizes[i], DPxPTR(TgtPtrBegin),
         (IsNew ? "" : " not"));
+#ifdef OMPT_SUPPORT
+    if (OmptMap.enabled())
+      OmptMap.add(HstPtrBegin, TgtPtrBegin, arg_sizes[i],
+          (arg_types[i] & OMP_TGT_MAPTYPE_TO) ? ompt_target_map_flag_to
+                                              : ompt_target_map_flag_alloc);
+#endif
 
     if (arg_types[i] & OMP_TGT_MAPTYPE_RETURN_PARAM) {
       void *ret_ptr;
@@ -1733,6 +1794,9 @@ static int target_data_begin(DeviceTy &Device, int32_t arg_num,
     }
   }
 
+#ifdef OMPT_SUPPORT
+  OmptMap.report();
+#endif
   return rc;
 }
 
@@ -1743,6 +1807,9 @@ EXTERN void __tgt_target_data_begin_nowait(int32_t device_id, int32_t arg_num,
   if (depNum + noAliasDepNum > 0)
     __kmpc_omp_taskwait(NULL, 0);
 
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+#endif
   __tgt_target_data_begin(device_id, arg_num, args_base, args, arg_sizes,
                           arg_types);
 }
@@ -1754,6 +1821,10 @@ EXTERN void __tgt_target_data_begin(int32_t device_id, int32_t arg_num,
     void **args_base, void **args, int64_t *arg_sizes, int32_t *arg_types) {
   DP("Entering data begin region for device %d with %d mappings\n", device_id,
      arg_num);
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+  OmptTargetRegionTy OmptRegion(ompt_target_enter_data);
+#endif
 
   // No devices available?
   if (device_id == OFFLOAD_DEVICE_DEFAULT) {
@@ -1767,6 +1838,9 @@ EXTERN void __tgt_target_data_begin(int32_t device_id, int32_t arg_num,
   }
 
   DeviceTy& Device = Devices[device_id];
+#ifdef OMPT_SUPPORT
+  OmptRegion.begin(device_id);
+#endif
 
   // Translate maps
   int32_t new_arg_num;
@@ -1789,6 +1863,9 @@ EXTERN void __tgt_target_data_begin(int32_t device_id, int32_t arg_num,
 /// Internal function to undo the mapping and retrieve the data from the device.
 static int target_data_end(DeviceTy &Device, int32_t arg_num, void **args_base,
     void **args, int64_t *arg_sizes, int64_t *arg_types) {
+#ifdef OMPT_SUPPORT
+  OmptTargetMapTy OmptMap;
+#endif
   int rc = OFFLOAD_SUCCESS;
   // process each input.
   for (int32_t i = arg_num - 1; i >= 0; --i) {
@@ -1818,6 +1895,15 @@ static int target_data_end(DeviceTy &Device, int32_t arg_num, void **args_base,
       DelEntry = false; // protect parent struct from being deallocated
     }
 
+#ifdef OMPT_SUPPORT
+    if (OmptMap.enabled())
+      OmptMap.add(HstPtrBegin, TgtPtrBegin, arg_sizes[i],
+          ((arg_types[i] & OMP_TGT_MAPTYPE_FROM) ? ompt_target_map_flag_from
+                                                 : 0) |
+          (ForceDelete ? ompt_target_map_flag_delete
+                       : ompt_target_map_flag_release));
+#endif
+
     if ((arg_types[i] & OMP_TGT_MAPTYPE_FROM) || DelEntry) {
       // Move data back to the host
       if (arg_types[i] & OMP_TGT_MAPTYPE_FROM) {
@@ -1889,6 +1975,9 @@ static int target_data_end(DeviceTy &Device, int32_t arg_num, void **args_base,
     }
   }
 
+#ifdef OMPT_SUPPORT
+  OmptMap.report();
+#endif
   return rc;
 }
 
@@ -1898,6 +1987,10 @@ static int target_data_end(DeviceTy &Device, int32_t arg_num, void **args_base,
 EXTERN void __tgt_target_data_end(int32_t device_id, int32_t arg_num,
     void **args_base, void **args, int64_t *arg_sizes, int32_t *arg_types) {
   DP("Entering data end region with %d mappings\n", arg_num);
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+  OmptTargetRegionTy OmptRegion(ompt_target_exit_data);
+#endif
 
   // No devices available?
   if (device_id == OFFLOAD_DEVICE_DEFAULT) {
@@ -1917,6 +2010,9 @@ EXTERN void __tgt_target_data_end(int32_t device_id, int32_t arg_num,
     DP("uninit device: ignore");
     return;
   }
+#ifdef OMPT_SUPPORT
+  OmptRegion.begin(device_id);
+#endif
 
   // Translate maps
   int32_t new_arg_num;
@@ -1943,6 +2039,9 @@ EXTERN void __tgt_target_data_end_nowait(int32_t device_id, int32_t arg_num,
   if (depNum + noAliasDepNum > 0)
     __kmpc_omp_taskwait(NULL, 0);
 
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+#endif
   __tgt_target_data_end(device_id, arg_num, args_base, args, arg_sizes,
                         arg_types);
 }
@@ -1951,6 +2050,11 @@ EXTERN void __tgt_target_data_end_nowait(int32_t device_id, int32_t arg_num,
 EXTERN void __tgt_target_data_update(int32_t device_id, int32_t arg_num,
     void **args_base, void **args, int64_t *arg_sizes, int32_t *arg_types) {
   DP("Entering data update with %d mappings\n", arg_num);
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+  OmptTargetRegionTy OmptRegion(ompt_target_update);
+  OmptTargetMapTy OmptMap;
+#endif
 
   // No devices available?
   if (device_id == OFFLOAD_DEVICE_DEFAULT) {
@@ -1963,6 +2067,9 @@ EXTERN void __tgt_target_data_update(int32_t device_id, int32_t arg_num,
   }
 
   DeviceTy& Device = Devices[device_id];
+#ifdef OMPT_SUPPORT
+  OmptRegion.begin(device_id);
+#endif
 
   // process each input.
   for (int32_t i = 0; i < arg_num; ++i) {
@@ -1975,6 +2082,13 @@ EXTERN void __tgt_target_data_update(int32_t device_id, int32_t arg_num,
     bool IsLast;
     void *TgtPtrBegin = Device.getTgtPtrBegin(HstPtrBegin, MapSize, IsLast,
         false);
+#ifdef OMPT_SUPPORT
+    if (OmptMap.enabled())
+      OmptMap.add(HstPtrBegin, TgtPtrBegin, MapSize,
+          ((arg_types[i] & OMP_TGT_MAPTYPE_TO) ? ompt_target_map_flag_to : 0) |
+          ((arg_types[i] & OMP_TGT_MAPTYPE_FROM) ? ompt_target_map_flag_from
+                                                 : 0));
+#endif
 
     if (arg_types[i] & OMP_TGT_MAPTYPE_FROM) {
       DP("Moving %" PRId64 " bytes (tgt:" DPxMOD ") -> (hst:" DPxMOD ")\n",
@@ -2023,6 +2137,9 @@ EXTERN void __tgt_target_data_update(int32_t device_id, int32_t arg_num,
       Device.ShadowMtx.unlock();
     }
   }
+#ifdef OMPT_SUPPORT
+  OmptMap.report();
+#endif
 }
 
 EXTERN void __tgt_target_data_update_nowait(
@@ -2032,6 +2149,9 @@ EXTERN void __tgt_target_data_update_nowait(
   if (depNum + noAliasDepNum > 0)
     __kmpc_omp_taskwait(NULL, 0);
 
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+#endif
   __tgt_target_data_update(device_id, arg_num, args_base, args, arg_sizes,
                            arg_types);
 }
@@ -2114,7 +2234,13 @@ static int target(int32_t device_id, void *host_ptr, int32_t arg_num,
   std::vector<ptrdiff_t> tgt_offsets;
 
   // List of (first-)private arrays allocated for this target region
-  std::vector<void *> fpArrays;
+  // (First-)private arrays: device address, host address and size
+  struct FpArrayTy {
+    void *TgtPtrBegin;
+    void *HstPtrBegin;
+    int64_t Size;
+  };
+  std::vector<FpArrayTy> fpArrays;
 
   for (int32_t i = 0; i < arg_num; ++i) {
     if (!(arg_types[i] & OMP_TGT_MAPTYPE_TARGET_PARAM)) {
@@ -2135,6 +2261,11 @@ static int target(int32_t device_id, void *host_ptr, int32_t arg_num,
       // Allocate memory for (first-)private array
       TgtPtrBegin = Device.RTL->data_alloc(Device.RTLDeviceID,
           arg_sizes[i], HstPtrBegin);
+#ifdef OMPT_SUPPORT
+      if (TgtPtrBegin)
+        ompt_target_data_op(ompt_target_data_alloc, HstPtrBegin, TgtPtrBegin,
+            arg_sizes[i]);
+#endif
       if (!TgtPtrBegin) {
         DP ("Data allocation for %sprivate array " DPxMOD " failed\n",
             (arg_types[i] & OMP_TGT_MAPTYPE_TO ? "first-" : ""),
@@ -2142,7 +2273,7 @@ static int target(int32_t device_id, void *host_ptr, int32_t arg_num,
         rc = OFFLOAD_FAIL;
         break;
       } else {
-        fpArrays.push_back(TgtPtrBegin);
+        fpArrays.push_back({TgtPtrBegin, HstPtrBegin, arg_sizes[i]});
         TgtBaseOffset = (intptr_t)HstPtrBase - (intptr_t)HstPtrBegin;
 #ifdef OMPTARGET_DEBUG
         void *TgtPtrBase = (void *)((intptr_t)TgtPtrBegin + TgtBaseOffset);
@@ -2212,8 +2343,12 @@ static int target(int32_t device_id, void *host_ptr, int32_t arg_num,
   }
 
   // Deallocate (first-)private arrays
-  for (auto it : fpArrays) {
-    int rt = Device.RTL->data_delete(Device.RTLDeviceID, it);
+  for (auto &it : fpArrays) {
+#ifdef OMPT_SUPPORT
+    ompt_target_data_op(ompt_target_data_delete, it.HstPtrBegin,
+        it.TgtPtrBegin, it.Size);
+#endif
+    int rt = Device.RTL->data_delete(Device.RTLDeviceID, it.TgtPtrBegin);
     if (rt != OFFLOAD_SUCCESS) {
       DP("Deallocation of (first-)private arrays failed.\n");
       rc = OFFLOAD_FAIL;
@@ -2236,6 +2371,10 @@ EXTERN int __tgt_target(int32_t device_id, void *host_ptr, int32_t arg_num,
     void **args_base, void **args, int64_t *arg_sizes, int32_t *arg_types) {
   DP("Entering target region with entry point " DPxMOD " and device Id %d\n",
      DPxPTR(host_ptr), device_id);
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+  OmptTargetRegionTy OmptRegion(ompt_target);
+#endif
 
   if (device_id == OFFLOAD_DEVICE_DEFAULT) {
     device_id = omp_get_default_device();
@@ -2245,6 +2384,9 @@ EXTERN int __tgt_target(int32_t device_id, void *host_ptr, int32_t arg_num,
     DP("Failed to get device %d ready\n", device_id);
     return OFFLOAD_FAIL;
   }
+#ifdef OMPT_SUPPORT
+  OmptRegion.begin(device_id);
+#endif
 
   // Translate maps
   int32_t new_arg_num;
@@ -2274,6 +2416,9 @@ EXTERN int __tgt_target_nowait(int32_t device_id, void *host_ptr,
   if (depNum + noAliasDepNum > 0)
     __kmpc_omp_taskwait(NULL, 0);
 
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+#endif
   return __tgt_target(device_id, host_ptr, arg_num, args_base, args, arg_sizes,
                       arg_types);
 }
@@ -2283,6 +2428,10 @@ EXTERN int __tgt_target_teams(int32_t device_id, void *host_ptr,
     int32_t *arg_types, int32_t team_num, int32_t thread_limit) {
   DP("Entering target region with entry point " DPxMOD " and device Id %d\n",
      DPxPTR(host_ptr), device_id);
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+  OmptTargetRegionTy OmptRegion(ompt_target);
+#endif
 
   if (device_id == OFFLOAD_DEVICE_DEFAULT) {
     device_id = omp_get_default_device();
@@ -2292,6 +2441,9 @@ EXTERN int __tgt_target_teams(int32_t device_id, void *host_ptr,
     DP("Failed to get device %d ready\n", device_id);
     return OFFLOAD_FAIL;
   }
+#ifdef OMPT_SUPPORT
+  OmptRegion.begin(device_id);
+#endif
 
   // Translate maps
   int32_t new_arg_num;
@@ -2322,6 +2474,9 @@ EXTERN int __tgt_target_teams_nowait(int32_t device_id, void *host_ptr,
   if (depNum + noAliasDepNum > 0)
     __kmpc_omp_taskwait(NULL, 0);
 
+#ifdef OMPT_SUPPORT
+  OMPT_TARGET_STORE_RETURN_ADDRESS;
+#endif
   return __tgt_target_teams(device_id, host_ptr, arg_num, args_base, args,
                             arg_sizes, arg_types, team_num, thread_limit);
 }
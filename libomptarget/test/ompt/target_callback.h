@@ -0,0 +1,106 @@
+// The tool of the host runtime's OMPT tests, see runtime/test/ompt/callback.h,
+// which also registers the target and device callbacks dispatched by
+// libomptarget.
+#define register_extra_callbacks register_target_callbacks
+static void register_target_callbacks();
+
+#include "callback.h"
+
+static const char* ompt_target_type_t_values[] = {
+  NULL,
+  "ompt_target",
+  "ompt_target_enter_data",
+  "ompt_target_exit_data",
+  "ompt_target_update"
+};
+
+static const char* ompt_target_data_op_t_values[] = {
+  NULL,
+  "ompt_target_data_alloc",
+  "ompt_target_data_transfer_to_dev",
+  "ompt_target_data_transfer_from_dev",
+  "ompt_target_data_delete"
+};
+
+static void
+on_ompt_callback_target(
+  ompt_target_type_t kind,
+  ompt_scope_endpoint_t endpoint,
+  uint64_t device_num,
+  ompt_data_t *task_data,
+  ompt_id_t target_id,
+  const void *codeptr_ra)
+{
+  switch(endpoint)
+  {
+    case ompt_scope_begin:
+      printf("%" PRIu64 ": ompt_event_target_begin: kind=%s, device_num=%" PRIu64 ", task_id=%" PRIu64 ", target_id=%" PRIu64 ", codeptr_ra=%p\n", ompt_get_thread_data()->value, ompt_target_type_t_values[kind], device_num, task_data ? task_data->value : 0, target_id, codeptr_ra);
+      break;
+    case ompt_scope_end:
+      printf("%" PRIu64 ": ompt_event_target_end: kind=%s, device_num=%" PRIu64 ", task_id=%" PRIu64 ", target_id=%" PRIu64 ", codeptr_ra=%p\n", ompt_get_thread_data()->value, ompt_target_type_t_values[kind], device_num, task_data ? task_data->value : 0, target_id, codeptr_ra);
+      break;
+  }
+}
+
+static void
+on_ompt_callback_target_data_op(
+  ompt_id_t target_id,
+  ompt_id_t host_op_id,
+  ompt_target_data_op_t optype,
+  void *host_addr,
+  void *device_addr,
+  size_t bytes)
+{
+  printf("%" PRIu64 ": ompt_event_target_data_op: target_id=%" PRIu64 ", host_op_id=%" PRIu64 ", optype=%s, host_addr=%p, device_addr=%p, bytes=%zu\n", ompt_get_thread_data()->value, target_id, host_op_id, ompt_target_data_op_t_values[optype], host_addr, device_addr, bytes);
+}
+
+static void
+on_ompt_callback_target_submit(
+  ompt_id_t target_id,
+  ompt_id_t host_op_id)
+{
+  printf("%" PRIu64 ": ompt_event_target_submit: target_id=%" PRIu64 ", host_op_id=%" PRIu64 "\n", ompt_get_thread_data()->value, target_id, host_op_id);
+}
+
+static void
+on_ompt_callback_target_map(
+  ompt_id_t target_id,
+  unsigned int nitems,
+  void **host_addr,
+  void **device_addr,
+  size_t *bytes,
+  unsigned int *mapping_flags)
+{
+  unsigned int i;
+  printf("%" PRIu64 ": ompt_event_target_map: target_id=%" PRIu64 ", nitems=%u\n", ompt_get_thread_data()->value, target_id, nitems);
+  for (i = 0; i < nitems; i++)
+    printf("%" PRIu64 ": ompt_event_target_map_item: target_id=%" PRIu64 ", host_addr=%p, device_addr=%p, bytes=%zu, mapping_flags=0x%x\n", ompt_get_thread_data()->value, target_id, host_addr[i], device_addr[i], bytes[i], mapping_flags[i]);
+}
+
+static void
+on_ompt_callback_device_initialize(
+  uint64_t device_num,
+  const char *type,
+  ompt_device_t *device,
+  ompt_function_lookup_t lookup,
+  const char *documentation)
+{
+  printf("0: ompt_event_device_initialize: device_num=%" PRIu64 ", type=%s\n", device_num, type);
+}
+
+static void
+on_ompt_callback_device_finalize(
+  uint64_t device_num)
+{
+  printf("0: ompt_event_device_finalize: device_num=%" PRIu64 "\n", device_num);
+}
+
+static void register_target_callbacks()
+{
+  register_callback(ompt_callback_target);
+  register_callback(ompt_callback_target_data_op);
+  register_callback(ompt_callback_target_submit);
+  register_callback(ompt_callback_target_map);
+  register_callback(ompt_callback_device_initialize);
+  register_callback(ompt_callback_device_finalize);
+}
@@ -0,0 +1,68 @@
+// RUN: %libomptarget-compile-run-and-check-aarch64-unknown-linux-gnu
+// RUN: %libomptarget-compile-run-and-check-powerpc64-ibm-linux-gnu
+// RUN: %libomptarget-compile-run-and-check-powerpc64le-ibm-linux-gnu
+// RUN: %libomptarget-compile-run-and-check-x86_64-pc-linux-gnu
+// REQUIRES: ompt
+#include "target_callback.h"
+
+#define N 64
+
+int main()
+{
+  int a[N], i;
+
+  for (i = 0; i < N; i++)
+    a[i] = i;
+  printf("%" PRIu64 ": a=%p\n", ompt_get_thread_data()->value, a);
+
+  #pragma omp target enter data map(to: a)
+  #pragma omp target
+  for (i = 0; i < N; i++)
+    a[i] *= 2;
+  #pragma omp target update from(a)
+  #pragma omp target exit data map(delete: a)
+
+  printf("%" PRIu64 ": a[N-1]=%d\n", ompt_get_thread_data()->value, a[N - 1]);
+
+  // Check if libomp supports the callbacks for this test.
+  // CHECK-NOT: {{^}}0: Could not register callback 'ompt_callback_target'
+  // CHECK-NOT: {{^}}0: Could not register callback 'ompt_callback_target_data_op'
+  // CHECK-NOT: {{^}}0: Could not register callback 'ompt_callback_target_submit'
+  // CHECK-NOT: {{^}}0: Could not register callback 'ompt_callback_target_map'
+  // CHECK-NOT: {{^}}0: Could not register callback 'ompt_callback_device_initialize'
+  // CHECK-NOT: {{^}}0: Could not register callback 'ompt_callback_device_finalize'
+
+  // CHECK: 0: NULL_POINTER=[[NULL:.*$]]
+  // CHECK: {{^}}[[THREAD_ID:[0-9]+]]: a=[[A:0x[0-f]+]]
+  // CHECK: {{^}}0: ompt_event_device_initialize: device_num=0, type=libomptarget.rtl.
+
+  // The array is allocated and copied to the device by the enter data.
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_begin: kind=ompt_target_enter_data, device_num=0, task_id={{[0-9]+}}, target_id=[[ENTER_ID:[0-9]+]]
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_data_op: target_id=[[ENTER_ID]], host_op_id={{[0-9]+}}, optype=ompt_target_data_alloc, host_addr=[[A]], device_addr=[[DEV_A:0x[0-f]+]], bytes=256
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_data_op: target_id=[[ENTER_ID]], host_op_id={{[0-9]+}}, optype=ompt_target_data_transfer_to_dev, host_addr=[[A]], device_addr=[[DEV_A]], bytes=256
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_map: target_id=[[ENTER_ID]], nitems=1
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_map_item: target_id=[[ENTER_ID]], host_addr=[[A]], device_addr=[[DEV_A]], bytes=256, mapping_flags=0x1
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_end: kind=ompt_target_enter_data, device_num=0, task_id={{[0-9]+}}, target_id=[[ENTER_ID]]
+
+  // The target region finds the array on the device and copies nothing.
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_begin: kind=ompt_target, device_num=0, task_id={{[0-9]+}}, target_id=[[TARGET_ID:[0-9]+]]
+  // CHECK-NOT: ompt_event_target_data_op: target_id=[[TARGET_ID]], {{.*}}host_addr=[[A]]
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_submit: target_id=[[TARGET_ID]], host_op_id={{[0-9]+}}
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_end: kind=ompt_target, device_num=0, task_id={{[0-9]+}}, target_id=[[TARGET_ID]]
+
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_begin: kind=ompt_target_update, device_num=0, task_id={{[0-9]+}}, target_id=[[UPDATE_ID:[0-9]+]]
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_data_op: target_id=[[UPDATE_ID]], host_op_id={{[0-9]+}}, optype=ompt_target_data_transfer_from_dev, host_addr=[[A]], device_addr=[[DEV_A]], bytes=256
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_map_item: target_id=[[UPDATE_ID]], host_addr=[[A]], device_addr=[[DEV_A]], bytes=256, mapping_flags=0x2
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_end: kind=ompt_target_update, device_num=0, task_id={{[0-9]+}}, target_id=[[UPDATE_ID]]
+
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_begin: kind=ompt_target_exit_data, device_num=0, task_id={{[0-9]+}}, target_id=[[EXIT_ID:[0-9]+]]
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_data_op: target_id=[[EXIT_ID]], host_op_id={{[0-9]+}}, optype=ompt_target_data_delete, host_addr=[[A]], device_addr=[[DEV_A]], bytes=256
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_map_item: target_id=[[EXIT_ID]], host_addr=[[A]], device_addr=[[DEV_A]], bytes=256, mapping_flags=0x10
+  // CHECK: {{^}}[[THREAD_ID]]: ompt_event_target_end: kind=ompt_target_exit_data, device_num=0, task_id={{[0-9]+}}, target_id=[[EXIT_ID]]
+
+  // CHECK: {{^}}[[THREAD_ID]]: a[N-1]=126
+  // CHECK: {{^}}0: ompt_event_device_finalize: device_num=0
+  // CHECK: {{^}}0: ompt_event_runtime_shutdown
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * affinity_places.c -- Cost of affinity initialization and of place handling.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+// Measures the time of the first call into the runtime, which builds the
+// topology and the place masks, the time of a parallel region that alternates
+// between spread and close binding, so that the places are partitioned again
+// and the threads rebound at every fork, and the time of a walk over all places
+// with omp_get_place_num_procs() and omp_get_place_proc_ids(). Run it with
+// bound threads on a machine with many hardware threads, e.g.
+// OMP_PLACES=threads OMP_PROC_BIND=spread; a topology that the machine does
+// not have can be described with KMP_CPUINFO_FILE.
+// Usage: affinity_places [threads [repetitions]]
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define RUNS 5
+#define MAX_THREADS 1024
+
+// Keeps the compiler from removing the otherwise empty parallel regions
+static long visits[MAX_THREADS];
+
+static double now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static double best_of(double *t) {
+  double best = t[0];
+  int i;
+  for (i = 1; i < RUNS; i++)
+    if (t[i] < best)
+      best = t[i];
+  return best;
+}
+
+int main(int argc, char **argv) {
+  double start, t_init, t_fork[RUNS], t_places[RUNS];
+  int nplaces, nthreads;
+  long reps, sum = 0;
+  int run, *ids;
+
+  // omp_get_wtime() would initialize the runtime before the clock starts
+  start = now();
+  nplaces = omp_get_num_places();
+  t_init = now() - start;
+
+  nthreads = argc > 1 ? atoi(argv[1]) : omp_get_max_threads();
+  reps = argc > 2 ? atol(argv[2]) : 1000;
+  if (nthreads > MAX_THREADS)
+    nthreads = MAX_THREADS;
+  ids = (int *)malloc(sizeof(int) * (omp_get_num_procs() + 1));
+
+#pragma omp parallel num_threads(nthreads)
+  visits[omp_get_thread_num()]++;
+  for (run = 0; run < RUNS; run++) {
+    long i;
+    int p;
+
+    start = omp_get_wtime();
+    for (i = 0; i < reps; i++) {
+      if (i % 2) {
+#pragma omp parallel num_threads(nthreads) proc_bind(spread)
+        visits[omp_get_thread_num()]++;
+      } else {
+#pragma omp parallel num_threads(nthreads) proc_bind(close)
+        visits[omp_get_thread_num()]++;
+      }
+    }
+    t_fork[run] = (omp_get_wtime() - start) / reps;
+
+    start = omp_get_wtime();
+    for (i = 0; i < reps; i++) {
+      for (p = 0; p < nplaces; p++) {
+        int n = omp_get_place_num_procs(p);
+        omp_get_place_proc_ids(p, ids);
+        sum += n + ids[n - 1];
+      }
+    }
+    t_places[run] = (omp_get_wtime() - start) / reps;
+  }
+  if (sum < 0)
+    printf("unexpected sum\n");
+
+  printf("%8s %8s %14s %14s %14s\n", "procs", "places", "init us", "fork us",
+         "places us");
+  printf("%8d %8d %14.1f %14.3f %14.3f\n", omp_get_num_procs(), nplaces,
+         t_init * 1e6, best_of(t_fork) * 1e6, best_of(t_places) * 1e6);
+  free(ids);
+  return 0;
+}
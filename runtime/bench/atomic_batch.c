@@ -0,0 +1,86 @@
+/*
+ * atomic_batch.c -- Throughput of batched vs. element-wise atomic updates.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+// Every thread scatters NVALS values into a shared histogram, once with one
+// __kmpc_atomic_float8_add call per element and once with
+// __kmpc_atomic_float8_add_batch. Usage: atomic_batch [bins [reps]]
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef long long kmp_int64;
+void __kmpc_atomic_float8_add(void *id_ref, int gtid, double *lhs, double rhs);
+void __kmpc_atomic_float8_add_batch(void *id_ref, int gtid, double *base,
+                                    int n, const kmp_int64 *idx,
+                                    const double *val);
+int __kmpc_global_thread_num(void *id_ref);
+
+#define NVALS 4096
+
+int main(int argc, char **argv) {
+  int nbins = argc > 1 ? atoi(argv[1]) : 64;
+  int reps = argc > 2 ? atoi(argv[2]) : 200;
+  double *hist = (double *)calloc(nbins, sizeof(double));
+  double t_elem = 0.0, t_batch = 0.0;
+  long long total;
+  int mode;
+
+  for (mode = 0; mode < 2; mode++) {
+#pragma omp parallel
+    {
+      int gtid = __kmpc_global_thread_num(NULL);
+      kmp_int64 *idx = (kmp_int64 *)malloc(NVALS * sizeof(kmp_int64));
+      double *val = (double *)malloc(NVALS * sizeof(double));
+      unsigned seed = 12345u + omp_get_thread_num();
+      double start = 0.0;
+      int r, j;
+
+      for (j = 0; j < NVALS; j++) {
+        seed = seed * 1103515245u + 12345u;
+        idx[j] = (seed >> 8) % nbins;
+        val[j] = 1.0;
+      }
+#pragma omp barrier
+#pragma omp master
+      start = omp_get_wtime();
+      for (r = 0; r < reps; r++) {
+        if (mode == 0) {
+          for (j = 0; j < NVALS; j++)
+            __kmpc_atomic_float8_add(NULL, gtid, &hist[idx[j]], val[j]);
+        } else {
+          __kmpc_atomic_float8_add_batch(NULL, gtid, hist, NVALS, idx, val);
+        }
+      }
+#pragma omp barrier
+#pragma omp master
+      {
+        if (mode == 0)
+          t_elem = omp_get_wtime() - start;
+        else
+          t_batch = omp_get_wtime() - start;
+      }
+      free(idx);
+      free(val);
+    }
+  }
+
+  total = (long long)omp_get_max_threads() * NVALS * reps;
+  printf("threads %d bins %d updates %lld\n", omp_get_max_threads(), nbins,
+         total);
+  printf("element-wise  %8.2f Mupdates/s\n", total / t_elem * 1e-6);
+  printf("batched       %8.2f Mupdates/s\n", total / t_batch * 1e-6);
+  free(hist);
+  return 0;
+}
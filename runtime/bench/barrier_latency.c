@@ -0,0 +1,102 @@
+/*
+ * barrier_latency.c -- Latency of barriers and of parallel region fork/join.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+// For 1..N threads, measures the time of an explicit barrier inside a parallel
+// region, of a parallel region with an empty body (fork + join barrier) and of
+// a static loop with a reduction, each averaged over the given number of
+// repetitions and reported as the best of several runs. The barrier state of
+// every thread lives in its kmp_info_t, so on a multi-socket machine compare
+// KMP_NUMA_LOCAL_THREADS=false against the default, with bound threads, e.g.
+// OMP_PROC_BIND=spread OMP_PLACES=cores.
+// Usage: barrier_latency [max_threads [repetitions]]
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RUNS 5
+#define MAX_THREADS 1024
+
+// Keeps the compiler from removing the otherwise empty parallel regions
+static long visits[MAX_THREADS];
+
+static double best_of(double *t) {
+  double best = t[0];
+  int i;
+  for (i = 1; i < RUNS; i++)
+    if (t[i] < best)
+      best = t[i];
+  return best;
+}
+
+int main(int argc, char **argv) {
+  int max_threads = argc > 1 ? atoi(argv[1]) : omp_get_max_threads();
+  long reps = argc > 2 ? atol(argv[2]) : 10000;
+  int nth;
+
+  if (max_threads > MAX_THREADS)
+    max_threads = MAX_THREADS;
+  printf("%8s %14s %14s %14s\n", "threads", "barrier us", "parallel us",
+         "reduction us");
+  for (nth = 1; nth <= max_threads;
+       nth = nth < max_threads && 2 * nth > max_threads ? max_threads
+                                                        : 2 * nth) {
+    double t_barrier[RUNS], t_parallel[RUNS], t_reduction[RUNS];
+    int run;
+
+    // Warm up the hot team so that thread creation is not measured.
+#pragma omp parallel num_threads(nth)
+    visits[omp_get_thread_num()]++;
+    for (run = 0; run < RUNS; run++) {
+      double start;
+      long i;
+      double sum = 0.0;
+
+      start = omp_get_wtime();
+#pragma omp parallel num_threads(nth) private(i)
+      {
+        for (i = 0; i < reps; i++) {
+#pragma omp barrier
+        }
+      }
+      t_barrier[run] = (omp_get_wtime() - start) / reps;
+
+      start = omp_get_wtime();
+      for (i = 0; i < reps; i++) {
+#pragma omp parallel num_threads(nth)
+        visits[omp_get_thread_num()]++;
+      }
+      t_parallel[run] = (omp_get_wtime() - start) / reps;
+
+      start = omp_get_wtime();
+#pragma omp parallel num_threads(nth) private(i)
+      {
+        for (i = 0; i < reps; i++) {
+          int j;
+#pragma omp for schedule(static) reduction(+ : sum)
+          for (j = 0; j < nth; j++)
+            sum += j;
+        }
+      }
+      t_reduction[run] = (omp_get_wtime() - start) / reps;
+      if (sum < 0.0)
+        printf("unexpected sum\n");
+    }
+    printf("%8d %14.3f %14.3f %14.3f\n", nth, best_of(t_barrier) * 1e6,
+           best_of(t_parallel) * 1e6, best_of(t_reduction) * 1e6);
+    if (nth == max_threads)
+      break;
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * malloc_pool.c -- Throughput and footprint of the kmp_malloc() allocator.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+// For 1..N threads, every thread allocates and releases blocks of random sizes
+// (16 bytes to 2KB) with kmp_malloc()/kmp_free(), first in its own working set
+// of NLIVE blocks (local), then releasing the blocks allocated by its neighbour
+// (remote). The footprint is the resident size of the process against the
+// bytes live at the end of the local phase. Run it once with
+// KMP_MALLOC_KIND=sizeclass and once with KMP_MALLOC_KIND=bget.
+// Usage: malloc_pool [max_threads [ops_per_thread]]
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NLIVE 1024
+#define MAX_SIZE 2048
+
+static long resident_kb(void) {
+  long pages = 0, rss = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f != NULL) {
+    if (fscanf(f, "%ld %ld", &pages, &rss) != 2)
+      rss = 0;
+    fclose(f);
+  }
+  return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static unsigned next_size(unsigned *seed) {
+  *seed = *seed * 1103515245u + 12345u;
+  return 16 + (*seed >> 8) % (MAX_SIZE - 16);
+}
+
+int main(int argc, char **argv) {
+  int max_threads = argc > 1 ? atoi(argv[1]) : omp_get_max_threads();
+  long ops = argc > 2 ? atol(argv[2]) : 2000000;
+  void **slots = (void **)calloc((size_t)max_threads * NLIVE, sizeof(void *));
+  long rss0 = resident_kb();
+  int nth;
+
+  printf("%8s %14s %14s %10s %10s\n", "threads", "local Mops/s",
+         "remote Mops/s", "live KB", "rss KB");
+  for (nth = 1; nth <= max_threads; nth *= 2) {
+    double t_local = 0.0, t_remote = 0.0;
+    long live = 0;
+    long rss = 0;
+
+#pragma omp parallel num_threads(nth) reduction(+ : live)
+    {
+      int tid = omp_get_thread_num();
+      void **mine = slots + (size_t)tid * NLIVE;
+      void **next = slots + (size_t)((tid + 1) % nth) * NLIVE;
+      unsigned seed = 12345u + tid;
+      unsigned sizes[NLIVE];
+      double start = 0.0;
+      long i;
+
+      for (i = 0; i < NLIVE; i++) {
+        sizes[i] = next_size(&seed);
+        mine[i] = kmp_malloc(sizes[i]);
+      }
+#pragma omp barrier
+#pragma omp master
+      start = omp_get_wtime();
+      for (i = 0; i < ops; i++) {
+        long k = (seed >> 4) % NLIVE;
+        kmp_free(mine[k]);
+        sizes[k] = next_size(&seed);
+        mine[k] = kmp_malloc(sizes[k]);
+      }
+#pragma omp barrier
+#pragma omp master
+      {
+        t_local = omp_get_wtime() - start;
+        rss = resident_kb();
+      }
+      for (i = 0; i < NLIVE; i++)
+        live += sizes[i];
+
+      // Every round releases the blocks of the neighbour and refills its own
+#pragma omp barrier
+#pragma omp master
+      start = omp_get_wtime();
+      for (i = 0; i < ops / NLIVE; i++) {
+        long k;
+#pragma omp barrier
+        for (k = 0; k < NLIVE; k++)
+          kmp_free(next[k]);
+#pragma omp barrier
+        for (k = 0; k < NLIVE; k++)
+          mine[k] = kmp_malloc(next_size(&seed));
+      }
+#pragma omp barrier
+#pragma omp master
+      t_remote = omp_get_wtime() - start;
+      for (i = 0; i < NLIVE; i++)
+        kmp_free(mine[i]);
+    }
+    printf("%8d %14.2f %14.2f %10ld %10ld\n", nth,
+           (double)nth * ops / t_local * 1e-6,
+           (double)nth * (ops / NLIVE) * NLIVE / t_remote * 1e-6,
+           live / 1024, rss - rss0);
+  }
+  free(slots);
+  return 0;
+}
@@ -0,0 +1,832 @@
+/*
+ * omp_bench.c -- Overheads of the OpenMP constructs, in the style of EPCC.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+// Every test repeats a construct around a short delay loop, as the EPCC
+// syncbench, schedbench and taskbench do, and reports the time per
+// repetition and the overhead over the delays alone. The number of
+// repetitions of a sample doubles until the sample takes the target time;
+// the statistics are over the samples.
+//
+// The settings that the runtime reads once at startup, the barrier patterns,
+// the lock kinds and the reduction methods, are compared in configurations:
+// every configuration runs in a process of its own with its environment
+// variables set, and the parent, which stays out of OpenMP, collects the
+// results and writes them as one JSON document (to stdout by default). Every
+// result has the lock kind that the runtime took; a configuration whose lock
+// kind the runtime replaced (adaptive or rtm without TSX) is not measured
+// and is listed as skipped.
+//
+// Usage: omp-bench [-t threads] [-r tests] [-n samples] [-T target_us]
+//                  [-d delay_us] [-o file] [-l]
+//   -t  comma separated thread counts, by default 1, 2, 4... and all
+//       processors
+//   -r  comma separated groups, tests or configurations to run, e.g.
+//       -r barrier,lock or -r task
+//   -n  samples per test (20), -T  time of a sample in us (1000)
+//   -d  length of the delay loop in us (0.1)
+//   -o  the JSON file
+//   -l  lists the tests and the configurations
+#include <errno.h>
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_THREAD_COUNTS 64
+#define MAX_SAMPLES 1000
+#define MAX_REPS (1L << 24)
+#define ITERS_PER_THREAD 128 // of a loop of the schedule tests
+#define DEPEND_SLOTS 64
+#define CHILD_SKIPPED 3 // exit status of a child that measured nothing
+#define LOCK_KIND_VAR "KMP_LOCK_KIND="
+
+typedef struct test {
+  const char *group;
+  const char *name;
+  void (*run)(long reps);
+  int delays; // in a repetition if the construct were free
+  int kind; // omp_sched_t of the schedule tests
+  int chunk;
+} test_t;
+
+typedef struct config {
+  const char *name;
+  const char *tests; // comma separated, NULL for all of them
+  const char *env[3];
+} config_t;
+
+static int nthreads;
+static long delay_length;
+static char lock_kind[32] = "unknown";
+static int sched_kind, sched_chunk;
+
+static void delay(long length) {
+  volatile double a = 0.0;
+  long i;
+  for (i = 0; i < length; i++)
+    a += i;
+  if (a < 0)
+    printf("%f\n", a);
+}
+
+// ---------------------------------------------------------------------------
+// syncbench
+
+static void test_parallel(long reps) {
+  long j;
+  for (j = 0; j < reps; j++) {
+#pragma omp parallel num_threads(nthreads)
+    delay(delay_length);
+  }
+}
+
+static void test_for(long reps) {
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    int i;
+    for (j = 0; j < reps; j++) {
+#pragma omp for
+      for (i = 0; i < nthreads; i++)
+        delay(delay_length);
+    }
+  }
+}
+
+static void test_parallel_for(long reps) {
+  long j;
+  int i;
+  for (j = 0; j < reps; j++) {
+#pragma omp parallel for num_threads(nthreads)
+    for (i = 0; i < nthreads; i++)
+      delay(delay_length);
+  }
+}
+
+static void test_barrier(long reps) {
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps; j++) {
+      delay(delay_length);
+#pragma omp barrier
+    }
+  }
+}
+
+static void test_single(long reps) {
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps; j++) {
+#pragma omp single
+      delay(delay_length);
+    }
+  }
+}
+
+static void test_copyprivate(long reps) {
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j, x = 0;
+    for (j = 0; j < reps; j++) {
+#pragma omp single copyprivate(x)
+      {
+        delay(delay_length);
+        x = j;
+      }
+    }
+    if (x != reps - 1)
+      printf("copyprivate failed\n");
+  }
+}
+
+// The threads share the repetitions of the mutual exclusion tests, so that
+// one repetition is one delay whatever the number of threads.
+static void test_critical(long reps) {
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps / nthreads; j++) {
+#pragma omp critical
+      delay(delay_length);
+    }
+  }
+}
+
+static void test_lock(long reps) {
+  omp_lock_t lock;
+  omp_init_lock(&lock);
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps / nthreads; j++) {
+      omp_set_lock(&lock);
+      delay(delay_length);
+      omp_unset_lock(&lock);
+    }
+  }
+  omp_destroy_lock(&lock);
+}
+
+static void test_nest_lock(long reps) {
+  omp_nest_lock_t lock;
+  omp_init_nest_lock(&lock);
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps / nthreads; j++) {
+      omp_set_nest_lock(&lock);
+      delay(delay_length);
+      omp_unset_nest_lock(&lock);
+    }
+  }
+  omp_destroy_nest_lock(&lock);
+}
+
+static void test_ordered(long reps) {
+  long j;
+#pragma omp parallel for ordered schedule(static, 1) num_threads(nthreads)
+  for (j = 0; j < reps; j++) {
+#pragma omp ordered
+    delay(delay_length);
+  }
+}
+
+static void test_reduction(long reps) {
+  long j;
+  for (j = 0; j < reps; j++) {
+    long sum = 0;
+#pragma omp parallel reduction(+ : sum) num_threads(nthreads)
+    {
+      delay(delay_length);
+      sum += 1;
+    }
+    if (sum != nthreads)
+      printf("reduction failed\n");
+  }
+}
+
+static void test_for_reduction(long reps) {
+  double sum = 0.0;
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    int i;
+    for (j = 0; j < reps; j++) {
+#pragma omp for reduction(+ : sum)
+      for (i = 0; i < nthreads; i++) {
+        delay(delay_length);
+        sum += 1.0;
+      }
+    }
+  }
+  if (sum != (double)reps * nthreads)
+    printf("reduction failed\n");
+}
+
+// The atomics have no delay, a repetition is one update.
+static void test_atomic(long reps) {
+  long x = 0;
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps / nthreads; j++) {
+#pragma omp atomic
+      x += 1;
+    }
+  }
+  if (x != reps / nthreads * nthreads)
+    printf("atomic failed\n");
+}
+
+static void test_atomic_double(long reps) {
+  double x = 0.0;
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps / nthreads; j++) {
+#pragma omp atomic
+      x += 1.0;
+    }
+  }
+  if (x != (double)(reps / nthreads * nthreads))
+    printf("atomic failed\n");
+}
+
+static void test_atomic_capture(long reps) {
+  long x = 0;
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j, v, last = -1;
+    for (j = 0; j < reps / nthreads; j++) {
+#pragma omp atomic capture
+      v = x++;
+      if (v <= last)
+        printf("atomic capture failed\n");
+      last = v;
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// schedbench
+
+static void test_schedule(long reps) {
+  omp_set_schedule((omp_sched_t)sched_kind, sched_chunk);
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    int i;
+    for (j = 0; j < reps; j++) {
+#pragma omp for schedule(monotonic : runtime)
+      for (i = 0; i < ITERS_PER_THREAD * nthreads; i++)
+        delay(delay_length);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// taskbench
+
+// Every thread spawns its tasks, executed by whichever thread.
+static void test_task_parallel(long reps) {
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps; j++) {
+#pragma omp task
+      delay(delay_length);
+    }
+  }
+}
+
+// One thread spawns the tasks of all, the others steal them.
+static void test_task_master(long reps) {
+#pragma omp parallel num_threads(nthreads)
+  {
+#pragma omp master
+    {
+      long j;
+      for (j = 0; j < reps * nthreads; j++) {
+#pragma omp task
+        delay(delay_length);
+      }
+    }
+  }
+}
+
+static void test_taskwait(long reps) {
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+    for (j = 0; j < reps; j++) {
+#pragma omp task
+      delay(delay_length);
+#pragma omp taskwait
+    }
+  }
+}
+
+// Every task depends on the one before, the tasks run one after the other.
+static void test_depend_chain(long reps) {
+  long x = 0;
+#pragma omp parallel num_threads(nthreads)
+#pragma omp single
+  {
+    long j;
+    for (j = 0; j < reps; j++) {
+#pragma omp task depend(inout : x) shared(x)
+      {
+        delay(delay_length);
+        x++;
+      }
+    }
+  }
+  if (x != reps)
+    printf("depend failed\n");
+}
+
+// The tasks only read the same variable, nothing orders them; the cost is
+// the bookkeeping of the dependences.
+static void test_depend_in(long reps) {
+  long x = 0;
+#pragma omp parallel num_threads(nthreads)
+#pragma omp single
+  {
+    long j;
+    for (j = 0; j < reps * nthreads; j++) {
+#pragma omp task depend(in : x) shared(x)
+      delay(delay_length + x);
+    }
+  }
+}
+
+// Rows of tasks, each reading two neighbours in the row before and writing
+// its own slot: the dependences of a stencil.
+static void test_depend_stencil(long reps) {
+  static long slots[2][DEPEND_SLOTS];
+  int width = nthreads < DEPEND_SLOTS - 2 ? nthreads : DEPEND_SLOTS - 2;
+#pragma omp parallel num_threads(nthreads)
+#pragma omp single
+  {
+    long j;
+    int i;
+    for (j = 0; j < reps * nthreads / width; j++) {
+      long *in = slots[(j + 1) % 2], *out = slots[j % 2];
+      for (i = 1; i <= width; i++) {
+#pragma omp task depend(in : in[i - 1], in[i + 1]) depend(out : out[i])
+        {
+          delay(delay_length);
+          out[i] = in[i - 1] + in[i + 1] + 1;
+        }
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+
+static const test_t tests[] = {
+    {"sync", "parallel", test_parallel, 1, 0, 0},
+    {"sync", "for", test_for, 1, 0, 0},
+    {"sync", "parallel_for", test_parallel_for, 1, 0, 0},
+    {"sync", "barrier", test_barrier, 1, 0, 0},
+    {"sync", "single", test_single, 1, 0, 0},
+    {"sync", "copyprivate", test_copyprivate, 1, 0, 0},
+    {"sync", "critical", test_critical, 1, 0, 0},
+    {"sync", "lock", test_lock, 1, 0, 0},
+    {"sync", "nest_lock", test_nest_lock, 1, 0, 0},
+    {"sync", "ordered", test_ordered, 1, 0, 0},
+    {"sync", "reduction", test_reduction, 1, 0, 0},
+    {"sync", "for_reduction", test_for_reduction, 1, 0, 0},
+    {"sync", "atomic", test_atomic, 0, 0, 0},
+    {"sync", "atomic_double", test_atomic_double, 0, 0, 0},
+    {"sync", "atomic_capture", test_atomic_capture, 0, 0, 0},
+    {"schedule", "static", test_schedule, ITERS_PER_THREAD, omp_sched_static,
+     0},
+    {"schedule", "static_1", test_schedule, ITERS_PER_THREAD,
+     omp_sched_static, 1},
+    {"schedule", "static_8", test_schedule, ITERS_PER_THREAD,
+     omp_sched_static, 8},
+    {"schedule", "static_64", test_schedule, ITERS_PER_THREAD,
+     omp_sched_static, 64},
+    {"schedule", "dynamic_1", test_schedule, ITERS_PER_THREAD,
+     omp_sched_dynamic, 1},
+    {"schedule", "dynamic_8", test_schedule, ITERS_PER_THREAD,
+     omp_sched_dynamic, 8},
+    {"schedule", "dynamic_64", test_schedule, ITERS_PER_THREAD,
+     omp_sched_dynamic, 64},
+    {"schedule", "guided_1", test_schedule, ITERS_PER_THREAD,
+     omp_sched_guided, 1},
+    {"schedule", "guided_8", test_schedule, ITERS_PER_THREAD,
+     omp_sched_guided, 8},
+    {"schedule", "guided_64", test_schedule, ITERS_PER_THREAD,
+     omp_sched_guided, 64},
+    {"schedule", "auto", test_schedule, ITERS_PER_THREAD, omp_sched_auto, 0},
+    {"task", "task_parallel", test_task_parallel, 1, 0, 0},
+    {"task", "task_master", test_task_master, 1, 0, 0},
+    {"task", "taskwait", test_taskwait, 1, 0, 0},
+    {"task", "depend_chain", test_depend_chain, 1, 0, 0},
+    {"task", "depend_in", test_depend_in, 1, 0, 0},
+    {"task", "depend_stencil", test_depend_stencil, 1, 0, 0},
+};
+
+#define NTESTS (int)(sizeof(tests) / sizeof(tests[0]))
+
+#define BARRIER_TESTS "parallel,barrier,reduction,for_reduction"
+#define BARRIER_PATTERN(p)                                                     \
+  {                                                                            \
+    "KMP_PLAIN_BARRIER_PATTERN=" p "," p,                                      \
+        "KMP_FORKJOIN_BARRIER_PATTERN=" p "," p,                               \
+        "KMP_REDUCTION_BARRIER_PATTERN=" p "," p                               \
+  }
+#define LOCK_TESTS "critical,lock,nest_lock"
+// KMP_FORCE_REDUCTION applies to __kmpc_reduce(); code compiled by gcc does
+// its reductions without the runtime and runs the same in all three.
+#define REDUCTION_TESTS "reduction,for_reduction"
+
+// The first configuration runs everything with the defaults, the others the
+// tests that their settings change.
+static const config_t configs[] = {
+    {"default", NULL, {NULL}},
+    {"barrier_linear", BARRIER_TESTS, BARRIER_PATTERN("linear")},
+    {"barrier_tree", BARRIER_TESTS, BARRIER_PATTERN("tree")},
+    {"barrier_hyper", BARRIER_TESTS, BARRIER_PATTERN("hyper")},
+    {"barrier_hierarchical", BARRIER_TESTS, BARRIER_PATTERN("hierarchical")},
+    {"lock_tas", LOCK_TESTS, {"KMP_LOCK_KIND=tas"}},
+#if defined(__linux__)
+    {"lock_futex", LOCK_TESTS, {"KMP_LOCK_KIND=futex"}},
+#endif
+    {"lock_ticket", LOCK_TESTS, {"KMP_LOCK_KIND=ticket"}},
+    {"lock_queuing", LOCK_TESTS, {"KMP_LOCK_KIND=queuing"}},
+    {"lock_drdpa", LOCK_TESTS, {"KMP_LOCK_KIND=drdpa"}},
+    {"lock_autotune", LOCK_TESTS, {"KMP_LOCK_KIND=autotune"}},
+#if defined(__x86_64__) || defined(__i386__)
+    // Without TSX the runtime warns and falls back to another kind; these
+    // are skipped then.
+    {"lock_adaptive", LOCK_TESTS, {"KMP_LOCK_KIND=adaptive"}},
+    {"lock_hle", LOCK_TESTS, {"KMP_LOCK_KIND=hle"}},
+    {"lock_rtm", LOCK_TESTS, {"KMP_LOCK_KIND=rtm"}},
+#endif
+    {"reduction_critical", REDUCTION_TESTS, {"KMP_FORCE_REDUCTION=critical"}},
+    {"reduction_atomic", REDUCTION_TESTS, {"KMP_FORCE_REDUCTION=atomic"}},
+    {"reduction_tree", REDUCTION_TESTS, {"KMP_FORCE_REDUCTION=tree"}},
+};
+
+#define NCONFIGS (int)(sizeof(configs) / sizeof(configs[0]))
+
+static int thread_counts[MAX_THREAD_COUNTS];
+static int nthread_counts = 0;
+static const char *selection = NULL;
+static int nsamples = 20;
+static double target_us = 1000.0;
+static double delay_us = 0.1;
+
+static int in_list(const char *list, const char *name) {
+  size_t len = strlen(name);
+  const char *s = list;
+  while (s != NULL && *s != '\0') {
+    if (strncmp(s, name, len) == 0 && (s[len] == ',' || s[len] == '\0'))
+      return 1;
+    s = strchr(s, ',');
+    if (s != NULL)
+      s++;
+  }
+  return 0;
+}
+
+static int selected(const config_t *config, const test_t *test) {
+  if (config->tests != NULL && !in_list(config->tests, test->name))
+    return 0;
+  return selection == NULL || in_list(selection, test->group) ||
+         in_list(selection, test->name) || in_list(selection, config->name);
+}
+
+// ---------------------------------------------------------------------------
+// The child: runs the tests of one configuration, a JSON object per line.
+
+static double sample(const test_t *test, long reps) {
+  double start = omp_get_wtime();
+  test->run(reps);
+  return omp_get_wtime() - start;
+}
+
+static void measure(FILE *out, const config_t *config, const test_t *test,
+                    double delay_time) {
+  double times[MAX_SAMPLES], mean = 0.0, sd = 0.0, min, max;
+  long reps = nthreads;
+  int i;
+
+  sched_kind = test->kind;
+  sched_chunk = test->chunk;
+  // Warms up the threads, then finds the repetitions of a sample.
+  sample(test, reps);
+  while (reps < MAX_REPS && sample(test, reps) * 1e6 < target_us)
+    reps *= 2;
+  for (i = 0; i < nsamples; i++) {
+    times[i] = sample(test, reps) / reps * 1e6;
+    mean += times[i];
+  }
+  mean /= nsamples;
+  min = max = mean;
+  for (i = 0; i < nsamples; i++) {
+    sd += (times[i] - mean) * (times[i] - mean);
+    if (times[i] < min)
+      min = times[i];
+    if (times[i] > max)
+      max = times[i];
+  }
+  sd = nsamples > 1 ? sqrt(sd / (nsamples - 1)) : 0.0;
+
+  fprintf(out,
+          "{\"group\": \"%s\", \"test\": \"%s\", \"config\": \"%s\", "
+          "\"threads\": %d, \"reps\": %ld, \"mean_us\": %.4f, "
+          "\"min_us\": %.4f, \"max_us\": %.4f, \"sd_us\": %.4f, "
+          "\"overhead_us\": %.4f, \"lock_kind\": \"%s\"}\n",
+          test->group, test->name, config->name, nthreads, reps, mean, min,
+          max, sd, mean - test->delays * delay_time * 1e6, lock_kind);
+  fflush(out);
+  fprintf(stderr, "omp-bench: %-20s %-16s %4d threads %12.4f us\n",
+          config->name, test->name, nthreads, mean);
+}
+
+// Starts the runtime with KMP_SETTINGS and takes the lock kind from the
+// effective settings, which follow the ones of the user. The rest of what the
+// runtime printed, its warnings, goes to stderr.
+static void get_lock_kind(void) {
+  char line[1024], *s;
+  FILE *tmp = tmpfile();
+  int saved = dup(2);
+
+  if (tmp == NULL || saved < 0)
+    return;
+  setenv("KMP_SETTINGS", "true", 1);
+  fflush(stderr);
+  dup2(fileno(tmp), 2);
+  omp_get_max_threads();
+  fflush(stderr);
+  dup2(saved, 2);
+  close(saved);
+  rewind(tmp);
+  while (fgets(line, sizeof(line), tmp) != NULL) {
+    if ((s = strstr(line, LOCK_KIND_VAR)) != NULL) {
+      s += strlen(LOCK_KIND_VAR);
+      s[strcspn(s, "'\" \n")] = '\0';
+      snprintf(lock_kind, sizeof(lock_kind), "%s", s);
+    } else if (strncmp(line, "OMP:", 4) == 0) {
+      fputs(line, stderr);
+    }
+  }
+  fclose(tmp);
+}
+
+static int child(int fd, int c) {
+  const config_t *config = &configs[c];
+  FILE *out = fdopen(fd, "w");
+  double start, delay_time;
+  int i, t;
+
+  if (out == NULL)
+    return 1;
+  get_lock_kind();
+  for (i = 0; i < 3 && config->env[i] != NULL; i++) {
+    const char *env = config->env[i];
+    if (strncmp(env, LOCK_KIND_VAR, strlen(LOCK_KIND_VAR)) == 0 &&
+        strcmp(env + strlen(LOCK_KIND_VAR), lock_kind) != 0) {
+      fprintf(stderr, "omp-bench: %s: the runtime uses %s locks, skipped\n",
+              config->name, lock_kind);
+      fclose(out);
+      return CHILD_SKIPPED;
+    }
+  }
+  // The length of the delay loop that takes delay_us.
+  delay_length = 1000;
+  do {
+    delay_length *= 2;
+    start = omp_get_wtime();
+    delay(delay_length);
+  } while (omp_get_wtime() - start < 0.01);
+  delay_length = (long)(delay_length * delay_us * 1e-6 /
+                        (omp_get_wtime() - start));
+  if (delay_length < 1)
+    delay_length = 1;
+  start = omp_get_wtime();
+  for (i = 0; i < 10000; i++)
+    delay(delay_length);
+  delay_time = (omp_get_wtime() - start) / 10000;
+
+  for (t = 0; t < nthread_counts; t++) {
+    nthreads = thread_counts[t];
+    for (i = 0; i < NTESTS; i++) {
+      if (selected(config, &tests[i]))
+        measure(out, config, &tests[i], delay_time);
+    }
+  }
+  fclose(out);
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// The parent: starts a child per configuration and collects the results.
+
+// Returns 0 if the configuration ran or had nothing to run, CHILD_SKIPPED if
+// the child skipped it and 1 if it failed.
+static int run_config(FILE *out, int argc, char **argv, int c,
+                      int *nresults) {
+  const config_t *config = &configs[c];
+  char line[1024], fd_arg[16], config_arg[16];
+  char *args[256];
+  int fds[2], status, i;
+  FILE *in;
+  pid_t pid;
+
+  for (i = 0; i < NTESTS; i++) {
+    if (selected(config, &tests[i]))
+      break;
+  }
+  if (i == NTESTS)
+    return 0;
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    return 1;
+  }
+  pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    return 1;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    for (i = 0; i < 3 && config->env[i] != NULL; i++)
+      putenv((char *)config->env[i]);
+    snprintf(config_arg, sizeof(config_arg), "%d", c);
+    snprintf(fd_arg, sizeof(fd_arg), "%d", fds[1]);
+    // omp-bench -child config fd, then the options of the parent.
+    args[0] = argv[0];
+    args[1] = (char *)"-child";
+    args[2] = config_arg;
+    args[3] = fd_arg;
+    for (i = 1; i < argc && i < 252; i++)
+      args[i + 3] = argv[i];
+    args[i + 3] = NULL;
+    execv("/proc/self/exe", args);
+    perror("execv");
+    _exit(1);
+  }
+  close(fds[1]);
+  in = fdopen(fds[0], "r");
+  while (in != NULL && fgets(line, sizeof(line), in) != NULL) {
+    line[strcspn(line, "\n")] = '\0';
+    fprintf(out, "%s\n    %s", *nresults ? "," : "", line);
+    (*nresults)++;
+  }
+  if (in != NULL)
+    fclose(in);
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+      (WEXITSTATUS(status) != 0 && WEXITSTATUS(status) != CHILD_SKIPPED)) {
+    fprintf(stderr, "omp-bench: configuration %s failed\n", config->name);
+    return 1;
+  }
+  return WEXITSTATUS(status);
+}
+
+// Adds "name" to the comma separated JSON strings of list, if it fits.
+static void add_name(char *list, size_t size, const char *name) {
+  size_t len = strlen(list);
+  if (len + strlen(name) + 4 < size)
+    snprintf(list + len, size - len, "%s\"%s\"", len ? ", " : "", name);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: omp-bench [-t threads] [-r tests] [-n samples] "
+                  "[-T target_us] [-d delay_us] [-o file] [-l]\n");
+  exit(2);
+}
+
+static void list(void) {
+  int c, i;
+  for (c = 0; c < NCONFIGS; c++) {
+    printf("%s:", configs[c].name);
+    for (i = 0; i < 3 && configs[c].env[i] != NULL; i++)
+      printf(" %s", configs[c].env[i]);
+    printf("\n");
+    for (i = 0; i < NTESTS; i++) {
+      if (configs[c].tests == NULL || in_list(configs[c].tests, tests[i].name))
+        printf("  %s %s\n", tests[i].group, tests[i].name);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *output = NULL;
+  char *threads = NULL;
+  char failed[1024] = "", skipped[1024] = "";
+  FILE *out = stdout;
+  int nresults = 0, is_child = 0, fd = -1, config = 0;
+  int opt, c, t;
+  long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+
+  // A child is started as: omp-bench -child config fd <options>
+  if (argc > 3 && strcmp(argv[1], "-child") == 0) {
+    is_child = 1;
+    config = atoi(argv[2]);
+    fd = atoi(argv[3]);
+    argv[3] = argv[0];
+    argv += 3;
+    argc -= 3;
+  }
+  while ((opt = getopt(argc, argv, "t:r:n:T:d:o:l")) != -1) {
+    switch (opt) {
+    case 't':
+      threads = optarg;
+      break;
+    case 'r':
+      selection = optarg;
+      break;
+    case 'n':
+      nsamples = atoi(optarg);
+      break;
+    case 'T':
+      target_us = atof(optarg);
+      break;
+    case 'd':
+      delay_us = atof(optarg);
+      break;
+    case 'o':
+      output = optarg;
+      break;
+    case 'l':
+      list();
+      return 0;
+    default:
+      usage();
+    }
+  }
+  if (optind < argc || nsamples < 1 || nsamples > MAX_SAMPLES ||
+      target_us <= 0 || delay_us < 0)
+    usage();
+  if (threads != NULL) {
+    char *s = threads;
+    while (*s != '\0' && nthread_counts < MAX_THREAD_COUNTS) {
+      int n = (int)strtol(s, &s, 10);
+      if (n < 1 || (*s != ',' && *s != '\0'))
+        usage();
+      thread_counts[nthread_counts++] = n;
+      if (*s == ',')
+        s++;
+    }
+  } else {
+    if (nprocs < 1)
+      nprocs = 1;
+    for (t = 1; t < nprocs && nthread_counts < MAX_THREAD_COUNTS - 1; t *= 2)
+      thread_counts[nthread_counts++] = t;
+    thread_counts[nthread_counts++] = (int)nprocs;
+  }
+  if (is_child)
+    return child(fd, config);
+
+  if (output != NULL) {
+    out = fopen(output, "w");
+    if (out == NULL) {
+      fprintf(stderr, "omp-bench: %s: %s\n", output, strerror(errno));
+      return 1;
+    }
+  }
+  fprintf(out, "{\n  \"benchmark\": \"omp-bench\",\n  \"version\": 1,\n");
+  fprintf(out, "  \"processors\": %ld,\n  \"threads\": [", nprocs);
+  for (t = 0; t < nthread_counts; t++)
+    fprintf(out, "%s%d", t ? ", " : "", thread_counts[t]);
+  fprintf(out, "],\n  \"samples\": %d,\n  \"target_us\": %g,\n"
+               "  \"delay_us\": %g,\n  \"results\": [",
+          nsamples, target_us, delay_us);
+  fflush(out);
+  for (c = 0; c < NCONFIGS; c++) {
+    int rc = run_config(out, argc, argv, c, &nresults);
+    if (rc == CHILD_SKIPPED)
+      add_name(skipped, sizeof(skipped), configs[c].name);
+    else if (rc != 0)
+      add_name(failed, sizeof(failed), configs[c].name);
+    fflush(out);
+  }
+  fprintf(out, "\n  ],\n  \"skipped\": [%s],\n  \"failed\": [%s]\n}\n",
+          skipped, failed);
+  if (out != stdout)
+    fclose(out);
+  return failed[0] != '\0';
+}
@@ -0,0 +1,139 @@
+/*
+ * startup.c -- Cost of runtime initialization in a short-lived process.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+// Starts itself the given number of times and, in every child, measures the
+// first call to omp_get_num_threads() (serial initialization), the first call
+// to omp_get_max_threads() (middle initialization: topology and affinity), the
+// first parallel region (thread creation) and a second parallel region. The
+// best and the median of the runs are reported. Compare the default settings
+// against bound threads, e.g. OMP_PROC_BIND=spread, which need the topology.
+// Usage: startup [runs [threads]]
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_RUNS 1000
+#define MAX_THREADS 1024
+#define NTIMES 4
+
+static const char *names[NTIMES] = {"num_threads", "max_threads",
+                                    "1st parallel", "2nd parallel"};
+
+// Keeps the compiler from removing the otherwise empty parallel regions
+static long visits[MAX_THREADS];
+
+static double now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Runs in a fresh process, so that the runtime is not initialized yet
+static int child(int fd, int nthreads) {
+  double t[NTIMES], start;
+
+  start = now();
+  if (omp_get_num_threads() != 1)
+    return 1;
+  t[0] = now() - start;
+
+  start = now();
+  if (nthreads <= 0)
+    nthreads = omp_get_max_threads();
+  else
+    omp_get_max_threads();
+  t[1] = now() - start;
+  if (nthreads > MAX_THREADS)
+    nthreads = MAX_THREADS;
+
+  start = now();
+#pragma omp parallel num_threads(nthreads)
+  visits[omp_get_thread_num()]++;
+  t[2] = now() - start;
+
+  start = now();
+#pragma omp parallel num_threads(nthreads)
+  visits[omp_get_thread_num()]++;
+  t[3] = now() - start;
+
+  return write(fd, t, sizeof(t)) != sizeof(t);
+}
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv) {
+  static double times[NTIMES][MAX_RUNS];
+  int runs, nthreads, run, i;
+  char fd_arg[16], nth_arg[16];
+
+  if (argc > 3 && strcmp(argv[1], "-child") == 0)
+    return child(atoi(argv[2]), atoi(argv[3]));
+
+  runs = argc > 1 ? atoi(argv[1]) : 20;
+  nthreads = argc > 2 ? atoi(argv[2]) : 0;
+  if (runs < 1)
+    runs = 1;
+  if (runs > MAX_RUNS)
+    runs = MAX_RUNS;
+
+  for (run = 0; run < runs; run++) {
+    double t[NTIMES];
+    int fds[2], status;
+    pid_t pid;
+
+    if (pipe(fds) != 0) {
+      perror("pipe");
+      return 1;
+    }
+    pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (pid == 0) {
+      close(fds[0]);
+      snprintf(fd_arg, sizeof(fd_arg), "%d", fds[1]);
+      snprintf(nth_arg, sizeof(nth_arg), "%d", nthreads);
+      execl("/proc/self/exe", argv[0], "-child", fd_arg, nth_arg,
+            (char *)NULL);
+      perror("execl");
+      _exit(1);
+    }
+    close(fds[1]);
+    if (read(fds[0], t, sizeof(t)) != sizeof(t)) {
+      fprintf(stderr, "run %d failed\n", run);
+      return 1;
+    }
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+    for (i = 0; i < NTIMES; i++)
+      times[i][run] = t[i];
+  }
+
+  printf("%14s %12s %12s\n", "first call", "best us", "median us");
+  for (i = 0; i < NTIMES; i++) {
+    qsort(times[i], runs, sizeof(double), cmp_double);
+    printf("%14s %12.1f %12.1f\n", names[i], times[i][0] * 1e6,
+           times[i][runs / 2] * 1e6);
+  }
+  return 0;
+}
@@ -84,6 +84,9 @@
 #if KMP_STATS_ENABLED
 class kmp_stats_list;
 #endif
+struct kmp_trace_buffer;
+struct kmp_cp_graph;
+struct kmp_cp_node;
 
 #if KMP_USE_HWLOC && KMP_AFFINITY_SUPPORTED
 #include "hwloc.h"
@@ -589,6 +592,7 @@ extern size_t __kmp_affin_mask_size;
 #define KMP_CPU_AND(dest, src) (dest)->bitwise_and(src)
 #define KMP_CPU_COMPLEMENT(max_bit_number, mask) (mask)->bitwise_not()
 #define KMP_CPU_UNION(dest, src) (dest)->bitwise_or(src)
+#define KMP_CPU_COUNT(mask) (mask)->count()
 #define KMP_CPU_ALLOC(ptr) (ptr = __kmp_affinity_dispatch->allocate_mask())
 #define KMP_CPU_FREE(ptr) __kmp_affinity_dispatch->deallocate_mask(ptr)
 #define KMP_CPU_ALLOC_ON_STACK(ptr) KMP_CPU_ALLOC(ptr)
@@ -633,6 +637,13 @@ public:
     virtual void bitwise_or(const Mask *rhs) {}
     // this = ~this
     virtual void bitwise_not() {}
+    // Number of bits set
+    virtual int count() const {
+      int retval = 0;
+      for (int i = begin(); i != end(); i = next(i))
+        ++retval;
+      return retval;
+    }
     // API for iterating over an affinity mask
     // for (int i = mask->begin(); i != mask->end(); i = mask->next(i))
     virtual int begin() const { return 0; }
@@ -718,6 +729,9 @@ enum affinity_top_method {
   affinity_top_method_x2apicid,
 #endif /* KMP_ARCH_X86 || KMP_ARCH_X86_64 */
   affinity_top_method_cpuinfo, // KMP_CPUINFO_FILE is usable on Windows* OS, too
+#if KMP_OS_LINUX
+  affinity_top_method_sysfs, // KMP_SYSFS_ROOT selects an alternate tree
+#endif /* KMP_OS_LINUX */
 #if KMP_GROUP_AFFINITY
   affinity_top_method_group,
 #endif /* KMP_GROUP_AFFINITY */
@@ -743,10 +757,19 @@ extern int __kmp_affinity_respect_mask; // Respect process' init affinity mask?
 extern char *__kmp_affinity_proclist; /* proc ID list */
 extern kmp_affin_mask_t *__kmp_affinity_masks;
 extern unsigned __kmp_affinity_num_masks;
+#if OMP_40_ENABLED
+// OS proc ids of the places: place p has the procs __kmp_affinity_place_ids[k]
+// for __kmp_affinity_place_first[p] <= k < __kmp_affinity_place_first[p + 1].
+extern int *__kmp_affinity_place_first;
+extern int *__kmp_affinity_place_ids;
+#endif
 extern void __kmp_affinity_bind_thread(int which);
 
 extern kmp_affin_mask_t *__kmp_affin_fullMask;
 extern char const *__kmp_cpuinfo_file;
+#if KMP_OS_LINUX
+extern char const *__kmp_sysfs_root;
+#endif
 
 #endif /* KMP_AFFINITY_SUPPORTED */
 
@@ -770,6 +793,8 @@ typedef struct kmp_nested_proc_bind_t {
 } kmp_nested_proc_bind_t;
 
 extern kmp_nested_proc_bind_t __kmp_nested_proc_bind;
+extern int __kmp_place_partition_first; /* initial place partition of roots */
+extern int __kmp_place_partition_last;
 
 #endif /* OMP_40_ENABLED */
 
@@ -808,6 +833,95 @@ extern int __kmp_hws_abs_flag; // absolute or per-item number requested
 extern char const *__kmp_tool_libraries;
 #endif // OMP_50_ENABLED && LIBOMP_OMPT_SUPPORT
 
+#if OMP_50_ENABLED
+// OpenMP 5.0 memory management. The types duplicate the ones from omp.h, which
+// only a few of the runtime sources include.
+#ifndef __OMP_H
+typedef uintptr_t omp_uintptr_t;
+
+typedef enum omp_alloctrait_key_t {
+  omp_atk_sync_hint = 1,
+  omp_atk_alignment = 2,
+  omp_atk_access = 3,
+  omp_atk_pool_size = 4,
+  omp_atk_fallback = 5,
+  omp_atk_fb_data = 6,
+  omp_atk_pinned = 7,
+  omp_atk_partition = 8
+} omp_alloctrait_key_t;
+
+typedef enum omp_alloctrait_value_t {
+  omp_atv_false = 0,
+  omp_atv_true = 1,
+  omp_atv_default = 2,
+  omp_atv_contended = 3,
+  omp_atv_uncontended = 4,
+  omp_atv_sequential = 5,
+  omp_atv_private = 6,
+  omp_atv_all = 7,
+  omp_atv_thread = 8,
+  omp_atv_pteam = 9,
+  omp_atv_cgroup = 10,
+  omp_atv_default_mem_fb = 11,
+  omp_atv_null_fb = 12,
+  omp_atv_abort_fb = 13,
+  omp_atv_allocator_fb = 14,
+  omp_atv_environment = 15,
+  omp_atv_nearest = 16,
+  omp_atv_blocked = 17,
+  omp_atv_interleaved = 18
+} omp_alloctrait_value_t;
+
+typedef struct omp_alloctrait_t {
+  omp_alloctrait_key_t key;
+  omp_uintptr_t value;
+} omp_alloctrait_t;
+
+typedef enum omp_memspace_handle_t {
+  omp_default_mem_space = 0,
+  omp_large_cap_mem_space = 1,
+  omp_const_mem_space = 2,
+  omp_high_bw_mem_space = 3,
+  omp_low_lat_mem_space = 4
+} omp_memspace_handle_t;
+
+typedef enum omp_allocator_handle_t {
+  omp_null_allocator = 0,
+  omp_default_mem_alloc = 1,
+  omp_large_cap_mem_alloc = 2,
+  omp_const_mem_alloc = 3,
+  omp_high_bw_mem_alloc = 4,
+  omp_low_lat_mem_alloc = 5,
+  omp_cgroup_mem_alloc = 6,
+  omp_pteam_mem_alloc = 7,
+  omp_thread_mem_alloc = 8,
+  kmp_interleaved_mem_alloc = 100,
+  kmp_numa_local_mem_alloc = 101,
+  KMP_ALLOCATOR_MAX_HANDLE = UINTPTR_MAX
+} omp_allocator_handle_t;
+#endif // __OMP_H
+
+// Handles above this value point to a kmp_allocator_t made by
+// omp_init_allocator(), the others name predefined allocators.
+#define KMP_MAX_PREDEFINED_ALLOCATOR ((omp_uintptr_t)1024)
+// The most omp_atv_allocator_fb fallbacks an allocation follows; a chain
+// through the handle of a destroyed allocator may loop.
+#define KMP_MAX_ALLOCATOR_FALLBACKS 16
+
+typedef struct kmp_allocator_t {
+  omp_memspace_handle_t memspace;
+  size_t alignment; // minimal alignment of the returned memory, 0 if default
+  omp_alloctrait_value_t fb; // what to do when an allocation fails
+  omp_allocator_handle_t fb_data; // allocator used by omp_atv_allocator_fb
+  kmp_uint64 pool_size; // bytes the allocator may hand out, 0 if unlimited
+  volatile kmp_int64 pool_used; // bytes currently allocated from the pool
+  omp_alloctrait_value_t partition; // placement of the pages on NUMA nodes
+  int pinned; // lock the pages in memory
+} kmp_allocator_t;
+
+extern omp_allocator_handle_t __kmp_def_allocator;
+#endif // OMP_50_ENABLED
+
 /* ------------------------------------------------------------------------ */
 
 #define KMP_PAD(type, sz)                                                      \
@@ -906,6 +1020,12 @@ extern char const *__kmp_tool_libraries;
   (INT_MAX) /* Must be this for "infinite" setting the work */
 #define KMP_DEFAULT_BLOCKTIME (200) /*  __kmp_blocktime is in milliseconds  */
 
+#if KMP_OS_LINUX
+/* Milliseconds between two samples of the system load */
+#define KMP_DEFAULT_OVERSUB_CHECK (0) /* off */
+#define KMP_MAX_OVERSUB_CHECK (60000)
+#endif
+
 #if KMP_USE_MONITOR
 #define KMP_DEFAULT_MONITOR_STKSIZE ((size_t)(64 * 1024))
 #define KMP_MIN_MONITOR_WAKEUPS (1) // min times monitor wakes up per second
@@ -1191,6 +1311,7 @@ typedef struct kmp_cpuinfo {
   // Model << 4 ) + Model)
   int stepping; // CPUID(1).EAX[3:0] ( Stepping )
   int sse2; // 0 if SSE2 instructions are not supported, 1 otherwise.
+  int cx16; // 0 if CMPXCHG16B is not supported, 1 otherwise.
   int rtm; // 0 if RTM instructions are not supported, 1 otherwise.
   int cpu_stackoffset;
   int apic_id;
@@ -1958,6 +2079,7 @@ typedef struct kmp_local {
 #if KMP_USE_BGET
   void *bget_data;
   void *bget_list;
+  void *sc_heap; /* size class heap, if __kmp_malloc_kind is sizeclass */
 #if !USE_CMP_XCHG_FOR_BGET
 #ifdef USE_QUEUING_LOCK_FOR_BGET
   kmp_lock_t bget_lock; /* Lock for accessing bget free list */
@@ -2165,6 +2287,8 @@ typedef struct kmp_base_depnode {
 
   volatile kmp_int32 npredecessors;
   volatile kmp_int32 nrefs;
+
+  struct kmp_cp_node *cp; // KMP_CRITICAL_PATH only, under the lock
 } kmp_base_depnode_t;
 
 union KMP_ALIGN_CACHE kmp_depnode {
@@ -2284,6 +2408,8 @@ struct kmp_taskdata { /* aligned during dynamic allocation       */
   kmp_task_team_t *td_task_team;
   kmp_int32 td_size_alloc; // The size of task structure, including shareds etc.
 #endif
+  struct kmp_cp_graph *td_cp_graph; // Critical path analysis of the children
+  kmp_uint64 td_cp_time; // Execution time, for the critical path analysis
 }; // struct kmp_taskdata
 
 // Make sure padding above worked
@@ -2381,6 +2507,78 @@ typedef struct kmp_teams_size {
 } kmp_teams_size_t;
 #endif
 
+// Cumulative counters of a thread, read by kmp_get_perf_counters() while the
+// thread runs. The times are in KMP_PERF_NOW() units and converted to
+// nanoseconds by the reader. The layout matches kmp_perf_counters_t of omp.h.
+typedef struct kmp_perf {
+  kmp_uint64 forks; // parallel regions forked as their master
+  kmp_uint64 joins;
+  kmp_uint64 barriers; // explicit, implicit and join barriers
+  kmp_uint64 barrier_time; // only with KMP_PERF_WAIT_TIMING
+  kmp_uint64 spin_time; // waiting without sleeping, including tasks run then
+  kmp_uint64 sleep_time; // suspended in __kmp_wait_template
+  kmp_uint64 sleeps;
+  kmp_uint64 tasks_executed;
+  kmp_uint64 tasks_stolen;
+  kmp_uint64 tasks_inlined; // undeferred, or run at once as the deque is full
+  kmp_uint64 dispatch_chunks; // chunks of dynamically scheduled loops
+  kmp_uint64 lock_acquires; // critical sections and user locks
+  kmp_uint64 lock_wait_time; // only with KMP_PERF_LOCK_TIMING
+} kmp_perf_t;
+
+#if KMP_OS_UNIX && (KMP_ARCH_X86 || KMP_ARCH_X86_64)
+extern kmp_uint64 __kmp_ticks_per_msec;
+#define KMP_PERF_NOW() __kmp_hardware_timestamp()
+#else
+extern kmp_uint64 __kmp_now_nsec();
+#define KMP_PERF_NOW() __kmp_now_nsec()
+#endif
+
+// A thread keeps its counters in th_perf, indexed like the fields of
+// kmp_perf_t. Only the thread itself updates them, so a relaxed load and store
+// are enough and no read-modify-write is needed; the reader loads them relaxed
+// too and never sees a value half updated.
+#ifdef _MSC_VER
+// MSVC won't allow use of std::atomic<> in a union, see kmp_lock.h.
+typedef std::atomic_ullong kmp_perf_counter_t;
+#else
+typedef std::atomic<kmp_uint64> kmp_perf_counter_t;
+#endif
+#define KMP_PERF_NUM_COUNTERS (sizeof(kmp_perf_t) / sizeof(kmp_uint64))
+#define KMP_PERF_COUNTER(thr, counter)                                         \
+  ((thr)->th.th_perf[offsetof(kmp_perf_t, counter) / sizeof(kmp_uint64)])
+
+static inline void __kmp_perf_bump(kmp_perf_counter_t *counter,
+                                   kmp_uint64 value) {
+  counter->store(counter->load(std::memory_order_relaxed) + value,
+                 std::memory_order_relaxed);
+}
+
+#define KMP_PERF_INC(thr, counter)                                             \
+  __kmp_perf_bump(&KMP_PERF_COUNTER(thr, counter), 1)
+#define KMP_PERF_ADD(thr, counter, value)                                      \
+  __kmp_perf_bump(&KMP_PERF_COUNTER(thr, counter), (value))
+// Two timestamps would double the cost of an uncontended lock, so the wait is
+// only timed if KMP_PERF_LOCK_TIMING is set; the acquisitions are always
+// counted.
+#define KMP_PERF_LOCK_BEGIN(start)                                             \
+  kmp_uint64 start = __kmp_perf_lock_timing ? KMP_PERF_NOW() : 0
+#define KMP_PERF_LOCK_END(thr, start)                                          \
+  do {                                                                         \
+    KMP_PERF_INC(thr, lock_acquires);                                          \
+    if (__kmp_perf_lock_timing)                                                \
+      KMP_PERF_ADD(thr, lock_wait_time, KMP_PERF_NOW() - (start));             \
+  } while (0)
+// The same for the barrier, spin and sleep times, with KMP_PERF_WAIT_TIMING;
+// the barriers and sleeps are always counted.
+#define KMP_PERF_WAIT_BEGIN(start)                                             \
+  kmp_uint64 start = __kmp_perf_wait_timing ? KMP_PERF_NOW() : 0
+#define KMP_PERF_WAIT_END(thr, counter, start)                                 \
+  do {                                                                         \
+    if (__kmp_perf_wait_timing)                                                \
+      KMP_PERF_ADD(thr, counter, KMP_PERF_NOW() - (start));                    \
+  } while (0)
+
 // OpenMP thread data structures
 
 typedef struct KMP_ALIGN_CACHE kmp_base_info {
@@ -2393,6 +2591,8 @@ typedef struct KMP_ALIGN_CACHE kmp_base_info {
   kmp_info_p *th_next_pool; /* next available thread in the pool */
   kmp_disp_t *th_dispatch; /* thread's dispatch data */
   int th_in_pool; /* in thread pool (32 bits for TCR/TCW) */
+  int th_spawn_pending; /* allocated, but its OS thread not created yet */
+  kmp_info_p *th_spawn[2]; /* threads it creates as it starts */
 
   /* The following are cached from the team info structure */
   /* TODO use these in more places as determined to be needed via profiling */
@@ -2418,6 +2618,9 @@ typedef struct KMP_ALIGN_CACHE kmp_base_info {
 
 #if KMP_AFFINITY_SUPPORTED
   kmp_affin_mask_t *th_affin_mask; /* thread's current affinity mask */
+#if KMP_OS_LINUX
+  int th_numa_node; /* node the thread's structures live on, -1 if unknown */
+#endif
 #endif
 
   /* The data set by the master at reinit, then R/W by the worker */
@@ -2438,6 +2641,9 @@ typedef struct KMP_ALIGN_CACHE kmp_base_info {
   int th_last_place; /* last place in partition */
 #endif
 #endif
+#if OMP_50_ENABLED
+  omp_allocator_handle_t th_def_allocator; /* omp_null_allocator until set */
+#endif
 #if USE_ITT_BUILD
   kmp_uint64 th_bar_arrive_time; /* arrival to barrier timestamp */
   kmp_uint64 th_bar_min_time; /* minimum arrival time at the barrier */
@@ -2515,6 +2721,9 @@ typedef struct KMP_ALIGN_CACHE kmp_base_info {
 #if KMP_STATS_ENABLED
   kmp_stats_list *th_stats;
 #endif
+  struct kmp_trace_buffer *th_trace; // allocated by the first traced event
+  kmp_perf_counter_t th_perf[KMP_PERF_NUM_COUNTERS];
+  struct kmp_hw_thread *th_hw_counters; // opened by the first region counted
 } kmp_base_info_t;
 
 typedef union KMP_ALIGN_CACHE kmp_info {
@@ -2698,6 +2907,7 @@ typedef struct kmp_base_root {
   volatile int r_begin;
   int r_blocktime; /* blocktime for this root and descendants */
   int r_cg_nthreads; // count of active threads in a contention group
+  int r_partition_procs; // procs in the root's place partition, 0 if unknown
 } kmp_base_root_t;
 
 typedef union KMP_ALIGN_CACHE kmp_root {
@@ -2842,6 +3052,29 @@ extern int __kmp_stkpadding; /* Should we pad root thread(s) stack */
 
 extern size_t
     __kmp_malloc_pool_incr; /* incremental size of pool for kmp_malloc() */
+#if KMP_USE_BGET
+// Allocator behind kmpc_malloc() and the thread-private runtime allocations
+typedef enum kmp_malloc_kind {
+  kmp_malloc_bget, // bget pools of the allocating thread
+  kmp_malloc_sizeclass // per-thread size class caches over shared spans
+} kmp_malloc_kind_t;
+extern kmp_malloc_kind_t __kmp_malloc_kind;
+#endif
+#if KMP_OS_LINUX
+// Pages backing the internal arena of __kmp_allocate()
+typedef enum kmp_huge_pages {
+  kmp_huge_pages_disabled, // no arena, blocks come from malloc()
+  kmp_huge_pages_transparent, // transparent huge pages, madvise(MADV_HUGEPAGE)
+  kmp_huge_pages_explicit // hugetlbfs pages, transparent ones if none is left
+} kmp_huge_pages_t;
+extern kmp_huge_pages_t __kmp_huge_pages;
+extern int __kmp_huge_pages_stats; /* report arena usage at shutdown */
+extern int __kmp_numa_local_threads; /* move thread structures to its node */
+extern int __kmp_oversub_check; /* ms between system load samples, 0 = off */
+extern volatile int __kmp_sys_oversubscribed; /* other processes compete */
+extern volatile int __kmp_sys_free_procs; /* procs left by other processes */
+extern volatile kmp_int32 __kmp_nth_sleeping; /* threads in suspend */
+#endif
 extern int __kmp_env_stksize; /* was KMP_STACKSIZE specified? */
 extern int __kmp_env_blocktime; /* was KMP_BLOCKTIME specified? */
 extern int __kmp_env_checks; /* was KMP_CHECKS specified?    */
@@ -2945,6 +3178,9 @@ extern int __kmp_dispatch_num_buffers; /* max possible dynamic loops in
 extern int __kmp_hot_teams_mode;
 extern int __kmp_hot_teams_max_level;
 #endif
+extern int __kmp_spawn_tree; /* create the workers of a fork in a tree */
+extern int __kmp_perf_lock_timing; /* time the lock waits in th_perf */
+extern int __kmp_perf_wait_timing; /* time the barriers and waits in th_perf */
 
 #if KMP_OS_LINUX
 extern enum clock_function_type __kmp_clock_function;
@@ -3051,6 +3287,7 @@ extern void __kmp_internal_end_dest(void *);
 
 extern int __kmp_register_root(int initial_thread);
 extern void __kmp_unregister_root(int gtid);
+extern int __kmp_unregister_root_other_thread(int gtid);
 
 extern int __kmp_ignore_mppbeg(void);
 extern int __kmp_ignore_mppend(void);
@@ -3064,6 +3301,11 @@ extern void __kmp_parallel_dxo(int *gtid_ref, int *cid_ref, ident_t *loc_ref);
 #ifdef USE_LOAD_BALANCE
 extern int __kmp_get_load_balance(int);
 #endif
+#if KMP_OS_LINUX
+extern void __kmp_oversub_init(void);
+extern void __kmp_oversub_fini(void);
+extern void __kmp_oversub_reset(void);
+#endif
 
 #ifdef BUILD_TV
 extern void __kmp_tv_threadprivate_store(kmp_info_t *th, void *global_addr,
@@ -3252,6 +3494,23 @@ extern void __kmp_check_stack_overlap(kmp_info_t *thr);
 extern void __kmp_expand_host_name(char *buffer, size_t size);
 extern void __kmp_expand_file_name(char *result, size_t rlen, char *pattern);
 
+/* A record of a thread for a report at exit (the trace buffers, the hardware
+   counters). The records of a list are never freed while the runtime runs:
+   threads of other roots may still use them after the report. A record that
+   its thread released goes to the next thread of the same gtid. The records
+   start with this header. */
+typedef struct kmp_thread_slot {
+  struct kmp_thread_slot *next; // all records of the list
+  kmp_int32 gtid;
+  volatile kmp_int32 in_use;
+} kmp_thread_slot_t;
+
+extern kmp_thread_slot_t *
+__kmp_thread_slot_reuse(kmp_thread_slot_t *volatile *list, int gtid);
+extern void __kmp_thread_slot_push(kmp_thread_slot_t *volatile *list,
+                                   kmp_thread_slot_t *slot, int gtid);
+#define __kmp_thread_slot_release(slot) KMP_ST_REL32(&(slot)->in_use, 0)
+
 #if KMP_ARCH_X86 || KMP_ARCH_X86_64
 extern void
 __kmp_initialize_system_tick(void); /* Initialize timer tick value */
@@ -3270,6 +3529,7 @@ extern void __kmp_affinity_set_init_mask(
     int gtid, int isa_root); /* set affinity according to KMP_AFFINITY */
 #if OMP_40_ENABLED
 extern void __kmp_affinity_set_place(int gtid);
+extern int __kmp_affinity_set_partition(int gtid, int first, int last);
 #endif
 extern void __kmp_affinity_determine_capable(const char *env_var);
 extern int __kmp_aux_set_affinity(void **mask);
@@ -3281,6 +3541,14 @@ extern int __kmp_aux_get_affinity_mask_proc(int proc, void **mask);
 extern void __kmp_balanced_affinity(int tid, int team_size);
 #if KMP_OS_LINUX
 extern int kmp_set_thread_affinity_mask_initial(void);
+extern int __kmp_numa_num_nodes(void);
+extern int __kmp_numa_proc_node_of(int proc);
+extern int __kmp_numa_thread_node(kmp_info_t *th);
+extern int __kmp_numa_bind(void *addr, size_t size, int node);
+extern int __kmp_numa_node_of_range(const void *addr, size_t size);
+extern int __kmp_numa_migrate(void *addr, size_t size, int node);
+extern void __kmp_numa_migrate_thread(kmp_info_t *th);
+extern void __kmp_numa_cleanup(void);
 #endif
 #endif /* KMP_AFFINITY_SUPPORTED */
 
@@ -3307,6 +3575,7 @@ extern void __kmp_create_monitor(kmp_info_t *th);
 extern void *__kmp_launch_thread(kmp_info_t *thr);
 
 extern void __kmp_create_worker(int gtid, kmp_info_t *th, size_t stack_size);
+extern void __kmp_spawn_workers(kmp_info_t *th);
 
 #if KMP_OS_WINDOWS
 extern int __kmp_still_running(kmp_info_t *th);
@@ -3347,6 +3616,7 @@ extern void __kmp_suspend_uninitialize_thread(kmp_info_t *th);
 
 extern kmp_info_t *__kmp_allocate_thread(kmp_root_t *root, kmp_team_t *team,
                                          int tid);
+extern void *__kmp_allocate_thread_owned(kmp_info_t *owner, size_t size);
 #if OMP_40_ENABLED
 extern kmp_team_t *
 __kmp_allocate_team(kmp_root_t *root, int new_nproc, int max_nproc,
@@ -3373,6 +3643,23 @@ extern kmp_team_t *__kmp_reap_team(kmp_team_t *);
 
 extern void __kmp_initialize_bget(kmp_info_t *th);
 extern void __kmp_finalize_bget(kmp_info_t *th);
+#if KMP_USE_BGET
+extern void __kmp_cleanup_sizeclass(void);
+extern void __kmp_sc_flush_remote(kmp_info_t *th);
+extern void __kmp_atfork_sizeclass(void);
+// Push the releases to the heaps of other threads batched so far.
+#define KMP_SC_FLUSH_REMOTE(th)                                                \
+  do {                                                                         \
+    if (__kmp_malloc_kind == kmp_malloc_sizeclass)                             \
+      __kmp_sc_flush_remote((th));                                             \
+  } while (0)
+#else
+#define KMP_SC_FLUSH_REMOTE(th) ((void)0)
+#endif
+#if KMP_OS_LINUX
+extern void __kmp_cleanup_arena(void);
+extern void __kmp_atfork_arena(void);
+#endif
 
 KMP_EXPORT void *kmpc_malloc(size_t size);
 KMP_EXPORT void *kmpc_aligned_malloc(size_t size, size_t alignment);
@@ -3380,6 +3667,17 @@ KMP_EXPORT void *kmpc_calloc(size_t nelem, size_t elsize);
 KMP_EXPORT void *kmpc_realloc(void *ptr, size_t size);
 KMP_EXPORT void kmpc_free(void *ptr);
 
+#if OMP_50_ENABLED
+extern omp_allocator_handle_t
+__kmpc_init_allocator(int gtid, omp_memspace_handle_t memspace, int ntraits,
+                      const omp_alloctrait_t traits[]);
+extern void __kmpc_destroy_allocator(int gtid, omp_allocator_handle_t al);
+extern void __kmpc_set_default_allocator(int gtid, omp_allocator_handle_t al);
+extern omp_allocator_handle_t __kmpc_get_default_allocator(int gtid);
+KMP_EXPORT void *__kmpc_alloc(int gtid, size_t size, omp_allocator_handle_t al);
+KMP_EXPORT void __kmpc_free(int gtid, void *ptr, omp_allocator_handle_t al);
+#endif
+
 /* declarations for internal use */
 
 extern int __kmp_barrier(enum barrier_type bt, int gtid, int is_split,
@@ -3419,6 +3717,25 @@ extern void __kmp_join_call(ident_t *loc, int gtid
 #endif
                             );
 
+/* Asynchronous parallel regions (kmp_async.cpp) */
+typedef struct kmp_async_region kmp_async_region_t;
+typedef struct kmp_async_launcher kmp_async_launcher_t;
+extern kmp_async_region_t *__kmp_async_launch(void (*fn)(void *), void *data,
+                                              int nthreads);
+extern int __kmp_async_test(kmp_async_region_t *region);
+extern void __kmp_async_wait(kmp_async_region_t *region);
+extern void __kmp_async_fini(void);
+extern void __kmp_async_reset(void);
+
+/* Parallel first-touch initialization of memory (kmp_first_touch.cpp) */
+extern void __kmp_parallel_first_touch(void *ptr, size_t size, size_t chunk);
+extern void __kmp_parallel_memset(void *ptr, int value, size_t size);
+extern void __kmp_parallel_memcpy(void *dst, const void *src, size_t size);
+extern int __kmp_get_memory_node(const void *ptr, size_t size);
+
+extern int __kmp_get_perf_counters(int thread, kmp_perf_t *perf);
+extern void __kmp_perf_retire(kmp_info_t *thr);
+
 extern void __kmp_serialized_parallel(ident_t *id, kmp_int32 gtid);
 extern void __kmp_internal_fork(ident_t *id, int gtid, kmp_team_t *team);
 extern void __kmp_internal_join(ident_t *id, int gtid, kmp_team_t *team);
@@ -3594,6 +3911,14 @@ KMP_EXPORT void KMPC_FOR_STATIC_INIT(ident_t *loc, kmp_int32 global_tid,
                                      kmp_int *pstride, kmp_int incr,
                                      kmp_int chunk);
 
+KMP_EXPORT void __kmpc_for_static_init_8u(ident_t *loc, kmp_int32 global_tid,
+                                          kmp_int32 schedtype,
+                                          kmp_int32 *plastiter,
+                                          kmp_uint64 *plower,
+                                          kmp_uint64 *pupper,
+                                          kmp_int64 *pstride, kmp_int64 incr,
+                                          kmp_int64 chunk);
+
 KMP_EXPORT void __kmpc_for_static_fini(ident_t *loc, kmp_int32 global_tid);
 
 KMP_EXPORT void __kmpc_copyprivate(ident_t *loc, kmp_int32 global_tid,
@@ -20,6 +20,11 @@
 #include "kmp_str.h"
 #include "kmp_wrapper_getpid.h"
 
+#if KMP_OS_LINUX
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
 // Store the real or imagined machine hierarchy here
 static hierarchy_info machine_hierarchy;
 
@@ -2351,6 +2356,454 @@ restart_radix_check:
   return depth;
 }
 
+#if KMP_OS_LINUX
+
+// Levels of the machine topology described by sysfs. The NUMA node level is
+// placed in the address tree once the levels have been compared: a node may
+// contain packages, be contained in one, or duplicate another level entirely.
+enum kmp_sysfs_level {
+  sysfs_level_package = 0,
+  sysfs_level_node,
+  sysfs_level_l3,
+  sysfs_level_l2,
+  sysfs_level_core,
+  sysfs_level_thread,
+  sysfs_levels
+};
+
+struct kmp_sysfs_proc_t {
+  unsigned os; // OS proc id
+  // Object containing the proc at each level, unique machine-wide: the node or
+  // package number, or the first OS proc sharing the cache or core. UINT_MAX
+  // if sysfs does not describe the level.
+  unsigned key[sysfs_levels];
+  // Label of the object within its parent, as stored in the Address
+  unsigned label[sysfs_levels];
+};
+
+static const char *__kmp_affinity_sysfs_root() {
+  return __kmp_sysfs_root != NULL ? __kmp_sysfs_root : "/sys";
+}
+
+// Parse a sysfs list ("0-3,8,10-11\n"), calling set(id, arg) for each listed id
+// below max. The file is closed before the first call.
+static bool __kmp_sysfs_read_list(char const *path, unsigned long max,
+                                  void (*set)(unsigned long id, void *arg),
+                                  void *arg) {
+  char buf[4096];
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+    return false;
+  bool ok = (fgets(buf, sizeof(buf), f) != NULL);
+  fclose(f);
+  if (!ok)
+    return false;
+
+  char *p = buf;
+  for (;;) {
+    char *end;
+    unsigned long first = strtoul(p, &end, 10);
+    unsigned long last = first;
+    if (end == p)
+      break;
+    p = end;
+    if (*p == '-') {
+      last = strtoul(p + 1, &end, 10);
+      if (end == p + 1)
+        return false;
+      p = end;
+    }
+    for (; first <= last && first < max; first++)
+      set(first, arg);
+    if (*p != ',')
+      break;
+    p++;
+  }
+  return true;
+}
+
+static void __kmp_sysfs_set_proc(unsigned long id, void *mask) {
+  KMP_CPU_SET(id, (kmp_affin_mask_t *)mask);
+}
+
+// Parse a sysfs cpu list into mask. OS procs that do not fit in an affinity
+// mask are ignored.
+static bool __kmp_sysfs_read_cpulist(char const *path, kmp_affin_mask_t *mask) {
+  KMP_CPU_ZERO(mask);
+  return __kmp_sysfs_read_list(path, __kmp_affin_mask_size * CHAR_BIT,
+                               __kmp_sysfs_set_proc, mask);
+}
+
+static int __kmp_sysfs_cmp_keys(const void *a, const void *b) {
+  kmp_uint64 aa = *(const kmp_uint64 *)a;
+  kmp_uint64 bb = *(const kmp_uint64 *)b;
+  return aa < bb ? -1 : aa > bb ? 1 : 0;
+}
+
+// Sort the (parent, level) key pairs of all procs into keys[]; parent may be -1
+// for the whole machine. Returns the number of distinct pairs, and the largest
+// number of level objects in one parent object in *max_per_parent.
+static unsigned __kmp_sysfs_count(const kmp_sysfs_proc_t *procs, int nprocs,
+                                  int parent, int level, kmp_uint64 *keys,
+                                  unsigned *max_per_parent = NULL) {
+  int i;
+  unsigned count = 0, per_parent = 0, max = 0;
+  for (i = 0; i < nprocs; i++) {
+    kmp_uint64 outer = parent < 0 ? 0 : procs[i].key[parent];
+    keys[i] = (outer << 32) | procs[i].key[level];
+  }
+  qsort(keys, nprocs, sizeof(*keys), __kmp_sysfs_cmp_keys);
+  for (i = 0; i < nprocs; i++) {
+    if (i > 0 && keys[i] == keys[i - 1])
+      continue;
+    count++;
+    if (i == 0 || (keys[i] >> 32) != (keys[i - 1] >> 32))
+      per_parent = 0;
+    if (++per_parent > max)
+      max = per_parent;
+  }
+  if (max_per_parent != NULL)
+    *max_per_parent = max;
+  return count;
+}
+
+// Every object of the inner level is within a single object of the outer one.
+static bool __kmp_sysfs_nested(const kmp_sysfs_proc_t *procs, int nprocs,
+                               int inner, int outer, kmp_uint64 *keys) {
+  return __kmp_sysfs_count(procs, nprocs, outer, inner, keys) ==
+         __kmp_sysfs_count(procs, nprocs, -1, inner, keys);
+}
+
+static void __kmp_affinity_print_sysfs_topology(AddrUnsPair *address2os,
+                                                int len, int depth,
+                                                const int *levels) {
+  int proc;
+
+  KMP_INFORM(OSProcToPhysicalThreadMap, "KMP_AFFINITY");
+  for (proc = 0; proc < len; proc++) {
+    int level;
+    kmp_str_buf_t buf;
+    __kmp_str_buf_init(&buf);
+    for (level = 0; level < depth; level++) {
+      switch (levels[level]) {
+      case sysfs_level_package:
+        __kmp_str_buf_print(&buf, "%s ", KMP_I18N_STR(Package));
+        break;
+      case sysfs_level_node:
+        __kmp_str_buf_print(&buf, "%s ", KMP_I18N_STR(Node));
+        break;
+      case sysfs_level_l3:
+        __kmp_str_buf_print(&buf, "L3 ");
+        break;
+      case sysfs_level_l2:
+        __kmp_str_buf_print(&buf, "L2 ");
+        break;
+      case sysfs_level_core:
+        __kmp_str_buf_print(&buf, "%s ", KMP_I18N_STR(Core));
+        break;
+      case sysfs_level_thread:
+        __kmp_str_buf_print(&buf, "%s ", KMP_I18N_STR(Thread));
+        break;
+      }
+      __kmp_str_buf_print(&buf, "%d ", address2os[proc].first.labels[level]);
+    }
+    KMP_INFORM(OSProcMapToPack, "KMP_AFFINITY", address2os[proc].second,
+               buf.str);
+    __kmp_str_buf_free(&buf);
+  }
+}
+
+// Build the affinity map from /sys/devices/system/{cpu,node}. Besides the
+// package/core/thread levels, the map has a level for NUMA nodes and for L2/L3
+// caches whenever they group procs differently from their neighbor levels, so
+// hierarchical barriers and place lists see them on any architecture.
+static int __kmp_affinity_create_sysfs_map(AddrUnsPair **address2os,
+                                           kmp_i18n_id_t *const msg_id) {
+  const char *root = __kmp_affinity_sysfs_root();
+  char path[512];
+  int nprocs = 0;
+  int i, level;
+  unsigned os;
+
+  *address2os = NULL;
+  *msg_id = kmp_i18n_null;
+
+  kmp_sysfs_proc_t *procs = (kmp_sysfs_proc_t *)__kmp_allocate(
+      sizeof(kmp_sysfs_proc_t) * __kmp_avail_proc);
+  kmp_uint64 *keys =
+      (kmp_uint64 *)__kmp_allocate(sizeof(kmp_uint64) * __kmp_avail_proc);
+  kmp_affin_mask_t *list;
+  KMP_CPU_ALLOC(list);
+
+#define CLEANUP_SYSFS_INFO                                                     \
+  KMP_CPU_FREE(list);                                                          \
+  __kmp_free(keys);                                                            \
+  __kmp_free(procs);
+
+  KMP_CPU_SET_ITERATE(os, __kmp_affin_fullMask) {
+    if (!KMP_CPU_ISSET(os, __kmp_affin_fullMask)) {
+      continue;
+    }
+    KMP_ASSERT(nprocs < __kmp_avail_proc);
+    kmp_sysfs_proc_t *proc = &procs[nprocs++];
+    int pkg_id, core_id;
+    proc->os = os;
+    for (level = 0; level < sysfs_levels; level++) {
+      proc->key[level] = proc->label[level] = UINT_MAX;
+    }
+
+    // Some architectures report -1 for unknown package or core ids.
+    KMP_SNPRINTF(path, sizeof(path),
+                 "%s/devices/system/cpu/cpu%u/topology/physical_package_id",
+                 root, os);
+    if (__kmp_read_from_file(path, "%d", &pkg_id) != 1)
+      goto no_topology;
+    KMP_SNPRINTF(path, sizeof(path),
+                 "%s/devices/system/cpu/cpu%u/topology/core_id", root, os);
+    if (__kmp_read_from_file(path, "%d", &core_id) != 1)
+      goto no_topology;
+    KMP_SNPRINTF(path, sizeof(path),
+                 "%s/devices/system/cpu/cpu%u/topology/thread_siblings_list",
+                 root, os);
+    if (!__kmp_sysfs_read_cpulist(path, list) || !KMP_CPU_ISSET(os, list))
+      goto no_topology;
+
+    proc->key[sysfs_level_package] = proc->label[sysfs_level_package] =
+        pkg_id < 0 ? 0 : pkg_id;
+    proc->key[sysfs_level_core] = list->begin();
+    proc->label[sysfs_level_core] = core_id < 0 ? 0 : core_id;
+    proc->key[sysfs_level_thread] = os;
+    proc->label[sysfs_level_thread] = 0;
+    for (unsigned sibling = list->begin(); sibling < os;
+         sibling = list->next(sibling)) {
+      proc->label[sysfs_level_thread]++;
+    }
+
+    // Unified or data caches shared at levels 2 and 3
+    for (int index = 0;; index++) {
+      unsigned cache_level;
+      char type[16];
+      KMP_SNPRINTF(path, sizeof(path),
+                   "%s/devices/system/cpu/cpu%u/cache/index%d/level", root, os,
+                   index);
+      if (__kmp_read_from_file(path, "%u", &cache_level) != 1)
+        break;
+      if (cache_level != 2 && cache_level != 3)
+        continue;
+      KMP_SNPRINTF(path, sizeof(path),
+                   "%s/devices/system/cpu/cpu%u/cache/index%d/type", root, os,
+                   index);
+      if (__kmp_read_from_file(path, "%15s", type) != 1 ||
+          strcmp(type, "Instruction") == 0)
+        continue;
+      KMP_SNPRINTF(path, sizeof(path),
+                   "%s/devices/system/cpu/cpu%u/cache/index%d/shared_cpu_list",
+                   root, os, index);
+      if (!__kmp_sysfs_read_cpulist(path, list) || !KMP_CPU_ISSET(os, list))
+        continue;
+      level = (cache_level == 2) ? sysfs_level_l2 : sysfs_level_l3;
+      proc->key[level] = proc->label[level] = list->begin();
+    }
+  }
+  if (nprocs == 0)
+    goto no_topology;
+
+  // NUMA nodes, listed with their procs
+  {
+    kmp_affin_mask_t *nodes;
+    KMP_CPU_ALLOC(nodes);
+    KMP_SNPRINTF(path, sizeof(path), "%s/devices/system/node/online", root);
+    if (__kmp_sysfs_read_cpulist(path, nodes)) {
+      unsigned node;
+      KMP_CPU_SET_ITERATE(node, nodes) {
+        if (!KMP_CPU_ISSET(node, nodes)) {
+          continue;
+        }
+        KMP_SNPRINTF(path, sizeof(path),
+                     "%s/devices/system/node/node%u/cpulist", root, node);
+        if (!__kmp_sysfs_read_cpulist(path, list)) {
+          continue;
+        }
+        for (i = 0; i < nprocs; i++) {
+          if (KMP_CPU_ISSET(procs[i].os, list)) {
+            procs[i].key[sysfs_level_node] = node;
+            procs[i].label[sysfs_level_node] = node;
+          }
+        }
+      }
+    }
+    KMP_CPU_FREE(nodes);
+  }
+
+  {
+    // Start from the package/core/thread levels, then fit each of the other
+    // levels between the innermost level containing it and the next one,
+    // outermost first. A level that cannot be nested that way, or that has the
+    // same objects as a neighbor, is dropped.
+    static const int optional[] = {sysfs_level_node, sysfs_level_l3,
+                                   sysfs_level_l2};
+    unsigned counts[sysfs_levels];
+    int levels[sysfs_levels];
+    int depth = 0;
+    levels[depth++] = sysfs_level_package;
+    levels[depth++] = sysfs_level_core;
+    levels[depth++] = sysfs_level_thread;
+    if (!__kmp_sysfs_nested(procs, nprocs, sysfs_level_core,
+                            sysfs_level_package, keys)) {
+      CLEANUP_SYSFS_INFO;
+      *msg_id = kmp_i18n_str_PhysicalIDsNotUnique;
+      return -1;
+    }
+    for (level = 0; level < sysfs_levels; level++) {
+      for (i = 0; i < nprocs; i++) {
+        if (procs[i].key[level] == UINT_MAX)
+          break;
+      }
+      counts[level] = (i < nprocs) ? 0 : __kmp_sysfs_count(procs, nprocs, -1,
+                                                           level, keys);
+    }
+    for (unsigned n = 0; n < sizeof(optional) / sizeof(optional[0]); n++) {
+      int pos;
+      level = optional[n];
+      if (counts[level] == 0) {
+        continue; // not described for every proc
+      }
+      for (pos = depth; pos > 0; pos--) {
+        if (__kmp_sysfs_nested(procs, nprocs, level, levels[pos - 1], keys)) {
+          break;
+        }
+      }
+      if (pos == depth ||
+          !__kmp_sysfs_nested(procs, nprocs, levels[pos], level, keys) ||
+          counts[level] == (pos > 0 ? counts[levels[pos - 1]] : 1) ||
+          counts[level] == counts[levels[pos]]) {
+        continue;
+      }
+      for (i = depth; i > pos; i--) {
+        levels[i] = levels[i - 1];
+      }
+      levels[pos] = level;
+      depth++;
+    }
+
+    // Remove the core and thread levels if they add no information, the
+    // package level is always kept.
+    int kept = 0;
+    for (i = 0; i < depth; i++) {
+      if (levels[i] != sysfs_level_package &&
+          counts[levels[i]] == (kept > 0 ? counts[levels[kept - 1]] : 1)) {
+        continue;
+      }
+      levels[kept++] = levels[i];
+    }
+    depth = kept;
+
+    unsigned max_cores, max_threads;
+    __kmp_sysfs_count(procs, nprocs, sysfs_level_package, sysfs_level_core,
+                      keys, &max_cores);
+    __kmp_sysfs_count(procs, nprocs, sysfs_level_core, sysfs_level_thread,
+                      keys, &max_threads);
+    nPackages = counts[sysfs_level_package];
+    nCoresPerPkg = max_cores;
+    __kmp_nThreadsPerCore = max_threads;
+    __kmp_ncores = counts[sysfs_level_core];
+
+    if (__kmp_affinity_verbose) {
+      bool uniform = __kmp_affinity_uniform_topology();
+      if (!KMP_AFFINITY_CAPABLE()) {
+        KMP_INFORM(AffNotCapableUseSysfs, "KMP_AFFINITY");
+      } else {
+        char buf[KMP_AFFIN_MASK_PRINT_LEN];
+        __kmp_affinity_print_mask(buf, KMP_AFFIN_MASK_PRINT_LEN,
+                                  __kmp_affin_fullMask);
+        KMP_INFORM(AffCapableUseSysfs, "KMP_AFFINITY");
+        if (__kmp_affinity_respect_mask) {
+          KMP_INFORM(InitOSProcSetRespect, "KMP_AFFINITY", buf);
+        } else {
+          KMP_INFORM(InitOSProcSetNotRespect, "KMP_AFFINITY", buf);
+        }
+      }
+      KMP_INFORM(AvailableOSProc, "KMP_AFFINITY", __kmp_avail_proc);
+      if (uniform) {
+        KMP_INFORM(Uniform, "KMP_AFFINITY");
+      } else {
+        KMP_INFORM(NonUniform, "KMP_AFFINITY");
+      }
+      KMP_INFORM(Topology, "KMP_AFFINITY", nPackages, nCoresPerPkg,
+                 __kmp_nThreadsPerCore, __kmp_ncores);
+    }
+
+    // Construct the data structure that is to be returned, in physical order.
+    *address2os = (AddrUnsPair *)__kmp_allocate(sizeof(AddrUnsPair) * nprocs);
+    for (i = 0; i < nprocs; i++) {
+      Address addr(depth);
+      for (level = 0; level < depth; level++) {
+        addr.labels[level] = procs[i].label[levels[level]];
+      }
+      (*address2os)[i] = AddrUnsPair(addr, procs[i].os);
+    }
+    qsort(*address2os, nprocs, sizeof(**address2os),
+          __kmp_affinity_cmp_Address_labels);
+
+    KMP_DEBUG_ASSERT(__kmp_pu_os_idx == NULL);
+    KMP_DEBUG_ASSERT(nprocs == __kmp_avail_proc);
+    __kmp_pu_os_idx = (int *)__kmp_allocate(sizeof(int) * nprocs);
+    for (i = 0; i < nprocs; i++) {
+      __kmp_pu_os_idx[i] = (*address2os)[i].second;
+    }
+
+    if (__kmp_affinity_type == affinity_none) {
+      __kmp_free(*address2os);
+      *address2os = NULL;
+      CLEANUP_SYSFS_INFO;
+      return 0;
+    }
+
+    if (__kmp_affinity_gran_levels < 0) {
+      // Caches and NUMA nodes within a package are only merged at package
+      // granularity, nodes containing packages at node granularity.
+      bool above_package = true;
+      __kmp_affinity_gran_levels = 0;
+      for (level = 0; level < depth; level++) {
+        enum affinity_gran gran;
+        switch (levels[level]) {
+        case sysfs_level_package:
+          gran = affinity_gran_package;
+          above_package = false;
+          break;
+        case sysfs_level_node:
+          gran = above_package ? affinity_gran_node : affinity_gran_core;
+          break;
+        case sysfs_level_thread:
+          gran = affinity_gran_thread;
+          break;
+        default:
+          gran = affinity_gran_core;
+          break;
+        }
+        if (__kmp_affinity_gran > gran) {
+          __kmp_affinity_gran_levels++;
+        }
+      }
+    }
+
+    if (__kmp_affinity_verbose) {
+      __kmp_affinity_print_sysfs_topology(*address2os, nprocs, depth, levels);
+    }
+
+    CLEANUP_SYSFS_INFO;
+    return depth;
+  }
+
+no_topology:
+  CLEANUP_SYSFS_INFO;
+  *msg_id = kmp_i18n_str_CantReadSysfsTopology;
+  return -1;
+#undef CLEANUP_SYSFS_INFO
+}
+
+#endif /* KMP_OS_LINUX */
+
 // Create and return a table of affinity masks, indexed by OS thread ID.
 // This routine handles OR'ing together all the affinity masks of threads
 // that are sufficiently close, if granularity > fine.
@@ -3828,14 +4281,7 @@ static void __kmp_aux_affinity_initialize(void) {
       __kmp_get_system_affinity(__kmp_affin_fullMask, TRUE);
 
       // Count the number of available processors.
-      unsigned i;
-      __kmp_avail_proc = 0;
-      KMP_CPU_SET_ITERATE(i, __kmp_affin_fullMask) {
-        if (!KMP_CPU_ISSET(i, __kmp_affin_fullMask)) {
-          continue;
-        }
-        __kmp_avail_proc++;
-      }
+      __kmp_avail_proc = KMP_CPU_COUNT(__kmp_affin_fullMask);
       if (__kmp_avail_proc > __kmp_xproc) {
         if (__kmp_affinity_verbose ||
             (__kmp_affinity_warnings &&
@@ -3855,6 +4301,19 @@ static void __kmp_aux_affinity_initialize(void) {
   int depth = -1;
   kmp_i18n_id_t msg_id = kmp_i18n_null;
 
+  // Unbound threads need neither places nor the machine hierarchy, so unless
+  // the topology is printed, subset or sizes the default team, skip its
+  // discovery: it is the slowest part of the initialization on big machines,
+  // where the x2APIC method binds the thread to every proc in turn.
+#ifndef KMP_DFLT_NTH_CORES
+  if (__kmp_affinity_type == affinity_none && !__kmp_affinity_verbose &&
+      !__kmp_hws_requested) {
+    depth = __kmp_affinity_create_flat_map(&address2os, &msg_id);
+    KMP_ASSERT(depth == 0);
+    KMP_EXIT_AFF_NONE;
+  }
+#endif
+
   // For backward compatibility, setting KMP_CPUINFO_FILE =>
   // KMP_TOPOLOGY_METHOD=cpuinfo
   if ((__kmp_cpuinfo_file != NULL) &&
@@ -3924,6 +4383,24 @@ static void __kmp_aux_affinity_initialize(void) {
 
 #if KMP_OS_LINUX
 
+    if (depth < 0) {
+      if (__kmp_affinity_verbose) {
+        if (msg_id != kmp_i18n_null) {
+          KMP_INFORM(AffStrParseFilename, "KMP_AFFINITY",
+                     __kmp_i18n_catgets(msg_id), __kmp_affinity_sysfs_root());
+        } else {
+          KMP_INFORM(AffParseFilename, "KMP_AFFINITY",
+                     __kmp_affinity_sysfs_root());
+        }
+      }
+
+      file_name = NULL;
+      depth = __kmp_affinity_create_sysfs_map(&address2os, &msg_id);
+      if (depth == 0) {
+        KMP_EXIT_AFF_NONE;
+      }
+    }
+
     if (depth < 0) {
       if (__kmp_affinity_verbose) {
         if (msg_id != kmp_i18n_null) {
@@ -4064,6 +4541,25 @@ static void __kmp_aux_affinity_initialize(void) {
     }
   }
 
+#if KMP_OS_LINUX
+
+  else if (__kmp_affinity_top_method == affinity_top_method_sysfs) {
+    if (__kmp_affinity_verbose) {
+      KMP_INFORM(AffParseFilename, "KMP_AFFINITY", __kmp_affinity_sysfs_root());
+    }
+
+    depth = __kmp_affinity_create_sysfs_map(&address2os, &msg_id);
+    if (depth == 0) {
+      KMP_EXIT_AFF_NONE;
+    }
+    if (depth < 0) {
+      KMP_ASSERT(msg_id != kmp_i18n_null);
+      KMP_FATAL(MsgExiting, __kmp_i18n_catgets(msg_id));
+    }
+  }
+
+#endif /* KMP_OS_LINUX */
+
 #if KMP_GROUP_AFFINITY
 
   else if (__kmp_affinity_top_method == affinity_top_method_group) {
@@ -4312,6 +4808,35 @@ static void __kmp_aux_affinity_initialize(void) {
 }
 #undef KMP_EXIT_AFF_NONE
 
+#if OMP_40_ENABLED
+// Lists the OS procs of every place once, for the place queries of the API.
+static void __kmp_affinity_create_place_ids(void) {
+  int place, proc, k = 0, nids = 0;
+
+  if (__kmp_affinity_place_first != NULL) {
+    __kmp_free(__kmp_affinity_place_first);
+    __kmp_free(__kmp_affinity_place_ids);
+    __kmp_affinity_place_first = __kmp_affinity_place_ids = NULL;
+  }
+  if (__kmp_affinity_masks == NULL || __kmp_affinity_num_masks == 0)
+    return;
+  for (place = 0; place < (int)__kmp_affinity_num_masks; ++place)
+    nids += KMP_CPU_COUNT(KMP_CPU_INDEX(__kmp_affinity_masks, place));
+  __kmp_affinity_place_first =
+      (int *)__kmp_allocate(sizeof(int) * (__kmp_affinity_num_masks + 1));
+  __kmp_affinity_place_ids = (int *)__kmp_allocate(sizeof(int) * (nids + 1));
+  for (place = 0; place < (int)__kmp_affinity_num_masks; ++place) {
+    kmp_affin_mask_t *mask = KMP_CPU_INDEX(__kmp_affinity_masks, place);
+    __kmp_affinity_place_first[place] = k;
+    KMP_CPU_SET_ITERATE(proc, mask) {
+      if (KMP_CPU_ISSET(proc, __kmp_affin_fullMask))
+        __kmp_affinity_place_ids[k++] = proc;
+    }
+  }
+  __kmp_affinity_place_first[place] = k;
+}
+#endif
+
 void __kmp_affinity_initialize(void) {
   // Much of the code above was written assumming that if a machine was not
   // affinity capable, then __kmp_affinity_type == affinity_none.  We now
@@ -4332,6 +4857,21 @@ void __kmp_affinity_initialize(void) {
   if (disabled) {
     __kmp_affinity_type = affinity_disabled;
   }
+#if OMP_40_ENABLED
+  __kmp_affinity_create_place_ids();
+  // KMP_PLACE_PARTITION only applies to the places of OMP_PROC_BIND.
+  if (__kmp_place_partition_first >= 0 &&
+      (__kmp_nested_proc_bind.bind_types[0] == proc_bind_false ||
+       __kmp_nested_proc_bind.bind_types[0] == proc_bind_intel)) {
+    __kmp_place_partition_first = __kmp_place_partition_last = -1;
+  } else if (__kmp_place_partition_first >= 0 &&
+             (__kmp_place_partition_first >= (int)__kmp_affinity_num_masks ||
+              __kmp_place_partition_last >= (int)__kmp_affinity_num_masks)) {
+    KMP_WARNING(AffPlacePartitionIgnored, __kmp_place_partition_first,
+                __kmp_place_partition_last, (int)__kmp_affinity_num_masks);
+    __kmp_place_partition_first = __kmp_place_partition_last = -1;
+  }
+#endif
 }
 
 void __kmp_affinity_uninitialize(void) {
@@ -4347,6 +4887,14 @@ void __kmp_affinity_uninitialize(void) {
   __kmp_affinity_type = affinity_default;
 #if OMP_40_ENABLED
   __kmp_affinity_num_places = 0;
+  if (__kmp_affinity_place_first != NULL) {
+    __kmp_free(__kmp_affinity_place_first);
+    __kmp_affinity_place_first = NULL;
+  }
+  if (__kmp_affinity_place_ids != NULL) {
+    __kmp_free(__kmp_affinity_place_ids);
+    __kmp_affinity_place_ids = NULL;
+  }
 #endif
   if (__kmp_affinity_proclist != NULL) {
     __kmp_free(__kmp_affinity_proclist);
@@ -4369,6 +4917,29 @@ void __kmp_affinity_uninitialize(void) {
   KMPAffinity::destroy_api();
 }
 
+#if OMP_40_ENABLED
+// Number of OS procs in the places [first, last], which wraps around the end of
+// the place list if first > last.
+static int __kmp_affinity_partition_procs(int first, int last) {
+  kmp_affin_mask_t *procs;
+  int place = first;
+  int count;
+
+  KMP_CPU_ALLOC_ON_STACK(procs);
+  KMP_CPU_ZERO(procs);
+  for (;;) {
+    KMP_CPU_UNION(procs, KMP_CPU_INDEX(__kmp_affinity_masks, place));
+    if (place == last)
+      break;
+    place = (place + 1) % __kmp_affinity_num_masks;
+  }
+  count = KMP_CPU_COUNT(procs);
+  KMP_CPU_FREE_FROM_STACK(procs);
+  return count;
+}
+
+#endif
+
 void __kmp_affinity_set_init_mask(int gtid, int isa_root) {
   if (!KMP_AFFINITY_CAPABLE()) {
     return;
@@ -4431,11 +5002,26 @@ void __kmp_affinity_set_init_mask(int gtid, int isa_root) {
 #endif
 
 #if OMP_40_ENABLED
+  if (isa_root && i != KMP_PLACE_ALL && __kmp_place_partition_first >= 0) {
+    // Start inside the partition requested with KMP_PLACE_PARTITION.
+    int first = __kmp_place_partition_first, last = __kmp_place_partition_last;
+    if ((first <= last && (i < first || i > last)) ||
+        (first > last && i < first && i > last)) {
+      i = first;
+      mask = KMP_CPU_INDEX(__kmp_affinity_masks, i);
+    }
+  }
   th->th.th_current_place = i;
   if (isa_root) {
     th->th.th_new_place = i;
     th->th.th_first_place = 0;
     th->th.th_last_place = __kmp_affinity_num_masks - 1;
+    if (i != KMP_PLACE_ALL && __kmp_place_partition_first >= 0) {
+      th->th.th_first_place = __kmp_place_partition_first;
+      th->th.th_last_place = __kmp_place_partition_last;
+      th->th.th_root->r.r_partition_procs = __kmp_affinity_partition_procs(
+          __kmp_place_partition_first, __kmp_place_partition_last);
+    }
   }
 
   if (i == KMP_PLACE_ALL) {
@@ -4476,6 +5062,11 @@ void __kmp_affinity_set_init_mask(int gtid, int isa_root) {
   } else
 #endif
     __kmp_set_system_affinity(th->th.th_affin_mask, TRUE);
+#if KMP_OS_LINUX
+  // Workers are bound here for the first time, their structures were
+  // allocated by the master.
+  __kmp_numa_migrate_thread(th);
+#endif
 }
 
 #if OMP_40_ENABLED
@@ -4520,6 +5111,50 @@ void __kmp_affinity_set_place(int gtid) {
                __kmp_gettid(), gtid, buf);
   }
   __kmp_set_system_affinity(th->th.th_affin_mask, TRUE);
+#if KMP_OS_LINUX
+  __kmp_numa_migrate_thread(th);
+#endif
+}
+
+// Restrict the place partition of the root of the calling thread to the places
+// [first, last] (wrapping around if first > last), e.g. when other processes
+// start using part of the machine. Hot team threads are rebound at the next
+// fork, and the default team size of the root is capped at the number of procs
+// in the partition. The master is moved to the first place right away if its
+// current place is outside the partition. Only valid for an uber thread
+// outside of parallel regions with OMP_PROC_BIND places in effect. Returns 0
+// on success, -1 otherwise.
+int __kmp_affinity_set_partition(int gtid, int first, int last) {
+  kmp_info_t *th = __kmp_threads[gtid];
+  kmp_root_t *root = th->th.th_root;
+  int place;
+
+  if (!KMP_AFFINITY_CAPABLE() || __kmp_affinity_num_masks == 0 ||
+      __kmp_nested_proc_bind.bind_types[0] == proc_bind_false ||
+      __kmp_nested_proc_bind.bind_types[0] == proc_bind_intel)
+    return -1;
+  if (first < 0 || last < 0 || first >= (int)__kmp_affinity_num_masks ||
+      last >= (int)__kmp_affinity_num_masks)
+    return -1;
+  if (th != root->r.r_uber_thread || root->r.r_active ||
+      th->th.th_team != root->r.r_root_team)
+    return -1;
+
+  KA_TRACE(10, ("__kmp_affinity_set_partition: T#%d partition [%d,%d] -> "
+                "[%d,%d]\n",
+                gtid, th->th.th_first_place, th->th.th_last_place, first,
+                last));
+  th->th.th_first_place = first;
+  th->th.th_last_place = last;
+  root->r.r_partition_procs = __kmp_affinity_partition_procs(first, last);
+
+  place = th->th.th_current_place;
+  if (place < 0 || (first <= last && (place < first || place > last)) ||
+      (first > last && place < first && place > last)) {
+    th->th.th_new_place = first;
+    __kmp_affinity_set_place(gtid);
+  }
+  return 0;
 }
 
 #endif /* OMP_40_ENABLED */
@@ -5033,4 +5668,271 @@ extern "C"
 }
 #endif
 
+#if KMP_OS_LINUX
+// NUMA placement of memory for the OpenMP 5.0 allocators. The node of every OS
+// proc is read from sysfs the first time placement is requested; it does not
+// depend on the affinity settings, so it also works with KMP_AFFINITY=disabled.
+
+#define KMP_NUMA_MAX_NODES 1024
+#define KMP_NUMA_MASK_WORDS (KMP_NUMA_MAX_NODES / (CHAR_BIT * sizeof(long)))
+
+// Memory policies and flags of mbind(2)
+#define KMP_MPOL_PREFERRED 1
+#define KMP_MPOL_INTERLEAVE 3
+#define KMP_MPOL_MF_MOVE (1 << 1)
+
+// Pages queried per move_pages(2) call
+#define KMP_NUMA_QUERY_BATCH 64
+
+// mbind(2) and move_pages(2) as declared by <numaif.h>, whose definitions are
+// in libnuma; the runtime does not link with it.
+static long __kmp_mbind(void *addr, unsigned long len, int mode,
+                        const unsigned long *nodemask, unsigned long maxnode,
+                        unsigned flags) {
+  return syscall(__NR_mbind, addr, len, mode, nodemask, maxnode, flags);
+}
+
+static long __kmp_move_pages(int pid, unsigned long count, void **pages,
+                             const int *nodes, int *status, int flags) {
+  return syscall(__NR_move_pages, pid, count, pages, nodes, status, flags);
+}
+
+static int *__kmp_numa_proc_node = NULL; // node of each OS proc, -1 if none
+static int __kmp_numa_nprocs = 0; // entries in __kmp_numa_proc_node
+static int __kmp_numa_nnodes = 0; // highest online node + 1
+static unsigned long __kmp_numa_online[KMP_NUMA_MASK_WORDS];
+static volatile int __kmp_numa_initialized = FALSE;
+static kmp_bootstrap_lock_t __kmp_numa_lock =
+    KMP_BOOTSTRAP_LOCK_INITIALIZER(__kmp_numa_lock);
+
+static void __kmp_numa_add_proc(unsigned long proc, void *node) {
+  if ((int)proc >= __kmp_numa_nprocs) {
+    int n = KMP_MAX((int)proc + 1, 2 * __kmp_numa_nprocs);
+    __kmp_numa_proc_node = (int *)KMP_INTERNAL_REALLOC(__kmp_numa_proc_node,
+                                                       n * sizeof(int));
+    KMP_ASSERT(__kmp_numa_proc_node != NULL);
+    for (int i = __kmp_numa_nprocs; i < n; i++)
+      __kmp_numa_proc_node[i] = -1;
+    __kmp_numa_nprocs = n;
+  }
+  __kmp_numa_proc_node[proc] = *(int *)node;
+}
+
+static void __kmp_numa_add_node(unsigned long node, void *arg) {
+  char path[PATH_MAX];
+  int id = (int)node;
+
+  KMP_SNPRINTF(path, sizeof(path), "%s/devices/system/node/node%d/cpulist",
+               __kmp_affinity_sysfs_root(), id);
+  // Nodes with memory only have an empty list and no procs.
+  if (!__kmp_sysfs_read_list(path, INT_MAX, __kmp_numa_add_proc, &id))
+    return;
+  __kmp_numa_online[node / (CHAR_BIT * sizeof(long))] |=
+      1UL << (node % (CHAR_BIT * sizeof(long)));
+  if (id >= __kmp_numa_nnodes)
+    __kmp_numa_nnodes = id + 1;
+}
+
+static void __kmp_numa_initialize() {
+  if (TCR_4(__kmp_numa_initialized))
+    return;
+  __kmp_acquire_bootstrap_lock(&__kmp_numa_lock);
+  if (!__kmp_numa_initialized) {
+    char path[PATH_MAX];
+    KMP_SNPRINTF(path, sizeof(path), "%s/devices/system/node/online",
+                 __kmp_affinity_sysfs_root());
+    __kmp_sysfs_read_list(path, KMP_NUMA_MAX_NODES, __kmp_numa_add_node, NULL);
+    KA_TRACE(10, ("__kmp_numa_initialize: %d nodes, %d procs\n",
+                  __kmp_numa_nnodes, __kmp_numa_nprocs));
+    TCW_4(__kmp_numa_initialized, TRUE);
+  }
+  __kmp_release_bootstrap_lock(&__kmp_numa_lock);
+}
+
+// Number of NUMA nodes (highest online node + 1), 0 if sysfs lists none.
+int __kmp_numa_num_nodes() {
+  __kmp_numa_initialize();
+  return __kmp_numa_nnodes;
+}
+
+// NUMA node of an OS proc, -1 if unknown.
+int __kmp_numa_proc_node_of(int proc) {
+  __kmp_numa_initialize();
+  if (proc < 0 || proc >= __kmp_numa_nprocs)
+    return -1;
+  return __kmp_numa_proc_node[proc];
+}
+
+// NUMA node of the procs in the mask, -1 if they span several nodes.
+static int __kmp_numa_mask_node(kmp_affin_mask_t *mask) {
+  int node = -1;
+  int proc;
+
+  KMP_CPU_SET_ITERATE(proc, mask) {
+    if (!KMP_CPU_ISSET(proc, mask))
+      continue;
+    int n = __kmp_numa_proc_node_of(proc);
+    if (n < 0)
+      continue;
+    if (node >= 0 && n != node)
+      return -1;
+    node = n;
+  }
+  return node;
+}
+
+// NUMA node of the place the thread is bound to. A thread whose place spans
+// several nodes, or that is not bound, gets the node it is running on.
+int __kmp_numa_thread_node(kmp_info_t *th) {
+  int node = -1;
+
+  __kmp_numa_initialize();
+  if (KMP_AFFINITY_CAPABLE() && th != NULL && th->th.th_affin_mask != NULL)
+    node = __kmp_numa_mask_node(th->th.th_affin_mask);
+  if (node < 0)
+    node = __kmp_numa_proc_node_of(sched_getcpu());
+  return node;
+}
+
+// Place the pages of [addr, addr + size) on the given node, or interleave them
+// across the online nodes if node is negative. Pages that have already been
+// touched are migrated. Returns 0 or an errno value.
+int __kmp_numa_bind(void *addr, size_t size, int node) {
+  unsigned long mask[KMP_NUMA_MASK_WORDS];
+  int mode;
+
+  __kmp_numa_initialize();
+  if (__kmp_numa_nnodes == 0 || node >= __kmp_numa_nnodes)
+    return EINVAL;
+  if (node < 0) {
+    mode = KMP_MPOL_INTERLEAVE;
+    KMP_MEMCPY(mask, __kmp_numa_online, sizeof(mask));
+  } else {
+    mode = KMP_MPOL_PREFERRED;
+    memset(mask, 0, sizeof(mask));
+    mask[node / (CHAR_BIT * sizeof(long))] =
+        1UL << (node % (CHAR_BIT * sizeof(long)));
+  }
+  // The kernel reads maxnode - 1 bits of the mask.
+  if (__kmp_mbind(addr, size, mode, mask, KMP_NUMA_MAX_NODES + 1,
+                  KMP_MPOL_MF_MOVE) != 0) {
+    int error = errno;
+    KA_TRACE(10, ("__kmp_numa_bind: mbind(%p, %lu, %d) failed: %d\n", addr,
+                  (unsigned long)size, node, error));
+    return error;
+  }
+  return 0;
+}
+
+// Node holding the resident pages of [addr, addr + size). Returns -1 if the
+// pages are spread over several nodes, if none of them has been touched yet or
+// if the kernel cannot tell.
+int __kmp_numa_node_of_range(const void *addr, size_t size) {
+  void *pages[KMP_NUMA_QUERY_BATCH];
+  int status[KMP_NUMA_QUERY_BATCH];
+  size_t page_size = KMP_GET_PAGE_SIZE();
+  kmp_uintptr_t page, end;
+  int node = -1;
+
+  if (size == 0)
+    return -1;
+  page = (kmp_uintptr_t)addr & ~(kmp_uintptr_t)(page_size - 1);
+  end = (kmp_uintptr_t)addr + size;
+  while (page < end) {
+    int i, count = 0;
+    for (; page < end && count < KMP_NUMA_QUERY_BATCH; page += page_size)
+      pages[count++] = (void *)page;
+    // Without a nodes array move_pages(2) only reports where the pages are.
+    if (__kmp_move_pages(0, count, pages, NULL, status, 0) != 0) {
+      KA_TRACE(10, ("__kmp_numa_node_of_range: move_pages(%p) failed: %d\n",
+                    pages[0], errno));
+      return -1;
+    }
+    for (i = 0; i < count; i++) {
+      if (status[i] < 0) // not resident
+        continue;
+      if (node >= 0 && status[i] != node)
+        return -1;
+      node = status[i];
+    }
+  }
+  return node;
+}
+
+// Move the pages overlapping [addr, addr + size) to the given node. Pages that
+// are not resident yet are left alone. Returns 0 or an errno value.
+int __kmp_numa_migrate(void *addr, size_t size, int node) {
+  void *pages[KMP_NUMA_QUERY_BATCH];
+  int nodes[KMP_NUMA_QUERY_BATCH];
+  int status[KMP_NUMA_QUERY_BATCH];
+  size_t page_size = KMP_GET_PAGE_SIZE();
+  kmp_uintptr_t page, end;
+
+  __kmp_numa_initialize();
+  if (node < 0 || node >= __kmp_numa_nnodes)
+    return EINVAL;
+  page = (kmp_uintptr_t)addr & ~(kmp_uintptr_t)(page_size - 1);
+  end = (kmp_uintptr_t)addr + size;
+  while (page < end) {
+    int count = 0;
+    for (; page < end && count < KMP_NUMA_QUERY_BATCH; page += page_size) {
+      nodes[count] = node;
+      pages[count++] = (void *)page;
+    }
+    if (__kmp_move_pages(0, count, pages, nodes, status, KMP_MPOL_MF_MOVE) <
+        0) {
+      int error = errno;
+      KA_TRACE(10, ("__kmp_numa_migrate: move_pages(%p, %d) failed: %d\n",
+                    pages[0], node, error));
+      return error;
+    }
+  }
+  return 0;
+}
+
+// Move the runtime structures owned by the thread to the node of its place:
+// kmp_info_t, which holds the barrier state, and the private dispatch buffers
+// of its slot in the current team. They are allocated by the master, before
+// the thread is bound, with __kmp_allocate_thread_owned(), which gives them
+// pages of their own. Structures allocated later for the thread are placed by
+// __kmp_allocate_thread_owned() directly. Memory of the huge page arena is
+// shared by the structures of several threads and is never moved.
+void __kmp_numa_migrate_thread(kmp_info_t *th) {
+  kmp_team_t *team;
+  int node;
+
+  if (!__kmp_numa_local_threads || __kmp_numa_num_nodes() < 2 ||
+      __kmp_huge_pages != kmp_huge_pages_disabled ||
+      th->th.th_affin_mask == NULL)
+    return;
+  // A thread free to run on several nodes is left where it is.
+  node = __kmp_numa_mask_node(th->th.th_affin_mask);
+  if (node < 0 || node == th->th.th_numa_node)
+    return;
+  KA_TRACE(10, ("__kmp_numa_migrate_thread: T#%d from node %d to node %d\n",
+                th->th.th_info.ds.ds_gtid, th->th.th_numa_node, node));
+  __kmp_numa_migrate(th, sizeof(kmp_info_t), node);
+  team = th->th.th_team;
+  if (team != NULL && !team->t.t_serialized && th->th.th_dispatch != NULL &&
+      th->th.th_dispatch == &team->t.t_dispatch[th->th.th_info.ds.ds_tid] &&
+      th->th.th_dispatch->th_disp_buffer != NULL) {
+    __kmp_numa_migrate(
+        th->th.th_dispatch->th_disp_buffer,
+        sizeof(dispatch_private_info_t) *
+            (team->t.t_max_nproc == 1 ? 1 : __kmp_dispatch_num_buffers),
+        node);
+  }
+  th->th.th_numa_node = node;
+}
+
+void __kmp_numa_cleanup() {
+  KMP_INTERNAL_FREE(__kmp_numa_proc_node);
+  __kmp_numa_proc_node = NULL;
+  __kmp_numa_nprocs = 0;
+  __kmp_numa_nnodes = 0;
+  memset(__kmp_numa_online, 0, sizeof(__kmp_numa_online));
+  __kmp_numa_initialized = FALSE;
+}
+#endif // KMP_OS_LINUX
+
 #endif // KMP_AFFINITY_SUPPORTED
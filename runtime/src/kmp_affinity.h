@@ -51,6 +51,7 @@ public:
     void bitwise_not() override { hwloc_bitmap_not(mask, mask); }
     int begin() const override { return hwloc_bitmap_first(mask); }
     int end() const override { return -1; }
+    int count() const override { return hwloc_bitmap_weight(mask); }
     int next(int previous) const override {
       return hwloc_bitmap_next(mask, previous);
     }
@@ -242,12 +243,17 @@ public:
 #endif /* KMP_ARCH_* */
 class KMPNativeAffinity : public KMPAffinity {
   class Mask : public KMPAffinity::Mask {
-    typedef unsigned char mask_t;
+    // Same layout as the kernel's cpumask, so that whole words can be scanned
+    typedef unsigned long mask_t;
     static const int BITS_PER_MASK_T = sizeof(mask_t) * CHAR_BIT;
+    // Number of words that hold the __kmp_affin_mask_size bytes of the mask
+    static size_t num_words() {
+      return (__kmp_affin_mask_size + sizeof(mask_t) - 1) / sizeof(mask_t);
+    }
 
   public:
     mask_t *mask;
-    Mask() { mask = (mask_t *)__kmp_allocate(__kmp_affin_mask_size); }
+    Mask() { mask = (mask_t *)__kmp_allocate(num_words() * sizeof(mask_t)); }
     ~Mask() {
       if (mask)
         __kmp_free(mask);
@@ -262,40 +268,54 @@ class KMPNativeAffinity : public KMPAffinity {
       mask[i / BITS_PER_MASK_T] &= ~((mask_t)1 << (i % BITS_PER_MASK_T));
     }
     void zero() override {
-      for (size_t i = 0; i < __kmp_affin_mask_size; ++i)
+      for (size_t i = 0; i < num_words(); ++i)
         mask[i] = 0;
     }
     void copy(const KMPAffinity::Mask *src) override {
       const Mask *convert = static_cast<const Mask *>(src);
-      for (size_t i = 0; i < __kmp_affin_mask_size; ++i)
+      for (size_t i = 0; i < num_words(); ++i)
         mask[i] = convert->mask[i];
     }
     void bitwise_and(const KMPAffinity::Mask *rhs) override {
       const Mask *convert = static_cast<const Mask *>(rhs);
-      for (size_t i = 0; i < __kmp_affin_mask_size; ++i)
+      for (size_t i = 0; i < num_words(); ++i)
         mask[i] &= convert->mask[i];
     }
     void bitwise_or(const KMPAffinity::Mask *rhs) override {
       const Mask *convert = static_cast<const Mask *>(rhs);
-      for (size_t i = 0; i < __kmp_affin_mask_size; ++i)
+      for (size_t i = 0; i < num_words(); ++i)
         mask[i] |= convert->mask[i];
     }
     void bitwise_not() override {
-      for (size_t i = 0; i < __kmp_affin_mask_size; ++i)
+      size_t n = num_words();
+      int tail = end() % BITS_PER_MASK_T;
+      for (size_t i = 0; i < n; ++i)
         mask[i] = ~(mask[i]);
+      // Keep the bits past end() clear for begin()/next() and count()
+      if (tail)
+        mask[n - 1] &= ((mask_t)1 << tail) - 1;
     }
-    int begin() const override {
+    int count() const override {
       int retval = 0;
-      while (retval < end() && !is_set(retval))
-        ++retval;
+      for (size_t i = 0; i < num_words(); ++i)
+        retval += __builtin_popcountl(mask[i]);
       return retval;
     }
-    int end() const override { return __kmp_affin_mask_size * BITS_PER_MASK_T; }
+    int begin() const override { return next(-1); }
+    int end() const override { return __kmp_affin_mask_size * CHAR_BIT; }
     int next(int previous) const override {
-      int retval = previous + 1;
-      while (retval < end() && !is_set(retval))
-        ++retval;
-      return retval;
+      int i = previous + 1;
+      if (i >= end())
+        return end();
+      // Skip the zero words, then find the lowest bit of the first other one
+      size_t word = i / BITS_PER_MASK_T;
+      mask_t bits = mask[word] & (~(mask_t)0 << (i % BITS_PER_MASK_T));
+      while (bits == 0) {
+        if (++word >= num_words())
+          return end();
+        bits = mask[word];
+      }
+      return word * BITS_PER_MASK_T + __builtin_ctzl(bits);
     }
     int get_system_affinity(bool abort_on_error) override {
       KMP_ASSERT2(KMP_AFFINITY_CAPABLE(),
@@ -17,6 +17,10 @@
 #include "kmp_io.h"
 #include "kmp_wrapper_malloc.h"
 
+#if KMP_OS_UNIX
+#include <sys/mman.h>
+#endif
+
 // Disable bget when it is not used
 #if KMP_USE_BGET
 
@@ -1210,6 +1214,565 @@ static int bpoolv(kmp_info_t *th, void *buf) {
 
 #endif /* KMP_DEBUG */
 
+/* Size class allocator.
+
+   Requests of up to KMP_SC_MAX_SIZE bytes are rounded up to one of
+   KMP_SC_NUM_CLASSES size classes and carved out of spans: chunks of
+   KMP_SC_SPAN_SIZE bytes, aligned to their size, holding objects of a single
+   class. The span header sits at the start of the span, so the span of an
+   object is found by masking its address. Every thread owns a heap with, for
+   each class, the list of its spans that still have room; allocation and
+   release in the heap of the calling thread need no synchronization.
+
+   An object released by another thread is queued on the heap owning its span.
+   The releasing thread batches such objects per owner and pushes a whole batch
+   with one compare-and-store; the owner takes the queue over when one of its
+   class lists runs empty; a partial batch is pushed when the releasing thread
+   reaches a barrier or goes away. Empty spans go to a pool shared by all
+   threads, and larger requests get a span-aligned mapping of their own. A heap
+   still owning objects when its thread goes away is adopted by the next new
+   thread; the heaps nobody adopted are unmapped with the pool at shutdown. */
+
+#define KMP_SC_SPAN_SIZE ((size_t)64 * 1024)
+#define KMP_SC_MAX_SIZE 16384
+#define KMP_SC_NUM_CLASSES 40 // 16 bytes apart up to 256, then 4 per doubling
+#define KMP_SC_LARGE (-1) // class of a span holding a single large object
+#define KMP_SC_BATCH_SPANS 16 // spans mapped at once
+#define KMP_SC_POOL_MAX 64 // empty spans kept in the pool
+#define KMP_SC_REMOTE_BATCH 32 // remote releases pushed at once
+
+struct kmp_sc_heap;
+
+typedef struct kmp_sc_span {
+  struct kmp_sc_heap *heap; // owner of the span
+  struct kmp_sc_span *next; // links in the class list of the owner or the pool
+  struct kmp_sc_span *prev;
+  struct kmp_sc_span *all_next; // links in the list of all spans of the owner
+  struct kmp_sc_span *all_prev;
+  void *free; // released objects
+  char *bump; // start of the never allocated space
+  char *end; // end of the span
+  size_t size; // size of the mapping
+  kmp_int32 cls; // size class of the objects
+  kmp_int32 used; // number of allocated objects
+  kmp_int32 listed; // the span is in the class list of its owner
+} kmp_sc_span_t;
+
+#define KMP_SC_HEADER_SIZE                                                     \
+  ((sizeof(kmp_sc_span_t) + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1))
+#define KMP_SC_SPAN_OF(ptr)                                                    \
+  ((kmp_sc_span_t *)((kmp_uintptr_t)(ptr) & ~(KMP_SC_SPAN_SIZE - 1)))
+
+typedef struct kmp_sc_heap {
+  kmp_sc_span_t *spans[KMP_SC_NUM_CLASSES]; // spans with room, per class
+  kmp_int32 nspans; // small object spans owned by the heap
+  kmp_sc_span_t *all; // all of them, full ones included
+  // Objects released by this thread to another heap and not pushed yet
+  struct kmp_sc_heap *pend_heap;
+  void *pend_head;
+  void *pend_tail;
+  kmp_int32 pend_count;
+  struct kmp_sc_heap *next_orphan; // link in the list of orphaned heaps
+  // Objects released by other threads, pushed with compare-and-store
+  KMP_ALIGN_CACHE void *volatile remote;
+} kmp_sc_heap_t;
+
+static kmp_uint32 __kmp_sc_size[KMP_SC_NUM_CLASSES];
+static unsigned char __kmp_sc_class[KMP_SC_MAX_SIZE / 16 + 1];
+static int __kmp_sc_classes_ready = FALSE;
+
+// Pool of empty spans and orphaned heaps, protected by __kmp_sc_lock.
+static kmp_sc_span_t *__kmp_sc_pool = NULL;
+static int __kmp_sc_pool_size = 0;
+static kmp_sc_heap_t *__kmp_sc_orphans = NULL;
+static kmp_bootstrap_lock_t __kmp_sc_lock =
+    KMP_BOOTSTRAP_LOCK_INITIALIZER(__kmp_sc_lock);
+
+// Called with __kmp_sc_lock held.
+static void __kmp_sc_init_classes(void) {
+  size_t base;
+  int cls, i;
+
+  for (cls = 0; cls < 16; ++cls)
+    __kmp_sc_size[cls] = 16 * (cls + 1);
+  for (base = 256; base < KMP_SC_MAX_SIZE; base *= 2)
+    for (i = 1; i <= 4; ++i)
+      __kmp_sc_size[cls++] = (kmp_uint32)(base + i * base / 4);
+  KMP_DEBUG_ASSERT(cls == KMP_SC_NUM_CLASSES &&
+                   __kmp_sc_size[cls - 1] == KMP_SC_MAX_SIZE);
+  for (i = 0, cls = 0; i <= KMP_SC_MAX_SIZE / 16; ++i) {
+    while (__kmp_sc_size[cls] < (kmp_uint32)i * 16)
+      ++cls;
+    __kmp_sc_class[i] = (unsigned char)cls;
+  }
+  __kmp_sc_classes_ready = TRUE;
+}
+
+// Maps size bytes aligned to KMP_SC_SPAN_SIZE, size is a multiple of it.
+static void *__kmp_sc_map(size_t size) {
+#if KMP_OS_WINDOWS
+  // The allocation granularity of VirtualAlloc() is 64KB.
+  return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  char *addr, *start;
+
+  addr = (char *)mmap(NULL, size + KMP_SC_SPAN_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == (char *)MAP_FAILED)
+    return NULL;
+  start = (char *)(((kmp_uintptr_t)addr + KMP_SC_SPAN_SIZE - 1) &
+                   ~(KMP_SC_SPAN_SIZE - 1));
+  if (start != addr)
+    munmap(addr, start - addr);
+  if (start != addr + KMP_SC_SPAN_SIZE)
+    munmap(start + size, addr + KMP_SC_SPAN_SIZE - start);
+  return start;
+#endif
+}
+
+static void __kmp_sc_unmap(void *addr, size_t size) {
+#if KMP_OS_WINDOWS
+  VirtualFree(addr, 0, MEM_RELEASE);
+#else
+  munmap(addr, size);
+#endif
+}
+
+static kmp_sc_span_t *__kmp_sc_get_span(void) {
+  kmp_sc_span_t *span;
+
+  __kmp_acquire_bootstrap_lock(&__kmp_sc_lock);
+  span = __kmp_sc_pool;
+  if (span != NULL) {
+    __kmp_sc_pool = span->next;
+    --__kmp_sc_pool_size;
+  }
+  __kmp_release_bootstrap_lock(&__kmp_sc_lock);
+  if (span != NULL)
+    return span;
+
+#if KMP_OS_WINDOWS
+  span = (kmp_sc_span_t *)__kmp_sc_map(KMP_SC_SPAN_SIZE);
+#else
+  // Spans of a batch are unmapped one by one, so the rest of the batch simply
+  // joins the pool.
+  span = (kmp_sc_span_t *)__kmp_sc_map(KMP_SC_BATCH_SPANS * KMP_SC_SPAN_SIZE);
+  if (span != NULL) {
+    int i;
+    __kmp_acquire_bootstrap_lock(&__kmp_sc_lock);
+    for (i = 1; i < KMP_SC_BATCH_SPANS; ++i) {
+      kmp_sc_span_t *s = (kmp_sc_span_t *)((char *)span + i * KMP_SC_SPAN_SIZE);
+      s->next = __kmp_sc_pool;
+      __kmp_sc_pool = s;
+    }
+    __kmp_sc_pool_size += KMP_SC_BATCH_SPANS - 1;
+    __kmp_release_bootstrap_lock(&__kmp_sc_lock);
+  }
+#endif
+  KE_TRACE(10, ("__kmp_sc_get_span: mapped span %p\n", span));
+  return span;
+}
+
+static void __kmp_sc_put_span(kmp_sc_span_t *span) {
+  __kmp_acquire_bootstrap_lock(&__kmp_sc_lock);
+  if (__kmp_sc_pool_size < KMP_SC_POOL_MAX) {
+    span->next = __kmp_sc_pool;
+    __kmp_sc_pool = span;
+    ++__kmp_sc_pool_size;
+    span = NULL;
+  }
+  __kmp_release_bootstrap_lock(&__kmp_sc_lock);
+  if (span != NULL)
+    __kmp_sc_unmap(span, KMP_SC_SPAN_SIZE);
+}
+
+static void __kmp_sc_link(kmp_sc_heap_t *heap, kmp_sc_span_t *span) {
+  kmp_sc_span_t *head = heap->spans[span->cls];
+
+  span->prev = NULL;
+  span->next = head;
+  if (head != NULL)
+    head->prev = span;
+  heap->spans[span->cls] = span;
+  span->listed = TRUE;
+}
+
+static void __kmp_sc_unlink(kmp_sc_heap_t *heap, kmp_sc_span_t *span) {
+  if (span->prev != NULL)
+    span->prev->next = span->next;
+  else
+    heap->spans[span->cls] = span->next;
+  if (span->next != NULL)
+    span->next->prev = span->prev;
+  span->listed = FALSE;
+}
+
+// The heap takes an empty span for small objects.
+static void __kmp_sc_add_span(kmp_sc_heap_t *heap, kmp_sc_span_t *span) {
+  span->all_prev = NULL;
+  span->all_next = heap->all;
+  if (heap->all != NULL)
+    heap->all->all_prev = span;
+  heap->all = span;
+  ++heap->nspans;
+}
+
+// The heap gives an empty span back to the pool.
+static void __kmp_sc_remove_span(kmp_sc_heap_t *heap, kmp_sc_span_t *span) {
+  if (span->all_prev != NULL)
+    span->all_prev->all_next = span->all_next;
+  else
+    heap->all = span->all_next;
+  if (span->all_next != NULL)
+    span->all_next->all_prev = span->all_prev;
+  --heap->nspans;
+  __kmp_sc_put_span(span);
+}
+
+// Release an object of a span owned by heap.
+static void __kmp_sc_free_local(kmp_sc_heap_t *heap, kmp_sc_span_t *span,
+                                void *obj) {
+  *(void **)obj = span->free;
+  span->free = obj;
+  if (--span->used == 0) {
+    // Keep the last span of the class to avoid thrashing the pool.
+    kmp_sc_span_t *head = heap->spans[span->cls];
+    if (span->listed ? head != span || span->next != NULL : head != NULL) {
+      if (span->listed)
+        __kmp_sc_unlink(heap, span);
+      __kmp_sc_remove_span(heap, span);
+      return;
+    }
+  }
+  if (!span->listed)
+    __kmp_sc_link(heap, span);
+}
+
+// Take over the objects released to the heap by other threads.
+static void __kmp_sc_drain(kmp_sc_heap_t *heap) {
+  void *obj = TCR_PTR(heap->remote);
+
+  if (obj == NULL)
+    return;
+  while (!KMP_COMPARE_AND_STORE_PTR(&heap->remote, obj, nullptr)) {
+    KMP_CPU_PAUSE();
+    obj = TCR_PTR(heap->remote);
+  }
+  while (obj != NULL) {
+    void *next = *(void **)obj;
+    __kmp_sc_free_local(heap, KMP_SC_SPAN_OF(obj), obj);
+    obj = next;
+  }
+}
+
+// Push the pending remote releases to their owner.
+static void __kmp_sc_flush(kmp_sc_heap_t *heap) {
+  kmp_sc_heap_t *owner = heap->pend_heap;
+  void *old_value;
+
+  if (owner == NULL)
+    return;
+  old_value = TCR_PTR(owner->remote);
+  *(void **)heap->pend_tail = old_value;
+  while (!KMP_COMPARE_AND_STORE_PTR(&owner->remote, old_value,
+                                    heap->pend_head)) {
+    KMP_CPU_PAUSE();
+    old_value = TCR_PTR(owner->remote);
+    *(void **)heap->pend_tail = old_value;
+  }
+  heap->pend_heap = NULL;
+  heap->pend_head = heap->pend_tail = NULL;
+  heap->pend_count = 0;
+}
+
+static void __kmp_sc_free_remote(kmp_sc_heap_t *heap, kmp_sc_heap_t *owner,
+                                 void *obj) {
+  if (heap->pend_heap != owner) {
+    __kmp_sc_flush(heap);
+    heap->pend_heap = owner;
+    heap->pend_tail = obj;
+  }
+  *(void **)obj = heap->pend_head;
+  heap->pend_head = obj;
+  if (++heap->pend_count >= KMP_SC_REMOTE_BATCH)
+    __kmp_sc_flush(heap);
+}
+
+static void *__kmp_sc_malloc_large(kmp_sc_heap_t *heap, size_t size) {
+  size_t map_size = (size + KMP_SC_HEADER_SIZE + KMP_SC_SPAN_SIZE - 1) &
+                    ~(KMP_SC_SPAN_SIZE - 1);
+  kmp_sc_span_t *span;
+
+  if (map_size < size)
+    return NULL;
+  if (map_size == KMP_SC_SPAN_SIZE)
+    span = __kmp_sc_get_span();
+  else
+    span = (kmp_sc_span_t *)__kmp_sc_map(map_size);
+  if (span == NULL)
+    return NULL;
+  span->heap = heap;
+  span->next = span->prev = NULL;
+  span->free = NULL;
+  span->bump = span->end = (char *)span + map_size;
+  span->size = map_size;
+  span->cls = KMP_SC_LARGE;
+  span->used = 1;
+  span->listed = FALSE;
+  return (char *)span + KMP_SC_HEADER_SIZE;
+}
+
+static void *__kmp_sc_malloc(kmp_info_t *th, size_t size) {
+  kmp_sc_heap_t *heap = (kmp_sc_heap_t *)th->th.th_local.sc_heap;
+  kmp_sc_span_t *span;
+  size_t obj_size;
+  void *obj;
+  int cls;
+
+  KMP_DEBUG_ASSERT(heap != NULL);
+  if (size > KMP_SC_MAX_SIZE)
+    return __kmp_sc_malloc_large(heap, size);
+  cls = __kmp_sc_class[(size + 15) >> 4];
+  obj_size = __kmp_sc_size[cls];
+  span = heap->spans[cls];
+  if (span == NULL) {
+    __kmp_sc_drain(heap);
+    span = heap->spans[cls];
+    if (span == NULL) {
+      span = __kmp_sc_get_span();
+      if (span == NULL)
+        return NULL;
+      span->heap = heap;
+      span->free = NULL;
+      span->bump = (char *)span + KMP_SC_HEADER_SIZE;
+      span->end = (char *)span + KMP_SC_SPAN_SIZE;
+      span->size = KMP_SC_SPAN_SIZE;
+      span->cls = cls;
+      span->used = 0;
+      __kmp_sc_add_span(heap, span);
+      __kmp_sc_link(heap, span);
+    }
+  }
+  obj = span->free;
+  if (obj != NULL) {
+    span->free = *(void **)obj;
+  } else {
+    obj = span->bump;
+    span->bump += obj_size;
+  }
+  ++span->used;
+  if (span->free == NULL && (size_t)(span->end - span->bump) < obj_size)
+    __kmp_sc_unlink(heap, span);
+  return obj;
+}
+
+static void __kmp_sc_free(kmp_info_t *th, void *ptr) {
+  kmp_sc_heap_t *heap = (kmp_sc_heap_t *)th->th.th_local.sc_heap;
+  kmp_sc_span_t *span = KMP_SC_SPAN_OF(ptr);
+
+  KMP_DEBUG_ASSERT(heap != NULL && span->heap != NULL);
+  if (span->cls == KMP_SC_LARGE) {
+    if (span->size == KMP_SC_SPAN_SIZE)
+      __kmp_sc_put_span(span);
+    else
+      __kmp_sc_unmap(span, span->size);
+  } else if (span->heap == heap) {
+    __kmp_sc_free_local(heap, span, ptr);
+  } else {
+    __kmp_sc_free_remote(heap, span->heap, ptr);
+  }
+}
+
+static size_t __kmp_sc_usable_size(void *ptr) {
+  kmp_sc_span_t *span = KMP_SC_SPAN_OF(ptr);
+
+  if (span->cls == KMP_SC_LARGE)
+    return span->size - KMP_SC_HEADER_SIZE;
+  return __kmp_sc_size[span->cls];
+}
+
+static void *__kmp_sc_realloc(kmp_info_t *th, void *ptr, size_t size) {
+  size_t old_size;
+  void *nptr;
+
+  if (ptr == NULL)
+    return __kmp_sc_malloc(th, size);
+  old_size = __kmp_sc_usable_size(ptr);
+  if (size <= old_size && size > old_size / 2)
+    return ptr;
+  nptr = __kmp_sc_malloc(th, size);
+  if (nptr == NULL)
+    return NULL;
+  KMP_MEMCPY(nptr, ptr, size < old_size ? size : old_size);
+  __kmp_sc_free(th, ptr);
+  return nptr;
+}
+
+// Free space in the spans of the heap: the largest class with room and the
+// total of the free objects.
+static void __kmp_sc_check(kmp_sc_heap_t *heap, size_t *max_free,
+                           size_t *total_free) {
+  int cls;
+
+  *max_free = *total_free = 0;
+  for (cls = 0; cls < KMP_SC_NUM_CLASSES; ++cls) {
+    size_t obj_size = __kmp_sc_size[cls];
+    kmp_sc_span_t *span;
+    for (span = heap->spans[cls]; span != NULL; span = span->next) {
+      size_t capacity = (KMP_SC_SPAN_SIZE - KMP_SC_HEADER_SIZE) / obj_size;
+      *total_free += (capacity - span->used) * obj_size;
+      *max_free = obj_size;
+    }
+  }
+}
+
+static void __kmp_sc_print(kmp_info_t *th) {
+  kmp_sc_heap_t *heap = (kmp_sc_heap_t *)th->th.th_local.sc_heap;
+  int gtid = __kmp_gtid_from_thread(th);
+  int cls;
+
+  __kmp_printf_no_lock("__kmp_printpool: T#%d spans=%d pooled=%d\n", gtid,
+                       (int)heap->nspans, __kmp_sc_pool_size);
+  for (cls = 0; cls < KMP_SC_NUM_CLASSES; ++cls) {
+    size_t obj_size = __kmp_sc_size[cls];
+    size_t capacity = (KMP_SC_SPAN_SIZE - KMP_SC_HEADER_SIZE) / obj_size;
+    kmp_sc_span_t *span;
+    for (span = heap->spans[cls]; span != NULL; span = span->next)
+      __kmp_printf_no_lock("__kmp_printpool: T#%d Span: 0x%p size %6ld bytes, "
+                           "%d of %d free.\n",
+                           gtid, span, (long)obj_size,
+                           (int)(capacity - span->used), (int)capacity);
+  }
+}
+
+static void __kmp_sc_initialize(kmp_info_t *th) {
+  kmp_sc_heap_t *heap;
+
+  if (th->th.th_local.sc_heap != NULL)
+    return;
+  __kmp_acquire_bootstrap_lock(&__kmp_sc_lock);
+  if (!__kmp_sc_classes_ready)
+    __kmp_sc_init_classes();
+  heap = __kmp_sc_orphans;
+  if (heap != NULL)
+    __kmp_sc_orphans = heap->next_orphan;
+  __kmp_release_bootstrap_lock(&__kmp_sc_lock);
+  if (heap == NULL)
+    heap = (kmp_sc_heap_t *)__kmp_allocate(sizeof(kmp_sc_heap_t));
+  heap->next_orphan = NULL;
+  th->th.th_local.sc_heap = heap;
+}
+
+static void __kmp_sc_finalize(kmp_info_t *th) {
+  kmp_sc_heap_t *heap = (kmp_sc_heap_t *)th->th.th_local.sc_heap;
+  int cls;
+
+  if (heap == NULL)
+    return;
+  th->th.th_local.sc_heap = NULL;
+  __kmp_sc_flush(heap);
+  __kmp_sc_drain(heap);
+  for (cls = 0; cls < KMP_SC_NUM_CLASSES; ++cls) {
+    kmp_sc_span_t *span = heap->spans[cls];
+    while (span != NULL) {
+      kmp_sc_span_t *next = span->next;
+      if (span->used == 0) {
+        __kmp_sc_unlink(heap, span);
+        __kmp_sc_remove_span(heap, span);
+      }
+      span = next;
+    }
+  }
+  if (heap->nspans == 0) {
+    __kmp_free(heap);
+    return;
+  }
+  // Objects of the heap are still in use and may be released by any thread.
+  KE_TRACE(10, ("__kmp_sc_finalize: T#%d orphans heap %p with %d spans\n",
+                __kmp_gtid_from_thread(th), heap, (int)heap->nspans));
+  __kmp_acquire_bootstrap_lock(&__kmp_sc_lock);
+  heap->next_orphan = __kmp_sc_orphans;
+  __kmp_sc_orphans = heap;
+  __kmp_release_bootstrap_lock(&__kmp_sc_lock);
+}
+
+// Push the remote releases of the thread that are still pending, at a barrier.
+void __kmp_sc_flush_remote(kmp_info_t *th) {
+  kmp_sc_heap_t *heap = (kmp_sc_heap_t *)th->th.th_local.sc_heap;
+
+  if (heap != NULL && heap->pend_heap != NULL)
+    __kmp_sc_flush(heap);
+}
+
+// All threads are gone: unmap the empty spans and the heaps nobody adopted,
+// whose objects the program never released.
+void __kmp_cleanup_sizeclass(void) {
+  kmp_sc_span_t *span;
+  kmp_sc_heap_t *heap;
+
+  __kmp_acquire_bootstrap_lock(&__kmp_sc_lock);
+  span = __kmp_sc_pool;
+  __kmp_sc_pool = NULL;
+  __kmp_sc_pool_size = 0;
+  heap = __kmp_sc_orphans;
+  __kmp_sc_orphans = NULL;
+  __kmp_release_bootstrap_lock(&__kmp_sc_lock);
+  while (span != NULL) {
+    kmp_sc_span_t *next = span->next;
+    __kmp_sc_unmap(span, KMP_SC_SPAN_SIZE);
+    span = next;
+  }
+  while (heap != NULL) {
+    kmp_sc_heap_t *next = heap->next_orphan;
+    KE_TRACE(10, ("__kmp_cleanup_sizeclass: heap %p with %d spans\n", heap,
+                  (int)heap->nspans));
+    for (span = heap->all; span != NULL;) {
+      kmp_sc_span_t *next_span = span->all_next;
+      __kmp_sc_unmap(span, KMP_SC_SPAN_SIZE);
+      span = next_span;
+    }
+    __kmp_free(heap);
+    heap = next;
+  }
+}
+
+// The lock may have been held by another thread of the parent at fork().
+void __kmp_atfork_sizeclass(void) {
+  __kmp_init_bootstrap_lock(&__kmp_sc_lock);
+}
+
+// Thread-private allocation from the allocator selected by KMP_MALLOC_KIND.
+static void *__kmp_pool_get(kmp_info_t *th, size_t size) {
+  if (__kmp_malloc_kind == kmp_malloc_sizeclass)
+    return __kmp_sc_malloc(th, size);
+  return bget(th, (bufsize)size);
+}
+
+static void *__kmp_pool_getz(kmp_info_t *th, size_t size) {
+  if (__kmp_malloc_kind == kmp_malloc_sizeclass) {
+    void *ptr = __kmp_sc_malloc(th, size);
+    if (ptr != NULL)
+      memset(ptr, 0, size);
+    return ptr;
+  }
+  return bgetz(th, (bufsize)size);
+}
+
+static void *__kmp_pool_getr(kmp_info_t *th, void *ptr, size_t size) {
+  if (__kmp_malloc_kind == kmp_malloc_sizeclass)
+    return __kmp_sc_realloc(th, ptr, size);
+  return bgetr(th, ptr, (bufsize)size);
+}
+
+static void __kmp_pool_rel(kmp_info_t *th, void *ptr) {
+  if (__kmp_malloc_kind == kmp_malloc_sizeclass) {
+    __kmp_sc_free(th, ptr);
+    return;
+  }
+  __kmp_bget_dequeue(th); /* Release any queued buffers */
+  brel(th, ptr);
+}
+
 void __kmp_initialize_bget(kmp_info_t *th) {
   KMP_DEBUG_ASSERT(SizeQuant >= sizeof(void *) && (th != 0));
 
@@ -1217,6 +1780,9 @@ void __kmp_initialize_bget(kmp_info_t *th) {
 
   bectl(th, (bget_compact_t)0, (bget_acquire_t)malloc, (bget_release_t)free,
         (bufsize)__kmp_malloc_pool_incr);
+
+  if (__kmp_malloc_kind == kmp_malloc_sizeclass)
+    __kmp_sc_initialize(th);
 }
 
 void __kmp_finalize_bget(kmp_info_t *th) {
@@ -1225,6 +1791,8 @@ void __kmp_finalize_bget(kmp_info_t *th) {
 
   KMP_DEBUG_ASSERT(th != 0);
 
+  __kmp_sc_finalize(th);
+
 #if BufStats
   thr = (thr_data_t *)th->th.th_local.bget_data;
   KMP_DEBUG_ASSERT(thr != NULL);
@@ -1296,6 +1864,14 @@ void kmpc_get_poolstat(size_t *maxmem, size_t *allmem) {
   kmp_info_t *th = __kmp_get_thread();
   bufsize a, b;
 
+  if (__kmp_malloc_kind == kmp_malloc_sizeclass) {
+    kmp_sc_heap_t *heap = (kmp_sc_heap_t *)th->th.th_local.sc_heap;
+    __kmp_sc_flush(heap);
+    __kmp_sc_drain(heap);
+    __kmp_sc_check(heap, maxmem, allmem);
+    return;
+  }
+
   __kmp_bget_dequeue(th); /* Release any queued buffers */
 
   bcheck(th, &a, &b);
@@ -1307,6 +1883,14 @@ void kmpc_get_poolstat(size_t *maxmem, size_t *allmem) {
 void kmpc_poolprint(void) {
   kmp_info_t *th = __kmp_get_thread();
 
+  if (__kmp_malloc_kind == kmp_malloc_sizeclass) {
+    kmp_sc_heap_t *heap = (kmp_sc_heap_t *)th->th.th_local.sc_heap;
+    __kmp_sc_flush(heap);
+    __kmp_sc_drain(heap);
+    __kmp_sc_print(th);
+    return;
+  }
+
   __kmp_bget_dequeue(th); /* Release any queued buffers */
 
   bfreed(th);
@@ -1316,7 +1900,7 @@ void kmpc_poolprint(void) {
 
 void *kmpc_malloc(size_t size) {
   void *ptr;
-  ptr = bget(__kmp_entry_thread(), (bufsize)(size + sizeof(ptr)));
+  ptr = __kmp_pool_get(__kmp_entry_thread(), size + sizeof(ptr));
   if (ptr != NULL) {
     // save allocated pointer just before one returned to user
     *(void **)ptr = ptr;
@@ -1337,7 +1921,7 @@ void *kmpc_aligned_malloc(size_t size, size_t alignment) {
     return NULL;
   }
   size = size + sizeof(void *) + alignment;
-  ptr_allocated = bget(__kmp_entry_thread(), (bufsize)size);
+  ptr_allocated = __kmp_pool_get(__kmp_entry_thread(), size);
   if (ptr_allocated != NULL) {
     // save allocated pointer just before one returned to user
     ptr = (void *)(((kmp_uintptr_t)ptr_allocated + sizeof(void *) + alignment) &
@@ -1351,7 +1935,7 @@ void *kmpc_aligned_malloc(size_t size, size_t alignment) {
 
 void *kmpc_calloc(size_t nelem, size_t elsize) {
   void *ptr;
-  ptr = bgetz(__kmp_entry_thread(), (bufsize)(nelem * elsize + sizeof(ptr)));
+  ptr = __kmp_pool_getz(__kmp_entry_thread(), nelem * elsize + sizeof(ptr));
   if (ptr != NULL) {
     // save allocated pointer just before one returned to user
     *(void **)ptr = ptr;
@@ -1364,7 +1948,7 @@ void *kmpc_realloc(void *ptr, size_t size) {
   void *result = NULL;
   if (ptr == NULL) {
     // If pointer is NULL, realloc behaves like malloc.
-    result = bget(__kmp_entry_thread(), (bufsize)(size + sizeof(ptr)));
+    result = __kmp_pool_get(__kmp_entry_thread(), size + sizeof(ptr));
     // save allocated pointer just before one returned to user
     if (result != NULL) {
       *(void **)result = result;
@@ -1377,10 +1961,10 @@ void *kmpc_realloc(void *ptr, size_t size) {
     // So it should be safe to call __kmp_get_thread(), not
     // __kmp_entry_thread().
     KMP_ASSERT(*((void **)ptr - 1));
-    brel(__kmp_get_thread(), *((void **)ptr - 1));
+    __kmp_pool_rel(__kmp_get_thread(), *((void **)ptr - 1));
   } else {
-    result = bgetr(__kmp_entry_thread(), *((void **)ptr - 1),
-                   (bufsize)(size + sizeof(ptr)));
+    result = __kmp_pool_getr(__kmp_entry_thread(), *((void **)ptr - 1),
+                             size + sizeof(ptr));
     if (result != NULL) {
       *(void **)result = result;
       result = (void **)result + 1;
@@ -1396,18 +1980,308 @@ void kmpc_free(void *ptr) {
   }; // if
   if (ptr != NULL) {
     kmp_info_t *th = __kmp_get_thread();
-    __kmp_bget_dequeue(th); /* Release any queued buffers */
     // extract allocated pointer and free it
     KMP_ASSERT(*((void **)ptr - 1));
-    brel(th, *((void **)ptr - 1));
+    __kmp_pool_rel(th, *((void **)ptr - 1));
   };
 }
 
+#if OMP_50_ENABLED
+/* OpenMP 5.0 memory management.
+
+   The predefined allocators and the ones made by omp_init_allocator() take
+   their memory from one of three sources, chosen by the traits:
+   - the thread-private pool of the allocating thread (see KMP_MALLOC_KIND),
+     which is the default. Blocks freed by another thread are handed back to
+     the pool of their owner;
+   - the system malloc, for the large capacity memory space;
+   - anonymous mappings on Linux, for pinned memory and for memory whose pages
+     are placed on NUMA nodes by the partition trait: on the node of the
+     allocating thread's place (nearest), one block per node (blocked) or
+     interleaved across the nodes.
+   The other memory spaces are backed by regular memory. */
+
+#define KMP_MEM_PLACEMENT (KMP_OS_LINUX && KMP_AFFINITY_SUPPORTED)
+
+enum kmp_mem_kind { kmp_mem_bget, kmp_mem_malloc, kmp_mem_mmap };
+
+// Stored just before every pointer returned by __kmpc_alloc
+typedef struct kmp_mem_desc {
+  void *ptr_alloc; // start of the underlying block
+  size_t size_a; // size of the underlying block, charged to the pool
+  kmp_allocator_t *allocator; // allocator charged, NULL if predefined
+  enum kmp_mem_kind kind; // where the block comes from
+} kmp_mem_desc_t;
+
+// Fill al with the traits of a predefined allocator.
+static void __kmp_predefined_allocator(omp_allocator_handle_t handle,
+                                       kmp_allocator_t *al) {
+  memset(al, 0, sizeof(*al));
+  al->memspace = omp_default_mem_space;
+  al->fb = omp_atv_default_mem_fb;
+  al->fb_data = omp_null_allocator;
+  al->partition = omp_atv_environment;
+  switch (handle) {
+  case omp_large_cap_mem_alloc:
+    al->memspace = omp_large_cap_mem_space;
+    break;
+  case omp_const_mem_alloc:
+    al->memspace = omp_const_mem_space;
+    break;
+  case omp_high_bw_mem_alloc:
+    al->memspace = omp_high_bw_mem_space;
+    break;
+  case omp_low_lat_mem_alloc:
+    al->memspace = omp_low_lat_mem_space;
+    break;
+  case kmp_interleaved_mem_alloc:
+    al->partition = omp_atv_interleaved;
+    break;
+  case kmp_numa_local_mem_alloc:
+    al->partition = omp_atv_nearest;
+    break;
+  default:
+    break;
+  }
+}
+
+#if KMP_MEM_PLACEMENT
+static size_t __kmp_mem_map_size(size_t size) {
+  size_t page = KMP_GET_PAGE_SIZE();
+  return (size + page - 1) & ~(page - 1);
+}
+
+// Map size bytes and place their pages as requested by the partition trait.
+// Placement is best effort, a failure to bind only leaves the pages where the
+// first touch puts them.
+static void *__kmp_mem_map(kmp_info_t *th, size_t size,
+                           const kmp_allocator_t *al) {
+  size_t len = __kmp_mem_map_size(size);
+  void *ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED)
+    return NULL;
+
+  switch (al->partition) {
+  case omp_atv_nearest: {
+    int node = __kmp_numa_thread_node(th);
+    if (node >= 0)
+      __kmp_numa_bind(ptr, len, node);
+  } break;
+  case omp_atv_blocked: {
+    int nnodes = __kmp_numa_num_nodes();
+    if (nnodes > 0) {
+      size_t block = __kmp_mem_map_size((len + nnodes - 1) / nnodes);
+      for (int node = 0; node < nnodes && node * block < len; node++)
+        __kmp_numa_bind((char *)ptr + node * block,
+                        KMP_MIN(block, len - node * block), node);
+    }
+  } break;
+  case omp_atv_interleaved:
+    __kmp_numa_bind(ptr, len, -1);
+    break;
+  default:
+    break;
+  }
+
+  if (al->pinned && mlock(ptr, len) != 0) {
+    KE_TRACE(10, ("__kmp_mem_map: mlock(%p, %lu) failed: %d\n", ptr,
+                  (unsigned long)len, errno));
+    munmap(ptr, len);
+    return NULL;
+  }
+  return ptr;
+}
+#endif // KMP_MEM_PLACEMENT
+
+static void *__kmp_mem_get(kmp_info_t *th, const kmp_allocator_t *al,
+                           size_t size, enum kmp_mem_kind *kind) {
+#if KMP_MEM_PLACEMENT
+  if (al->pinned || al->partition != omp_atv_environment) {
+    *kind = kmp_mem_mmap;
+    return __kmp_mem_map(th, size, al);
+  }
+#endif
+  if (al->memspace == omp_large_cap_mem_space) {
+    *kind = kmp_mem_malloc;
+    return malloc(size);
+  }
+  *kind = kmp_mem_bget;
+  return __kmp_pool_get(th, size);
+}
+
+omp_allocator_handle_t __kmpc_init_allocator(int gtid,
+                                             omp_memspace_handle_t memspace,
+                                             int ntraits,
+                                             const omp_alloctrait_t traits[]) {
+  kmp_allocator_t *al;
+  int i;
+
+  al = (kmp_allocator_t *)__kmp_allocate(sizeof(kmp_allocator_t));
+  __kmp_predefined_allocator(omp_default_mem_alloc, al);
+  al->memspace = memspace;
+  for (i = 0; i < ntraits; ++i) {
+    omp_uintptr_t value = traits[i].value;
+    switch (traits[i].key) {
+    case omp_atk_sync_hint:
+    case omp_atk_access:
+      // Every allocator is thread safe and its memory is accessible by all
+      // threads.
+      break;
+    case omp_atk_alignment:
+      if (value == 0 || !IS_POWER_OF_TWO(value))
+        goto invalid;
+      al->alignment = value;
+      break;
+    case omp_atk_pool_size:
+      al->pool_size = value;
+      break;
+    case omp_atk_fallback:
+      if (value < omp_atv_default_mem_fb || value > omp_atv_allocator_fb)
+        goto invalid;
+      al->fb = (omp_alloctrait_value_t)value;
+      break;
+    case omp_atk_fb_data:
+      al->fb_data = (omp_allocator_handle_t)value;
+      break;
+    case omp_atk_pinned:
+      al->pinned = (value != omp_atv_false);
+      break;
+    case omp_atk_partition:
+      if (value < omp_atv_environment || value > omp_atv_interleaved)
+        goto invalid;
+      al->partition = (omp_alloctrait_value_t)value;
+      break;
+    default:
+      goto invalid;
+    }
+  }
+  if (al->fb == omp_atv_allocator_fb &&
+      (al->fb_data == omp_null_allocator ||
+       al->fb_data == (omp_allocator_handle_t)(kmp_uintptr_t)al))
+    goto invalid;
+  KE_TRACE(10, ("__kmpc_init_allocator: T#%d allocator %p\n", gtid, al));
+  return (omp_allocator_handle_t)(kmp_uintptr_t)al;
+
+invalid:
+  __kmp_free(al);
+  return omp_null_allocator;
+}
+
+void __kmpc_destroy_allocator(int gtid, omp_allocator_handle_t allocator) {
+  if ((omp_uintptr_t)allocator > KMP_MAX_PREDEFINED_ALLOCATOR)
+    __kmp_free((void *)(kmp_uintptr_t)allocator);
+}
+
+void __kmpc_set_default_allocator(int gtid, omp_allocator_handle_t allocator) {
+  __kmp_threads[gtid]->th.th_def_allocator = allocator;
+}
+
+omp_allocator_handle_t __kmpc_get_default_allocator(int gtid) {
+  omp_allocator_handle_t allocator = __kmp_threads[gtid]->th.th_def_allocator;
+  return allocator == omp_null_allocator ? __kmp_def_allocator : allocator;
+}
+
+void *__kmpc_alloc(int gtid, size_t size, omp_allocator_handle_t allocator) {
+  kmp_info_t *th = __kmp_threads[gtid];
+  kmp_allocator_t predefined, *al;
+  kmp_mem_desc_t desc;
+  kmp_uintptr_t addr;
+  size_t align;
+  void *ptr;
+  int fallbacks = 0;
+
+  KE_TRACE(25, ("__kmpc_alloc: T#%d (%d, %p)\n", gtid, (int)size,
+                (void *)allocator));
+  if (allocator == omp_null_allocator)
+    allocator = __kmpc_get_default_allocator(gtid);
+  for (;;) {
+    if ((omp_uintptr_t)allocator > KMP_MAX_PREDEFINED_ALLOCATOR) {
+      al = (kmp_allocator_t *)(kmp_uintptr_t)allocator;
+      desc.allocator = al;
+    } else {
+      __kmp_predefined_allocator(allocator, &predefined);
+      al = &predefined;
+      desc.allocator = NULL;
+    }
+    align = KMP_MAX(al->alignment, sizeof(void *));
+    desc.size_a = size + sizeof(kmp_mem_desc_t) + align;
+
+    ptr = NULL;
+    if (al->pool_size > 0 &&
+        (kmp_uint64)(KMP_TEST_THEN_ADD64(&al->pool_used, desc.size_a) +
+                     desc.size_a) > al->pool_size) {
+      // The pool is exhausted
+      KMP_TEST_THEN_ADD64(&al->pool_used, -(kmp_int64)desc.size_a);
+    } else {
+      ptr = __kmp_mem_get(th, al, desc.size_a, &desc.kind);
+      if (ptr == NULL && al->pool_size > 0)
+        KMP_TEST_THEN_ADD64(&al->pool_used, -(kmp_int64)desc.size_a);
+    }
+    if (ptr != NULL)
+      break;
+
+    switch (al->fb) {
+    case omp_atv_abort_fb:
+      KMP_FATAL(MemoryAllocFailed);
+      break;
+    case omp_atv_allocator_fb:
+      if (++fallbacks > KMP_MAX_ALLOCATOR_FALLBACKS)
+        return NULL;
+      allocator = al->fb_data;
+      break;
+    case omp_atv_default_mem_fb:
+      if (allocator == omp_default_mem_alloc)
+        return NULL;
+      allocator = omp_default_mem_alloc;
+      break;
+    default:
+      return NULL;
+    }
+  }
+
+  addr = ((kmp_uintptr_t)ptr + sizeof(kmp_mem_desc_t) + align - 1) &
+         ~(kmp_uintptr_t)(align - 1);
+  desc.ptr_alloc = ptr;
+  *((kmp_mem_desc_t *)addr - 1) = desc;
+  KE_TRACE(25, ("__kmpc_alloc returns %p, T#%d\n", (void *)addr, gtid));
+  return (void *)addr;
+}
+
+// The allocator argument may be omp_null_allocator, the block records the
+// allocator it was taken from.
+void __kmpc_free(int gtid, void *ptr, omp_allocator_handle_t allocator) {
+  kmp_mem_desc_t desc;
+
+  KE_TRACE(25, ("__kmpc_free: T#%d free(%p)\n", gtid, ptr));
+  if (ptr == NULL)
+    return;
+  desc = *((kmp_mem_desc_t *)ptr - 1);
+  switch (desc.kind) {
+  case kmp_mem_bget:
+    __kmp_pool_rel(__kmp_threads[gtid], desc.ptr_alloc);
+    break;
+  case kmp_mem_malloc:
+    free(desc.ptr_alloc);
+    break;
+#if KMP_MEM_PLACEMENT
+  case kmp_mem_mmap:
+    munmap(desc.ptr_alloc, __kmp_mem_map_size(desc.size_a));
+    break;
+#endif
+  default:
+    KMP_ASSERT(0);
+  }
+  if (desc.allocator != NULL && desc.allocator->pool_size > 0)
+    KMP_TEST_THEN_ADD64(&desc.allocator->pool_used, -(kmp_int64)desc.size_a);
+}
+#endif // OMP_50_ENABLED
+
 void *___kmp_thread_malloc(kmp_info_t *th, size_t size KMP_SRC_LOC_DECL) {
   void *ptr;
   KE_TRACE(30, ("-> __kmp_thread_malloc( %p, %d ) called from %s:%d\n", th,
                 (int)size KMP_SRC_LOC_PARM));
-  ptr = bget(th, (bufsize)size);
+  ptr = __kmp_pool_get(th, size);
   KE_TRACE(30, ("<- __kmp_thread_malloc() returns %p\n", ptr));
   return ptr;
 }
@@ -1417,7 +2291,7 @@ void *___kmp_thread_calloc(kmp_info_t *th, size_t nelem,
   void *ptr;
   KE_TRACE(30, ("-> __kmp_thread_calloc( %p, %d, %d ) called from %s:%d\n", th,
                 (int)nelem, (int)elsize KMP_SRC_LOC_PARM));
-  ptr = bgetz(th, (bufsize)(nelem * elsize));
+  ptr = __kmp_pool_getz(th, nelem * elsize);
   KE_TRACE(30, ("<- __kmp_thread_calloc() returns %p\n", ptr));
   return ptr;
 }
@@ -1426,7 +2300,7 @@ void *___kmp_thread_realloc(kmp_info_t *th, void *ptr,
                             size_t size KMP_SRC_LOC_DECL) {
   KE_TRACE(30, ("-> __kmp_thread_realloc( %p, %p, %d ) called from %s:%d\n", th,
                 ptr, (int)size KMP_SRC_LOC_PARM));
-  ptr = bgetr(th, ptr, (bufsize)size);
+  ptr = __kmp_pool_getr(th, ptr, size);
   KE_TRACE(30, ("<- __kmp_thread_realloc() returns %p\n", ptr));
   return ptr;
 }
@@ -1434,12 +2308,258 @@ void *___kmp_thread_realloc(kmp_info_t *th, void *ptr,
 void ___kmp_thread_free(kmp_info_t *th, void *ptr KMP_SRC_LOC_DECL) {
   KE_TRACE(30, ("-> __kmp_thread_free( %p, %p ) called from %s:%d\n", th,
                 ptr KMP_SRC_LOC_PARM));
+  if (ptr != NULL)
+    __kmp_pool_rel(th, ptr);
+  KE_TRACE(30, ("<- __kmp_thread_free()\n"));
+}
+
+#if KMP_OS_LINUX
+/* Internal arena.
+
+   With KMP_HUGE_PAGES set, __kmp_allocate() and __kmp_page_allocate() take
+   their blocks from 2MB chunks backed by huge pages instead of malloc(), so
+   that the thread, team, barrier and task deque structures touched on every
+   fork and barrier share a few TLB entries. There is an arena per NUMA node;
+   a block comes from the arena of the node the calling thread runs on, so the
+   structures a thread allocates for itself (task deques, private common
+   blocks, consistency stacks) are local to it. Blocks are rounded up to one of
+   KMP_ARENA_NUM_CLASSES size classes and recycled through per-class free
+   lists, blocks larger than KMP_ARENA_MAX_SIZE get a huge page mapping of
+   their own. Each arena has its own lock, so that the threads of different
+   nodes do not wait for each other. */
+
+#define KMP_ARENA_CHUNK_SIZE ((size_t)2 * 1024 * 1024)
+#define KMP_ARENA_MIN_SIZE ((size_t)64)
+#define KMP_ARENA_MAX_SIZE ((size_t)1024 * 1024)
+#define KMP_ARENA_NUM_CLASSES 57 // 64 bytes, then 4 per doubling up to 1MB
+#define KMP_ARENA_MAX_NODES 64
+
+typedef struct KMP_ALIGN_CACHE kmp_arena {
+  kmp_bootstrap_lock_t lock; // initialized on first use of the arena
+  volatile kmp_int32 ready;
+  // Cleared when the arena is released
+  void *free[KMP_ARENA_NUM_CLASSES]; // released blocks, per size class
+  char *bump; // unused space at the end of the current chunk
+  char *end;
+  void *chunks; // mapped chunks, linked through their first word
+  // Statistics
+  kmp_uint64 nchunks; // chunks mapped
+  kmp_uint64 nfallback; // chunks mapped with transparent huge pages instead
+  // of explicit ones
+  kmp_uint64 nalloc; // blocks allocated
+  kmp_uint64 nfree; // blocks released
+  kmp_uint64 nlarge; // blocks with a mapping of their own
+  size_t used; // bytes in allocated blocks
+  size_t peak; // highest value of used
+} kmp_arena_t;
+
+static kmp_arena_t __kmp_arenas[KMP_ARENA_MAX_NODES];
+// Only serializes the initialization of the arena locks.
+static kmp_bootstrap_lock_t __kmp_arena_lock =
+    KMP_BOOTSTRAP_LOCK_INITIALIZER(__kmp_arena_lock);
+
+// The arena of the node, its lock is initialized on the first call.
+static kmp_arena_t *__kmp_arena_get(int node) {
+  kmp_arena_t *arena = &__kmp_arenas[node];
+
+  if (!TCR_4(arena->ready)) {
+    __kmp_acquire_bootstrap_lock(&__kmp_arena_lock);
+    if (!arena->ready) {
+      __kmp_init_bootstrap_lock(&arena->lock);
+      TCW_4(arena->ready, TRUE);
+    }
+    __kmp_release_bootstrap_lock(&__kmp_arena_lock);
+  }
+  return arena;
+}
+
+// Size class of a block of size bytes, the class size is returned in size.
+static int __kmp_arena_class(size_t *size) {
+  size_t base = KMP_ARENA_MIN_SIZE, step;
+  int cls = 0, k;
+
+  if (*size <= base) {
+    *size = base;
+    return 0;
+  }
+  while (*size > 2 * base) {
+    base *= 2;
+    cls += 4;
+  }
+  step = base / 4;
+  k = (int)((*size - base + step - 1) / step);
+  *size = base + k * step;
+  return cls + k;
+}
+
+// Map size bytes of huge pages, size is a multiple of KMP_ARENA_CHUNK_SIZE.
+static void *__kmp_arena_map(kmp_arena_t *arena, size_t size, int node) {
+  char *addr = (char *)MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if (__kmp_huge_pages == kmp_huge_pages_explicit) {
+    addr = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr == (char *)MAP_FAILED)
+      ++arena->nfallback;
+  }
+#endif
+  if (addr == (char *)MAP_FAILED) {
+    // Over-map to align the chunk, only aligned ranges get huge pages.
+    char *start;
+    addr = (char *)mmap(NULL, size + KMP_ARENA_CHUNK_SIZE,
+                        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1, 0);
+    if (addr == (char *)MAP_FAILED)
+      return NULL;
+    start = (char *)(((kmp_uintptr_t)addr + KMP_ARENA_CHUNK_SIZE - 1) &
+                     ~(KMP_ARENA_CHUNK_SIZE - 1));
+    if (start != addr)
+      munmap(addr, start - addr);
+    if (start != addr + KMP_ARENA_CHUNK_SIZE)
+      munmap(start + size, addr + KMP_ARENA_CHUNK_SIZE - start);
+    addr = start;
+#ifdef MADV_HUGEPAGE
+    madvise(addr, size, MADV_HUGEPAGE);
+#endif
+  }
+#if KMP_AFFINITY_SUPPORTED
+  // Pages are placed on first touch, which is ours in ___kmp_allocate_align().
+  if (node >= 0)
+    __kmp_numa_bind(addr, size, node);
+#endif
+  return addr;
+}
+
+// NUMA node of the calling thread, -1 if memory placement is of no use.
+static int __kmp_arena_node(void) {
+#if KMP_AFFINITY_SUPPORTED
+  if (__kmp_numa_num_nodes() > 1) {
+    int node = __kmp_numa_proc_node_of(sched_getcpu());
+    if (node < KMP_ARENA_MAX_NODES)
+      return node;
+  }
+#endif
+  return -1;
+}
+
+// Allocate a block of at least *size bytes. The size of the block is returned
+// in *size and its arena in *owner, for __kmp_arena_free().
+static void *__kmp_arena_allocate(size_t *size, void **owner) {
+  int node = __kmp_arena_node();
+  kmp_arena_t *arena = __kmp_arena_get(node < 0 ? 0 : node);
+  void *ptr;
+
+  if (*size > KMP_ARENA_MAX_SIZE) {
+    *size = (*size + KMP_ARENA_CHUNK_SIZE - 1) & ~(KMP_ARENA_CHUNK_SIZE - 1);
+    __kmp_acquire_bootstrap_lock(&arena->lock);
+    ptr = __kmp_arena_map(arena, *size, node);
+    if (ptr != NULL)
+      ++arena->nlarge;
+  } else {
+    int cls = __kmp_arena_class(size);
+    __kmp_acquire_bootstrap_lock(&arena->lock);
+    ptr = arena->free[cls];
+    if (ptr != NULL) {
+      arena->free[cls] = *(void **)ptr;
+    } else {
+      if ((size_t)(arena->end - arena->bump) < *size) {
+        // The rest of the chunk is left unused, the classes are too coarse to
+        // recycle it.
+        char *chunk =
+            (char *)__kmp_arena_map(arena, KMP_ARENA_CHUNK_SIZE, node);
+        if (chunk == NULL) {
+          __kmp_release_bootstrap_lock(&arena->lock);
+          return NULL;
+        }
+        *(void **)chunk = arena->chunks;
+        arena->chunks = chunk;
+        arena->bump = chunk + CACHE_LINE;
+        arena->end = chunk + KMP_ARENA_CHUNK_SIZE;
+        ++arena->nchunks;
+      }
+      ptr = arena->bump;
+      arena->bump += *size;
+    }
+  }
   if (ptr != NULL) {
-    __kmp_bget_dequeue(th); /* Release any queued buffers */
-    brel(th, ptr);
+    ++arena->nalloc;
+    arena->used += *size;
+    if (arena->used > arena->peak)
+      arena->peak = arena->used;
   }
-  KE_TRACE(30, ("<- __kmp_thread_free()\n"));
+  __kmp_release_bootstrap_lock(&arena->lock);
+  *owner = arena;
+  return ptr;
+}
+
+static void __kmp_arena_free(void *owner, void *ptr, size_t size) {
+  kmp_arena_t *arena = (kmp_arena_t *)owner;
+
+  __kmp_acquire_bootstrap_lock(&arena->lock);
+  ++arena->nfree;
+  arena->used -= size;
+  if (size > KMP_ARENA_MAX_SIZE) {
+    munmap(ptr, size);
+  } else {
+    int cls = __kmp_arena_class(&size);
+    *(void **)ptr = arena->free[cls];
+    arena->free[cls] = ptr;
+  }
+  __kmp_release_bootstrap_lock(&arena->lock);
+}
+
+// Report the arena usage if requested and release the arenas no longer in use.
+void __kmp_cleanup_arena(void) {
+  int i;
+
+  for (i = 0; i < KMP_ARENA_MAX_NODES; ++i) {
+    kmp_arena_t *arena = &__kmp_arenas[i];
+    if (!TCR_4(arena->ready))
+      continue;
+    __kmp_acquire_bootstrap_lock(&arena->lock);
+    if (arena->nalloc == 0) {
+      __kmp_release_bootstrap_lock(&arena->lock);
+      continue;
+    }
+    if (__kmp_huge_pages_stats) {
+      __kmp_printf("OMP: Info: arena node %d: %" KMP_UINT64_SPEC
+                   " chunks (%" KMP_UINT64_SPEC " KB), %" KMP_UINT64_SPEC
+                   " large blocks, %" KMP_UINT64_SPEC
+                   " mappings without explicit huge pages\n",
+                   i, arena->nchunks,
+                   arena->nchunks * (KMP_ARENA_CHUNK_SIZE / 1024),
+                   arena->nlarge, arena->nfallback);
+      __kmp_printf("OMP: Info: arena node %d: %" KMP_UINT64_SPEC
+                   " allocations, %" KMP_UINT64_SPEC " frees, %" KMP_UINT64_SPEC
+                   " KB in use, %" KMP_UINT64_SPEC " KB peak\n",
+                   i, arena->nalloc, arena->nfree,
+                   (kmp_uint64)arena->used / 1024,
+                   (kmp_uint64)arena->peak / 1024);
+    }
+    if (arena->used == 0) {
+      void *chunk = arena->chunks;
+      while (chunk != NULL) {
+        void *next = *(void **)chunk;
+        munmap(chunk, KMP_ARENA_CHUNK_SIZE);
+        chunk = next;
+      }
+      memset(&arena->free, 0, sizeof(*arena) - offsetof(kmp_arena_t, free));
+    }
+    __kmp_release_bootstrap_lock(&arena->lock);
+  }
+}
+
+// The locks may have been held by other threads of the parent at fork().
+void __kmp_atfork_arena(void) {
+  int i;
+
+  __kmp_init_bootstrap_lock(&__kmp_arena_lock);
+  for (i = 0; i < KMP_ARENA_MAX_NODES; ++i)
+    if (__kmp_arenas[i].ready)
+      __kmp_init_bootstrap_lock(&__kmp_arenas[i].lock);
 }
+#endif // KMP_OS_LINUX
 
 /* If LEAK_MEMORY is defined, __kmp_free() will *not* free memory. It causes
    memory leaks, but it may be useful for debugging memory corruptions, used
@@ -1450,6 +2570,7 @@ struct kmp_mem_descr { // Memory block descriptor.
   size_t size_allocated; // Size of allocated memory block.
   void *ptr_aligned; // Pointer to aligned memory, to be used by client code.
   size_t size_aligned; // Size of aligned memory block.
+  void *arena; // Arena of the block, NULL if it was returned by malloc().
 };
 typedef struct kmp_mem_descr kmp_mem_descr_t;
 
@@ -1490,11 +2611,22 @@ static void *___kmp_allocate_align(size_t size,
   descr.size_allocated =
       descr.size_aligned + sizeof(kmp_mem_descr_t) + alignment;
 
+  descr.arena = NULL;
+#if KMP_OS_LINUX
+  if (__kmp_huge_pages != kmp_huge_pages_disabled) {
+    descr.ptr_allocated =
+        __kmp_arena_allocate(&descr.size_allocated, &descr.arena);
+  } else
+#endif
+  {
 #if KMP_DEBUG
-  descr.ptr_allocated = _malloc_src_loc(descr.size_allocated, _file_, _line_);
+    descr.ptr_allocated =
+        _malloc_src_loc(descr.size_allocated, _file_, _line_);
 #else
-  descr.ptr_allocated = malloc_src_loc(descr.size_allocated KMP_SRC_LOC_PARM);
+    descr.ptr_allocated =
+        malloc_src_loc(descr.size_allocated KMP_SRC_LOC_PARM);
 #endif
+  }
   KE_TRACE(10, ("   malloc( %d ) returned %p\n", (int)descr.size_allocated,
                 descr.ptr_allocated));
   if (descr.ptr_allocated == NULL) {
@@ -1628,10 +2760,15 @@ void ___kmp_free(void *ptr KMP_SRC_LOC_DECL) {
 
 #ifndef LEAK_MEMORY
   KE_TRACE(10, ("   free( %p )\n", descr.ptr_allocated));
+#if KMP_OS_LINUX
+  if (descr.arena != NULL)
+    __kmp_arena_free(descr.arena, descr.ptr_allocated, descr.size_allocated);
+  else
+#endif
 #ifdef KMP_DEBUG
-  _free_src_loc(descr.ptr_allocated, _file_, _line_);
+    _free_src_loc(descr.ptr_allocated, _file_, _line_);
 #else
-  free_src_loc(descr.ptr_allocated KMP_SRC_LOC_PARM);
+    free_src_loc(descr.ptr_allocated KMP_SRC_LOC_PARM);
 #endif
 #endif
   KMP_MB();
@@ -1718,7 +2855,7 @@ alloc_call:
   KE_TRACE(25, ("__kmp_fast_allocate: T#%d Calling __kmp_thread_malloc with "
                 "alloc_size %d\n",
                 __kmp_gtid_from_thread(this_thr), alloc_size));
-  alloc_ptr = bget(this_thr, (bufsize)alloc_size);
+  alloc_ptr = __kmp_pool_get(this_thr, alloc_size);
 
   // align ptr to DCACHE_LINE
   ptr = (void *)((((kmp_uintptr_t)alloc_ptr) + sizeof(kmp_mem_descr_t) +
@@ -1842,8 +2979,7 @@ void ___kmp_fast_free(kmp_info_t *this_thr, void *ptr KMP_SRC_LOC_DECL) {
 free_call:
   KE_TRACE(25, ("__kmp_fast_free: T#%d Calling __kmp_thread_free for size %d\n",
                 __kmp_gtid_from_thread(this_thr), size));
-  __kmp_bget_dequeue(this_thr); /* Release any queued buffers */
-  brel(this_thr, descr->ptr_allocated);
+  __kmp_pool_rel(this_thr, descr->ptr_allocated);
 
 end:
   KE_TRACE(25, ("<- __kmp_fast_free() returns\n"));
@@ -1869,6 +3005,32 @@ void __kmp_free_fast_memory(kmp_info_t *th) {
   KE_TRACE(
       5, ("__kmp_free_fast_memory: Called T#%d\n", __kmp_gtid_from_thread(th)));
 
+  if (__kmp_malloc_kind == kmp_malloc_sizeclass) {
+    // Size class spans are not released along with the thread, give the
+    // cached blocks back one by one so that the heap can drop its spans.
+    int index;
+    for (index = 0; index < NUM_LISTS; ++index) {
+      kmp_free_list_t *fl = &th->th.th_free_lists[index];
+      void *lists[3] = {fl->th_free_list_self, fl->th_free_list_sync,
+                        fl->th_free_list_other};
+      int i;
+      for (i = 0; i < 3; ++i) {
+        void *ptr = lists[i];
+        while (ptr != NULL) {
+          void *next = *(void **)ptr;
+          __kmp_sc_free(th, ((kmp_mem_descr_t *)((kmp_uintptr_t)ptr -
+                                                 sizeof(kmp_mem_descr_t)))
+                                ->ptr_allocated);
+          ptr = next;
+        }
+      }
+      memset(fl, 0, sizeof(*fl));
+    }
+    KE_TRACE(5, ("__kmp_free_fast_memory: Freed T#%d\n",
+                 __kmp_gtid_from_thread(th)));
+    return;
+  }
+
   __kmp_bget_dequeue(th); // Release any queued buffers
 
   // Dig through free lists and extract all allocated blocks
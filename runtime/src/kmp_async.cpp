@@ -0,0 +1,275 @@
+/*
+ * kmp_async.cpp -- Asynchronous launch of parallel regions.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp.h"
+#include "kmp_i18n.h"
+
+/* An asynchronous parallel region is forked by a launcher thread rather than by
+   the caller. The launcher registers itself as a new root the first time it
+   forks, so each launcher owns a hot team whose workers are taken from the
+   shared thread pool. The caller gets a handle back immediately and may keep
+   doing serial work, launch more regions (on other launchers, hence on disjoint
+   teams) and later test or wait on the handle.
+
+   Launchers are cached once their region completes, so the next launch reuses
+   both the OS thread and its hot team. At shutdown the idle launchers are
+   stopped and joined, and their roots unregistered. On platforms without
+   launcher support the region is executed synchronously by the caller and the
+   returned handle is already complete. */
+
+static ident_t loc_async = {0, KMP_IDENT_KMPC, 0, 0, ";unknown;unknown;0;0;;"};
+
+struct kmp_async_region {
+  void (*ar_fn)(void *); // user routine executed by every thread of the team
+  void *ar_data; // argument passed to ar_fn
+  int ar_nthreads; // requested team size, 0 means the default
+  volatile kmp_int32 ar_done; // set once the region has been joined
+  kmp_async_launcher_t *ar_launcher; // launcher executing the region
+};
+
+struct kmp_async_launcher {
+  kmp_async_launcher_t *al_next; // next idle launcher
+  kmp_async_region_t *volatile al_region; // region to launch, NULL when idle
+  int al_gtid; // of the root of the launcher once it has forked
+  volatile kmp_int32 al_stop; // set at shutdown, the launcher exits
+#if KMP_OS_UNIX
+  pthread_t al_thread;
+  pthread_mutex_t al_mutex;
+  pthread_cond_t al_cond;
+#endif
+};
+
+// Idle launchers, protected by __kmp_async_lock.
+static kmp_async_launcher_t *__kmp_async_idle = NULL;
+static kmp_bootstrap_lock_t __kmp_async_lock =
+    KMP_BOOTSTRAP_LOCK_INITIALIZER(__kmp_async_lock);
+
+static void __kmp_async_microtask(int *gtid, int *tid,
+                                  kmp_async_region_t *region) {
+  region->ar_fn(region->ar_data);
+}
+
+// Fork and join the region from the calling thread.
+static void __kmp_async_invoke(kmp_async_region_t *region) {
+  int gtid = __kmp_entry_gtid();
+
+  KA_TRACE(10, ("__kmp_async_invoke: T#%d region %p nthreads %d\n", gtid,
+                region, region->ar_nthreads));
+  if (region->ar_nthreads > 0)
+    __kmpc_push_num_threads(&loc_async, gtid, region->ar_nthreads);
+  __kmpc_fork_call(&loc_async, 1, (kmpc_micro)__kmp_async_microtask, region);
+}
+
+#if KMP_OS_UNIX
+
+static void *__kmp_async_launcher_main(void *arg) {
+  kmp_async_launcher_t *launcher = (kmp_async_launcher_t *)arg;
+  int status;
+
+  status = pthread_mutex_lock(&launcher->al_mutex);
+  KMP_CHECK_SYSFAIL("pthread_mutex_lock", status);
+  for (;;) {
+    kmp_async_region_t *region;
+    while ((region = launcher->al_region) == NULL && !launcher->al_stop) {
+      status = pthread_cond_wait(&launcher->al_cond, &launcher->al_mutex);
+      KMP_CHECK_SYSFAIL("pthread_cond_wait", status);
+    }
+    status = pthread_mutex_unlock(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_unlock", status);
+    if (region == NULL)
+      break; // __kmp_async_fini() unregisters the root
+
+    // The first invocation registers this thread as a new root.
+    __kmp_async_invoke(region);
+    launcher->al_gtid = __kmp_get_gtid();
+
+    status = pthread_mutex_lock(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_lock", status);
+    launcher->al_region = NULL;
+    // The waiter may free the region as soon as the mutex is released.
+    TCW_4(region->ar_done, TRUE);
+    status = pthread_cond_broadcast(&launcher->al_cond);
+    KMP_CHECK_SYSFAIL("pthread_cond_broadcast", status);
+
+    __kmp_acquire_bootstrap_lock(&__kmp_async_lock);
+    launcher->al_next = __kmp_async_idle;
+    __kmp_async_idle = launcher;
+    __kmp_release_bootstrap_lock(&__kmp_async_lock);
+  }
+  return NULL;
+}
+
+static kmp_async_launcher_t *__kmp_async_create_launcher(void) {
+  kmp_async_launcher_t *launcher;
+  pthread_attr_t attr;
+  int status;
+
+  launcher =
+      (kmp_async_launcher_t *)__kmp_allocate(sizeof(kmp_async_launcher_t));
+  status = pthread_mutex_init(&launcher->al_mutex, NULL);
+  KMP_CHECK_SYSFAIL("pthread_mutex_init", status);
+  status = pthread_cond_init(&launcher->al_cond, NULL);
+  KMP_CHECK_SYSFAIL("pthread_cond_init", status);
+
+  launcher->al_gtid = KMP_GTID_DNE;
+  launcher->al_stop = FALSE;
+
+  status = pthread_attr_init(&attr);
+  KMP_CHECK_SYSFAIL("pthread_attr_init", status);
+  // Joined by __kmp_async_fini().
+  status = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+  KMP_CHECK_SYSFAIL("pthread_attr_setdetachstate", status);
+  // The launcher acts as a master thread, give it a worker-sized stack.
+  status = pthread_attr_setstacksize(&attr, __kmp_stksize);
+  KMP_CHECK_SYSFAIL("pthread_attr_setstacksize", status);
+  status = pthread_create(&launcher->al_thread, &attr,
+                          __kmp_async_launcher_main, launcher);
+  if (status != 0)
+    KMP_SYSFAIL("pthread_create", status);
+  status = pthread_attr_destroy(&attr);
+  KMP_CHECK_SYSFAIL("pthread_attr_destroy", status);
+
+  KA_TRACE(10, ("__kmp_async_create_launcher: created launcher %p\n",
+                launcher));
+  return launcher;
+}
+
+#endif // KMP_OS_UNIX
+
+kmp_async_region_t *__kmp_async_launch(void (*fn)(void *), void *data,
+                                       int nthreads) {
+  kmp_async_region_t *region;
+
+  // Make sure the caller is registered and the thread pool is available.
+  __kmp_entry_gtid();
+  if (!TCR_4(__kmp_init_parallel))
+    __kmp_parallel_initialize();
+
+  region = (kmp_async_region_t *)__kmp_allocate(sizeof(kmp_async_region_t));
+  region->ar_fn = fn;
+  region->ar_data = data;
+  region->ar_nthreads = nthreads;
+  region->ar_done = FALSE;
+
+#if KMP_OS_UNIX
+  {
+    kmp_async_launcher_t *launcher;
+    int status;
+
+    __kmp_acquire_bootstrap_lock(&__kmp_async_lock);
+    launcher = __kmp_async_idle;
+    if (launcher != NULL)
+      __kmp_async_idle = launcher->al_next;
+    __kmp_release_bootstrap_lock(&__kmp_async_lock);
+    if (launcher == NULL)
+      launcher = __kmp_async_create_launcher();
+
+    region->ar_launcher = launcher;
+    status = pthread_mutex_lock(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_lock", status);
+    KMP_DEBUG_ASSERT(launcher->al_region == NULL);
+    launcher->al_next = NULL;
+    launcher->al_region = region;
+    status = pthread_cond_broadcast(&launcher->al_cond);
+    KMP_CHECK_SYSFAIL("pthread_cond_broadcast", status);
+    status = pthread_mutex_unlock(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_unlock", status);
+  }
+#else
+  region->ar_launcher = NULL;
+  __kmp_async_invoke(region);
+  TCW_4(region->ar_done, TRUE);
+#endif
+  return region;
+}
+
+int __kmp_async_test(kmp_async_region_t *region) {
+  if (region == NULL)
+    return TRUE;
+  KMP_MB();
+  return TCR_4(region->ar_done);
+}
+
+void __kmp_async_wait(kmp_async_region_t *region) {
+  if (region == NULL)
+    return;
+#if KMP_OS_UNIX
+  if (!TCR_4(region->ar_done)) {
+    kmp_async_launcher_t *launcher = region->ar_launcher;
+    int status;
+
+    status = pthread_mutex_lock(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_lock", status);
+    while (!TCR_4(region->ar_done)) {
+      status = pthread_cond_wait(&launcher->al_cond, &launcher->al_mutex);
+      KMP_CHECK_SYSFAIL("pthread_cond_wait", status);
+    }
+    status = pthread_mutex_unlock(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_unlock", status);
+  }
+#endif
+  KMP_DEBUG_ASSERT(TCR_4(region->ar_done));
+  __kmp_free(region);
+}
+
+/* Stop and join the idle launchers and unregister their roots. Called by
+   __kmp_internal_end() with __kmp_forkjoin_lock held, once g_done is set, so
+   the exiting launchers do not try to unregister themselves. A launcher still
+   running a region is an active root, it is left alone like any other. */
+void __kmp_async_fini(void) {
+#if KMP_OS_UNIX
+  kmp_async_launcher_t *idle;
+  int status;
+
+  __kmp_acquire_bootstrap_lock(&__kmp_async_lock);
+  idle = __kmp_async_idle;
+  __kmp_async_idle = NULL;
+  __kmp_release_bootstrap_lock(&__kmp_async_lock);
+
+  while (idle != NULL) {
+    kmp_async_launcher_t *launcher = idle;
+    void *exit_val;
+    idle = launcher->al_next;
+
+    status = pthread_mutex_lock(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_lock", status);
+    launcher->al_stop = TRUE;
+    status = pthread_cond_broadcast(&launcher->al_cond);
+    KMP_CHECK_SYSFAIL("pthread_cond_broadcast", status);
+    status = pthread_mutex_unlock(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_unlock", status);
+    status = pthread_join(launcher->al_thread, &exit_val);
+    KMP_CHECK_SYSFAIL("pthread_join", status);
+
+    KA_TRACE(10, ("__kmp_async_fini: joined launcher %p T#%d\n", launcher,
+                  launcher->al_gtid));
+    if (launcher->al_gtid >= 0 && KMP_UBER_GTID(launcher->al_gtid))
+      __kmp_unregister_root_other_thread(launcher->al_gtid);
+    status = pthread_cond_destroy(&launcher->al_cond);
+    KMP_CHECK_SYSFAIL("pthread_cond_destroy", status);
+    status = pthread_mutex_destroy(&launcher->al_mutex);
+    KMP_CHECK_SYSFAIL("pthread_mutex_destroy", status);
+    __kmp_free(launcher);
+  }
+#endif
+}
+
+// Launcher threads do not survive fork(), forget about them in the child.
+void __kmp_async_reset(void) {
+  __kmp_async_idle = NULL;
+  __kmp_init_bootstrap_lock(&__kmp_async_lock);
+}
+
+// end of file //
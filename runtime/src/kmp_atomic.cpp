@@ -575,30 +575,8 @@ KMP_ALIGN(128)
 
 // Control access to all user coded atomics in Gnu compat mode
 kmp_atomic_lock_t __kmp_atomic_lock;
-// Control access to all user coded atomics for 1-byte fixed data types
-kmp_atomic_lock_t __kmp_atomic_lock_1i;
-// Control access to all user coded atomics for 2-byte fixed data types
-kmp_atomic_lock_t __kmp_atomic_lock_2i;
-// Control access to all user coded atomics for 4-byte fixed data types
-kmp_atomic_lock_t __kmp_atomic_lock_4i;
-// Control access to all user coded atomics for kmp_real32 data type
-kmp_atomic_lock_t __kmp_atomic_lock_4r;
-// Control access to all user coded atomics for 8-byte fixed data types
-kmp_atomic_lock_t __kmp_atomic_lock_8i;
-// Control access to all user coded atomics for kmp_real64 data type
-kmp_atomic_lock_t __kmp_atomic_lock_8r;
-// Control access to all user coded atomics for complex byte data type
-kmp_atomic_lock_t __kmp_atomic_lock_8c;
-// Control access to all user coded atomics for long double data type
-kmp_atomic_lock_t __kmp_atomic_lock_10r;
-// Control access to all user coded atomics for _Quad data type
-kmp_atomic_lock_t __kmp_atomic_lock_16r;
-// Control access to all user coded atomics for double complex data type
-kmp_atomic_lock_t __kmp_atomic_lock_16c;
-// Control access to all user coded atomics for long double complex type
-kmp_atomic_lock_t __kmp_atomic_lock_20c;
-// Control access to all user coded atomics for _Quad complex data type
-kmp_atomic_lock_t __kmp_atomic_lock_32c;
+// Address-hashed locks for all other non-native atomics, see kmp_atomic.h
+kmp_atomic_lock_t __kmp_atomic_lock_stripes[KMP_ATOMIC_LOCK_STRIPES];
 
 /* 2007-03-02:
    Without "volatile" specifier in OP_CMPXCHG and MIN_MAX_CMPXCHG we have a bug
@@ -701,20 +679,21 @@ static inline void operator/=(kmp_cmplx128_a16_t &lhs,
     KA_TRACE(100, ("__kmpc_atomic_" #TYPE_ID "_" #OP_ID ": T#%d\n", gtid));
 
 // ------------------------------------------------------------------------
-// Lock variables used for critical sections for various size operands
-#define ATOMIC_LOCK0 __kmp_atomic_lock // all types, for Gnu compat
-#define ATOMIC_LOCK1i __kmp_atomic_lock_1i // char
-#define ATOMIC_LOCK2i __kmp_atomic_lock_2i // short
-#define ATOMIC_LOCK4i __kmp_atomic_lock_4i // long int
-#define ATOMIC_LOCK4r __kmp_atomic_lock_4r // float
-#define ATOMIC_LOCK8i __kmp_atomic_lock_8i // long long int
-#define ATOMIC_LOCK8r __kmp_atomic_lock_8r // double
-#define ATOMIC_LOCK8c __kmp_atomic_lock_8c // float complex
-#define ATOMIC_LOCK10r __kmp_atomic_lock_10r // long double
-#define ATOMIC_LOCK16r __kmp_atomic_lock_16r // _Quad
-#define ATOMIC_LOCK16c __kmp_atomic_lock_16c // double complex
-#define ATOMIC_LOCK20c __kmp_atomic_lock_20c // long double complex
-#define ATOMIC_LOCK32c __kmp_atomic_lock_32c // _Quad complex
+// Lock variables used for critical sections for various size operands. All
+// sizes share the address-hashed stripes, so the lock only depends on ADDR.
+#define ATOMIC_LOCK0(ADDR) (&__kmp_atomic_lock) // all types, for Gnu compat
+#define ATOMIC_LOCK1i(ADDR) __kmp_get_atomic_lock(ADDR) // char
+#define ATOMIC_LOCK2i(ADDR) __kmp_get_atomic_lock(ADDR) // short
+#define ATOMIC_LOCK4i(ADDR) __kmp_get_atomic_lock(ADDR) // long int
+#define ATOMIC_LOCK4r(ADDR) __kmp_get_atomic_lock(ADDR) // float
+#define ATOMIC_LOCK8i(ADDR) __kmp_get_atomic_lock(ADDR) // long long int
+#define ATOMIC_LOCK8r(ADDR) __kmp_get_atomic_lock(ADDR) // double
+#define ATOMIC_LOCK8c(ADDR) __kmp_get_atomic_lock(ADDR) // float complex
+#define ATOMIC_LOCK10r(ADDR) __kmp_get_atomic_lock(ADDR) // long double
+#define ATOMIC_LOCK16r(ADDR) __kmp_get_atomic_lock(ADDR) // _Quad
+#define ATOMIC_LOCK16c(ADDR) __kmp_get_atomic_lock(ADDR) // double complex
+#define ATOMIC_LOCK20c(ADDR) __kmp_get_atomic_lock(ADDR) // long double complex
+#define ATOMIC_LOCK32c(ADDR) __kmp_get_atomic_lock(ADDR) // _Quad complex
 
 // ------------------------------------------------------------------------
 // Operation on *lhs, rhs bound by critical section
@@ -723,11 +702,11 @@ static inline void operator/=(kmp_cmplx128_a16_t &lhs,
 // Note: don't check gtid as it should always be valid
 // 1, 2-byte - expect valid parameter, other - check before this macro
 #define OP_CRITICAL(OP, LCK_ID)                                                \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   (*lhs) OP(rhs);                                                              \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);
 
 // ------------------------------------------------------------------------
 // For GNU compatibility, we may need to use a critical section,
@@ -818,6 +797,77 @@ static inline void operator/=(kmp_cmplx128_a16_t &lhs,
 // end of the first part of the workaround for C78287
 #endif // USE_CMPXCHG_FIX
 
+#if KMP_ARCH_X86_64 && KMP_OS_UNIX
+// ------------------------------------------------------------------------
+// 16-byte operands (_Quad, double complex) are updated with cmpxchg16b when
+// the CPU supports it and the target is 16-byte aligned, otherwise they use
+// the lock stripe of the address. Every routine on these types makes the
+// same choice for a given address, so the two paths never mix.
+#define KMP_ATOMIC_CAS16 1
+
+template <typename TYPE> struct __kmp_atomic_cas16_type {
+  static const bool value = false;
+};
+template <> struct __kmp_atomic_cas16_type<kmp_cmplx64> {
+  static const bool value = true;
+};
+#if KMP_HAVE_QUAD
+template <> struct __kmp_atomic_cas16_type<_Quad> {
+  static const bool value = true;
+};
+#endif
+
+// Stores desired to *addr if it still contains expected. On failure the
+// current contents of *addr are returned in expected.
+static inline int __kmp_compare_and_store128(volatile kmp_uint64 *addr,
+                                             kmp_uint64 *expected,
+                                             const kmp_uint64 *desired) {
+  unsigned char ok;
+  __asm__ __volatile__("lock; cmpxchg16b %1\n\tsete %0"
+                       : "=q"(ok), "+m"(*addr), "+a"(expected[0]),
+                         "+d"(expected[1])
+                       : "b"(desired[0]), "c"(desired[1])
+                       : "memory", "cc");
+  return ok;
+}
+
+#define ATOMIC_CAS16_OK(TYPE, ADDR)                                            \
+  (__kmp_atomic_cas16_type<TYPE>::value && __kmp_cpuinfo.cx16 &&               \
+   !((kmp_uintptr_t)(ADDR)&0xf))
+
+// Operation on *ADDR using 16-byte "compare_and_store": new_value is computed
+// from old_value and stored if *ADDR has not changed in the meantime. Values
+// are moved through raw images, so padding bits are compared as well.
+//     TYPE      - operands' type
+//     ADDR      - target address
+//     NEW_VALUE - expression of old_value (and rhs) to store
+#define OP_CMPXCHG16(TYPE, ADDR, NEW_VALUE)                                    \
+  {                                                                            \
+    kmp_uint64 old_raw[2], new_raw[2];                                         \
+    KMP_MEMCPY(old_raw, (void *)(ADDR), sizeof(TYPE));                         \
+    for (;;) {                                                                 \
+      KMP_MEMCPY(&old_value, old_raw, sizeof(TYPE));                           \
+      new_value = NEW_VALUE;                                                   \
+      KMP_MEMCPY(new_raw, &new_value, sizeof(TYPE));                           \
+      if (__kmp_compare_and_store128((volatile kmp_uint64 *)(ADDR), old_raw,   \
+                                     new_raw))                                 \
+        break;                                                                 \
+      KMP_DO_PAUSE;                                                            \
+    }                                                                          \
+  }
+
+// Lock free path of the critical routines for 16-byte operands
+//     RET - statement completing the routine, may use old_value and new_value
+#define ATOMIC_CAS16(TYPE, ADDR, NEW_VALUE, RET)                               \
+  if (ATOMIC_CAS16_OK(TYPE, ADDR)) {                                           \
+    TYPE old_value, new_value;                                                 \
+    OP_CMPXCHG16(TYPE, ADDR, NEW_VALUE)                                        \
+    RET;                                                                       \
+  }
+#else
+#define ATOMIC_CAS16(TYPE, ADDR, NEW_VALUE, RET)
+#endif // KMP_ARCH_X86_64 && KMP_OS_UNIX
+
 #if KMP_ARCH_X86 || KMP_ARCH_X86_64
 
 // ------------------------------------------------------------------------
@@ -1084,12 +1134,12 @@ ATOMIC_CMPX_L(fixed8, orl, kmp_int64, 64, ||, 8i, 7,
 // MIN and MAX need separate macros
 // OP - operator to check if we need any actions?
 #define MIN_MAX_CRITSECT(OP, LCK_ID)                                           \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   if (*lhs OP rhs) { /* still need actions? */                                 \
     *lhs = rhs;                                                                \
   }                                                                            \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);
 
 // -------------------------------------------------------------------------
 #ifdef KMP_GOMP_COMPAT
@@ -1127,6 +1177,7 @@ ATOMIC_CMPX_L(fixed8, orl, kmp_int64, 64, ||, 8i, 7,
   ATOMIC_BEGIN(TYPE_ID, OP_ID, TYPE, void)                                     \
   if (*lhs OP rhs) { /* need actions? */                                       \
     GOMP_MIN_MAX_CRITSECT(OP, GOMP_FLAG)                                       \
+    ATOMIC_CAS16(TYPE, lhs, (old_value OP rhs) ? rhs : old_value, return)      \
     MIN_MAX_CRITSECT(OP, LCK_ID)                                               \
   }                                                                            \
   }
@@ -1260,6 +1311,7 @@ ATOMIC_CMPX_EQV(fixed8, eqv, kmp_int64, 64, ^~, 8i, 7,
 #define ATOMIC_CRITICAL(TYPE_ID, OP_ID, TYPE, OP, LCK_ID, GOMP_FLAG)           \
   ATOMIC_BEGIN(TYPE_ID, OP_ID, TYPE, void)                                     \
   OP_GOMP_CRITICAL(OP## =, GOMP_FLAG) /* send assignment */                    \
+  ATOMIC_CAS16(TYPE, lhs, old_value OP rhs, return)                            \
   OP_CRITICAL(OP## =, LCK_ID) /* send assignment */                            \
   }
 
@@ -1360,11 +1412,11 @@ ATOMIC_CRITICAL(cmplx16, div_a16, kmp_cmplx128_a16_t, /, 32c,
 // Note: don't check gtid as it should always be valid
 // 1, 2-byte - expect valid parameter, other - check before this macro
 #define OP_CRITICAL_REV(OP, LCK_ID)                                            \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   (*lhs) = (rhs)OP(*lhs);                                                      \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);
 
 #ifdef KMP_GOMP_COMPAT
 #define OP_GOMP_CRITICAL_REV(OP, FLAG)                                         \
@@ -1506,6 +1558,7 @@ ATOMIC_CMPXCHG_REV(float8, sub, kmp_real64, 64, -, 8r,
 #define ATOMIC_CRITICAL_REV(TYPE_ID, OP_ID, TYPE, OP, LCK_ID, GOMP_FLAG)       \
   ATOMIC_BEGIN_REV(TYPE_ID, OP_ID, TYPE, void)                                 \
   OP_GOMP_CRITICAL_REV(OP, GOMP_FLAG)                                          \
+  ATOMIC_CAS16(TYPE, lhs, (rhs)OP(old_value), return)                          \
   OP_CRITICAL_REV(OP, LCK_ID)                                                  \
   }
 
@@ -1908,11 +1961,11 @@ ATOMIC_CMPXCHG_CMPLX(cmplx4, kmp_cmplx32, div, 64, /, cmplx8, kmp_cmplx64, 8c,
 // Note: don't check gtid as it should always be valid
 // 1, 2-byte - expect valid parameter, other - check before this macro
 #define OP_CRITICAL_READ(OP, LCK_ID)                                           \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(loc), gtid);                   \
                                                                                \
   new_value = (*loc);                                                          \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(loc), gtid);
 
 // -------------------------------------------------------------------------
 #ifdef KMP_GOMP_COMPAT
@@ -1951,6 +2004,7 @@ ATOMIC_CMPXCHG_CMPLX(cmplx4, kmp_cmplx32, div, 64, /, cmplx8, kmp_cmplx64, 8c,
   ATOMIC_BEGIN_READ(TYPE_ID, OP_ID, TYPE, TYPE)                                \
   TYPE new_value;                                                              \
   OP_GOMP_CRITICAL_READ(OP## =, GOMP_FLAG) /* send assignment */               \
+  ATOMIC_CAS16(TYPE, loc, old_value, return old_value)                         \
   OP_CRITICAL_READ(OP, LCK_ID) /* send assignment */                           \
   return new_value;                                                            \
   }
@@ -1962,11 +2016,11 @@ ATOMIC_CMPXCHG_CMPLX(cmplx4, kmp_cmplx32, div, 64, /, cmplx8, kmp_cmplx64, 8c,
 #if (KMP_OS_WINDOWS)
 
 #define OP_CRITICAL_READ_WRK(OP, LCK_ID)                                       \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(loc), gtid);                   \
                                                                                \
   (*out) = (*loc);                                                             \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(loc), gtid);
 // ------------------------------------------------------------------------
 #ifdef KMP_GOMP_COMPAT
 #define OP_GOMP_CRITICAL_READ_WRK(OP, FLAG)                                    \
@@ -2095,6 +2149,7 @@ ATOMIC_CRITICAL_READ(cmplx16, a16_rd, kmp_cmplx128_a16_t, +, 32c,
 #define ATOMIC_CRITICAL_WR(TYPE_ID, OP_ID, TYPE, OP, LCK_ID, GOMP_FLAG)        \
   ATOMIC_BEGIN(TYPE_ID, OP_ID, TYPE, void)                                     \
   OP_GOMP_CRITICAL(OP, GOMP_FLAG) /* send assignment */                        \
+  ATOMIC_CAS16(TYPE, lhs, rhs, return)                                         \
   OP_CRITICAL(OP, LCK_ID) /* send assignment */                                \
   }
 // -------------------------------------------------------------------------
@@ -2166,7 +2221,7 @@ ATOMIC_CRITICAL_WR(cmplx16, a16_wr, kmp_cmplx128_a16_t, =, 32c,
 // Note: don't check gtid as it should always be valid
 // 1, 2-byte - expect valid parameter, other - check before this macro
 #define OP_CRITICAL_CPT(OP, LCK_ID)                                            \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   if (flag) {                                                                  \
     (*lhs) OP rhs;                                                             \
@@ -2176,7 +2231,7 @@ ATOMIC_CRITICAL_WR(cmplx16, a16_wr, kmp_cmplx128_a16_t, =, 32c,
     (*lhs) OP rhs;                                                             \
   }                                                                            \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
   return new_value;
 
 // ------------------------------------------------------------------------
@@ -2502,14 +2557,14 @@ ATOMIC_CRITICAL_CPT_MIX(float10, long double, div_cpt, /, fp, _Quad, 10r,
 // Note: don't check gtid as it should always be valid
 // 1, 2-byte - expect valid parameter, other - check before this macro
 #define OP_CRITICAL_L_CPT(OP, LCK_ID)                                          \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   if (flag) {                                                                  \
     new_value OP rhs;                                                          \
   } else                                                                       \
     new_value = (*lhs);                                                        \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);
 
 // ------------------------------------------------------------------------
 #ifdef KMP_GOMP_COMPAT
@@ -2559,7 +2614,7 @@ ATOMIC_CMPX_L_CPT(fixed8, orl_cpt, kmp_int64, 64, ||,
 // MIN and MAX need separate macros
 // OP - operator to check if we need any actions?
 #define MIN_MAX_CRITSECT_CPT(OP, LCK_ID)                                       \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   if (*lhs OP rhs) { /* still need actions? */                                 \
     old_value = *lhs;                                                          \
@@ -2569,7 +2624,7 @@ ATOMIC_CMPX_L_CPT(fixed8, orl_cpt, kmp_int64, 64, ||,
     else                                                                       \
       new_value = old_value;                                                   \
   }                                                                            \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
   return new_value;
 
 // -------------------------------------------------------------------------
@@ -2612,6 +2667,8 @@ ATOMIC_CMPX_L_CPT(fixed8, orl_cpt, kmp_int64, 64, ||,
   TYPE new_value, old_value;                                                   \
   if (*lhs OP rhs) { /* need actions? */                                       \
     GOMP_MIN_MAX_CRITSECT_CPT(OP, GOMP_FLAG)                                   \
+    ATOMIC_CAS16(TYPE, lhs, (old_value OP rhs) ? rhs : old_value,              \
+                 return flag ? new_value : old_value)                          \
     MIN_MAX_CRITSECT_CPT(OP, LCK_ID)                                           \
   }                                                                            \
   return *lhs;                                                                 \
@@ -2711,6 +2768,8 @@ ATOMIC_CMPX_EQV_CPT(fixed8, eqv_cpt, kmp_int64, 64, ^~,
   ATOMIC_BEGIN_CPT(TYPE_ID, OP_ID, TYPE, TYPE)                                 \
   TYPE new_value;                                                              \
   OP_GOMP_CRITICAL_CPT(OP, GOMP_FLAG) /* send assignment */                    \
+  ATOMIC_CAS16(TYPE, lhs, old_value OP rhs,                                    \
+               return flag ? new_value : old_value)                            \
   OP_CRITICAL_CPT(OP## =, LCK_ID) /* send assignment */                        \
   }
 
@@ -2718,7 +2777,7 @@ ATOMIC_CMPX_EQV_CPT(fixed8, eqv_cpt, kmp_int64, 64, ^~,
 // Workaround for cmplx4. Regular routines with return value don't work
 // on Win_32e. Let's return captured values through the additional parameter.
 #define OP_CRITICAL_CPT_WRK(OP, LCK_ID)                                        \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   if (flag) {                                                                  \
     (*lhs) OP rhs;                                                             \
@@ -2728,7 +2787,7 @@ ATOMIC_CMPX_EQV_CPT(fixed8, eqv_cpt, kmp_int64, 64, ^~,
     (*lhs) OP rhs;                                                             \
   }                                                                            \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
   return;
 // ------------------------------------------------------------------------
 
@@ -2851,7 +2910,7 @@ ATOMIC_CRITICAL_CPT(cmplx16, div_a16_cpt, kmp_cmplx128_a16_t, /, 32c,
 // Note: don't check gtid as it should always be valid
 // 1, 2-byte - expect valid parameter, other - check before this macro
 #define OP_CRITICAL_CPT_REV(OP, LCK_ID)                                        \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   if (flag) {                                                                  \
     /*temp_val = (*lhs);*/                                                     \
@@ -2861,7 +2920,7 @@ ATOMIC_CRITICAL_CPT(cmplx16, div_a16_cpt, kmp_cmplx128_a16_t, /, 32c,
     new_value = (*lhs);                                                        \
     (*lhs) = (rhs)OP(*lhs);                                                    \
   }                                                                            \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
   return new_value;
 
 // ------------------------------------------------------------------------
@@ -2983,6 +3042,8 @@ ATOMIC_CMPXCHG_CPT_REV(float8, sub_cpt_rev, kmp_real64, 64, -,
   TYPE KMP_ATOMIC_VOLATILE temp_val;                                           \
   /*printf("__kmp_atomic_mode = %d\n", __kmp_atomic_mode);*/                   \
   OP_GOMP_CRITICAL_CPT_REV(OP, GOMP_FLAG)                                      \
+  ATOMIC_CAS16(TYPE, lhs, (rhs)OP(old_value),                                  \
+               return flag ? new_value : old_value)                            \
   OP_CRITICAL_CPT_REV(OP, LCK_ID)                                              \
   }
 
@@ -3012,7 +3073,7 @@ ATOMIC_CRITICAL_CPT_REV(float16, div_a16_cpt_rev, Quad_a16_t, /, 16r,
 // Workaround for cmplx4. Regular routines with return value don't work
 // on Win_32e. Let's return captured values through the additional parameter.
 #define OP_CRITICAL_CPT_REV_WRK(OP, LCK_ID)                                    \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   if (flag) {                                                                  \
     (*lhs) = (rhs)OP(*lhs);                                                    \
@@ -3022,7 +3083,7 @@ ATOMIC_CRITICAL_CPT_REV(float16, div_a16_cpt_rev, Quad_a16_t, /, 16r,
     (*lhs) = (rhs)OP(*lhs);                                                    \
   }                                                                            \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
   return;
 // ------------------------------------------------------------------------
 
@@ -3171,12 +3232,12 @@ ATOMIC_CRITICAL_CPT_REV_MIX(float10, long double, div_cpt_rev, /, fp, _Quad,
     KA_TRACE(100, ("__kmpc_atomic_" #TYPE_ID "_swp: T#%d\n", gtid));
 
 #define CRITICAL_SWP(LCK_ID)                                                   \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   old_value = (*lhs);                                                          \
   (*lhs) = rhs;                                                                \
                                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
   return old_value;
 
 // ------------------------------------------------------------------------
@@ -3259,6 +3320,7 @@ ATOMIC_XCHG_FLOAT_SWP(float8, kmp_real64, 64,
   ATOMIC_BEGIN_SWP(TYPE_ID, TYPE)                                              \
   TYPE old_value;                                                              \
   GOMP_CRITICAL_SWP(GOMP_FLAG)                                                 \
+  ATOMIC_CAS16(TYPE, lhs, rhs, return old_value)                               \
   CRITICAL_SWP(LCK_ID)                                                         \
   }
 
@@ -3274,12 +3336,12 @@ ATOMIC_XCHG_FLOAT_SWP(float8, kmp_real64, 64,
     KA_TRACE(100, ("__kmpc_atomic_" #TYPE_ID "_swp: T#%d\n", gtid));
 
 #define CRITICAL_SWP_WRK(LCK_ID)                                               \
-  __kmp_acquire_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_acquire_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
                                                                                \
   tmp = (*lhs);                                                                \
   (*lhs) = (rhs);                                                              \
   (*out) = tmp;                                                                \
-  __kmp_release_atomic_lock(&ATOMIC_LOCK##LCK_ID, gtid);                       \
+  __kmp_release_atomic_lock(ATOMIC_LOCK##LCK_ID(lhs), gtid);                   \
   return;
 // ------------------------------------------------------------------------
 
@@ -3369,7 +3431,7 @@ void __kmpc_atomic_1(ident_t *id_ref, int gtid, void *lhs, void *rhs,
       __kmp_acquire_atomic_lock(&__kmp_atomic_lock, gtid);
     } else
 #endif /* KMP_GOMP_COMPAT */
-      __kmp_acquire_atomic_lock(&__kmp_atomic_lock_1i, gtid);
+      __kmp_acquire_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 
     (*f)(lhs, lhs, rhs);
 
@@ -3378,7 +3440,7 @@ void __kmpc_atomic_1(ident_t *id_ref, int gtid, void *lhs, void *rhs,
       __kmp_release_atomic_lock(&__kmp_atomic_lock, gtid);
     } else
 #endif /* KMP_GOMP_COMPAT */
-      __kmp_release_atomic_lock(&__kmp_atomic_lock_1i, gtid);
+      __kmp_release_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
   }
 }
 
@@ -3416,7 +3478,7 @@ void __kmpc_atomic_2(ident_t *id_ref, int gtid, void *lhs, void *rhs,
       __kmp_acquire_atomic_lock(&__kmp_atomic_lock, gtid);
     } else
 #endif /* KMP_GOMP_COMPAT */
-      __kmp_acquire_atomic_lock(&__kmp_atomic_lock_2i, gtid);
+      __kmp_acquire_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 
     (*f)(lhs, lhs, rhs);
 
@@ -3425,7 +3487,7 @@ void __kmpc_atomic_2(ident_t *id_ref, int gtid, void *lhs, void *rhs,
       __kmp_release_atomic_lock(&__kmp_atomic_lock, gtid);
     } else
 #endif /* KMP_GOMP_COMPAT */
-      __kmp_release_atomic_lock(&__kmp_atomic_lock_2i, gtid);
+      __kmp_release_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
   }
 }
 
@@ -3458,15 +3520,15 @@ void __kmpc_atomic_4(ident_t *id_ref, int gtid, void *lhs, void *rhs,
 
     return;
   } else {
-// Use __kmp_atomic_lock_4i for all 4-byte data,
-// even if it isn't of integer data type.
+// Use the lock stripe of the address for all 4-byte data,
+// whatever its data type.
 
 #ifdef KMP_GOMP_COMPAT
     if (__kmp_atomic_mode == 2) {
       __kmp_acquire_atomic_lock(&__kmp_atomic_lock, gtid);
     } else
 #endif /* KMP_GOMP_COMPAT */
-      __kmp_acquire_atomic_lock(&__kmp_atomic_lock_4i, gtid);
+      __kmp_acquire_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 
     (*f)(lhs, lhs, rhs);
 
@@ -3475,7 +3537,7 @@ void __kmpc_atomic_4(ident_t *id_ref, int gtid, void *lhs, void *rhs,
       __kmp_release_atomic_lock(&__kmp_atomic_lock, gtid);
     } else
 #endif /* KMP_GOMP_COMPAT */
-      __kmp_release_atomic_lock(&__kmp_atomic_lock_4i, gtid);
+      __kmp_release_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
   }
 }
 
@@ -3507,15 +3569,15 @@ void __kmpc_atomic_8(ident_t *id_ref, int gtid, void *lhs, void *rhs,
 
     return;
   } else {
-// Use __kmp_atomic_lock_8i for all 8-byte data,
-// even if it isn't of integer data type.
+// Use the lock stripe of the address for all 8-byte data,
+// whatever its data type.
 
 #ifdef KMP_GOMP_COMPAT
     if (__kmp_atomic_mode == 2) {
       __kmp_acquire_atomic_lock(&__kmp_atomic_lock, gtid);
     } else
 #endif /* KMP_GOMP_COMPAT */
-      __kmp_acquire_atomic_lock(&__kmp_atomic_lock_8i, gtid);
+      __kmp_acquire_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 
     (*f)(lhs, lhs, rhs);
 
@@ -3524,7 +3586,7 @@ void __kmpc_atomic_8(ident_t *id_ref, int gtid, void *lhs, void *rhs,
       __kmp_release_atomic_lock(&__kmp_atomic_lock, gtid);
     } else
 #endif /* KMP_GOMP_COMPAT */
-      __kmp_release_atomic_lock(&__kmp_atomic_lock_8i, gtid);
+      __kmp_release_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
   }
 }
 
@@ -3537,7 +3599,7 @@ void __kmpc_atomic_10(ident_t *id_ref, int gtid, void *lhs, void *rhs,
     __kmp_acquire_atomic_lock(&__kmp_atomic_lock, gtid);
   } else
 #endif /* KMP_GOMP_COMPAT */
-    __kmp_acquire_atomic_lock(&__kmp_atomic_lock_10r, gtid);
+    __kmp_acquire_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 
   (*f)(lhs, lhs, rhs);
 
@@ -3546,19 +3608,36 @@ void __kmpc_atomic_10(ident_t *id_ref, int gtid, void *lhs, void *rhs,
     __kmp_release_atomic_lock(&__kmp_atomic_lock, gtid);
   } else
 #endif /* KMP_GOMP_COMPAT */
-    __kmp_release_atomic_lock(&__kmp_atomic_lock_10r, gtid);
+    __kmp_release_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 }
 
 void __kmpc_atomic_16(ident_t *id_ref, int gtid, void *lhs, void *rhs,
                       void (*f)(void *, void *, void *)) {
   KMP_DEBUG_ASSERT(__kmp_init_serial);
 
+#if KMP_ATOMIC_CAS16
+  // Same choice as the routines for the typed 16-byte operands
+  if (__kmp_atomic_mode != 2 && __kmp_cpuinfo.cx16 &&
+      !((kmp_uintptr_t)lhs & 0xf)) {
+    KMP_ALIGN(16) kmp_uint64 old_value[2], new_value[2];
+
+    KMP_MEMCPY(old_value, lhs, sizeof(old_value));
+    (*f)(new_value, old_value, rhs);
+    while (!__kmp_compare_and_store128((volatile kmp_uint64 *)lhs, old_value,
+                                       new_value)) {
+      KMP_CPU_PAUSE();
+      (*f)(new_value, old_value, rhs);
+    }
+    return;
+  }
+#endif
+
 #ifdef KMP_GOMP_COMPAT
   if (__kmp_atomic_mode == 2) {
     __kmp_acquire_atomic_lock(&__kmp_atomic_lock, gtid);
   } else
 #endif /* KMP_GOMP_COMPAT */
-    __kmp_acquire_atomic_lock(&__kmp_atomic_lock_16c, gtid);
+    __kmp_acquire_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 
   (*f)(lhs, lhs, rhs);
 
@@ -3567,7 +3646,7 @@ void __kmpc_atomic_16(ident_t *id_ref, int gtid, void *lhs, void *rhs,
     __kmp_release_atomic_lock(&__kmp_atomic_lock, gtid);
   } else
 #endif /* KMP_GOMP_COMPAT */
-    __kmp_release_atomic_lock(&__kmp_atomic_lock_16c, gtid);
+    __kmp_release_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 }
 
 void __kmpc_atomic_20(ident_t *id_ref, int gtid, void *lhs, void *rhs,
@@ -3579,7 +3658,7 @@ void __kmpc_atomic_20(ident_t *id_ref, int gtid, void *lhs, void *rhs,
     __kmp_acquire_atomic_lock(&__kmp_atomic_lock, gtid);
   } else
 #endif /* KMP_GOMP_COMPAT */
-    __kmp_acquire_atomic_lock(&__kmp_atomic_lock_20c, gtid);
+    __kmp_acquire_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 
   (*f)(lhs, lhs, rhs);
 
@@ -3588,7 +3667,7 @@ void __kmpc_atomic_20(ident_t *id_ref, int gtid, void *lhs, void *rhs,
     __kmp_release_atomic_lock(&__kmp_atomic_lock, gtid);
   } else
 #endif /* KMP_GOMP_COMPAT */
-    __kmp_release_atomic_lock(&__kmp_atomic_lock_20c, gtid);
+    __kmp_release_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 }
 
 void __kmpc_atomic_32(ident_t *id_ref, int gtid, void *lhs, void *rhs,
@@ -3600,7 +3679,7 @@ void __kmpc_atomic_32(ident_t *id_ref, int gtid, void *lhs, void *rhs,
     __kmp_acquire_atomic_lock(&__kmp_atomic_lock, gtid);
   } else
 #endif /* KMP_GOMP_COMPAT */
-    __kmp_acquire_atomic_lock(&__kmp_atomic_lock_32c, gtid);
+    __kmp_acquire_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 
   (*f)(lhs, lhs, rhs);
 
@@ -3609,9 +3688,142 @@ void __kmpc_atomic_32(ident_t *id_ref, int gtid, void *lhs, void *rhs,
     __kmp_release_atomic_lock(&__kmp_atomic_lock, gtid);
   } else
 #endif /* KMP_GOMP_COMPAT */
-    __kmp_release_atomic_lock(&__kmp_atomic_lock_32c, gtid);
+    __kmp_release_atomic_lock(__kmp_get_atomic_lock(lhs), gtid);
 }
 
+// ------------------------------------------------------------------------
+// Batched atomic update: base[idx[i]] += val[i] for 0 <= i < n, every single
+// update being atomic. Histogram and scatter-add kernels otherwise make one
+// runtime call and one compare-and-swap loop per element.
+//
+// Elements are handled in blocks of KMP_ATOMIC_BATCH_BLOCK. The values of
+// repeated indices of a block are summed first through a small open-addressing
+// table, so every distinct location of the block is updated once and hot
+// locations do not bounce between caches for each of their elements. When a
+// block turns out to have (almost) no repeated index, the next
+// KMP_ATOMIC_BATCH_SKIP ones are applied element by element.
+#define KMP_ATOMIC_BATCH_BLOCK 256
+#define KMP_ATOMIC_BATCH_SKIP 8
+#define KMP_ATOMIC_BATCH_SLOTS (2 * KMP_ATOMIC_BATCH_BLOCK) // power of two
+
+template <typename TYPE> struct kmp_atomic_batch_entry {
+  kmp_int64 idx;
+  TYPE val;
+  kmp_int32 slot; // slot of the table pointing to this entry
+};
+
+// Copies n elements into block, summing the values of repeated indices if
+// combine is set. slots[] must be all -1 on entry and is left that way.
+// Returns the number of updates left in block.
+template <typename TYPE>
+static kmp_int32 __kmp_atomic_batch_combine(kmp_atomic_batch_entry<TYPE> *block,
+                                            kmp_int32 *slots,
+                                            const kmp_int64 *idx,
+                                            const TYPE *val, kmp_int32 n,
+                                            int combine) {
+  kmp_int32 i, m = 0;
+
+  if (!combine) {
+    for (i = 0; i < n; ++i) {
+      block[i].idx = idx[i];
+      block[i].val = val[i];
+    }
+    return n;
+  }
+  for (i = 0; i < n; ++i) {
+    kmp_uint32 h = (kmp_uint32)(((kmp_uint64)idx[i] * 0x9E3779B97F4A7C15ULL) >>
+                                40) &
+                   (KMP_ATOMIC_BATCH_SLOTS - 1);
+    while (slots[h] >= 0 && block[slots[h]].idx != idx[i])
+      h = (h + 1) & (KMP_ATOMIC_BATCH_SLOTS - 1);
+    if (slots[h] >= 0) {
+      block[slots[h]].val += val[i];
+    } else {
+      slots[h] = m;
+      block[m].idx = idx[i];
+      block[m].val = val[i];
+      block[m].slot = h;
+      ++m;
+    }
+  }
+  for (i = 0; i < m; ++i)
+    slots[block[i].slot] = -1;
+  return m;
+}
+
+// In Gnu compat mode the whole batch is done under the common lock
+#ifdef KMP_GOMP_COMPAT
+#define OP_GOMP_CRITICAL_BATCH(FLAG)                                           \
+  if ((FLAG) && (__kmp_atomic_mode == 2)) {                                    \
+    KMP_CHECK_GTID;                                                            \
+    __kmp_acquire_atomic_lock(ATOMIC_LOCK0(base), gtid);                       \
+    for (i = 0; i < n; ++i)                                                    \
+      base[idx[i]] += val[i];                                                  \
+    __kmp_release_atomic_lock(ATOMIC_LOCK0(base), gtid);                       \
+    return;                                                                    \
+  }
+#else
+#define OP_GOMP_CRITICAL_BATCH(FLAG)
+#endif /* KMP_GOMP_COMPAT */
+
+// Single update of the batch, as done by the scalar add routines
+#define OP_BATCH_FIXED_ADD(TYPE, BITS) KMP_TEST_THEN_ADD##BITS(lhs, rhs);
+#define OP_BATCH_CMPXCHG_ADD(TYPE, BITS) OP_CMPXCHG(TYPE, BITS, +)
+
+#if KMP_ARCH_X86 || KMP_ARCH_X86_64
+#define OP_BATCH_UPDATE(TYPE, BITS, OP_ADD, LCK_ID, MASK) OP_ADD(TYPE, BITS)
+#else
+#define OP_BATCH_UPDATE(TYPE, BITS, OP_ADD, LCK_ID, MASK)                      \
+  if (!((kmp_uintptr_t)lhs & 0x##MASK)) {                                      \
+    OP_ADD(TYPE, BITS)                                                         \
+  } else {                                                                     \
+    KMP_CHECK_GTID;                                                            \
+    OP_CRITICAL(+=, LCK_ID) /* unaligned address - use critical */             \
+  }
+#endif
+
+//     TYPE_ID, TYPE, BITS, LCK_ID, MASK, GOMP_FLAG - as for the scalar add
+//     OP_ADD - OP_BATCH_FIXED_ADD or OP_BATCH_CMPXCHG_ADD
+#define ATOMIC_BATCH(TYPE_ID, TYPE, BITS, OP_ADD, LCK_ID, MASK, GOMP_FLAG)     \
+  void __kmpc_atomic_##TYPE_ID##_add_batch(ident_t *id_ref, int gtid,          \
+                                           TYPE *base, kmp_int32 n,            \
+                                           const kmp_int64 *idx,               \
+                                           const TYPE *val) {                  \
+    kmp_atomic_batch_entry<TYPE> block[KMP_ATOMIC_BATCH_BLOCK];                \
+    kmp_int32 slots[KMP_ATOMIC_BATCH_SLOTS];                                   \
+    kmp_int32 i, j, m, cnt;                                                    \
+    int skip = 0; /* blocks left to apply without combining */                 \
+    KMP_DEBUG_ASSERT(__kmp_init_serial);                                       \
+    KA_TRACE(100, ("__kmpc_atomic_" #TYPE_ID "_add_batch: T#%d n=%d\n", gtid,  \
+                   n));                                                        \
+    OP_GOMP_CRITICAL_BATCH(GOMP_FLAG)                                          \
+    for (i = 0; i < KMP_ATOMIC_BATCH_SLOTS; ++i)                               \
+      slots[i] = -1;                                                           \
+    for (i = 0; i < n; i += m) {                                               \
+      m = n - i < KMP_ATOMIC_BATCH_BLOCK ? n - i : KMP_ATOMIC_BATCH_BLOCK;     \
+      cnt = __kmp_atomic_batch_combine(block, slots, idx + i, val + i, m,      \
+                                       skip == 0);                             \
+      if (skip > 0)                                                            \
+        --skip;                                                                \
+      else if (cnt >= m - m / 8) /* saved less than 1/8 of the updates */      \
+        skip = KMP_ATOMIC_BATCH_SKIP;                                          \
+      for (j = 0; j < cnt; ++j) {                                              \
+        TYPE *lhs = base + block[j].idx;                                       \
+        TYPE rhs = block[j].val;                                               \
+        OP_BATCH_UPDATE(TYPE, BITS, OP_ADD, LCK_ID, MASK)                      \
+      }                                                                        \
+    }                                                                          \
+  }
+
+ATOMIC_BATCH(fixed4, kmp_int32, 32, OP_BATCH_FIXED_ADD, 4i, 3,
+             0) // __kmpc_atomic_fixed4_add_batch
+ATOMIC_BATCH(fixed8, kmp_int64, 64, OP_BATCH_FIXED_ADD, 8i, 7,
+             KMP_ARCH_X86) // __kmpc_atomic_fixed8_add_batch
+ATOMIC_BATCH(float4, kmp_real32, 32, OP_BATCH_CMPXCHG_ADD, 4r, 3,
+             KMP_ARCH_X86) // __kmpc_atomic_float4_add_batch
+ATOMIC_BATCH(float8, kmp_real64, 64, OP_BATCH_CMPXCHG_ADD, 8r, 7,
+             KMP_ARCH_X86) // __kmpc_atomic_float8_add_batch
+
 // AC: same two routines as GOMP_atomic_start/end, but will be called by our
 // compiler; duplicated in order to not use 3-party names in pure Intel code
 // TODO: consider adding GTID parameter after consultation with Ernesto/Xinmin.
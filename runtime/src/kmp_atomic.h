@@ -408,42 +408,20 @@ static inline void __kmp_destroy_atomic_lock(kmp_atomic_lock_t *lck) {
 // Global Locks
 extern kmp_atomic_lock_t __kmp_atomic_lock; /* Control access to all user coded
                                                atomics in Gnu compat mode   */
-extern kmp_atomic_lock_t __kmp_atomic_lock_1i; /* Control access to all user
-                                                  coded atomics for 1-byte fixed
-                                                  data types */
-extern kmp_atomic_lock_t __kmp_atomic_lock_2i; /* Control access to all user
-                                                  coded atomics for 2-byte fixed
-                                                  data types */
-extern kmp_atomic_lock_t __kmp_atomic_lock_4i; /* Control access to all user
-                                                  coded atomics for 4-byte fixed
-                                                  data types */
-extern kmp_atomic_lock_t __kmp_atomic_lock_4r; /* Control access to all user
-                                                  coded atomics for kmp_real32
-                                                  data type    */
-extern kmp_atomic_lock_t __kmp_atomic_lock_8i; /* Control access to all user
-                                                  coded atomics for 8-byte fixed
-                                                  data types */
-extern kmp_atomic_lock_t __kmp_atomic_lock_8r; /* Control access to all user
-                                                  coded atomics for kmp_real64
-                                                  data type    */
-extern kmp_atomic_lock_t
-    __kmp_atomic_lock_8c; /* Control access to all user coded atomics for
-                             complex byte data type  */
-extern kmp_atomic_lock_t
-    __kmp_atomic_lock_10r; /* Control access to all user coded atomics for long
-                              double data type   */
-extern kmp_atomic_lock_t __kmp_atomic_lock_16r; /* Control access to all user
-                                                   coded atomics for _Quad data
-                                                   type         */
-extern kmp_atomic_lock_t __kmp_atomic_lock_16c; /* Control access to all user
-                                                   coded atomics for double
-                                                   complex data type*/
-extern kmp_atomic_lock_t
-    __kmp_atomic_lock_20c; /* Control access to all user coded atomics for long
-                              double complex type*/
-extern kmp_atomic_lock_t __kmp_atomic_lock_32c; /* Control access to all user
-                                                   coded atomics for _Quad
-                                                   complex data type */
+
+// Atomics that cannot be done with a native instruction serialize on a lock
+// selected by hashing the address of the target, so that updates of unrelated
+// variables do not contend. The same stripe is used for a location whatever
+// the type of the routine, and kmp_atomic_lock_t is cache aligned, so each
+// stripe occupies its own cache line(s). Must be a power of two.
+#define KMP_ATOMIC_LOCK_STRIPES 64
+extern kmp_atomic_lock_t __kmp_atomic_lock_stripes[KMP_ATOMIC_LOCK_STRIPES];
+
+static inline kmp_atomic_lock_t *__kmp_get_atomic_lock(void *addr) {
+  kmp_uintptr_t key = (kmp_uintptr_t)addr >> 4;
+  return &__kmp_atomic_lock_stripes[(key ^ (key >> 6)) &
+                                    (KMP_ATOMIC_LOCK_STRIPES - 1)];
+}
 
 //  Below routines for atomic UPDATE are listed
 
@@ -1000,6 +978,22 @@ void __kmpc_atomic_20(ident_t *id_ref, int gtid, void *lhs, void *rhs,
 void __kmpc_atomic_32(ident_t *id_ref, int gtid, void *lhs, void *rhs,
                       void (*f)(void *, void *, void *));
 
+// batched atomic routines: base[idx[i]] += val[i], 0 <= i < n
+void __kmpc_atomic_fixed4_add_batch(ident_t *id_ref, int gtid, kmp_int32 *base,
+                                    kmp_int32 n, const kmp_int64 *idx,
+                                    const kmp_int32 *val);
+void __kmpc_atomic_fixed8_add_batch(ident_t *id_ref, int gtid, kmp_int64 *base,
+                                    kmp_int32 n, const kmp_int64 *idx,
+                                    const kmp_int64 *val);
+void __kmpc_atomic_float4_add_batch(ident_t *id_ref, int gtid,
+                                    kmp_real32 *base, kmp_int32 n,
+                                    const kmp_int64 *idx,
+                                    const kmp_real32 *val);
+void __kmpc_atomic_float8_add_batch(ident_t *id_ref, int gtid,
+                                    kmp_real64 *base, kmp_int32 n,
+                                    const kmp_int64 *idx,
+                                    const kmp_real64 *val);
+
 // READ, WRITE, CAPTURE are supported only on IA-32 architecture and Intel(R) 64
 #if KMP_ARCH_X86 || KMP_ARCH_X86_64
 
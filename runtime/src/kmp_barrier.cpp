@@ -18,6 +18,8 @@
 #include "kmp_itt.h"
 #include "kmp_os.h"
 #include "kmp_stats.h"
+#include "kmp_hw_counters.h"
+#include "kmp_trace.h"
 #if OMPT_SUPPORT
 #include "ompt-specific.h"
 #endif
@@ -1239,6 +1241,10 @@ int __kmp_barrier(enum barrier_type bt, int gtid, int is_split,
                 __kmp_team_from_gtid(gtid)->t.t_id, __kmp_tid_from_gtid(gtid)));
 
   ANNOTATE_BARRIER_BEGIN(&team->t.t_bar);
+  KMP_SC_FLUSH_REMOTE(this_thr);
+  KMP_TRACE_EVENT(this_thr, kmp_trace_barrier_begin, bt, loc, 0);
+  KMP_PERF_WAIT_BEGIN(perf_start);
+  KMP_HW_COUNTERS_PHASE(this_thr, kmp_hw_barrier, hw_saved);
 #if OMPT_SUPPORT
   if (ompt_enabled.enabled) {
 #if OMPT_OPTIONAL
@@ -1260,6 +1266,7 @@ int __kmp_barrier(enum barrier_type bt, int gtid, int is_split,
     // According to the OMPT specification, a compliant implementation may
     // even delay reporting this state until the barrier begins to wait.
     this_thr->th.ompt_thread_info.state = omp_state_wait_barrier;
+    this_thr->th.ompt_thread_info.ident = loc;
   }
 #endif
 
@@ -1508,8 +1515,13 @@ int __kmp_barrier(enum barrier_type bt, int gtid, int is_split,
     }
 #endif
     this_thr->th.ompt_thread_info.state = omp_state_work_parallel;
+    this_thr->th.ompt_thread_info.ident = team->t.t_ident;
   }
 #endif
+  KMP_PERF_INC(this_thr, barriers);
+  KMP_PERF_WAIT_END(this_thr, barrier_time, perf_start);
+  KMP_HW_COUNTERS_RESTORE(this_thr, hw_saved);
+  KMP_TRACE_EVENT(this_thr, kmp_trace_barrier_end, bt, 0, 0);
   ANNOTATE_BARRIER_END(&team->t.t_bar);
 
   return status;
@@ -1603,6 +1615,11 @@ void __kmp_join_barrier(int gtid) {
                 gtid, team_id, tid));
 
   ANNOTATE_BARRIER_BEGIN(&team->t.t_bar);
+  KMP_SC_FLUSH_REMOTE(this_thr);
+  KMP_TRACE_EVENT(this_thr, kmp_trace_barrier_begin, bs_forkjoin_barrier,
+                  team->t.t_ident, 0);
+  KMP_PERF_WAIT_BEGIN(perf_start);
+  KMP_HW_COUNTERS_BEGIN(this_thr, team->t.t_ident, kmp_hw_barrier);
 #if OMPT_SUPPORT
   ompt_data_t *my_task_data;
   ompt_data_t *my_parallel_data;
@@ -1628,6 +1645,7 @@ void __kmp_join_barrier(int gtid) {
     }
 #endif
     this_thr->th.ompt_thread_info.state = omp_state_wait_barrier_implicit;
+    this_thr->th.ompt_thread_info.ident = team->t.t_ident;
   }
 #endif
 
@@ -1786,6 +1804,10 @@ void __kmp_join_barrier(int gtid) {
   KA_TRACE(10,
            ("__kmp_join_barrier: T#%d(%d:%d) leaving\n", gtid, team_id, tid));
 
+  KMP_PERF_INC(this_thr, barriers);
+  KMP_PERF_WAIT_END(this_thr, barrier_time, perf_start);
+  KMP_HW_COUNTERS_END(this_thr);
+  KMP_TRACE_EVENT(this_thr, kmp_trace_barrier_end, bs_forkjoin_barrier, 0, 0);
   ANNOTATE_BARRIER_END(&team->t.t_bar);
 }
 
@@ -0,0 +1,371 @@
+/*
+ * kmp_critical_path.cpp -- Work, span and critical path of the task graphs.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp_critical_path.h"
+#include "kmp_i18n.h"
+#include "kmp_str.h"
+#include "kmp_wrapper_getpid.h"
+
+int __kmp_critical_path = FALSE;
+char const *__kmp_critical_path_file = NULL;
+
+// A finished task. The records of a graph live until the graph is flushed.
+typedef struct kmp_cp_record {
+  kmp_uint64 time; // execution time, ns
+  kmp_uint64 end; // the longest path through the graph to the end of the task
+  struct kmp_cp_record *pred; // the predecessor on that path, if any
+  kmp_routine_entry_t routine;
+  ident_t *loc;
+} kmp_cp_record_t;
+
+#define KMP_CP_CHUNK 255
+
+typedef struct kmp_cp_chunk {
+  struct kmp_cp_chunk *next;
+  kmp_int32 used;
+  kmp_cp_record_t records[KMP_CP_CHUNK];
+} kmp_cp_chunk_t;
+
+// The children of a task since the last flush. The id tells the records of
+// this graph from those of a flushed one that the dependence hash of the
+// parent may still point to.
+typedef struct kmp_cp_graph {
+  kmp_bootstrap_lock_t lock;
+  kmp_int32 id;
+  kmp_uint32 ntasks;
+  kmp_uint64 work;
+  kmp_cp_record_t *last; // the end of the longest path
+  kmp_cp_chunk_t *chunks;
+} kmp_cp_graph_t;
+
+// The paths through the dependence node of a task, under the lock of the node.
+typedef struct kmp_cp_node {
+  kmp_uint64 ready; // the longest path through the predecessors
+  kmp_cp_record_t *pred; // the predecessor on that path
+  kmp_uint64 end; // the longest path through the task, once finished
+  kmp_cp_record_t *rec; // the record of the finished task
+  kmp_int32 graph; // id of the graph of rec
+} kmp_cp_node_t;
+
+// The profile, the graphs flushed at a synchronization point and their
+// critical paths by entry point; the entry points beyond the table go to the
+// "other" row.
+#define KMP_CP_ENTRIES 32
+
+typedef struct kmp_cp_entry {
+  kmp_routine_entry_t routine;
+  ident_t *loc;
+  kmp_uint64 ntasks;
+  kmp_uint64 time;
+} kmp_cp_entry_t;
+
+typedef struct kmp_cp_site {
+  kmp_int32 sync;
+  ident_t *loc;
+  kmp_uint64 ngraphs;
+  kmp_uint64 ntasks;
+  kmp_uint64 work;
+  kmp_uint64 span;
+  kmp_int32 nentries;
+  kmp_cp_entry_t entries[KMP_CP_ENTRIES];
+  kmp_cp_entry_t other;
+} kmp_cp_site_t;
+
+static kmp_bootstrap_lock_t __kmp_cp_lock =
+    KMP_BOOTSTRAP_LOCK_INITIALIZER(__kmp_cp_lock);
+static kmp_cp_site_t *__kmp_cp_sites = NULL;
+static kmp_int32 __kmp_cp_nsites = 0;
+static kmp_int32 __kmp_cp_max_sites = 0;
+static volatile kmp_int32 __kmp_cp_last_id = 0;
+
+static char const *__kmp_cp_sync_names[kmp_cp_last] = {
+    "taskwait", "taskgroup", "parallel", "task", "initial"};
+
+// Called by the thread of the parent when it creates a child.
+void __kmp_critical_path_alloc(kmp_taskdata_t *parent) {
+  if (parent->td_cp_graph != NULL)
+    return;
+  kmp_cp_graph_t *graph = (kmp_cp_graph_t *)__kmp_allocate(sizeof(*graph));
+  __kmp_init_bootstrap_lock(&graph->lock);
+  graph->id = KMP_TEST_THEN_INC32(&__kmp_cp_last_id) + 1;
+  parent->td_cp_graph = graph;
+}
+
+// Called when the node of a task with dependences is created; the node of a
+// taskwait with depend has none.
+void __kmp_critical_path_node(kmp_depnode_t *node) {
+  node->dn.cp = (kmp_cp_node_t *)__kmp_allocate(sizeof(kmp_cp_node_t));
+}
+
+static void __kmp_critical_path_ready(kmp_int32 gtid, kmp_depnode_t *sink,
+                                      kmp_uint64 end, kmp_cp_record_t *pred) {
+  kmp_cp_node_t *cp = sink->dn.cp;
+  if (cp == NULL)
+    return;
+  __kmp_acquire_lock(&sink->dn.lock, gtid);
+  if (end > cp->ready) {
+    cp->ready = end;
+    cp->pred = pred;
+  }
+  __kmp_release_lock(&sink->dn.lock, gtid);
+}
+
+// A finished task releases a successor.
+void __kmp_critical_path_release(kmp_int32 gtid, kmp_depnode_t *source,
+                                 kmp_depnode_t *sink) {
+  kmp_cp_node_t *cp = source->dn.cp;
+  if (cp != NULL && cp->rec != NULL)
+    __kmp_critical_path_ready(gtid, sink, cp->end, cp->rec);
+}
+
+static void __kmp_critical_path_finished(kmp_int32 gtid, kmp_depnode_t *sink,
+                                         kmp_depnode_t *source,
+                                         kmp_int32 id) {
+  kmp_cp_node_t *cp = source->dn.cp;
+  kmp_uint64 end = 0;
+  kmp_cp_record_t *rec = NULL;
+  if (cp == NULL)
+    return;
+  __kmp_acquire_lock(&source->dn.lock, gtid);
+  if (cp->rec != NULL && cp->graph == id) {
+    end = cp->end;
+    rec = cp->rec;
+  }
+  __kmp_release_lock(&source->dn.lock, gtid);
+  if (rec != NULL)
+    __kmp_critical_path_ready(gtid, sink, end, rec);
+}
+
+// The runtime adds no edges from the tasks that are already finished when a
+// task is created, but they are on its paths all the same; take them from
+// the dependence hash entry before it is updated for the new task.
+void __kmp_critical_path_deps(kmp_int32 gtid, kmp_depnode_t *sink,
+                              kmp_task_t *task, kmp_dephash_entry_t *info,
+                              bool out) {
+  if (task == NULL) // taskwait with depend
+    return;
+  kmp_cp_graph_t *graph = KMP_TASK_TO_TASKDATA(task)->td_parent->td_cp_graph;
+  if (graph == NULL)
+    return;
+  if (out && info->last_ins) {
+    for (kmp_depnode_list_t *p = info->last_ins; p; p = p->next)
+      __kmp_critical_path_finished(gtid, sink, p->node, graph->id);
+  } else if (info->last_out) {
+    __kmp_critical_path_finished(gtid, sink, info->last_out, graph->id);
+  }
+}
+
+static kmp_cp_record_t *__kmp_critical_path_record(kmp_cp_graph_t *graph) {
+  kmp_cp_chunk_t *chunk = graph->chunks;
+  if (chunk == NULL || chunk->used == KMP_CP_CHUNK) {
+    chunk = (kmp_cp_chunk_t *)__kmp_allocate(sizeof(*chunk));
+    chunk->next = graph->chunks;
+    graph->chunks = chunk;
+  }
+  return &chunk->records[chunk->used++];
+}
+
+// Called when a task completes, before it releases its successors.
+void __kmp_critical_path_done(kmp_int32 gtid, kmp_taskdata_t *task) {
+  kmp_cp_graph_t *graph = task->td_parent->td_cp_graph;
+  kmp_depnode_t *node = task->td_depnode;
+  kmp_cp_node_t *cp = node ? node->dn.cp : NULL;
+  if (graph == NULL)
+    return;
+  // All predecessors are done, nothing updates the node any more.
+  kmp_uint64 ready = cp ? cp->ready : 0;
+
+  __kmp_acquire_bootstrap_lock(&graph->lock);
+  kmp_cp_record_t *rec = __kmp_critical_path_record(graph);
+  rec->time = task->td_cp_time;
+  rec->end = ready + rec->time;
+  rec->pred = ready ? cp->pred : NULL;
+  rec->routine = (KMP_TASKDATA_TO_TASK(task))->routine;
+  rec->loc = task->td_ident;
+  graph->ntasks++;
+  graph->work += rec->time;
+  if (graph->last == NULL || rec->end > graph->last->end)
+    graph->last = rec;
+  __kmp_release_bootstrap_lock(&graph->lock);
+
+  if (cp) {
+    __kmp_acquire_lock(&node->dn.lock, gtid);
+    cp->end = rec->end;
+    cp->rec = rec;
+    cp->graph = graph->id;
+    __kmp_release_lock(&node->dn.lock, gtid);
+  }
+}
+
+static kmp_cp_site_t *__kmp_critical_path_site(int sync, ident_t *loc) {
+  for (kmp_int32 i = 0; i < __kmp_cp_nsites; ++i) {
+    if (__kmp_cp_sites[i].sync == sync && __kmp_cp_sites[i].loc == loc)
+      return &__kmp_cp_sites[i];
+  }
+  if (__kmp_cp_nsites == __kmp_cp_max_sites) {
+    kmp_int32 max = __kmp_cp_max_sites ? 2 * __kmp_cp_max_sites : 16;
+    kmp_cp_site_t *sites = (kmp_cp_site_t *)KMP_INTERNAL_REALLOC(
+        __kmp_cp_sites, max * sizeof(kmp_cp_site_t));
+    if (sites == NULL)
+      KMP_FATAL(MemoryAllocFailed);
+    __kmp_cp_sites = sites;
+    __kmp_cp_max_sites = max;
+  }
+  kmp_cp_site_t *site = &__kmp_cp_sites[__kmp_cp_nsites++];
+  memset(site, 0, sizeof(*site));
+  site->sync = sync;
+  site->loc = loc;
+  return site;
+}
+
+static void __kmp_critical_path_count(kmp_cp_site_t *site,
+                                      kmp_cp_record_t *rec) {
+  kmp_cp_entry_t *e = NULL;
+  for (kmp_int32 i = 0; i < site->nentries; ++i) {
+    if (site->entries[i].routine == rec->routine &&
+        site->entries[i].loc == rec->loc) {
+      e = &site->entries[i];
+      break;
+    }
+  }
+  if (e == NULL) {
+    if (site->nentries < KMP_CP_ENTRIES) {
+      e = &site->entries[site->nentries++];
+      e->routine = rec->routine;
+      e->loc = rec->loc;
+    } else {
+      e = &site->other;
+    }
+  }
+  e->ntasks++;
+  e->time += rec->time;
+}
+
+// Folds the graph of the children of the task into the profile, once they are
+// all complete; otherwise the graph grows until the next synchronization.
+void __kmp_critical_path_flush(kmp_taskdata_t *task, int sync, ident_t *loc) {
+  kmp_cp_graph_t *graph = task->td_cp_graph;
+  if (graph == NULL || TCR_4(task->td_incomplete_child_tasks) > 0)
+    return;
+  task->td_cp_graph = NULL;
+
+  if (graph->ntasks > 0) {
+    __kmp_acquire_bootstrap_lock(&__kmp_cp_lock);
+    kmp_cp_site_t *site = __kmp_critical_path_site(sync, loc);
+    site->ngraphs++;
+    site->ntasks += graph->ntasks;
+    site->work += graph->work;
+    site->span += graph->last->end;
+    for (kmp_cp_record_t *rec = graph->last; rec; rec = rec->pred)
+      __kmp_critical_path_count(site, rec);
+    __kmp_release_bootstrap_lock(&__kmp_cp_lock);
+  }
+
+  kmp_cp_chunk_t *next;
+  for (kmp_cp_chunk_t *chunk = graph->chunks; chunk; chunk = next) {
+    next = chunk->next;
+    __kmp_free(chunk);
+  }
+  __kmp_destroy_bootstrap_lock(&graph->lock);
+  __kmp_free(graph);
+}
+
+static int __kmp_cp_site_compare(const void *a, const void *b) {
+  kmp_uint64 sa = ((const kmp_cp_site_t *)a)->span;
+  kmp_uint64 sb = ((const kmp_cp_site_t *)b)->span;
+  return sa < sb ? 1 : sa > sb ? -1 : 0;
+}
+
+static int __kmp_cp_entry_compare(const void *a, const void *b) {
+  kmp_uint64 ta = ((const kmp_cp_entry_t *)a)->time;
+  kmp_uint64 tb = ((const kmp_cp_entry_t *)b)->time;
+  return ta < tb ? 1 : ta > tb ? -1 : 0;
+}
+
+static void __kmp_critical_path_entry(kmp_str_buf_t *buffer,
+                                      kmp_cp_site_t *site, kmp_cp_entry_t *e) {
+  __kmp_str_buf_print(buffer, "  %10llu %12.3f %6.2f%%  ",
+                      (unsigned long long)e->ntasks, e->time / 1e6,
+                      site->span ? 100.0 * e->time / site->span : 0.0);
+}
+
+static void __kmp_critical_path_print(void) {
+  kmp_str_buf_t buffer;
+  kmp_uint64 ngraphs = 0, ntasks = 0, work = 0, span = 0;
+
+  qsort(__kmp_cp_sites, __kmp_cp_nsites, sizeof(kmp_cp_site_t),
+        __kmp_cp_site_compare);
+  for (kmp_int32 i = 0; i < __kmp_cp_nsites; ++i) {
+    ngraphs += __kmp_cp_sites[i].ngraphs;
+    ntasks += __kmp_cp_sites[i].ntasks;
+    work += __kmp_cp_sites[i].work;
+    span += __kmp_cp_sites[i].span;
+  }
+
+  __kmp_str_buf_init(&buffer);
+  __kmp_str_buf_print(&buffer,
+                      "# OpenMP task critical path of process %d: %llu tasks "
+                      "in %llu graphs\n",
+                      (int)getpid(), (unsigned long long)ntasks,
+                      (unsigned long long)ngraphs);
+  __kmp_str_buf_print(&buffer, "%-10s %10s %10s %12s %12s %11s  %s\n", "Sync",
+                      "Graphs", "Tasks", "Work (ms)", "Span (ms)",
+                      "Parallelism", "Location");
+  __kmp_str_buf_print(&buffer, "%-10s %10llu %10llu %12.3f %12.3f %11.2f  %s\n",
+                      "(all)", (unsigned long long)ngraphs,
+                      (unsigned long long)ntasks, work / 1e6, span / 1e6,
+                      span ? (double)work / span : 0.0, "-");
+  for (kmp_int32 i = 0; i < __kmp_cp_nsites; ++i) {
+    kmp_cp_site_t *site = &__kmp_cp_sites[i];
+    __kmp_str_buf_print(&buffer, "%-10s %10llu %10llu %12.3f %12.3f %11.2f  ",
+                        __kmp_cp_sync_names[site->sync],
+                        (unsigned long long)site->ngraphs,
+                        (unsigned long long)site->ntasks, site->work / 1e6,
+                        site->span / 1e6,
+                        site->span ? (double)site->work / site->span : 0.0);
+    __kmp_str_buf_print_loc(&buffer, site->loc ? site->loc->psource : NULL);
+    __kmp_str_buf_print(&buffer, "\n  %10s %12s %7s  %s\n", "Path tasks",
+                        "Time (ms)", "Span", "Entry point");
+    qsort(site->entries, site->nentries, sizeof(kmp_cp_entry_t),
+          __kmp_cp_entry_compare);
+    for (kmp_int32 j = 0; j < site->nentries; ++j) {
+      kmp_cp_entry_t *e = &site->entries[j];
+      __kmp_critical_path_entry(&buffer, site, e);
+      __kmp_str_buf_print(&buffer, "%p ", (void *)e->routine);
+      __kmp_str_buf_print_loc(&buffer, e->loc ? e->loc->psource : NULL);
+      __kmp_str_buf_print(&buffer, "\n");
+    }
+    if (site->other.ntasks > 0) {
+      __kmp_critical_path_entry(&buffer, site, &site->other);
+      __kmp_str_buf_print(&buffer, "(other)\n");
+    }
+  }
+
+  __kmp_str_buf_write(&buffer, __kmp_critical_path_file);
+  __kmp_str_buf_free(&buffer);
+}
+
+void __kmp_critical_path_fini(void) {
+  if (!__kmp_critical_path)
+    return;
+  __kmp_acquire_bootstrap_lock(&__kmp_cp_lock);
+  if (__kmp_cp_nsites > 0)
+    __kmp_critical_path_print();
+  KMP_INTERNAL_FREE(__kmp_cp_sites);
+  __kmp_cp_sites = NULL;
+  __kmp_cp_nsites = __kmp_cp_max_sites = 0;
+  __kmp_release_bootstrap_lock(&__kmp_cp_lock);
+  __kmp_critical_path = FALSE;
+}
@@ -0,0 +1,79 @@
+#ifndef KMP_CRITICAL_PATH_H
+#define KMP_CRITICAL_PATH_H
+
+/** @file kmp_critical_path.h
+ * Work and span of the explicit task graphs.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp.h"
+
+/* With KMP_CRITICAL_PATH=true the runtime times every explicit task and
+   follows the dependences as the tasks release their successors. Each task
+   that creates children owns a graph of them; a finished child adds a record
+   with its execution time and the longest path through its predecessors to
+   its end. When the children are complete at a taskwait, the end of a
+   taskgroup, the end of a parallel region or of the parent task, the graph is
+   folded into a profile per synchronization point: the work (the sum of the
+   task times), the span (the longest path) and the critical path by task
+   entry point. The profile is written at exit to KMP_CRITICAL_PATH_FILE
+   (stderr by default). Work / span bounds the speedup of the graph; if it is
+   below the number of threads, more threads will not help. */
+
+enum kmp_cp_sync_t {
+  kmp_cp_taskwait = 0,
+  kmp_cp_taskgroup,
+  kmp_cp_parallel, // the join of a parallel region or a serialized one
+  kmp_cp_task, // the end of the parent task
+  kmp_cp_initial, // the end of the initial task
+  kmp_cp_last
+};
+
+extern int __kmp_critical_path;
+extern char const *__kmp_critical_path_file;
+
+extern kmp_uint64 __kmp_now_nsec();
+
+extern void __kmp_critical_path_fini(void);
+extern void __kmp_critical_path_alloc(kmp_taskdata_t *parent);
+extern void __kmp_critical_path_node(kmp_depnode_t *node);
+extern void __kmp_critical_path_done(kmp_int32 gtid, kmp_taskdata_t *task);
+extern void __kmp_critical_path_deps(kmp_int32 gtid, kmp_depnode_t *sink,
+                                     kmp_task_t *task,
+                                     kmp_dephash_entry_t *info, bool out);
+extern void __kmp_critical_path_release(kmp_int32 gtid, kmp_depnode_t *source,
+                                        kmp_depnode_t *sink);
+extern void __kmp_critical_path_flush(kmp_taskdata_t *task, int sync,
+                                      ident_t *loc);
+
+// The execution time of a task accumulates over its parts (untied tasks): the
+// start subtracts the clock and the end adds it.
+#define KMP_CRITICAL_PATH_START(taskdata)                                      \
+  do {                                                                         \
+    if (__kmp_critical_path)                                                   \
+      (taskdata)->td_cp_time -= __kmp_now_nsec();                              \
+  } while (0)
+
+#define KMP_CRITICAL_PATH_STOP(taskdata)                                       \
+  do {                                                                         \
+    if (__kmp_critical_path)                                                   \
+      (taskdata)->td_cp_time += __kmp_now_nsec();                              \
+  } while (0)
+
+#define KMP_CRITICAL_PATH_FLUSH(task, sync, loc)                               \
+  do {                                                                         \
+    if (__kmp_critical_path && (task)->td_cp_graph != NULL)                    \
+      __kmp_critical_path_flush((task), (sync), (ident_t *)(loc));             \
+  } while (0)
+
+#endif // KMP_CRITICAL_PATH_H
@@ -15,11 +15,13 @@
 
 #include "omp.h" /* extern "C" declarations of user-visible routines */
 #include "kmp.h"
+#include "kmp_critical_path.h"
 #include "kmp_error.h"
 #include "kmp_i18n.h"
 #include "kmp_itt.h"
 #include "kmp_lock.h"
 #include "kmp_stats.h"
+#include "kmp_trace.h"
 
 #if OMPT_SUPPORT
 #include "ompt-internal.h"
@@ -474,6 +476,7 @@ void __kmpc_end_serialized_parallel(ident_t *loc, kmp_int32 global_tid) {
   if (task_team != NULL && task_team->tt.tt_found_proxy_tasks)
     __kmp_task_team_wait(this_thr, serial_team USE_ITT_BUILD_ARG(NULL));
 #endif
+  KMP_CRITICAL_PATH_FLUSH(this_thr->th.th_current_task, kmp_cp_parallel, loc);
 
   KMP_MB();
   KMP_DEBUG_ASSERT(serial_team);
@@ -833,6 +836,7 @@ void __kmpc_ordered(ident_t *loc, kmp_int32 gtid) {
     /* OMPT state update */
     th->th.ompt_thread_info.wait_id = lck;
     th->th.ompt_thread_info.state = omp_state_wait_ordered;
+    th->th.ompt_thread_info.ident = loc;
 
     /* OMPT event callback */
     codeptr_ra = OMPT_LOAD_RETURN_ADDRESS(gtid);
@@ -853,6 +857,7 @@ void __kmpc_ordered(ident_t *loc, kmp_int32 gtid) {
   if (ompt_enabled.enabled) {
     /* OMPT state update */
     th->th.ompt_thread_info.state = omp_state_work_parallel;
+    th->th.ompt_thread_info.ident = team->t.t_ident;
     th->th.ompt_thread_info.wait_id = 0;
 
     /* OMPT event callback */
@@ -1129,7 +1134,8 @@ void __kmpc_critical(ident_t *loc, kmp_int32 global_tid,
       OMP_critical_wait); /* Time spent waiting to enter the critical section */
 #if OMPT_SUPPORT && OMPT_OPTIONAL
   omp_state_t prev_state = omp_state_undefined;
-  ompt_thread_info_t ti;
+  ident_t *prev_ident = NULL;
+  ompt_thread_info_t *ti;
 #endif
   kmp_user_lock_p lck;
 
@@ -1168,11 +1174,13 @@ void __kmpc_critical(ident_t *loc, kmp_int32 global_tid,
   OMPT_STORE_RETURN_ADDRESS(gtid);
   void* codeptr_ra = NULL;
   if (ompt_enabled.enabled) {
-    ti = __kmp_threads[global_tid]->th.ompt_thread_info;
+    ti = &__kmp_threads[global_tid]->th.ompt_thread_info;
     /* OMPT state update */
-    prev_state = ti.state;
-    ti.wait_id = (ompt_wait_id_t)lck;
-    ti.state = omp_state_wait_critical;
+    prev_state = ti->state;
+    prev_ident = ti->ident;
+    ti->wait_id = (ompt_wait_id_t)lck;
+    ti->state = omp_state_wait_critical;
+    ti->ident = loc;
 
     /* OMPT event callback */
     codeptr_ra = OMPT_LOAD_RETURN_ADDRESS(gtid);
@@ -1185,7 +1193,15 @@ void __kmpc_critical(ident_t *loc, kmp_int32 global_tid,
 #endif
   // Value of 'crit' should be good for using as a critical_id of the critical
   // section directive.
+  KMP_TRACE_EVENT(__kmp_threads[global_tid], kmp_trace_lock_wait, 0, crit,
+                  loc);
+  KMP_PERF_LOCK_BEGIN(perf_start);
+  KMP_CRITICAL_STATS_ACQUIRING(crit_start);
   __kmp_acquire_user_lock_with_checks(lck, global_tid);
+  KMP_CRITICAL_STATS_ACQUIRED(crit_start, loc, crit);
+  KMP_PERF_LOCK_END(__kmp_threads[global_tid], perf_start);
+  KMP_TRACE_EVENT(__kmp_threads[global_tid], kmp_trace_lock_acquired, 0, crit,
+                  0);
 
 #if USE_ITT_BUILD
   __kmp_itt_critical_acquired(lck);
@@ -1193,8 +1209,9 @@ void __kmpc_critical(ident_t *loc, kmp_int32 global_tid,
 #if OMPT_SUPPORT && OMPT_OPTIONAL
   if (ompt_enabled.enabled) {
     /* OMPT state update */
-    ti.state = prev_state;
-    ti.wait_id = 0;
+    ti->state = prev_state;
+    ti->ident = prev_ident;
+    ti->wait_id = 0;
 
     /* OMPT event callback */
     if (ompt_enabled.ompt_callback_mutex_acquired) {
@@ -1233,6 +1250,8 @@ static __forceinline kmp_dyna_lockseq_t __kmp_map_hint_to_lock(uintptr_t hint) {
     return KMP_CPUINFO_RTM ? KMP_TSX_LOCK(rtm) : __kmp_user_lock_seq;
   if (hint & kmp_lock_hint_adaptive)
     return KMP_CPUINFO_RTM ? KMP_TSX_LOCK(adaptive) : __kmp_user_lock_seq;
+  if (hint & kmp_lock_hint_autotune)
+    return lockseq_autotune;
 
   // Rule out conflicting hints first by returning the default lock
   if ((hint & omp_lock_hint_contended) && (hint & omp_lock_hint_uncontended))
@@ -1285,6 +1304,7 @@ __ompt_get_mutex_impl_type(void *user_lock, kmp_indirect_lock_t *ilock = 0) {
   case locktag_rtm:
     return ompt_mutex_impl_speculative;
 #endif
+  case locktag_autotune:
   case locktag_nested_tas:
     return ompt_mutex_impl_spin;
 #if KMP_USE_FUTEX
@@ -1345,7 +1365,8 @@ void __kmpc_critical_with_hint(ident_t *loc, kmp_int32 global_tid,
   kmp_user_lock_p lck;
 #if OMPT_SUPPORT && OMPT_OPTIONAL
   omp_state_t prev_state = omp_state_undefined;
-  ompt_thread_info_t ti;
+  ident_t *prev_ident = NULL;
+  ompt_thread_info_t *ti;
   // This is the case, if called from __kmpc_critical:
   void* codeptr = OMPT_LOAD_RETURN_ADDRESS(global_tid);
   if (!codeptr) codeptr = OMPT_GET_RETURN_ADDRESS(0);
@@ -1367,6 +1388,11 @@ void __kmpc_critical_with_hint(ident_t *loc, kmp_int32 global_tid,
   // Branch for accessing the actual lock object and set operation. This
   // branching is inevitable since this lock initialization does not follow the
   // normal dispatch path (lock table is not used).
+  KMP_TRACE_EVENT(__kmp_threads[global_tid], kmp_trace_lock_wait, 0, crit,
+                  loc);
+  KMP_PERF_LOCK_BEGIN(perf_start);
+  KMP_PUSH_PARTITIONED_TIMER(OMP_critical_wait);
+  KMP_CRITICAL_STATS_ACQUIRING(crit_start);
   if (KMP_EXTRACT_D_TAG(lk) != 0) {
     lck = (kmp_user_lock_p)lk;
     if (__kmp_env_consistency_check) {
@@ -1378,11 +1404,13 @@ void __kmpc_critical_with_hint(ident_t *loc, kmp_int32 global_tid,
 #endif
 #if OMPT_SUPPORT && OMPT_OPTIONAL
     if (ompt_enabled.enabled) {
-      ti = __kmp_threads[global_tid]->th.ompt_thread_info;
+      ti = &__kmp_threads[global_tid]->th.ompt_thread_info;
       /* OMPT state update */
-      prev_state = ti.state;
-      ti.wait_id = (ompt_wait_id_t)lck;
-      ti.state = omp_state_wait_critical;
+      prev_state = ti->state;
+      prev_ident = ti->ident;
+      ti->wait_id = (ompt_wait_id_t)lck;
+      ti->state = omp_state_wait_critical;
+      ti->ident = loc;
 
       /* OMPT event callback */
       if (ompt_enabled.ompt_callback_mutex_acquire) {
@@ -1417,11 +1445,13 @@ void __kmpc_critical_with_hint(ident_t *loc, kmp_int32 global_tid,
 #endif
 #if OMPT_SUPPORT && OMPT_OPTIONAL
     if (ompt_enabled.enabled) {
-      ti = __kmp_threads[global_tid]->th.ompt_thread_info;
+      ti = &__kmp_threads[global_tid]->th.ompt_thread_info;
       /* OMPT state update */
-      prev_state = ti.state;
-      ti.wait_id = (ompt_wait_id_t)lck;
-      ti.state = omp_state_wait_critical;
+      prev_state = ti->state;
+      prev_ident = ti->ident;
+      ti->wait_id = (ompt_wait_id_t)lck;
+      ti->state = omp_state_wait_critical;
+      ti->ident = loc;
 
       /* OMPT event callback */
       if (ompt_enabled.ompt_callback_mutex_acquire) {
@@ -1434,6 +1464,11 @@ void __kmpc_critical_with_hint(ident_t *loc, kmp_int32 global_tid,
 #endif
     KMP_I_LOCK_FUNC(ilk, set)(lck, global_tid);
   }
+  KMP_CRITICAL_STATS_ACQUIRED(crit_start, loc, crit);
+  KMP_POP_PARTITIONED_TIMER();
+  KMP_PERF_LOCK_END(__kmp_threads[global_tid], perf_start);
+  KMP_TRACE_EVENT(__kmp_threads[global_tid], kmp_trace_lock_acquired, 0, crit,
+                  0);
 
 #if USE_ITT_BUILD
   __kmp_itt_critical_acquired(lck);
@@ -1441,8 +1476,9 @@ void __kmpc_critical_with_hint(ident_t *loc, kmp_int32 global_tid,
 #if OMPT_SUPPORT && OMPT_OPTIONAL
   if (ompt_enabled.enabled) {
     /* OMPT state update */
-    ti.state = prev_state;
-    ti.wait_id = 0;
+    ti->state = prev_state;
+    ti->ident = prev_ident;
+    ti->wait_id = 0;
 
     /* OMPT event callback */
     if (ompt_enabled.ompt_callback_mutex_acquired) {
@@ -1473,6 +1509,8 @@ void __kmpc_end_critical(ident_t *loc, kmp_int32 global_tid,
   kmp_user_lock_p lck;
 
   KC_TRACE(10, ("__kmpc_end_critical: called T#%d\n", global_tid));
+  KMP_TRACE_EVENT(__kmp_threads[global_tid], kmp_trace_lock_released, 0, crit,
+                  0);
 
 #if KMP_USE_DYNAMIC_LOCK
   if (KMP_IS_D_LOCK(__kmp_user_lock_seq)) {
@@ -1539,6 +1577,7 @@ void __kmpc_end_critical(ident_t *loc, kmp_int32 global_tid,
   __kmp_release_user_lock_with_checks(lck, global_tid);
 
 #endif // KMP_USE_DYNAMIC_LOCK
+  KMP_CRITICAL_STATS_RELEASED();
 
 #if OMPT_SUPPORT && OMPT_OPTIONAL
   /* OMPT release event triggers after lock is released; place here to trigger
@@ -2448,6 +2487,19 @@ void __kmpc_destroy_nest_lock(ident_t *loc, kmp_int32 gtid, void **user_lock) {
 
 void __kmpc_set_lock(ident_t *loc, kmp_int32 gtid, void **user_lock) {
   KMP_COUNT_BLOCK(OMP_set_lock);
+  KMP_TIME_PARTITIONED_BLOCK(OMP_lock_wait);
+  KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_lock_wait, 0, user_lock, loc);
+  KMP_PERF_LOCK_BEGIN(perf_start);
+#if OMPT_SUPPORT && OMPT_OPTIONAL
+  ompt_thread_info_t *ti = &__kmp_threads[gtid]->th.ompt_thread_info;
+  omp_state_t prev_state = ti->state;
+  ident_t *prev_ident = ti->ident;
+  if (ompt_enabled.enabled) {
+    ti->state = omp_state_wait_lock;
+    ti->wait_id = (ompt_wait_id_t)user_lock;
+    ti->ident = loc;
+  }
+#endif
 #if KMP_USE_DYNAMIC_LOCK
   int tag = KMP_EXTRACT_D_TAG(user_lock);
 #if USE_ITT_BUILD
@@ -2536,9 +2588,32 @@ void __kmpc_set_lock(ident_t *loc, kmp_int32 gtid, void **user_lock) {
 #endif
 
 #endif // KMP_USE_DYNAMIC_LOCK
+#if OMPT_SUPPORT && OMPT_OPTIONAL
+  if (ompt_enabled.enabled) {
+    ti->state = prev_state;
+    ti->ident = prev_ident;
+    ti->wait_id = 0;
+  }
+#endif
+  KMP_PERF_LOCK_END(__kmp_threads[gtid], perf_start);
+  KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_lock_acquired, 0, user_lock,
+                  0);
 }
 
 void __kmpc_set_nest_lock(ident_t *loc, kmp_int32 gtid, void **user_lock) {
+  KMP_TIME_PARTITIONED_BLOCK(OMP_lock_wait);
+  KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_lock_wait, 0, user_lock, loc);
+  KMP_PERF_LOCK_BEGIN(perf_start);
+#if OMPT_SUPPORT && OMPT_OPTIONAL
+  ompt_thread_info_t *ti = &__kmp_threads[gtid]->th.ompt_thread_info;
+  omp_state_t prev_state = ti->state;
+  ident_t *prev_ident = ti->ident;
+  if (ompt_enabled.enabled) {
+    ti->state = omp_state_wait_lock;
+    ti->wait_id = (ompt_wait_id_t)user_lock;
+    ti->ident = loc;
+  }
+#endif
 #if KMP_USE_DYNAMIC_LOCK
 
 #if USE_ITT_BUILD
@@ -2646,9 +2721,21 @@ void __kmpc_set_nest_lock(ident_t *loc, kmp_int32 gtid, void **user_lock) {
 #endif
 
 #endif // KMP_USE_DYNAMIC_LOCK
+#if OMPT_SUPPORT && OMPT_OPTIONAL
+  if (ompt_enabled.enabled) {
+    ti->state = prev_state;
+    ti->ident = prev_ident;
+    ti->wait_id = 0;
+  }
+#endif
+  KMP_PERF_LOCK_END(__kmp_threads[gtid], perf_start);
+  KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_lock_acquired, 0, user_lock,
+                  0);
 }
 
 void __kmpc_unset_lock(ident_t *loc, kmp_int32 gtid, void **user_lock) {
+  KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_lock_released, 0, user_lock,
+                  0);
 #if KMP_USE_DYNAMIC_LOCK
 
   int tag = KMP_EXTRACT_D_TAG(user_lock);
@@ -2745,6 +2832,8 @@ void __kmpc_unset_lock(ident_t *loc, kmp_int32 gtid, void **user_lock) {
 
 /* release the lock */
 void __kmpc_unset_nest_lock(ident_t *loc, kmp_int32 gtid, void **user_lock) {
+  KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_lock_released, 0, user_lock,
+                  0);
 #if KMP_USE_DYNAMIC_LOCK
 
 #if USE_ITT_BUILD
@@ -1563,6 +1563,8 @@ static int __kmp_dispatch_next(ident_t *loc, int gtid, kmp_int32 *p_last,
 #if INCLUDE_SSC_MARKS
     SSC_MARK_DISPATCH_NEXT();
 #endif
+    if (status)
+      KMP_PERF_INC(th, dispatch_chunks);
     OMPT_LOOP_END;
     return status;
   } else {
@@ -2396,6 +2398,8 @@ static int __kmp_dispatch_next(ident_t *loc, int gtid, kmp_int32 *p_last,
 #if INCLUDE_SSC_MARKS
   SSC_MARK_DISPATCH_NEXT();
 #endif
+  if (status)
+    KMP_PERF_INC(th, dispatch_chunks);
   OMPT_LOOP_END;
   return status;
 }
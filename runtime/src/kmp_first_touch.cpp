@@ -0,0 +1,162 @@
+/*
+ * kmp_first_touch.cpp -- First-touch aware initialization of memory.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp.h"
+
+/* Linux places a page on the NUMA node of the thread that first writes to it.
+   Memory initialized by the master alone therefore ends up on the master's
+   node, and a later static loop over it reads mostly remote memory. The
+   routines below fork a parallel region and split the pages of the buffer
+   among the threads of the team with the same static schedule as a
+   "#pragma omp for schedule(static[, chunk])" loop, so a subsequent loop with
+   that schedule finds its data on the local node (with OMP_PROC_BIND set).
+
+   The unit of the partitioning is the page: each page is touched by exactly one
+   thread, the one owning the page's first byte within the buffer. */
+
+static ident_t loc_first_touch = {0, KMP_IDENT_KMPC, 0, 0,
+                                  ";unknown;unknown;0;0;;"};
+
+enum kmp_first_touch_op { kmp_ft_touch, kmp_ft_memset, kmp_ft_memcpy };
+
+struct kmp_first_touch_args {
+  enum kmp_first_touch_op op;
+  char *dst;
+  const char *src; // kmp_ft_memcpy only
+  size_t size;
+  size_t chunk; // pages per chunk, 0 for a plain static schedule
+  int value; // kmp_ft_memset only
+};
+
+// Apply the operation to the bytes [lo, hi) of the buffer.
+static void __kmp_first_touch_range(struct kmp_first_touch_args *args,
+                                    size_t lo, size_t hi) {
+  switch (args->op) {
+  case kmp_ft_touch: {
+    size_t page_size = KMP_GET_PAGE_SIZE();
+    kmp_uintptr_t p = (kmp_uintptr_t)(args->dst + lo);
+    kmp_uintptr_t end = (kmp_uintptr_t)(args->dst + hi);
+    // Write back what is there, the contents must not change.
+    while (p < end) {
+      *(volatile char *)p = *(volatile char *)p;
+      p = (p & ~(kmp_uintptr_t)(page_size - 1)) + page_size;
+    }
+    break;
+  }
+  case kmp_ft_memset:
+    memset(args->dst + lo, args->value, hi - lo);
+    break;
+  case kmp_ft_memcpy:
+    KMP_MEMCPY(args->dst + lo, args->src + lo, hi - lo);
+    break;
+  }
+}
+
+static void __kmp_first_touch_microtask(int *gtid, int *tid,
+                                        struct kmp_first_touch_args *args) {
+  size_t page_size = KMP_GET_PAGE_SIZE();
+  kmp_uintptr_t base =
+      (kmp_uintptr_t)args->dst & ~(kmp_uintptr_t)(page_size - 1);
+  kmp_uint64 npages =
+      ((kmp_uintptr_t)args->dst + args->size - base + page_size - 1) /
+      page_size;
+  kmp_uint64 lower = 0, upper = npages - 1;
+  kmp_int64 stride = 1;
+  kmp_int32 last = 0;
+
+  __kmpc_for_static_init_8u(
+      &loc_first_touch, *gtid,
+      args->chunk ? kmp_sch_static_chunked : kmp_sch_static, &last, &lower,
+      &upper, &stride, 1, args->chunk ? (kmp_int64)args->chunk : 1);
+  for (; lower < npages; lower += stride, upper += stride) {
+    kmp_uint64 hi_page = KMP_MIN(upper, npages - 1);
+    // Byte offsets of the pages within the buffer, clipped to its bounds.
+    kmp_uintptr_t lo = base + lower * page_size;
+    kmp_uintptr_t hi = base + (hi_page + 1) * page_size;
+    lo = KMP_MAX(lo, (kmp_uintptr_t)args->dst);
+    hi = KMP_MIN(hi, (kmp_uintptr_t)args->dst + args->size);
+    if (lower <= hi_page && lo < hi)
+      __kmp_first_touch_range(args, lo - (kmp_uintptr_t)args->dst,
+                              hi - (kmp_uintptr_t)args->dst);
+  }
+  __kmpc_for_static_fini(&loc_first_touch, *gtid);
+}
+
+static void __kmp_first_touch_fork(struct kmp_first_touch_args *args) {
+  int gtid = __kmp_entry_gtid();
+
+  if (args->size == 0)
+    return;
+  KA_TRACE(10, ("__kmp_first_touch_fork: T#%d op %d dst %p size %lu chunk "
+                "%lu\n",
+                gtid, (int)args->op, args->dst, (unsigned long)args->size,
+                (unsigned long)args->chunk));
+  __kmpc_fork_call(&loc_first_touch, 1, (kmpc_micro)__kmp_first_touch_microtask,
+                   args);
+}
+
+// Touch the pages of the buffer in parallel without changing its contents.
+// chunk is in bytes and is rounded up to whole pages; 0 selects the plain
+// static schedule.
+void __kmp_parallel_first_touch(void *ptr, size_t size, size_t chunk) {
+  struct kmp_first_touch_args args;
+  size_t page_size = KMP_GET_PAGE_SIZE();
+
+  args.op = kmp_ft_touch;
+  args.dst = (char *)ptr;
+  args.src = NULL;
+  args.size = size;
+  args.chunk = (chunk + page_size - 1) / page_size;
+  args.value = 0;
+  __kmp_first_touch_fork(&args);
+}
+
+void __kmp_parallel_memset(void *ptr, int value, size_t size) {
+  struct kmp_first_touch_args args;
+
+  args.op = kmp_ft_memset;
+  args.dst = (char *)ptr;
+  args.src = NULL;
+  args.size = size;
+  args.chunk = 0;
+  args.value = value;
+  __kmp_first_touch_fork(&args);
+}
+
+// The pages of the destination are distributed, the source is read wherever
+// it resides.
+void __kmp_parallel_memcpy(void *dst, const void *src, size_t size) {
+  struct kmp_first_touch_args args;
+
+  args.op = kmp_ft_memcpy;
+  args.dst = (char *)dst;
+  args.src = (const char *)src;
+  args.size = size;
+  args.chunk = 0;
+  args.value = 0;
+  __kmp_first_touch_fork(&args);
+}
+
+// NUMA node of the resident pages of the buffer, -1 if they are on several
+// nodes, if none is resident or if the node cannot be determined.
+int __kmp_get_memory_node(const void *ptr, size_t size) {
+#if KMP_AFFINITY_SUPPORTED && KMP_OS_LINUX
+  return __kmp_numa_node_of_range(ptr, size);
+#else
+  return -1;
+#endif
+}
+
+// end of file //
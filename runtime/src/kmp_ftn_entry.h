@@ -22,6 +22,7 @@
 #endif
 
 #include "kmp_i18n.h"
+#include "kmp_stats.h"
 
 #if OMPT_SUPPORT
 #include "ompt-specific.h"
@@ -422,6 +423,128 @@ int FTN_STDCALL FTN_GET_NUM_KNOWN_THREADS(void) {
 #endif
 }
 
+/* Launch a parallel region executed by a separate root; the caller gets a
+   handle back immediately and must eventually pass it to FTN_ASYNC_WAIT. */
+void *FTN_STDCALL FTN_PARALLEL_ASYNC(void (*fn)(void *), void *data,
+                                     int KMP_DEREF nthreads) {
+#ifdef KMP_STUB
+  fn(data);
+  return NULL; // NULL handle is always complete
+#else
+  return __kmp_async_launch(fn, data, KMP_DEREF nthreads);
+#endif
+}
+
+int FTN_STDCALL FTN_ASYNC_TEST(void *handle) {
+#ifdef KMP_STUB
+  return 1;
+#else
+  return __kmp_async_test((kmp_async_region_t *)handle);
+#endif
+}
+
+void FTN_STDCALL FTN_ASYNC_WAIT(void *handle) {
+#ifndef KMP_STUB
+  __kmp_async_wait((kmp_async_region_t *)handle);
+#endif
+}
+
+/* Print the statistics gathered so far and reset them. Does nothing unless the
+   library was built with stats-gathering, nor inside a parallel region. */
+void FTN_STDCALL FTN_DUMP_STATS(void) {
+#if !defined(KMP_STUB) && KMP_STATS_ENABLED
+  if (__kmp_init_serial)
+    __kmp_stats_on_demand("Statistics on demand");
+#endif
+}
+
+/* Discard the statistics gathered so far, e.g. those of the start-up of the
+   program, so that the output covers the phases after the call only. Not
+   inside a parallel region, like kmp_dump_stats(). */
+void FTN_STDCALL FTN_CLEAR_STATS(void) {
+#if !defined(KMP_STUB) && KMP_STATS_ENABLED
+  if (__kmp_init_serial)
+    __kmp_stats_on_demand(NULL);
+#endif
+}
+
+/* Touch, fill or copy into the pages of a buffer from the threads of a new
+   parallel region, so that each page lands on the NUMA node of the thread a
+   static loop over the buffer assigns it to. */
+void FTN_STDCALL FTN_PARALLEL_FIRST_TOUCH(void *ptr, size_t KMP_DEREF size,
+                                          size_t KMP_DEREF chunk) {
+#ifndef KMP_STUB
+  __kmp_parallel_first_touch(ptr, KMP_DEREF size, KMP_DEREF chunk);
+#endif
+}
+
+void FTN_STDCALL FTN_PARALLEL_MEMSET(void *ptr, int KMP_DEREF value,
+                                     size_t KMP_DEREF size) {
+#ifdef KMP_STUB
+  memset(ptr, KMP_DEREF value, KMP_DEREF size);
+#else
+  __kmp_parallel_memset(ptr, KMP_DEREF value, KMP_DEREF size);
+#endif
+}
+
+void FTN_STDCALL FTN_PARALLEL_MEMCPY(void *dst, const void *src,
+                                     size_t KMP_DEREF size) {
+#ifdef KMP_STUB
+  memcpy(dst, src, KMP_DEREF size);
+#else
+  __kmp_parallel_memcpy(dst, src, KMP_DEREF size);
+#endif
+}
+
+/* NUMA node holding the resident pages of the buffer, -1 if they are spread
+   over several nodes or the node is not known. */
+int FTN_STDCALL FTN_GET_MEMORY_NODE(const void *ptr, size_t KMP_DEREF size) {
+#ifdef KMP_STUB
+  return -1;
+#else
+  return __kmp_get_memory_node(ptr, KMP_DEREF size);
+#endif
+}
+
+/* Restrict the place partition of the calling root to the places
+   [first_place, last_place]. Returns 0 on success, -1 if the range is invalid,
+   if the call is made inside a parallel region or if OMP_PROC_BIND places are
+   not in use. */
+int FTN_STDCALL FTN_SET_PLACE_PARTITION(int KMP_DEREF first_place,
+                                        int KMP_DEREF last_place) {
+#if defined(KMP_STUB) || !KMP_AFFINITY_SUPPORTED || !OMP_40_ENABLED
+  return -1;
+#else
+  int gtid;
+  if (!TCR_4(__kmp_init_middle)) {
+    __kmp_middle_initialize();
+  }
+  gtid = __kmp_entry_gtid();
+  return __kmp_affinity_set_partition(gtid, KMP_DEREF first_place,
+                                      KMP_DEREF last_place);
+#endif
+}
+
+// The caller passes the size of its kmp_perf_counters_t, so that a program
+// built with an older omp.h gets the fields it knows of.
+int FTN_STDCALL FTN_GET_PERF_COUNTERS(int KMP_DEREF thread, void *counters,
+                                      size_t KMP_DEREF size) {
+#ifdef KMP_STUB
+  if (counters != NULL)
+    memset(counters, 0, KMP_DEREF size);
+  return KMP_DEREF thread == -1 ? 0 : -1;
+#else
+  kmp_perf_t perf;
+  int rc;
+  if (counters == NULL)
+    return -1;
+  rc = __kmp_get_perf_counters(KMP_DEREF thread, &perf);
+  memset(counters, 0, KMP_DEREF size);
+  KMP_MEMCPY(counters, &perf, KMP_MIN(KMP_DEREF size, sizeof(perf)));
+  return rc;
+#endif
+}
+
 int FTN_STDCALL xexpand(FTN_GET_NUM_PROCS)(void) {
 #ifdef KMP_STUB
   return 1;
@@ -619,8 +742,6 @@ int FTN_STDCALL FTN_GET_PLACE_NUM_PROCS(int place_num) {
 #if defined(KMP_STUB) || !KMP_AFFINITY_SUPPORTED
   return 0;
 #else
-  int i;
-  int retval = 0;
   if (!TCR_4(__kmp_init_middle)) {
     __kmp_middle_initialize();
   }
@@ -628,15 +749,8 @@ int FTN_STDCALL FTN_GET_PLACE_NUM_PROCS(int place_num) {
     return 0;
   if (place_num < 0 || place_num >= (int)__kmp_affinity_num_masks)
     return 0;
-  kmp_affin_mask_t *mask = KMP_CPU_INDEX(__kmp_affinity_masks, place_num);
-  KMP_CPU_SET_ITERATE(i, mask) {
-    if ((!KMP_CPU_ISSET(i, __kmp_affin_fullMask)) ||
-        (!KMP_CPU_ISSET(i, mask))) {
-      continue;
-    }
-    ++retval;
-  }
-  return retval;
+  return __kmp_affinity_place_first[place_num + 1] -
+         __kmp_affinity_place_first[place_num];
 #endif
 }
 
@@ -644,7 +758,7 @@ void FTN_STDCALL FTN_GET_PLACE_PROC_IDS(int place_num, int *ids) {
 #if defined(KMP_STUB) || !KMP_AFFINITY_SUPPORTED
 // Nothing.
 #else
-  int i, j;
+  int k;
   if (!TCR_4(__kmp_init_middle)) {
     __kmp_middle_initialize();
   }
@@ -652,15 +766,9 @@ void FTN_STDCALL FTN_GET_PLACE_PROC_IDS(int place_num, int *ids) {
     return;
   if (place_num < 0 || place_num >= (int)__kmp_affinity_num_masks)
     return;
-  kmp_affin_mask_t *mask = KMP_CPU_INDEX(__kmp_affinity_masks, place_num);
-  j = 0;
-  KMP_CPU_SET_ITERATE(i, mask) {
-    if ((!KMP_CPU_ISSET(i, __kmp_affin_fullMask)) ||
-        (!KMP_CPU_ISSET(i, mask))) {
-      continue;
-    }
-    ids[j++] = i;
-  }
+  for (k = __kmp_affinity_place_first[place_num];
+       k < __kmp_affinity_place_first[place_num + 1]; ++k)
+    *ids++ = __kmp_affinity_place_ids[k];
 #endif
 }
 
@@ -891,6 +999,55 @@ int FTN_STDCALL FTN_TARGET_DISASSOCIATE_PTR(void *host_ptr, int device_num) {
 }
 #endif // OMP_45_ENABLED && defined(KMP_STUB)
 
+#if OMP_50_ENABLED
+// Memory management functions are C-only, parameters always passed by value
+omp_allocator_handle_t FTN_STDCALL
+FTN_INIT_ALLOCATOR(omp_memspace_handle_t memspace, int ntraits,
+                   const omp_alloctrait_t traits[]) {
+#ifdef KMP_STUB
+  return omp_default_mem_alloc;
+#else
+  return __kmpc_init_allocator(__kmp_entry_gtid(), memspace, ntraits, traits);
+#endif
+}
+
+void FTN_STDCALL FTN_DESTROY_ALLOCATOR(omp_allocator_handle_t allocator) {
+#ifndef KMP_STUB
+  __kmpc_destroy_allocator(__kmp_entry_gtid(), allocator);
+#endif
+}
+
+void FTN_STDCALL FTN_SET_DEFAULT_ALLOCATOR(omp_allocator_handle_t allocator) {
+#ifndef KMP_STUB
+  __kmpc_set_default_allocator(__kmp_entry_gtid(), allocator);
+#endif
+}
+
+omp_allocator_handle_t FTN_STDCALL FTN_GET_DEFAULT_ALLOCATOR(void) {
+#ifdef KMP_STUB
+  return omp_default_mem_alloc;
+#else
+  return __kmpc_get_default_allocator(__kmp_entry_gtid());
+#endif
+}
+
+void *FTN_STDCALL FTN_OMP_ALLOC(size_t size, omp_allocator_handle_t allocator) {
+#ifdef KMP_STUB
+  return malloc(size);
+#else
+  return __kmpc_alloc(__kmp_entry_gtid(), size, allocator);
+#endif
+}
+
+void FTN_STDCALL FTN_OMP_FREE(void *ptr, omp_allocator_handle_t allocator) {
+#ifdef KMP_STUB
+  free(ptr);
+#else
+  __kmpc_free(__kmp_entry_gtid(), ptr, allocator);
+#endif
+}
+#endif // OMP_50_ENABLED
+
 #ifdef KMP_STUB
 typedef enum { UNINIT = -1, UNLOCKED, LOCKED } kmp_stub_lock_t;
 #endif /* KMP_STUB */
@@ -52,6 +52,17 @@
 #define FTN_FREE kmp_free
 
 #define FTN_GET_NUM_KNOWN_THREADS kmp_get_num_known_threads
+#define FTN_PARALLEL_ASYNC kmp_parallel_async
+#define FTN_ASYNC_TEST kmp_async_test
+#define FTN_ASYNC_WAIT kmp_async_wait
+#define FTN_DUMP_STATS kmp_dump_stats
+#define FTN_CLEAR_STATS kmp_clear_stats
+#define FTN_PARALLEL_FIRST_TOUCH kmp_parallel_first_touch
+#define FTN_PARALLEL_MEMSET kmp_parallel_memset
+#define FTN_PARALLEL_MEMCPY kmp_parallel_memcpy
+#define FTN_GET_MEMORY_NODE kmp_get_memory_node
+#define FTN_SET_PLACE_PARTITION kmp_set_place_partition
+#define FTN_GET_PERF_COUNTERS kmp_get_perf_counters
 
 #if OMPT_SUPPORT
 #define FTN_CONTROL_TOOL omp_control_tool
@@ -138,6 +149,15 @@
 #endif
 #endif
 
+#if OMP_50_ENABLED
+#define FTN_INIT_ALLOCATOR omp_init_allocator
+#define FTN_DESTROY_ALLOCATOR omp_destroy_allocator
+#define FTN_SET_DEFAULT_ALLOCATOR omp_set_default_allocator
+#define FTN_GET_DEFAULT_ALLOCATOR omp_get_default_allocator
+#define FTN_OMP_ALLOC omp_alloc
+#define FTN_OMP_FREE omp_free
+#endif
+
 #endif /* KMP_FTN_PLAIN */
 
 /* ------------------------------------------------------------------------ */
@@ -173,6 +193,17 @@
 #define FTN_FREE kmp_free_
 
 #define FTN_GET_NUM_KNOWN_THREADS kmp_get_num_known_threads_
+#define FTN_PARALLEL_ASYNC kmp_parallel_async_
+#define FTN_ASYNC_TEST kmp_async_test_
+#define FTN_ASYNC_WAIT kmp_async_wait_
+#define FTN_DUMP_STATS kmp_dump_stats_
+#define FTN_CLEAR_STATS kmp_clear_stats_
+#define FTN_PARALLEL_FIRST_TOUCH kmp_parallel_first_touch_
+#define FTN_PARALLEL_MEMSET kmp_parallel_memset_
+#define FTN_PARALLEL_MEMCPY kmp_parallel_memcpy_
+#define FTN_GET_MEMORY_NODE kmp_get_memory_node_
+#define FTN_SET_PLACE_PARTITION kmp_set_place_partition_
+#define FTN_GET_PERF_COUNTERS kmp_get_perf_counters_
 
 #define FTN_SET_NUM_THREADS omp_set_num_threads_
 #define FTN_GET_NUM_THREADS omp_get_num_threads_
@@ -259,6 +290,12 @@
 
 #if OMP_50_ENABLED
 #define FTN_CONTROL_TOOL OMP_CONTROL_TOOL
+#define FTN_INIT_ALLOCATOR omp_init_allocator_
+#define FTN_DESTROY_ALLOCATOR omp_destroy_allocator_
+#define FTN_SET_DEFAULT_ALLOCATOR omp_set_default_allocator_
+#define FTN_GET_DEFAULT_ALLOCATOR omp_get_default_allocator_
+#define FTN_OMP_ALLOC omp_alloc_
+#define FTN_OMP_FREE omp_free_
 #endif
 
 #endif /* KMP_FTN_APPEND */
@@ -296,6 +333,17 @@
 #define FTN_FREE KMP_FREE
 
 #define FTN_GET_NUM_KNOWN_THREADS KMP_GET_NUM_KNOWN_THREADS
+#define FTN_PARALLEL_ASYNC KMP_PARALLEL_ASYNC
+#define FTN_ASYNC_TEST KMP_ASYNC_TEST
+#define FTN_ASYNC_WAIT KMP_ASYNC_WAIT
+#define FTN_DUMP_STATS KMP_DUMP_STATS
+#define FTN_CLEAR_STATS KMP_CLEAR_STATS
+#define FTN_PARALLEL_FIRST_TOUCH KMP_PARALLEL_FIRST_TOUCH
+#define FTN_PARALLEL_MEMSET KMP_PARALLEL_MEMSET
+#define FTN_PARALLEL_MEMCPY KMP_PARALLEL_MEMCPY
+#define FTN_GET_MEMORY_NODE KMP_GET_MEMORY_NODE
+#define FTN_SET_PLACE_PARTITION KMP_SET_PLACE_PARTITION
+#define FTN_GET_PERF_COUNTERS KMP_GET_PERF_COUNTERS
 
 #define FTN_SET_NUM_THREADS OMP_SET_NUM_THREADS
 #define FTN_GET_NUM_THREADS OMP_GET_NUM_THREADS
@@ -382,6 +430,12 @@
 
 #if OMP_50_ENABLED
 #define FTN_CONTROL_TOOL OMP_CONTROL_TOOL
+#define FTN_INIT_ALLOCATOR OMP_INIT_ALLOCATOR
+#define FTN_DESTROY_ALLOCATOR OMP_DESTROY_ALLOCATOR
+#define FTN_SET_DEFAULT_ALLOCATOR OMP_SET_DEFAULT_ALLOCATOR
+#define FTN_GET_DEFAULT_ALLOCATOR OMP_GET_DEFAULT_ALLOCATOR
+#define FTN_OMP_ALLOC OMP_ALLOC
+#define FTN_OMP_FREE OMP_FREE
 #endif
 
 #endif /* KMP_FTN_UPPER */
@@ -419,6 +473,17 @@
 #define FTN_FREE KMP_FREE_
 
 #define FTN_GET_NUM_KNOWN_THREADS KMP_GET_NUM_KNOWN_THREADS_
+#define FTN_PARALLEL_ASYNC KMP_PARALLEL_ASYNC_
+#define FTN_ASYNC_TEST KMP_ASYNC_TEST_
+#define FTN_ASYNC_WAIT KMP_ASYNC_WAIT_
+#define FTN_DUMP_STATS KMP_DUMP_STATS_
+#define FTN_CLEAR_STATS KMP_CLEAR_STATS_
+#define FTN_PARALLEL_FIRST_TOUCH KMP_PARALLEL_FIRST_TOUCH_
+#define FTN_PARALLEL_MEMSET KMP_PARALLEL_MEMSET_
+#define FTN_PARALLEL_MEMCPY KMP_PARALLEL_MEMCPY_
+#define FTN_GET_MEMORY_NODE KMP_GET_MEMORY_NODE_
+#define FTN_SET_PLACE_PARTITION KMP_SET_PLACE_PARTITION_
+#define FTN_GET_PERF_COUNTERS KMP_GET_PERF_COUNTERS_
 
 #if OMPT_SUPPORT
 #define FTN_CONTROL_TOOL OMP_CONTROL_TOOL_
@@ -506,6 +571,15 @@
 #endif
 #endif
 
+#if OMP_50_ENABLED
+#define FTN_INIT_ALLOCATOR OMP_INIT_ALLOCATOR_
+#define FTN_DESTROY_ALLOCATOR OMP_DESTROY_ALLOCATOR_
+#define FTN_SET_DEFAULT_ALLOCATOR OMP_SET_DEFAULT_ALLOCATOR_
+#define FTN_GET_DEFAULT_ALLOCATOR OMP_GET_DEFAULT_ALLOCATOR_
+#define FTN_OMP_ALLOC OMP_ALLOC_
+#define FTN_OMP_FREE OMP_FREE_
+#endif
+
 #endif /* KMP_FTN_UAPPEND */
 
 /* -------------------------- GOMP API NAMES ------------------------ */
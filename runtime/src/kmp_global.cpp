@@ -75,6 +75,18 @@ size_t __kmp_stkoffset = KMP_DEFAULT_STKOFFSET;
 int __kmp_stkpadding = KMP_MIN_STKPADDING;
 
 size_t __kmp_malloc_pool_incr = KMP_DEFAULT_MALLOC_POOL_INCR;
+#if KMP_USE_BGET
+kmp_malloc_kind_t __kmp_malloc_kind = kmp_malloc_bget;
+#endif
+#if KMP_OS_LINUX
+kmp_huge_pages_t __kmp_huge_pages = kmp_huge_pages_disabled;
+int __kmp_huge_pages_stats = FALSE;
+int __kmp_numa_local_threads = TRUE;
+int __kmp_oversub_check = KMP_DEFAULT_OVERSUB_CHECK;
+volatile int __kmp_sys_oversubscribed = FALSE;
+volatile int __kmp_sys_free_procs = 0;
+volatile kmp_int32 __kmp_nth_sleeping = 0;
+#endif
 
 // Barrier method defaults, settings, and strings.
 // branch factor = 2^branch_bits (only relevant for tree & hyper barrier types)
@@ -151,6 +163,9 @@ int __kmp_hot_teams_mode = 0; /* 0 - free extra threads when reduced */
 /* 1 - keep extra threads when reduced */
 int __kmp_hot_teams_max_level = 1; /* nesting level of hot teams */
 #endif
+int __kmp_spawn_tree = TRUE; /* new workers create other new workers */
+int __kmp_perf_lock_timing = FALSE; /* time the lock waits in th_perf */
+int __kmp_perf_wait_timing = FALSE; /* time the barriers and waits in th_perf */
 enum library_type __kmp_library = library_none;
 enum sched_type __kmp_sched =
     kmp_sch_default; /* scheduling method for runtime scheduling */
@@ -278,14 +293,23 @@ int __kmp_affinity_respect_mask = affinity_respect_mask_default;
 char *__kmp_affinity_proclist = NULL;
 kmp_affin_mask_t *__kmp_affinity_masks = NULL;
 unsigned __kmp_affinity_num_masks = 0;
+#if OMP_40_ENABLED
+int *__kmp_affinity_place_first = NULL;
+int *__kmp_affinity_place_ids = NULL;
+#endif
 
 char const *__kmp_cpuinfo_file = NULL;
+#if KMP_OS_LINUX
+char const *__kmp_sysfs_root = NULL; // NULL means "/sys"
+#endif
 
 #endif /* KMP_AFFINITY_SUPPORTED */
 
 #if OMP_40_ENABLED
 kmp_nested_proc_bind_t __kmp_nested_proc_bind = {NULL, 0, 0};
 int __kmp_affinity_num_places = 0;
+int __kmp_place_partition_first = -1; // KMP_PLACE_PARTITION, -1 if not set
+int __kmp_place_partition_last = -1;
 #endif
 
 kmp_hws_item_t __kmp_hws_socket = {0, 0};
@@ -310,6 +334,10 @@ kmp_uint64 __kmp_taskloop_min_tasks = 0;
 char const *__kmp_tool_libraries = NULL;
 #endif
 
+#if OMP_50_ENABLED
+omp_allocator_handle_t __kmp_def_allocator = omp_default_mem_alloc;
+#endif
+
 /* This check ensures that the compiler is passing the correct data type for the
    flags formal parameter of the function kmpc_omp_task_alloc(). If the type is
    not a 4-byte type, then give an error message about a non-positive length
@@ -394,6 +394,8 @@ static
   va_end(ap);
 
   if (rc) {
+    // The master runs the region in the team just forked, not in its parent.
+    team = thr->th.th_team;
     __kmp_run_before_invoked_task(gtid, tid, thr, team);
   }
 
@@ -0,0 +1,505 @@
+/*
+ * kmp_hw_counters.cpp -- Hardware performance counters per parallel region.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp_hw_counters.h"
+#include "kmp_i18n.h"
+#include "kmp_str.h"
+#include "kmp_wrapper_getpid.h"
+
+#if KMP_OS_LINUX
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#ifndef PERF_FLAG_FD_CLOEXEC // older headers
+#define PERF_FLAG_FD_CLOEXEC (1UL << 3)
+#endif
+#endif
+
+int __kmp_hw_counters = FALSE;
+char const *__kmp_hw_counters_events = NULL;
+char const *__kmp_hw_counters_file = NULL;
+
+typedef struct kmp_hw_event {
+  char const *name;
+  kmp_uint32 type;
+  kmp_uint64 config;
+} kmp_hw_event_t;
+
+#if KMP_OS_LINUX
+#define KMP_HW_CACHE(cache, op, result)                                        \
+  ((cache) | ((op) << 8) | ((result) << 16))
+
+// The names perf(1) uses for the generic events.
+static kmp_hw_event_t const __kmp_hw_event_names[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"bus-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES},
+    {"stalled-cycles-frontend", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+    {"stalled-cycles-backend", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+    {"ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES},
+    {"L1-dcache-loads", PERF_TYPE_HW_CACHE,
+     KMP_HW_CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                  PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+     KMP_HW_CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                  PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"LLC-loads", PERF_TYPE_HW_CACHE,
+     KMP_HW_CACHE(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                  PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"LLC-load-misses", PERF_TYPE_HW_CACHE,
+     KMP_HW_CACHE(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                  PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"dTLB-load-misses", PERF_TYPE_HW_CACHE,
+     KMP_HW_CACHE(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                  PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {"cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+};
+
+#define KMP_HW_DEFAULT_EVENTS "cycles,instructions,cache-misses"
+#endif
+
+// The events every thread opens, in the order of the group.
+static kmp_hw_event_t __kmp_hw_events[KMP_HW_COUNTERS_MAX];
+static int __kmp_hw_nevents = 0;
+static int __kmp_hw_cycles = -1, __kmp_hw_instructions = -1,
+           __kmp_hw_misses = -1; // indexes of the events of the ratios
+static kmp_str_buf_t __kmp_hw_refused; // the events left out and why
+static int __kmp_hw_pid = 0; // 0 until the counters are initialized
+
+static kmp_thread_slot_t *volatile __kmp_hw_threads = NULL;
+
+#if KMP_OS_LINUX
+static int __kmp_hw_counters_open(kmp_hw_event_t const *event, int group) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event->type;
+  attr.config = event->config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // The calling thread on any cpu.
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group,
+                      PERF_FLAG_FD_CLOEXEC);
+}
+
+static bool __kmp_hw_counters_parse(char const *name, kmp_hw_event_t *event) {
+  for (size_t i = 0;
+       i < sizeof(__kmp_hw_event_names) / sizeof(__kmp_hw_event_names[0]);
+       ++i) {
+    if (strcmp(name, __kmp_hw_event_names[i].name) == 0) {
+      *event = __kmp_hw_event_names[i];
+      return true;
+    }
+  }
+  // rNNNN is a raw event of the processor, as with perf(1).
+  if (name[0] == 'r' && name[1] != '\0') {
+    char *end;
+    unsigned long long config = strtoull(name + 1, &end, 16);
+    if (*end == '\0') {
+      event->name = name;
+      event->type = PERF_TYPE_RAW;
+      event->config = config;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Select the events of the group from the defaults and KMP_HW_COUNTERS_EVENTS,
+// leaving out those the kernel does not open on the initial thread.
+static void __kmp_hw_counters_select(void) {
+  int fds[KMP_HW_COUNTERS_MAX];
+  char *list = __kmp_str_format("%s,%s", KMP_HW_DEFAULT_EVENTS,
+                                __kmp_hw_counters_events
+                                    ? __kmp_hw_counters_events
+                                    : "");
+  char *buf;
+  char *name = __kmp_str_token(list, ", ", &buf);
+  for (; name != NULL; name = __kmp_str_token(NULL, ", ", &buf)) {
+    kmp_hw_event_t event;
+    int i;
+    for (i = 0; i < __kmp_hw_nevents; ++i) {
+      if (strcmp(__kmp_hw_events[i].name, name) == 0)
+        break;
+    }
+    if (i < __kmp_hw_nevents)
+      continue;
+    if (!__kmp_hw_counters_parse(name, &event)) {
+      __kmp_str_buf_print(&__kmp_hw_refused, " %s (unknown event)", name);
+      continue;
+    }
+    if (__kmp_hw_nevents == KMP_HW_COUNTERS_MAX) {
+      __kmp_str_buf_print(&__kmp_hw_refused, " %s (more than %d events)",
+                          name, KMP_HW_COUNTERS_MAX);
+      continue;
+    }
+    int fd = __kmp_hw_counters_open(&event, __kmp_hw_nevents ? fds[0] : -1);
+    if (fd < 0) {
+      __kmp_str_buf_print(&__kmp_hw_refused, " %s (%s)", name,
+                          strerror(errno));
+      continue;
+    }
+    fds[__kmp_hw_nevents] = fd;
+    // The raw names point into the list, which is freed below.
+    event.name = __kmp_str_format("%s", name);
+    __kmp_hw_events[__kmp_hw_nevents++] = event;
+  }
+  for (int i = 0; i < __kmp_hw_nevents; ++i) {
+    close(fds[i]);
+    if (strcmp(__kmp_hw_events[i].name, "cycles") == 0)
+      __kmp_hw_cycles = i;
+    else if (strcmp(__kmp_hw_events[i].name, "instructions") == 0)
+      __kmp_hw_instructions = i;
+    else if (strcmp(__kmp_hw_events[i].name, "cache-misses") == 0)
+      __kmp_hw_misses = i;
+  }
+  KMP_INTERNAL_FREE(list);
+}
+#endif
+
+void __kmp_hw_counters_init(void) {
+  if (!__kmp_hw_counters)
+    return;
+  if (__kmp_hw_pid == getpid())
+    return;
+#if KMP_OS_LINUX
+  // A child of fork() counts for itself; the counters it inherited are those
+  // of the threads of the parent.
+  for (kmp_hw_thread_t *t = (kmp_hw_thread_t *)__kmp_hw_threads; t;
+       t = (kmp_hw_thread_t *)t->slot.next) {
+    for (int i = 0; i < KMP_HW_COUNTERS_MAX; ++i) {
+      if (t->fds[i] >= 0)
+        close(t->fds[i]);
+    }
+  }
+  __kmp_hw_threads = NULL;
+  __kmp_hw_nevents = 0;
+  __kmp_hw_cycles = __kmp_hw_instructions = __kmp_hw_misses = -1;
+  __kmp_str_buf_init(&__kmp_hw_refused);
+  __kmp_hw_counters_select();
+  __kmp_hw_pid = getpid();
+  KA_TRACE(10, ("__kmp_hw_counters_init: %d events\n", __kmp_hw_nevents));
+#else
+  // No perf_event_open() on this OS.
+  __kmp_hw_counters = FALSE;
+#endif
+}
+
+// The scaled counts of the group, false if it cannot be read.
+static bool __kmp_hw_counters_read(kmp_hw_thread_t *t, kmp_uint64 *values) {
+#if KMP_OS_LINUX
+  kmp_uint64 buf[3 + KMP_HW_COUNTERS_MAX];
+  ssize_t size = (3 + __kmp_hw_nevents) * sizeof(kmp_uint64);
+  if (t->fds[0] < 0 || read(t->fds[0], buf, size) != size)
+    return false;
+  // buf is {nr, time enabled, time running, values}; a group that shares the
+  // counters with others runs part of the time.
+  kmp_uint64 enabled = buf[1], running = buf[2];
+  for (int i = 0; i < __kmp_hw_nevents; ++i) {
+    if (running == 0)
+      values[i] = 0;
+    else if (running < enabled)
+      values[i] = (kmp_uint64)((double)buf[3 + i] * enabled / running);
+    else
+      values[i] = buf[3 + i];
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+static kmp_hw_thread_t *__kmp_hw_counters_attach(kmp_info_t *thr) {
+  int gtid = thr->th.th_info.ds.ds_gtid;
+  // Take over the counts of an ended thread of the same gtid.
+  kmp_hw_thread_t *t =
+      (kmp_hw_thread_t *)__kmp_thread_slot_reuse(&__kmp_hw_threads, gtid);
+  if (t == NULL) {
+    t = (kmp_hw_thread_t *)KMP_INTERNAL_MALLOC(sizeof(kmp_hw_thread_t));
+    if (t == NULL)
+      KMP_FATAL(MemoryAllocFailed);
+    memset(t, 0, sizeof(kmp_hw_thread_t));
+    for (int i = 0; i < KMP_HW_COUNTERS_MAX; ++i)
+      t->fds[i] = -1;
+    __kmp_thread_slot_push(&__kmp_hw_threads, &t->slot, gtid);
+  }
+  t->depth = 0;
+#if KMP_OS_LINUX
+  // Called by the thread itself, the counters are those of the caller.
+  for (int i = 0; i < __kmp_hw_nevents; ++i) {
+    t->fds[i] = __kmp_hw_counters_open(&__kmp_hw_events[i],
+                                       i ? t->fds[0] : -1);
+    if (t->fds[i] < 0) {
+      // The thread is left out, its columns would not add up.
+      KA_TRACE(10, ("__kmp_hw_counters_attach: T#%d cannot open %s\n", gtid,
+                    __kmp_hw_events[i].name));
+      for (int j = 0; j < i; ++j) {
+        close(t->fds[j]);
+        t->fds[j] = -1;
+      }
+      break;
+    }
+  }
+#endif
+  if (!__kmp_hw_counters_read(t, t->last))
+    memset(t->last, 0, sizeof(t->last));
+  thr->th.th_hw_counters = t;
+  return t;
+}
+
+void __kmp_hw_counters_detach(kmp_info_t *thr) {
+  kmp_hw_thread_t *t = thr->th.th_hw_counters;
+  if (t == NULL)
+    return;
+  thr->th.th_hw_counters = NULL;
+  for (int i = 0; i < KMP_HW_COUNTERS_MAX; ++i) {
+    if (t->fds[i] >= 0)
+      close(t->fds[i]);
+    t->fds[i] = -1;
+  }
+  __kmp_thread_slot_release(&t->slot);
+}
+
+// The counts of the thread in a region at loc; the regions of a thread are
+// few, a short chain per bucket is enough.
+static kmp_hw_region_t *__kmp_hw_counters_region(kmp_hw_thread_t *t,
+                                                 ident_t *loc) {
+  kmp_uint64 key = (kmp_uint64)(kmp_uintptr_t)loc;
+  kmp_uint32 h = (kmp_uint32)((key >> 3) * 0x9E3779B1u) >> 26;
+  kmp_hw_region_t *r;
+  for (r = t->buckets[h]; r; r = r->next) {
+    if (r->loc == loc)
+      return r;
+  }
+  r = (kmp_hw_region_t *)KMP_INTERNAL_MALLOC(sizeof(kmp_hw_region_t));
+  if (r == NULL)
+    KMP_FATAL(MemoryAllocFailed);
+  memset(r, 0, sizeof(kmp_hw_region_t));
+  r->loc = loc;
+  r->next = t->buckets[h];
+  t->buckets[h] = r;
+  return r;
+}
+
+// Add the counts since the last read to the region and phase the thread is
+// in; the regions nested deeper than the stack go to the deepest one kept.
+static void __kmp_hw_counters_charge(kmp_hw_thread_t *t) {
+  kmp_uint64 now[KMP_HW_COUNTERS_MAX];
+  if (!__kmp_hw_counters_read(t, now))
+    return;
+  if (t->depth > 0) {
+    int top = (t->depth < KMP_HW_COUNTERS_DEPTH ? t->depth
+                                                : KMP_HW_COUNTERS_DEPTH) -
+              1;
+    kmp_uint64 *values = t->region[top]->values[t->phase[top]];
+    for (int i = 0; i < __kmp_hw_nevents; ++i) {
+      // The scaled counts of a multiplexed group may step back a little.
+      if (now[i] > t->last[i])
+        values[i] += now[i] - t->last[i];
+    }
+  }
+  memcpy(t->last, now, __kmp_hw_nevents * sizeof(kmp_uint64));
+}
+
+void __kmp_hw_counters_begin(kmp_info_t *thr, ident_t *loc, kmp_int32 phase) {
+  kmp_hw_thread_t *t = thr->th.th_hw_counters;
+  if (t == NULL)
+    t = __kmp_hw_counters_attach(thr);
+  __kmp_hw_counters_charge(t);
+  if (t->depth < KMP_HW_COUNTERS_DEPTH) {
+    kmp_hw_region_t *r = __kmp_hw_counters_region(t, loc);
+    // The join barrier is part of the instance the implicit task started.
+    if (phase == kmp_hw_work)
+      r->instances++;
+    t->region[t->depth] = r;
+    t->phase[t->depth] = phase;
+  }
+  t->depth++;
+}
+
+void __kmp_hw_counters_end(kmp_info_t *thr) {
+  kmp_hw_thread_t *t = thr->th.th_hw_counters;
+  if (t == NULL || t->depth == 0)
+    return;
+  __kmp_hw_counters_charge(t);
+  t->depth--;
+}
+
+kmp_int32 __kmp_hw_counters_phase(kmp_info_t *thr, kmp_int32 phase) {
+  kmp_hw_thread_t *t = thr->th.th_hw_counters;
+  if (t == NULL || t->depth == 0)
+    return phase;
+  __kmp_hw_counters_charge(t);
+  int top = (t->depth < KMP_HW_COUNTERS_DEPTH ? t->depth
+                                              : KMP_HW_COUNTERS_DEPTH) -
+            1;
+  kmp_int32 old = t->phase[top];
+  t->phase[top] = phase;
+  return old;
+}
+
+// One line of the report: the counts of a thread (or of all) in a phase.
+static void __kmp_hw_counters_line(kmp_str_buf_t *buffer, char const *thread,
+                                   char const *phase, kmp_uint64 instances,
+                                   kmp_uint64 const *values) {
+  __kmp_str_buf_print(buffer, "%-7s %-8s %10llu", thread, phase,
+                      (unsigned long long)instances);
+  for (int i = 0; i < __kmp_hw_nevents; ++i)
+    __kmp_str_buf_print(buffer, " %*llu",
+                        KMP_MAX(14, (int)strlen(__kmp_hw_events[i].name)),
+                        (unsigned long long)values[i]);
+  if (__kmp_hw_cycles >= 0 && __kmp_hw_instructions >= 0 &&
+      values[__kmp_hw_cycles] > 0)
+    __kmp_str_buf_print(buffer, " %7.2f",
+                        (double)values[__kmp_hw_instructions] /
+                            values[__kmp_hw_cycles]);
+  else
+    __kmp_str_buf_print(buffer, " %7s", "-");
+  if (__kmp_hw_misses >= 0 && __kmp_hw_instructions >= 0 &&
+      values[__kmp_hw_instructions] > 0)
+    __kmp_str_buf_print(buffer, " %7.2f",
+                        1000.0 * values[__kmp_hw_misses] /
+                            values[__kmp_hw_instructions]);
+  else
+    __kmp_str_buf_print(buffer, " %7s", "-");
+  __kmp_str_buf_print(buffer, "\n");
+}
+
+typedef struct kmp_hw_total {
+  ident_t *loc;
+  kmp_uint64 instances; // of the region, the most any thread ran
+  kmp_uint64 values[kmp_hw_last][KMP_HW_COUNTERS_MAX];
+} kmp_hw_total_t;
+
+static int __kmp_hw_total_compare(const void *a, const void *b) {
+  kmp_uint64 sa = ((const kmp_hw_total_t *)a)->values[kmp_hw_work][0] +
+                  ((const kmp_hw_total_t *)a)->values[kmp_hw_barrier][0];
+  kmp_uint64 sb = ((const kmp_hw_total_t *)b)->values[kmp_hw_work][0] +
+                  ((const kmp_hw_total_t *)b)->values[kmp_hw_barrier][0];
+  return sa < sb ? 1 : sa > sb ? -1 : 0;
+}
+
+static void __kmp_hw_counters_print(void) {
+  static char const *phase_names[kmp_hw_last] = {"work", "barrier"};
+  kmp_str_buf_t buffer;
+  kmp_hw_total_t *totals = NULL;
+  int ntotals = 0, size = 0, nthreads = 0, max_gtid = -1;
+
+  // Sum the regions over the threads.
+  for (kmp_hw_thread_t *t = (kmp_hw_thread_t *)__kmp_hw_threads; t;
+       t = (kmp_hw_thread_t *)t->slot.next) {
+    nthreads++;
+    if (t->slot.gtid > max_gtid)
+      max_gtid = t->slot.gtid;
+    for (int b = 0; b < KMP_HW_COUNTERS_BUCKETS; ++b) {
+      for (kmp_hw_region_t *r = t->buckets[b]; r; r = r->next) {
+        int i;
+        for (i = 0; i < ntotals; ++i) {
+          if (totals[i].loc == r->loc)
+            break;
+        }
+        if (i == ntotals) {
+          if (ntotals == size) {
+            size = size ? 2 * size : 16;
+            totals = (kmp_hw_total_t *)KMP_INTERNAL_REALLOC(
+                totals, size * sizeof(kmp_hw_total_t));
+            if (totals == NULL)
+              KMP_FATAL(MemoryAllocFailed);
+          }
+          memset(&totals[ntotals], 0, sizeof(kmp_hw_total_t));
+          totals[ntotals++].loc = r->loc;
+        }
+        if (r->instances > totals[i].instances)
+          totals[i].instances = r->instances;
+        for (int p = 0; p < kmp_hw_last; ++p)
+          for (int e = 0; e < __kmp_hw_nevents; ++e)
+            totals[i].values[p][e] += r->values[p][e];
+      }
+    }
+  }
+  if (ntotals > 0)
+    qsort(totals, ntotals, sizeof(kmp_hw_total_t), __kmp_hw_total_compare);
+
+  __kmp_str_buf_init(&buffer);
+  __kmp_str_buf_print(&buffer,
+                      "# OpenMP hardware counters of process %d: %d regions "
+                      "of up to %d threads\n",
+                      (int)getpid(), ntotals, nthreads);
+  __kmp_str_buf_print(&buffer, "# Counted:");
+  for (int e = 0; e < __kmp_hw_nevents; ++e)
+    __kmp_str_buf_print(&buffer, " %s", __kmp_hw_events[e].name);
+  __kmp_str_buf_print(&buffer, "%s\n", __kmp_hw_nevents ? "" : " nothing");
+  if (__kmp_hw_refused.used > 0)
+    __kmp_str_buf_print(&buffer, "# Not counted:%s\n", __kmp_hw_refused.str);
+
+  for (int i = 0; i < ntotals && __kmp_hw_nevents > 0; ++i) {
+    kmp_hw_total_t *total = &totals[i];
+    __kmp_str_buf_print(&buffer, "\n# Region %d: ", i + 1);
+    __kmp_str_buf_print_loc(&buffer, total->loc ? total->loc->psource : NULL);
+    __kmp_str_buf_print(&buffer, "\n%-7s %-8s %10s", "Thread", "Phase",
+                        "Instances");
+    for (int e = 0; e < __kmp_hw_nevents; ++e)
+      __kmp_str_buf_print(&buffer, " %*s",
+                          KMP_MAX(14, (int)strlen(__kmp_hw_events[e].name)),
+                          __kmp_hw_events[e].name);
+    __kmp_str_buf_print(&buffer, " %7s %7s\n", "IPC", "MPKI");
+    for (int p = 0; p < kmp_hw_last; ++p)
+      __kmp_hw_counters_line(&buffer, "all", phase_names[p], total->instances,
+                             total->values[p]);
+    // The threads by gtid.
+    for (int gtid = 0; gtid <= max_gtid; ++gtid) {
+      for (kmp_hw_thread_t *t = (kmp_hw_thread_t *)__kmp_hw_threads; t;
+           t = (kmp_hw_thread_t *)t->slot.next) {
+        if (t->slot.gtid != gtid)
+          continue;
+        for (int b = 0; b < KMP_HW_COUNTERS_BUCKETS; ++b) {
+          for (kmp_hw_region_t *r = t->buckets[b]; r; r = r->next) {
+            if (r->loc != total->loc)
+              continue;
+            char name[16];
+            KMP_SNPRINTF(name, sizeof(name), "%d", gtid);
+            for (int p = 0; p < kmp_hw_last; ++p)
+              __kmp_hw_counters_line(&buffer, name, phase_names[p],
+                                     r->instances, r->values[p]);
+          }
+        }
+      }
+    }
+  }
+
+  __kmp_str_buf_write(&buffer, __kmp_hw_counters_file);
+  __kmp_str_buf_free(&buffer);
+  KMP_INTERNAL_FREE(totals);
+}
+
+void __kmp_hw_counters_fini(void) {
+  if (!__kmp_hw_counters)
+    return;
+  if (__kmp_hw_pid != getpid())
+    return;
+  __kmp_hw_counters_print();
+  __kmp_hw_counters = FALSE;
+}
@@ -0,0 +1,101 @@
+#ifndef KMP_HW_COUNTERS_H
+#define KMP_HW_COUNTERS_H
+
+/** @file kmp_hw_counters.h
+ * Hardware performance counters per parallel region.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp.h"
+
+/* With KMP_HW_COUNTERS=true every OpenMP thread opens a group of counters
+   with perf_event_open(2) on its first parallel region: cycles, instructions
+   and cache misses (the last level cache misses on most processors), then the
+   events listed in KMP_HW_COUNTERS_EVENTS. The thread reads the group when it
+   starts and ends its implicit task and when it enters and leaves a barrier,
+   and adds the difference to the ident_t of the region it is in, apart for
+   the work and the barriers. At exit the counts, the instructions per cycle
+   and the misses per thousand instructions of each region, in total and per
+   thread, are written to KMP_HW_COUNTERS_FILE (stderr by default). Only user
+   mode is counted. Linux only; the events the kernel refuses are left out
+   and the report says why. */
+
+enum kmp_hw_phase_t {
+  kmp_hw_work = 0, // the implicit task, explicit tasks it runs included
+  kmp_hw_barrier, // barriers in the region and the join barrier
+  kmp_hw_last
+};
+
+#define KMP_HW_COUNTERS_MAX 8 // events in the group
+#define KMP_HW_COUNTERS_DEPTH 8 // nested regions counted apart
+
+// The counts of one thread in one region, for all its instances.
+typedef struct kmp_hw_region {
+  ident_t *loc;
+  kmp_uint64 instances;
+  kmp_uint64 values[kmp_hw_last][KMP_HW_COUNTERS_MAX];
+  struct kmp_hw_region *next; // in the hash chain
+} kmp_hw_region_t;
+
+#define KMP_HW_COUNTERS_BUCKETS 64
+
+// The counters of a thread, in the list of all threads for the report.
+typedef struct kmp_hw_thread {
+  kmp_thread_slot_t slot;
+  int fds[KMP_HW_COUNTERS_MAX]; // fds[0] leads the group, -1 if not open
+  kmp_uint64 last[KMP_HW_COUNTERS_MAX]; // the counts at the last read
+  int depth; // of the regions being counted
+  kmp_int32 phase[KMP_HW_COUNTERS_DEPTH];
+  kmp_hw_region_t *region[KMP_HW_COUNTERS_DEPTH];
+  kmp_hw_region_t *buckets[KMP_HW_COUNTERS_BUCKETS];
+} kmp_hw_thread_t;
+
+extern int __kmp_hw_counters;
+extern char const *__kmp_hw_counters_events;
+extern char const *__kmp_hw_counters_file;
+
+extern void __kmp_hw_counters_init(void);
+extern void __kmp_hw_counters_fini(void);
+extern void __kmp_hw_counters_detach(kmp_info_t *thr);
+extern void __kmp_hw_counters_begin(kmp_info_t *thr, ident_t *loc,
+                                    kmp_int32 phase);
+extern void __kmp_hw_counters_end(kmp_info_t *thr);
+extern kmp_int32 __kmp_hw_counters_phase(kmp_info_t *thr, kmp_int32 phase);
+
+// Count the thread for the region at loc until the matching
+// KMP_HW_COUNTERS_END; a nested region interrupts the counts of the outer one.
+#define KMP_HW_COUNTERS_BEGIN(thr, loc, phase)                                 \
+  do {                                                                         \
+    if (__kmp_hw_counters)                                                     \
+      __kmp_hw_counters_begin((thr), (ident_t *)(loc), (phase));               \
+  } while (0)
+
+#define KMP_HW_COUNTERS_END(thr)                                               \
+  do {                                                                         \
+    if (__kmp_hw_counters)                                                     \
+      __kmp_hw_counters_end((thr));                                            \
+  } while (0)
+
+// Switch the region the thread is in to another phase until the matching
+// KMP_HW_COUNTERS_RESTORE; outside of a region nothing is counted.
+#define KMP_HW_COUNTERS_PHASE(thr, phase, saved)                               \
+  kmp_int32 saved =                                                            \
+      __kmp_hw_counters ? __kmp_hw_counters_phase((thr), (phase)) : kmp_hw_work
+
+#define KMP_HW_COUNTERS_RESTORE(thr, saved)                                    \
+  do {                                                                         \
+    if (__kmp_hw_counters)                                                     \
+      __kmp_hw_counters_phase((thr), (saved));                                 \
+  } while (0)
+
+#endif // KMP_HW_COUNTERS_H
@@ -2909,6 +2909,250 @@ static int __kmp_test_rtm_lock_with_checks(kmp_queuing_lock_t *lck,
 
 #endif // KMP_USE_TSX
 
+// Autotuned lock functions.
+// The lock starts at the test and set level. The owner recomputes the level at
+// the end of every window of __kmp_autotune_lock_params.window acquisitions
+// from the share of contended acquisitions, the number of waiters and the hold
+// time observed in that window.
+
+// Default parameters: window, promote_pct, demote_pct, drdpa_waiters.
+kmp_autotune_lock_params_t __kmp_autotune_lock_params = {256, 25, 5, 8};
+
+// Number of consecutive calm windows before the lock steps down one level.
+#define KMP_AUTOTUNE_CALM_WINDOWS 4
+
+#define KMP_AUTOTUNE_QLK(l) ((kmp_queuing_lock_t *)&(l)->lk.qlk)
+
+static kmp_int32 __kmp_get_autotune_lock_owner(kmp_autotune_lock_t *lck) {
+  return TCR_4(lck->lk.poll) - 1;
+}
+
+static inline int __kmp_try_autotune_lock(kmp_autotune_lock_t *lck,
+                                          kmp_int32 gtid) {
+  return TCR_4(lck->lk.poll) == 0 &&
+         KMP_COMPARE_AND_STORE_ACQ32(&(lck->lk.poll), 0, gtid + 1);
+}
+
+// Spin on the poll word until the lock is acquired. Backoff is only useful when
+// all waiters spin here; behind a front lock there is a single spinning thread.
+static void __kmp_spin_autotune_lock(kmp_autotune_lock_t *lck, kmp_int32 gtid,
+                                     int use_backoff) {
+  kmp_uint32 spins;
+  kmp_backoff_t backoff = __kmp_spin_backoff_params;
+  KMP_INIT_YIELD(spins);
+  while (!__kmp_try_autotune_lock(lck, gtid)) {
+    if (use_backoff)
+      __kmp_spin_backoff(&backoff);
+    else
+      KMP_CPU_PAUSE();
+    if (TCR_4(__kmp_nth) >
+        (__kmp_avail_proc ? __kmp_avail_proc : __kmp_xproc)) {
+      KMP_YIELD(TRUE);
+    } else {
+      KMP_YIELD_SPIN(spins);
+    }
+  }
+}
+
+// Recompute the level at the end of a window. Called by the lock owner.
+static void __kmp_tune_autotune_lock(kmp_autotune_lock_t *lck) {
+  kmp_base_autotune_lock_t *lk = &lck->lk;
+  kmp_int32 level = lk->level;
+  kmp_int32 new_level = level;
+  kmp_uint32 pct = lk->contended * 100 / lk->acquires;
+  kmp_uint32 promote_pct = __kmp_autotune_lock_params.promote_pct;
+
+  // Waiters spinning on the poll word hurt more when the lock is held longer
+  // than a full backoff period, promote earlier in that case.
+  if (lk->hold_time / lk->acquires >
+      (kmp_uint64)__kmp_spin_backoff_params.max_backoff *
+          __kmp_spin_backoff_params.min_tick)
+    promote_pct /= 2;
+
+  if (pct >= promote_pct) {
+    lk->calm_windows = 0;
+    new_level =
+        (lk->max_waiters >= __kmp_autotune_lock_params.drdpa_waiters)
+            ? autotune_drdpa
+            : autotune_queuing;
+  } else if (pct < __kmp_autotune_lock_params.demote_pct) {
+    if (level != autotune_tas &&
+        ++lk->calm_windows >= KMP_AUTOTUNE_CALM_WINDOWS) {
+      new_level = level - 1;
+      lk->calm_windows = 0;
+    }
+  } else {
+    lk->calm_windows = 0;
+  }
+
+  if (new_level != level) {
+    if (new_level > level)
+      lk->promotions++;
+    else
+      lk->demotions++;
+    KA_TRACE(20, ("__kmp_tune_autotune_lock: lock %p level %d -> %d "
+                  "(contended %u%%, max waiters %u)\n",
+                  lck, level, new_level, pct, lk->max_waiters));
+    TCW_4(lk->level, new_level);
+  }
+
+  lk->total_acquires += lk->acquires;
+  lk->total_contended += lk->contended;
+  lk->acquires = 0;
+  lk->contended = 0;
+  lk->max_waiters = 0;
+  lk->hold_time = 0;
+}
+
+// Update the contention profile right after the lock has been acquired.
+static inline void __kmp_autotune_lock_acquired(kmp_autotune_lock_t *lck,
+                                                int contended) {
+  kmp_base_autotune_lock_t *lk = &lck->lk;
+  kmp_uint32 waiters = TCR_4(lk->waiters);
+  if (waiters > lk->max_waiters)
+    lk->max_waiters = waiters;
+  lk->contended += contended;
+  if (++lk->acquires >= __kmp_autotune_lock_params.window)
+    __kmp_tune_autotune_lock(lck);
+  lk->hold_start = __kmp_tsc();
+}
+
+static int __kmp_acquire_autotune_lock(kmp_autotune_lock_t *lck,
+                                       kmp_int32 gtid) {
+  int contended = 0;
+  KMP_MB();
+  if (!__kmp_try_autotune_lock(lck, gtid)) {
+    contended = 1;
+    KMP_FSYNC_PREPARE(lck);
+    KMP_TEST_THEN_INC32(&(lck->lk.waiters));
+    switch (TCR_4(lck->lk.level)) {
+    case autotune_queuing:
+      __kmp_acquire_queuing_lock(KMP_AUTOTUNE_QLK(lck), gtid);
+      __kmp_spin_autotune_lock(lck, gtid, FALSE);
+      __kmp_release_queuing_lock(KMP_AUTOTUNE_QLK(lck), gtid);
+      break;
+    case autotune_drdpa:
+      __kmp_acquire_drdpa_lock(&(lck->lk.drdpa), gtid);
+      __kmp_spin_autotune_lock(lck, gtid, FALSE);
+      __kmp_release_drdpa_lock(&(lck->lk.drdpa), gtid);
+      break;
+    default:
+      __kmp_spin_autotune_lock(lck, gtid, TRUE);
+    }
+    KMP_TEST_THEN_DEC32(&(lck->lk.waiters));
+  }
+  KMP_FSYNC_ACQUIRED(lck);
+  __kmp_autotune_lock_acquired(lck, contended);
+  return KMP_LOCK_ACQUIRED_FIRST;
+}
+
+static int __kmp_acquire_autotune_lock_with_checks(kmp_autotune_lock_t *lck,
+                                                   kmp_int32 gtid) {
+  char const *const func = "omp_set_lock";
+  if (lck->lk.qlk.initialized != KMP_AUTOTUNE_QLK(lck)) {
+    KMP_FATAL(LockIsUninitialized, func);
+  }
+  if (__kmp_get_autotune_lock_owner(lck) == gtid) {
+    KMP_FATAL(LockIsAlreadyOwned, func);
+  }
+  return __kmp_acquire_autotune_lock(lck, gtid);
+}
+
+static int __kmp_test_autotune_lock(kmp_autotune_lock_t *lck, kmp_int32 gtid) {
+  if (__kmp_try_autotune_lock(lck, gtid)) {
+    KMP_FSYNC_ACQUIRED(lck);
+    __kmp_autotune_lock_acquired(lck, 0);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+static int __kmp_test_autotune_lock_with_checks(kmp_autotune_lock_t *lck,
+                                                kmp_int32 gtid) {
+  char const *const func = "omp_test_lock";
+  if (lck->lk.qlk.initialized != KMP_AUTOTUNE_QLK(lck)) {
+    KMP_FATAL(LockIsUninitialized, func);
+  }
+  return __kmp_test_autotune_lock(lck, gtid);
+}
+
+static int __kmp_release_autotune_lock(kmp_autotune_lock_t *lck,
+                                       kmp_int32 gtid) {
+  lck->lk.hold_time += __kmp_tsc() - lck->lk.hold_start;
+  KMP_MB(); /* Flush all pending memory write invalidates.  */
+
+  KMP_FSYNC_RELEASING(lck);
+  KMP_ST_REL32(&(lck->lk.poll), 0);
+  KMP_MB(); /* Flush all pending memory write invalidates.  */
+
+  KMP_YIELD(TCR_4(__kmp_nth) >
+            (__kmp_avail_proc ? __kmp_avail_proc : __kmp_xproc));
+  return KMP_LOCK_RELEASED;
+}
+
+static int __kmp_release_autotune_lock_with_checks(kmp_autotune_lock_t *lck,
+                                                   kmp_int32 gtid) {
+  char const *const func = "omp_unset_lock";
+  KMP_MB(); /* in case another processor initialized lock */
+  if (lck->lk.qlk.initialized != KMP_AUTOTUNE_QLK(lck)) {
+    KMP_FATAL(LockIsUninitialized, func);
+  }
+  if (__kmp_get_autotune_lock_owner(lck) == -1) {
+    KMP_FATAL(LockUnsettingFree, func);
+  }
+  if (__kmp_get_autotune_lock_owner(lck) != gtid) {
+    KMP_FATAL(LockUnsettingSetByAnother, func);
+  }
+  return __kmp_release_autotune_lock(lck, gtid);
+}
+
+static void __kmp_init_autotune_lock(kmp_autotune_lock_t *lck) {
+  kmp_base_autotune_lock_t *lk = &lck->lk;
+  __kmp_init_queuing_lock(KMP_AUTOTUNE_QLK(lck));
+  __kmp_init_drdpa_lock(&(lk->drdpa));
+  lk->level = autotune_tas;
+  lk->waiters = 0;
+  lk->acquires = 0;
+  lk->contended = 0;
+  lk->max_waiters = 0;
+  lk->calm_windows = 0;
+  lk->hold_start = 0;
+  lk->hold_time = 0;
+  lk->total_acquires = 0;
+  lk->total_contended = 0;
+  lk->promotions = 0;
+  lk->demotions = 0;
+  KMP_ST_REL32(&(lk->poll), 0);
+  KA_TRACE(1000, ("__kmp_init_autotune_lock: lock %p initialized\n", lck));
+}
+
+static void __kmp_init_autotune_lock_with_checks(kmp_autotune_lock_t *lck) {
+  __kmp_init_autotune_lock(lck);
+}
+
+static void __kmp_destroy_autotune_lock(kmp_autotune_lock_t *lck) {
+  kmp_base_autotune_lock_t *lk = &lck->lk;
+  KA_TRACE(1000, ("__kmp_destroy_autotune_lock: lock %p level %d acquires "
+                  "%llu contended %llu promotions %u demotions %u\n",
+                  lck, lk->level, lk->total_acquires + lk->acquires,
+                  lk->total_contended + lk->contended, lk->promotions,
+                  lk->demotions));
+  __kmp_destroy_drdpa_lock(&(lk->drdpa));
+  __kmp_destroy_queuing_lock(KMP_AUTOTUNE_QLK(lck));
+  lk->poll = 0;
+}
+
+static void __kmp_destroy_autotune_lock_with_checks(kmp_autotune_lock_t *lck) {
+  char const *const func = "omp_destroy_lock";
+  if (lck->lk.qlk.initialized != KMP_AUTOTUNE_QLK(lck)) {
+    KMP_FATAL(LockIsUninitialized, func);
+  }
+  if (__kmp_get_autotune_lock_owner(lck) != -1) {
+    KMP_FATAL(LockStillOwned, func);
+  }
+  __kmp_destroy_autotune_lock(lck);
+}
+
 // Entry functions for indirect locks (first element of direct lock jump tables)
 static void __kmp_init_indirect_lock(kmp_dyna_lock_t *l,
                                      kmp_dyna_lockseq_t tag);
@@ -3227,6 +3471,8 @@ kmp_int32 __kmp_get_user_lock_owner(kmp_user_lock_p lck, kmp_uint32 seq) {
   case lockseq_drdpa:
   case lockseq_nested_drdpa:
     return __kmp_get_drdpa_lock_owner((kmp_drdpa_lock_t *)lck);
+  case lockseq_autotune:
+    return __kmp_get_autotune_lock_owner((kmp_autotune_lock_t *)lck);
   default:
     return 0;
   }
@@ -3274,6 +3520,7 @@ void __kmp_init_dynamic_user_locks() {
 #if KMP_USE_TSX
   __kmp_indirect_lock_size[locktag_rtm] = sizeof(kmp_queuing_lock_t);
 #endif
+  __kmp_indirect_lock_size[locktag_autotune] = sizeof(kmp_autotune_lock_t);
   __kmp_indirect_lock_size[locktag_nested_tas] = sizeof(kmp_tas_lock_t);
 #if KMP_USE_FUTEX
   __kmp_indirect_lock_size[locktag_nested_futex] = sizeof(kmp_futex_lock_t);
@@ -3295,12 +3542,14 @@ void __kmp_init_dynamic_user_locks() {
   {                                                                            \
     fill_jumps(table, expand, _);                                              \
     table[locktag_adaptive] = expand(queuing);                                 \
+    table[locktag_autotune] = expand(queuing);                                 \
     fill_jumps(table, expand, _nested_);                                       \
   }
 #else
 #define fill_table(table, expand)                                              \
   {                                                                            \
     fill_jumps(table, expand, _);                                              \
+    table[locktag_autotune] = expand(queuing);                                 \
     fill_jumps(table, expand, _nested_);                                       \
   }
 #endif // KMP_USE_ADAPTIVE_LOCKS
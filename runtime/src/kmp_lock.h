@@ -505,6 +505,75 @@ extern int __kmp_release_nested_drdpa_lock(kmp_drdpa_lock_t *lck,
 extern void __kmp_init_nested_drdpa_lock(kmp_drdpa_lock_t *lck);
 extern void __kmp_destroy_nested_drdpa_lock(kmp_drdpa_lock_t *lck);
 
+#if KMP_USE_DYNAMIC_LOCK
+
+// ----------------------------------------------------------------------------
+// Autotuned locks.
+//
+// Mutual exclusion is always provided by a test and set word (poll). Under
+// contention the waiting threads are first lined up on a "front" lock -- a
+// queuing or a DRDPA lock -- so that only the thread at the head of the line
+// spins on the poll word. The lock owner keeps a contention profile over a
+// window of acquisitions and switches the front lock (the level) at the end of
+// each window. Since release only clears the poll word, the level can change
+// at any time without handing the lock over between implementations.
+
+enum kmp_autotune_level {
+  autotune_tas = 0, // waiters spin on the poll word with backoff
+  autotune_queuing, // waiters line up on the queuing lock first
+  autotune_drdpa // waiters line up on the DRDPA lock first
+};
+
+// Tunable parameters, see KMP_AUTOTUNE_LOCK_PROPS.
+struct kmp_autotune_lock_params {
+  kmp_uint32 window; // acquisitions between two level adjustments
+  kmp_uint32 promote_pct; // promote at this percentage of contended acquires
+  kmp_uint32 demote_pct; // demote below this percentage of contended acquires
+  kmp_uint32 drdpa_waiters; // prefer DRDPA with at least this many waiters
+};
+
+typedef struct kmp_autotune_lock_params kmp_autotune_lock_params_t;
+
+extern kmp_autotune_lock_params_t __kmp_autotune_lock_params;
+
+struct kmp_base_autotune_lock {
+  // The queuing lock must be first: it holds the initialized, location and
+  // flags fields shared with the queuing lock accessors.
+  kmp_base_queuing_lock qlk;
+  kmp_drdpa_lock_t drdpa;
+
+  KMP_ALIGN_CACHE
+  volatile kmp_int32 poll; // (gtid+1) of owning thread, 0 if unlocked
+  volatile kmp_int32 level; // current kmp_autotune_level
+  volatile kmp_int32 waiters; // threads currently waiting for the lock
+
+  // The remaining fields are only written by the lock owner.
+  KMP_ALIGN_CACHE
+  kmp_uint32 acquires; // acquisitions in the current window
+  kmp_uint32 contended; // contended acquisitions in the current window
+  kmp_uint32 max_waiters; // max waiters seen in the current window
+  kmp_uint32 calm_windows; // consecutive windows below demote_pct
+  kmp_uint64 hold_start; // time stamp of the last acquisition
+  kmp_uint64 hold_time; // total hold time in the current window
+  kmp_uint64 total_acquires; // acquisitions since lock initialization
+  kmp_uint64 total_contended; // contended acquisitions since initialization
+  kmp_uint32 promotions; // number of level promotions
+  kmp_uint32 demotions; // number of level demotions
+};
+
+typedef struct kmp_base_autotune_lock kmp_base_autotune_lock_t;
+
+union KMP_ALIGN_CACHE kmp_autotune_lock {
+  kmp_base_autotune_lock_t lk;
+  kmp_lock_pool_t pool;
+  double lk_align; // use worst case alignment
+  char lk_pad[KMP_PAD(kmp_base_autotune_lock_t, CACHE_LINE)];
+};
+
+typedef union kmp_autotune_lock kmp_autotune_lock_t;
+
+#endif // KMP_USE_DYNAMIC_LOCK
+
 // ============================================================================
 // Lock purposes.
 // ============================================================================
@@ -592,8 +661,11 @@ enum kmp_lock_kind {
   lk_queuing,
   lk_drdpa,
 #if KMP_USE_ADAPTIVE_LOCKS
-  lk_adaptive
+  lk_adaptive,
 #endif // KMP_USE_ADAPTIVE_LOCKS
+#if KMP_USE_DYNAMIC_LOCK
+  lk_autotune
+#endif
 };
 
 typedef enum kmp_lock_kind kmp_lock_kind_t;
@@ -1065,28 +1137,29 @@ extern void __kmp_cleanup_user_locks();
 #define KMP_FOREACH_D_LOCK(m, a) m(tas, a) m(futex, a) m(hle, a)
 #define KMP_FOREACH_I_LOCK(m, a)                                               \
   m(ticket, a) m(queuing, a) m(adaptive, a) m(drdpa, a) m(rtm, a)              \
-      m(nested_tas, a) m(nested_futex, a) m(nested_ticket, a)                  \
+      m(autotune, a) m(nested_tas, a) m(nested_futex, a) m(nested_ticket, a)   \
           m(nested_queuing, a) m(nested_drdpa, a)
 #else
 #define KMP_FOREACH_D_LOCK(m, a) m(tas, a) m(hle, a)
 #define KMP_FOREACH_I_LOCK(m, a)                                               \
   m(ticket, a) m(queuing, a) m(adaptive, a) m(drdpa, a) m(rtm, a)              \
-      m(nested_tas, a) m(nested_ticket, a) m(nested_queuing, a)                \
-          m(nested_drdpa, a)
+      m(autotune, a) m(nested_tas, a) m(nested_ticket, a)                      \
+          m(nested_queuing, a) m(nested_drdpa, a)
 #endif // KMP_USE_FUTEX
 #define KMP_LAST_D_LOCK lockseq_hle
 #else
 #if KMP_USE_FUTEX
 #define KMP_FOREACH_D_LOCK(m, a) m(tas, a) m(futex, a)
 #define KMP_FOREACH_I_LOCK(m, a)                                               \
-  m(ticket, a) m(queuing, a) m(drdpa, a) m(nested_tas, a) m(nested_futex, a)   \
-      m(nested_ticket, a) m(nested_queuing, a) m(nested_drdpa, a)
+  m(ticket, a) m(queuing, a) m(drdpa, a) m(autotune, a) m(nested_tas, a)       \
+      m(nested_futex, a) m(nested_ticket, a) m(nested_queuing, a)              \
+          m(nested_drdpa, a)
 #define KMP_LAST_D_LOCK lockseq_futex
 #else
 #define KMP_FOREACH_D_LOCK(m, a) m(tas, a)
 #define KMP_FOREACH_I_LOCK(m, a)                                               \
-  m(ticket, a) m(queuing, a) m(drdpa, a) m(nested_tas, a) m(nested_ticket, a)  \
-      m(nested_queuing, a) m(nested_drdpa, a)
+  m(ticket, a) m(queuing, a) m(drdpa, a) m(autotune, a) m(nested_tas, a)       \
+      m(nested_ticket, a) m(nested_queuing, a) m(nested_drdpa, a)
 #define KMP_LAST_D_LOCK lockseq_tas
 #endif // KMP_USE_FUTEX
 #endif // KMP_USE_TSX
@@ -16,14 +16,18 @@
 #include "kmp.h"
 #include "kmp_affinity.h"
 #include "kmp_atomic.h"
+#include "kmp_critical_path.h"
 #include "kmp_environment.h"
 #include "kmp_error.h"
+#include "kmp_hw_counters.h"
 #include "kmp_i18n.h"
 #include "kmp_io.h"
 #include "kmp_itt.h"
 #include "kmp_settings.h"
 #include "kmp_stats.h"
 #include "kmp_str.h"
+#include "kmp_trace.h"
+#include "kmp_wait_profile.h"
 #include "kmp_wait_release.h"
 #include "kmp_wrapper_getpid.h"
 
@@ -91,9 +95,6 @@ static int __kmp_load_balance_nproc(kmp_root_t *root, int set_nproc);
 #endif
 
 static int __kmp_expand_threads(int nWish, int nNeed);
-#if KMP_OS_WINDOWS
-static int __kmp_unregister_root_other_thread(int gtid);
-#endif
 static void __kmp_unregister_library(void); // called by __kmp_internal_end()
 static void __kmp_reap_thread(kmp_info_t *thread, int is_root);
 static kmp_info_t *__kmp_thread_pool_insert_pt = NULL;
@@ -871,6 +872,27 @@ static int __kmp_reserve_threads(kmp_root_t *root, kmp_team_t *parent_team,
     KMP_ASSERT(0);
   }
 
+#if KMP_OS_LINUX
+  // If dyn-var is set, do not ask for more threads than other processes have
+  // left free while the machine is oversubscribed.
+  if (get__dynamic_2(parent_team, master_tid) &&
+      TCR_4(__kmp_sys_oversubscribed)) {
+    int free_nthreads = TCR_4(__kmp_sys_free_procs);
+    if (free_nthreads <= 1) {
+      KC_TRACE(10, ("__kmp_reserve_threads: T#%d system load reduced "
+                    "reservation to 1 thread\n",
+                    master_tid));
+      return 1;
+    }
+    if (new_nthreads > free_nthreads) {
+      KC_TRACE(10, ("__kmp_reserve_threads: T#%d system load reduced "
+                    "reservation to %d threads\n",
+                    master_tid, free_nthreads));
+      new_nthreads = free_nthreads;
+    }
+  }
+#endif
+
   // Respect KMP_ALL_THREADS/KMP_DEVICE_THREAD_LIMIT.
   if (__kmp_nth + new_nthreads -
           (root->r.r_active ? 1 : root->r.r_hot_team->t.t_nproc) >
@@ -981,6 +1003,49 @@ static int __kmp_reserve_threads(kmp_root_t *root, kmp_team_t *parent_team,
   return new_nthreads;
 }
 
+/* Create the OS threads of the workers that __kmp_allocate_thread() put into
+   the slots [first, last) of the team. The master only creates the first of
+   them and every new thread creates up to two more as it starts, so creating
+   n threads takes log(n) steps and overlaps with the work of the master. */
+static void __kmp_spawn_team_workers(kmp_team_t *team, int first, int last) {
+  kmp_info_t **pending;
+  int i, n = 0;
+
+  if (first >= last)
+    return;
+  pending = (kmp_info_t **)KMP_ALLOCA(sizeof(kmp_info_t *) * (last - first));
+  for (i = first; i < last; ++i) {
+    kmp_info_t *thr = team->t.t_threads[i];
+    if (thr->th.th_spawn_pending) {
+      thr->th.th_spawn_pending = FALSE;
+      pending[n++] = thr;
+    }
+  }
+  if (n == 0)
+    return;
+  for (i = 0; i < n; ++i) {
+    pending[i]->th.th_spawn[0] = 2 * i + 1 < n ? pending[2 * i + 1] : NULL;
+    pending[i]->th.th_spawn[1] = 2 * i + 2 < n ? pending[2 * i + 2] : NULL;
+  }
+  KA_TRACE(20, ("__kmp_spawn_team_workers: T#%d creates %d threads of team %d\n",
+                __kmp_get_gtid(), n, team->t.t_id));
+  __kmp_create_worker(pending[0]->th.th_info.ds.ds_gtid, pending[0],
+                      __kmp_stksize);
+}
+
+/* Called by a new worker thread before anything else: create the threads
+   __kmp_spawn_team_workers() left to it. */
+void __kmp_spawn_workers(kmp_info_t *th) {
+  int i;
+  for (i = 0; i < 2; ++i) {
+    kmp_info_t *child = th->th.th_spawn[i];
+    if (child != NULL) {
+      th->th.th_spawn[i] = NULL;
+      __kmp_create_worker(child->th.th_info.ds.ds_gtid, child, __kmp_stksize);
+    }
+  }
+}
+
 /* Allocate threads from the thread pool and assign them to the new team. We are
    assured that there are enough threads available, because we checked on that
    earlier within critical section forkjoin */
@@ -1074,12 +1139,20 @@ static void __kmp_fork_team_threads(kmp_root_t *root, kmp_team_t *team,
         }; // for b
       }
     }
+    __kmp_spawn_team_workers(team, 1, team->t.t_nproc);
 
 #if OMP_40_ENABLED && KMP_AFFINITY_SUPPORTED
     __kmp_partition_places(team);
 #endif
   }
 
+#if OMP_50_ENABLED
+  // def-allocator-var is inherited from the master, by the hot team as well;
+  // the workers see it once the fork barrier releases them.
+  for (i = 1; i < team->t.t_nproc; i++)
+    team->t.t_threads[i]->th.th_def_allocator = master_th->th.th_def_allocator;
+#endif
+
   KMP_MB();
 }
 
@@ -1447,7 +1520,7 @@ int __kmp_fork_call(ident_t *loc, int gtid,
   kmp_hot_team_ptr_t **p_hot_teams;
 #endif
   { // KMP_TIME_BLOCK
-    KMP_TIME_DEVELOPER_PARTITIONED_BLOCK(KMP_fork_call);
+    KMP_TIME_PARTITIONED_BLOCK(OMP_fork_call);
     KMP_COUNT_VALUE(OMP_PARALLEL_args, argc);
 
     KA_TRACE(20, ("__kmp_fork_call: enter T#%d\n", gtid));
@@ -1696,6 +1769,13 @@ int __kmp_fork_call(ident_t *loc, int gtid,
               : get__nproc_2(
                     parent_team,
                     master_tid); // TODO: get nproc directly from current task
+#if OMP_40_ENABLED && KMP_AFFINITY_SUPPORTED
+      // Do not oversubscribe a place partition narrowed by
+      // kmp_set_place_partition() unless the team size was asked for.
+      if (!master_set_numthreads && root->r.r_partition_procs > 0 &&
+          nthreads > root->r.r_partition_procs)
+        nthreads = root->r.r_partition_procs;
+#endif
 
       // Check if we need to take forkjoin lock? (no need for serialized
       // parallel out of teams construct). This code moved here from
@@ -2201,6 +2281,7 @@ int __kmp_fork_call(ident_t *loc, int gtid,
 
 #if OMPT_SUPPORT
     master_th->th.ompt_thread_info.state = omp_state_work_parallel;
+    master_th->th.ompt_thread_info.ident = loc;
 #endif
 
     __kmp_release_bootstrap_lock(&__kmp_forkjoin_lock);
@@ -2248,6 +2329,10 @@ int __kmp_fork_call(ident_t *loc, int gtid,
     }
 #endif /* USE_ITT_BUILD */
 
+    KMP_TRACE_EVENT(master_th, kmp_trace_fork, team->t.t_nproc, loc,
+                    microtask);
+    KMP_PERF_INC(master_th, forks);
+
 #if OMP_40_ENABLED
     // AC: skip __kmp_internal_fork at teams construct, let only master
     // threads execute
@@ -2268,7 +2353,7 @@ int __kmp_fork_call(ident_t *loc, int gtid,
     /* Invoke microtask for MASTER thread */
     KA_TRACE(20, ("__kmp_fork_call: T#%d(%d:0) invoke microtask = %p\n", gtid,
                   team->t.t_id, team->t.t_pkfn));
-  } // END of timer KMP_fork_call block
+  } // END of timer OMP_fork_call block
 
   {
     KMP_TIME_PARTITIONED_BLOCK(OMP_parallel);
@@ -2299,6 +2384,7 @@ static inline void __kmp_join_restore_state(kmp_info_t *thread,
   thread->th.ompt_thread_info.state =
       ((team->t.t_serialized) ? omp_state_work_serial
                               : omp_state_work_parallel);
+  thread->th.ompt_thread_info.ident = team->t.t_ident;
 }
 
 static inline void __kmp_join_ompt(int gtid, kmp_info_t *thread,
@@ -2409,6 +2495,14 @@ void __kmp_join_call(ident_t *loc, int gtid
 #endif /* OMP_40_ENABLED */
 
   KMP_MB();
+  KMP_TRACE_EVENT(master_th, kmp_trace_join, team->t.t_nproc, loc, 0);
+  KMP_PERF_INC(master_th, joins);
+  if (__kmp_critical_path) {
+    // The tasks of the implicit tasks are complete after the join barrier.
+    for (int i = 0; i < team->t.t_nproc; ++i)
+      KMP_CRITICAL_PATH_FLUSH(&team->t.t_implicit_task_taskdata[i],
+                              kmp_cp_parallel, team->t.t_ident);
+  }
 
 #if OMPT_SUPPORT
   ompt_data_t *parallel_data = &(team->t.ompt_team_info.parallel_data);
@@ -3184,6 +3278,7 @@ static void __kmp_initialize_root(kmp_root_t *root) {
   root->r.r_blocktime = __kmp_dflt_blocktime;
   root->r.r_nested = __kmp_dflt_nested;
   root->r.r_cg_nthreads = 1;
+  root->r.r_partition_procs = 0;
 
   /* setup the root team for this task */
   /* allocate the root team structure */
@@ -3769,7 +3864,11 @@ int __kmp_register_root(int initial_thread) {
   if (root->r.r_uber_thread) {
     root_thread = root->r.r_uber_thread;
   } else {
-    root_thread = (kmp_info_t *)__kmp_allocate(sizeof(kmp_info_t));
+    root_thread =
+        (kmp_info_t *)__kmp_allocate_thread_owned(NULL, sizeof(kmp_info_t));
+#if KMP_AFFINITY_SUPPORTED && KMP_OS_LINUX
+    root_thread->th.th_numa_node = -1;
+#endif
     if (__kmp_storage_map) {
       __kmp_print_thread_storage_map(root_thread, gtid);
     }
@@ -3937,6 +4036,8 @@ static int __kmp_reset_root(int gtid, kmp_root_t *root) {
 
   root->r.r_root_team = NULL;
   root->r.r_hot_team = NULL;
+  KMP_CRITICAL_PATH_FLUSH(&root_team->t.t_implicit_task_taskdata[0],
+                          kmp_cp_initial, NULL);
   // __kmp_free_team() does not free hot teams, so we have to clear r_hot_team
   // before call to __kmp_free_team().
   __kmp_free_team(root, root_team USE_NESTED_HOT_ARG(NULL));
@@ -4048,11 +4149,10 @@ void __kmp_unregister_root_current_thread(int gtid) {
   __kmp_release_bootstrap_lock(&__kmp_forkjoin_lock);
 }
 
-#if KMP_OS_WINDOWS
 /* __kmp_forkjoin_lock must be already held
    Unregisters a root thread that is not the current thread.  Returns the number
    of __kmp_threads entries freed as a result. */
-static int __kmp_unregister_root_other_thread(int gtid) {
+int __kmp_unregister_root_other_thread(int gtid) {
   kmp_root_t *root = __kmp_root[gtid];
   int r;
 
@@ -4067,7 +4167,6 @@ static int __kmp_unregister_root_other_thread(int gtid) {
            ("__kmp_unregister_root_other_thread: T#%d unregistered\n", gtid));
   return r;
 }
-#endif
 
 #if KMP_DEBUG
 void __kmp_task_info() {
@@ -4180,7 +4279,8 @@ static void __kmp_initialize_info(kmp_info_t *this_thr, kmp_team_t *team,
 #endif
     if (!dispatch->th_disp_buffer) {
       dispatch->th_disp_buffer =
-          (dispatch_private_info_t *)__kmp_allocate(disp_size);
+          (dispatch_private_info_t *)__kmp_allocate_thread_owned(this_thr,
+                                                                 disp_size);
 
       if (__kmp_storage_map) {
         __kmp_print_storage_map_gtid(
@@ -4222,6 +4322,28 @@ static void __kmp_initialize_info(kmp_info_t *this_thr, kmp_team_t *team,
   KMP_MB();
 }
 
+/* Allocate a zeroed structure owned by a single thread. With
+   KMP_NUMA_LOCAL_THREADS on a NUMA machine the structure gets pages of its own,
+   so that it can be moved to the node of the thread without dragging other
+   data along, and it is placed on that node right away if the thread is
+   already bound (owner may be NULL if it is not known yet). With
+   KMP_HUGE_PAGES the pages are slices of huge pages shared with other
+   structures, so the structure is not moved and stays on the node of the
+   allocating thread. */
+void *__kmp_allocate_thread_owned(kmp_info_t *owner, size_t size) {
+#if KMP_AFFINITY_SUPPORTED && KMP_OS_LINUX
+  if (__kmp_numa_local_threads && __kmp_numa_num_nodes() > 1 &&
+      __kmp_huge_pages == kmp_huge_pages_disabled) {
+    size_t page_size = KMP_GET_PAGE_SIZE();
+    void *ptr = __kmp_page_allocate((size + page_size - 1) & ~(page_size - 1));
+    if (owner != NULL && owner->th.th_numa_node >= 0)
+      __kmp_numa_migrate(ptr, size, owner->th.th_numa_node);
+    return ptr;
+  }
+#endif
+  return __kmp_allocate(size);
+}
+
 /* allocate a new thread for the requesting team. this is only called from
    within a forkjoin critical section. we will first try to get an available
    thread from the thread pool. if none is available, we will fork a new one
@@ -4337,7 +4459,11 @@ kmp_info_t *__kmp_allocate_thread(kmp_root_t *root, kmp_team_t *team,
   }
 
   /* allocate space for it. */
-  new_thr = (kmp_info_t *)__kmp_allocate(sizeof(kmp_info_t));
+  new_thr = (kmp_info_t *)__kmp_allocate_thread_owned(NULL, sizeof(kmp_info_t));
+#if KMP_AFFINITY_SUPPORTED && KMP_OS_LINUX
+  // Moved to the node of the thread once it is bound.
+  new_thr->th.th_numa_node = -1;
+#endif
 
   TCW_SYNC_PTR(__kmp_threads[new_gtid], new_thr);
 
@@ -4440,11 +4566,18 @@ kmp_info_t *__kmp_allocate_thread(kmp_root_t *root, kmp_team_t *team,
 #endif /* KMP_ADJUST_BLOCKTIME */
 
   /* actually fork it and create the new worker thread */
-  KF_TRACE(
-      10, ("__kmp_allocate_thread: before __kmp_create_worker: %p\n", new_thr));
-  __kmp_create_worker(new_gtid, new_thr, __kmp_stksize);
-  KF_TRACE(10,
-           ("__kmp_allocate_thread: after __kmp_create_worker: %p\n", new_thr));
+  if (__kmp_spawn_tree) {
+    // Created together with the other new threads of the team by the caller,
+    // in __kmp_spawn_team_workers().
+    new_thr->th.th_info.ds.ds_gtid = new_gtid;
+    new_thr->th.th_spawn_pending = TRUE;
+  } else {
+    KF_TRACE(10, ("__kmp_allocate_thread: before __kmp_create_worker: %p\n",
+                  new_thr));
+    __kmp_create_worker(new_gtid, new_thr, __kmp_stksize);
+    KF_TRACE(10, ("__kmp_allocate_thread: after __kmp_create_worker: %p\n",
+                  new_thr));
+  }
 
   KA_TRACE(20, ("__kmp_allocate_thread: T#%d forked T#%d\n", __kmp_get_gtid(),
                 new_gtid));
@@ -4908,7 +5041,10 @@ __kmp_allocate_team(kmp_root_t *root, int new_nproc, int max_nproc,
 #if OMP_40_ENABLED
 #if KMP_AFFINITY_SUPPORTED
       if ((team->t.t_size_changed == 0) &&
-          (team->t.t_proc_bind == new_proc_bind)) {
+          (team->t.t_proc_bind == new_proc_bind) &&
+          (team->t.t_first_place ==
+           team->t.t_threads[0]->th.th_first_place) &&
+          (team->t.t_last_place == team->t.t_threads[0]->th.th_last_place)) {
         if (new_proc_bind == proc_bind_spread) {
           __kmp_partition_places(
               team, 1); // add flag to update only master for spread
@@ -5083,6 +5219,7 @@ __kmp_allocate_team(kmp_root_t *root, int new_nproc, int max_nproc,
             }
           }
         }
+        __kmp_spawn_team_workers(team, team->t.t_nproc, new_nproc);
 
 #if KMP_OS_LINUX && KMP_AFFINITY_SUPPORTED
         if (KMP_AFFINITY_CAPABLE()) {
@@ -5495,6 +5632,10 @@ void __kmp_free_thread(kmp_info_t *this_th) {
     balign[b].bb.leaf_kids = 0;
   }
   this_th->th.th_task_state = 0;
+#if OMP_50_ENABLED
+  // def-allocator-var of the team is inherited again at the next fork.
+  this_th->th.th_def_allocator = omp_null_allocator;
+#endif
 
   /* put thread back on the free pool */
   TCW_PTR(this_th->th.th_team, NULL);
@@ -5585,6 +5726,7 @@ void *__kmp_launch_thread(kmp_info_t *this_thr) {
 #if OMPT_SUPPORT
   if (ompt_enabled.enabled) {
     this_thr->th.ompt_thread_info.state = omp_state_idle;
+    this_thr->th.ompt_thread_info.ident = NULL;
   }
 #endif
   /* This is the place where threads wait for work */
@@ -5621,6 +5763,7 @@ void *__kmp_launch_thread(kmp_info_t *this_thr) {
 #if OMPT_SUPPORT
         if (ompt_enabled.enabled) {
           this_thr->th.ompt_thread_info.state = omp_state_work_parallel;
+          this_thr->th.ompt_thread_info.ident = (*pteam)->t.t_ident;
         }
 #endif
 
@@ -5803,6 +5946,8 @@ static void __kmp_reap_thread(kmp_info_t *thread, int is_root) {
 #endif /* USE_FAST_MEMORY */
 
   __kmp_suspend_uninitialize_thread(thread);
+  __kmp_perf_retire(thread);
+  __kmp_hw_counters_detach(thread);
 
   KMP_DEBUG_ASSERT(__kmp_threads[gtid] == thread);
   TCW_SYNC_PTR(__kmp_threads[gtid], NULL);
@@ -5882,6 +6027,14 @@ static void __kmp_internal_end(void) {
   KMP_MB(); /* Flush all pending memory write invalidates.  */
   TCW_SYNC_4(__kmp_global.g.g_done, TRUE);
 
+  /* The idle launchers of kmp_parallel_async() are roots of their own */
+  __kmp_async_fini();
+#if KMP_OS_LINUX
+  __kmp_oversub_fini();
+#endif
+  // Before the threads are reaped, the sampler reads them.
+  __kmp_wait_profile_fini();
+
   if (i < __kmp_threads_capacity) {
 #if KMP_USE_MONITOR
     // 2009-09-08 (lev): Other alive roots found. Why do we kill the monitor??
@@ -6415,18 +6568,9 @@ static void __kmp_do_serial_initialize(void) {
   __kmp_init_queuing_lock(&__kmp_dispatch_lock);
   __kmp_init_lock(&__kmp_debug_lock);
   __kmp_init_atomic_lock(&__kmp_atomic_lock);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_1i);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_2i);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_4i);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_4r);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_8i);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_8r);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_8c);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_10r);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_16r);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_16c);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_20c);
-  __kmp_init_atomic_lock(&__kmp_atomic_lock_32c);
+  for (i = 0; i < KMP_ATOMIC_LOCK_STRIPES; ++i) {
+    __kmp_init_atomic_lock(&__kmp_atomic_lock_stripes[i]);
+  }
   __kmp_init_bootstrap_lock(&__kmp_forkjoin_lock);
   __kmp_init_bootstrap_lock(&__kmp_exit_lock);
 #if KMP_USE_MONITOR
@@ -6541,6 +6685,9 @@ static void __kmp_do_serial_initialize(void) {
   __kmp_global.g.g_dynamic_mode = dynamic_default;
 
   __kmp_env_initialize(NULL);
+  __kmp_trace_init();
+  __kmp_wait_profile_init();
+  __kmp_hw_counters_init();
 
 // Print all messages in message catalog for testing purposes.
 #ifdef KMP_DEBUG
@@ -6846,6 +6993,11 @@ void __kmp_parallel_initialize(void) {
     __kmp_print_version_2();
   }
 
+#if KMP_OS_LINUX
+  // KMP_OVERSUB_CHECK: sample the system load from a thread of its own
+  __kmp_oversub_init();
+#endif
+
   /* we have finished parallel initialization */
   TCW_SYNC_4(__kmp_init_parallel, TRUE);
 
@@ -6881,12 +7033,14 @@ void __kmp_run_before_invoked_task(int gtid, int tid, kmp_info_t *this_thr,
 #endif
   if (__kmp_env_consistency_check)
     __kmp_push_parallel(gtid, team->t.t_ident);
+  KMP_HW_COUNTERS_BEGIN(this_thr, team->t.t_ident, kmp_hw_work);
 
   KMP_MB(); /* Flush all pending memory write invalidates.  */
 }
 
 void __kmp_run_after_invoked_task(int gtid, int tid, kmp_info_t *this_thr,
                                   kmp_team_t *team) {
+  KMP_HW_COUNTERS_END(this_thr);
   if (__kmp_env_consistency_check)
     __kmp_pop_parallel(gtid, team->t.t_ident);
 
@@ -7344,6 +7498,10 @@ void __kmp_cleanup(void) {
   __kmp_root = NULL;
   __kmp_threads_capacity = 0;
 
+#if KMP_USE_BGET
+  __kmp_cleanup_sizeclass();
+#endif
+
 #if KMP_USE_DYNAMIC_LOCK
   __kmp_cleanup_indirect_user_locks();
 #else
@@ -7353,6 +7511,11 @@ void __kmp_cleanup(void) {
 #if KMP_AFFINITY_SUPPORTED
   KMP_INTERNAL_FREE(CCAST(char *, __kmp_cpuinfo_file));
   __kmp_cpuinfo_file = NULL;
+#if KMP_OS_LINUX
+  KMP_INTERNAL_FREE(CCAST(char *, __kmp_sysfs_root));
+  __kmp_sysfs_root = NULL;
+  __kmp_numa_cleanup();
+#endif
 #endif /* KMP_AFFINITY_SUPPORTED */
 
 #if KMP_USE_ADAPTIVE_LOCKS
@@ -7374,6 +7537,13 @@ void __kmp_cleanup(void) {
 #if KMP_STATS_ENABLED
   __kmp_stats_fini();
 #endif
+  __kmp_trace_fini();
+  __kmp_critical_path_fini();
+  __kmp_hw_counters_fini();
+
+#if KMP_OS_LINUX
+  __kmp_cleanup_arena();
+#endif
 
   KA_TRACE(10, ("__kmp_cleanup: exit\n"));
 }
@@ -7738,3 +7908,65 @@ __kmp_determine_reduction_method(
 kmp_int32 __kmp_get_reduce_method(void) {
   return ((__kmp_entry_thread()->th.th_local.packed_reduction_method) >> 8);
 }
+
+/* ------------------------------------------------------------------------ */
+// Performance counters
+
+// Sum of the counters of the threads reaped so far, so that the totals never
+// decrease. Like __kmp_threads, it is guarded by __kmp_forkjoin_lock.
+static kmp_perf_t __kmp_perf_retired;
+
+static void __kmp_perf_add(kmp_perf_t *sum, kmp_info_t const *thr) {
+  // The owner updates the counters while they are read.
+  kmp_uint64 *dst = (kmp_uint64 *)sum;
+  for (size_t i = 0; i < KMP_PERF_NUM_COUNTERS; ++i)
+    dst[i] += thr->th.th_perf[i].load(std::memory_order_relaxed);
+}
+
+static kmp_uint64 __kmp_perf_nsec(kmp_uint64 time) {
+#if KMP_OS_UNIX && (KMP_ARCH_X86 || KMP_ARCH_X86_64)
+  return (kmp_uint64)((double)time * 1e6 / __kmp_ticks_per_msec);
+#else
+  return time;
+#endif
+}
+
+// Called with __kmp_forkjoin_lock held, before the thread leaves __kmp_threads.
+void __kmp_perf_retire(kmp_info_t *thr) {
+  __kmp_perf_add(&__kmp_perf_retired, thr);
+}
+
+// The counters of the thread with the given gtid, or with -1 the sum over all
+// threads, including those already reaped. Returns the number of threads
+// summed, 0 if no thread has the gtid, -1 if the gtid is out of range.
+int __kmp_get_perf_counters(int thread, kmp_perf_t *perf) {
+  int nthreads = 0;
+  memset(perf, 0, sizeof(*perf));
+  if (!TCR_4(__kmp_init_serial))
+    return thread == -1 ? 0 : -1;
+  __kmp_acquire_bootstrap_lock(&__kmp_forkjoin_lock);
+  if (thread < -1 || thread >= __kmp_threads_capacity) {
+    nthreads = -1;
+  } else if (thread >= 0) {
+    kmp_info_t *thr = __kmp_threads[thread];
+    if (thr != NULL) {
+      __kmp_perf_add(perf, thr);
+      nthreads = 1;
+    }
+  } else {
+    KMP_MEMCPY(perf, &__kmp_perf_retired, sizeof(*perf));
+    for (int i = 0; i < __kmp_threads_capacity; ++i) {
+      kmp_info_t *thr = __kmp_threads[i];
+      if (thr != NULL) {
+        __kmp_perf_add(perf, thr);
+        ++nthreads;
+      }
+    }
+  }
+  __kmp_release_bootstrap_lock(&__kmp_forkjoin_lock);
+  perf->barrier_time = __kmp_perf_nsec(perf->barrier_time);
+  perf->spin_time = __kmp_perf_nsec(perf->spin_time);
+  perf->sleep_time = __kmp_perf_nsec(perf->sleep_time);
+  perf->lock_wait_time = __kmp_perf_nsec(perf->lock_wait_time);
+  return nthreads;
+}
@@ -16,13 +16,17 @@
 #include "kmp.h"
 #include "kmp_affinity.h"
 #include "kmp_atomic.h"
+#include "kmp_critical_path.h"
 #include "kmp_environment.h"
+#include "kmp_hw_counters.h"
 #include "kmp_i18n.h"
 #include "kmp_io.h"
 #include "kmp_itt.h"
 #include "kmp_lock.h"
 #include "kmp_settings.h"
 #include "kmp_str.h"
+#include "kmp_trace.h"
+#include "kmp_wait_profile.h"
 #include "kmp_wrapper_getpid.h"
 #include <ctype.h>   // toupper()
 
@@ -1262,6 +1266,224 @@ static void __kmp_stg_print_hot_teams_mode(kmp_str_buf_t *buffer,
 
 #endif // KMP_NESTED_HOT_TEAMS
 
+// -----------------------------------------------------------------------------
+// KMP_SPAWN_TREE
+
+static void __kmp_stg_parse_spawn_tree(char const *name, char const *value,
+                                       void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_spawn_tree);
+} // __kmp_stg_parse_spawn_tree
+
+static void __kmp_stg_print_spawn_tree(kmp_str_buf_t *buffer, char const *name,
+                                       void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_spawn_tree);
+} // __kmp_stg_print_spawn_tree
+
+// -----------------------------------------------------------------------------
+// KMP_TRACE, KMP_TRACE_FILE, KMP_TRACE_BUFFER_SIZE, KMP_TRACE_SIGNAL
+
+static void __kmp_stg_parse_trace(char const *name, char const *value,
+                                  void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_trace_enabled);
+} // __kmp_stg_parse_trace
+
+static void __kmp_stg_print_trace(kmp_str_buf_t *buffer, char const *name,
+                                  void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_trace_enabled);
+} // __kmp_stg_print_trace
+
+static void __kmp_stg_parse_trace_file(char const *name, char const *value,
+                                       void *data) {
+  __kmp_stg_parse_str(name, value, &__kmp_trace_file);
+} // __kmp_stg_parse_trace_file
+
+static void __kmp_stg_print_trace_file(kmp_str_buf_t *buffer, char const *name,
+                                       void *data) {
+  if (__kmp_env_format) {
+    KMP_STR_BUF_PRINT_NAME;
+  } else {
+    __kmp_str_buf_print(buffer, "   %s", name);
+  }
+  if (__kmp_trace_file) {
+    __kmp_str_buf_print(buffer, "='%s'\n", __kmp_trace_file);
+  } else {
+    __kmp_str_buf_print(buffer, ": %s\n", KMP_I18N_STR(NotDefined));
+  }
+} // __kmp_stg_print_trace_file
+
+static void __kmp_stg_parse_trace_buffer_size(char const *name,
+                                              char const *value, void *data) {
+  __kmp_stg_parse_int(name, value, 16, 1 << 24, &__kmp_trace_buffer_size);
+} // __kmp_stg_parse_trace_buffer_size
+
+static void __kmp_stg_print_trace_buffer_size(kmp_str_buf_t *buffer,
+                                              char const *name, void *data) {
+  __kmp_stg_print_int(buffer, name, __kmp_trace_buffer_size);
+} // __kmp_stg_print_trace_buffer_size
+
+static void __kmp_stg_parse_trace_signal(char const *name, char const *value,
+                                         void *data) {
+  __kmp_stg_parse_int(name, value, 0, 64, &__kmp_trace_signal);
+} // __kmp_stg_parse_trace_signal
+
+static void __kmp_stg_print_trace_signal(kmp_str_buf_t *buffer,
+                                         char const *name, void *data) {
+  __kmp_stg_print_int(buffer, name, __kmp_trace_signal);
+} // __kmp_stg_print_trace_signal
+
+// -----------------------------------------------------------------------------
+// KMP_WAIT_PROFILE, KMP_WAIT_PROFILE_INTERVAL, KMP_WAIT_PROFILE_FILE
+
+static void __kmp_stg_parse_wait_profile(char const *name, char const *value,
+                                         void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_wait_profile);
+} // __kmp_stg_parse_wait_profile
+
+static void __kmp_stg_print_wait_profile(kmp_str_buf_t *buffer,
+                                         char const *name, void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_wait_profile);
+} // __kmp_stg_print_wait_profile
+
+static void __kmp_stg_parse_wait_profile_interval(char const *name,
+                                                  char const *value,
+                                                  void *data) {
+  __kmp_stg_parse_int(name, value, 10, 1000000, &__kmp_wait_profile_interval);
+} // __kmp_stg_parse_wait_profile_interval
+
+static void __kmp_stg_print_wait_profile_interval(kmp_str_buf_t *buffer,
+                                                  char const *name,
+                                                  void *data) {
+  __kmp_stg_print_int(buffer, name, __kmp_wait_profile_interval);
+} // __kmp_stg_print_wait_profile_interval
+
+static void __kmp_stg_parse_wait_profile_file(char const *name,
+                                              char const *value, void *data) {
+  __kmp_stg_parse_str(name, value, &__kmp_wait_profile_file);
+} // __kmp_stg_parse_wait_profile_file
+
+static void __kmp_stg_print_wait_profile_file(kmp_str_buf_t *buffer,
+                                              char const *name, void *data) {
+  if (__kmp_env_format) {
+    KMP_STR_BUF_PRINT_NAME;
+  } else {
+    __kmp_str_buf_print(buffer, "   %s", name);
+  }
+  if (__kmp_wait_profile_file) {
+    __kmp_str_buf_print(buffer, "='%s'\n", __kmp_wait_profile_file);
+  } else {
+    __kmp_str_buf_print(buffer, ": %s\n", KMP_I18N_STR(NotDefined));
+  }
+} // __kmp_stg_print_wait_profile_file
+
+// -----------------------------------------------------------------------------
+// KMP_CRITICAL_PATH, KMP_CRITICAL_PATH_FILE
+
+static void __kmp_stg_parse_critical_path(char const *name, char const *value,
+                                          void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_critical_path);
+} // __kmp_stg_parse_critical_path
+
+static void __kmp_stg_print_critical_path(kmp_str_buf_t *buffer,
+                                          char const *name, void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_critical_path);
+} // __kmp_stg_print_critical_path
+
+static void __kmp_stg_parse_critical_path_file(char const *name,
+                                               char const *value, void *data) {
+  __kmp_stg_parse_str(name, value, &__kmp_critical_path_file);
+} // __kmp_stg_parse_critical_path_file
+
+static void __kmp_stg_print_critical_path_file(kmp_str_buf_t *buffer,
+                                               char const *name, void *data) {
+  if (__kmp_env_format) {
+    KMP_STR_BUF_PRINT_NAME;
+  } else {
+    __kmp_str_buf_print(buffer, "   %s", name);
+  }
+  if (__kmp_critical_path_file) {
+    __kmp_str_buf_print(buffer, "='%s'\n", __kmp_critical_path_file);
+  } else {
+    __kmp_str_buf_print(buffer, ": %s\n", KMP_I18N_STR(NotDefined));
+  }
+} // __kmp_stg_print_critical_path_file
+
+// -----------------------------------------------------------------------------
+// KMP_HW_COUNTERS, KMP_HW_COUNTERS_EVENTS, KMP_HW_COUNTERS_FILE
+
+static void __kmp_stg_parse_hw_counters(char const *name, char const *value,
+                                        void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_hw_counters);
+} // __kmp_stg_parse_hw_counters
+
+static void __kmp_stg_print_hw_counters(kmp_str_buf_t *buffer,
+                                        char const *name, void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_hw_counters);
+} // __kmp_stg_print_hw_counters
+
+static void __kmp_stg_parse_hw_counters_events(char const *name,
+                                               char const *value, void *data) {
+  __kmp_stg_parse_str(name, value, &__kmp_hw_counters_events);
+} // __kmp_stg_parse_hw_counters_events
+
+static void __kmp_stg_print_hw_counters_events(kmp_str_buf_t *buffer,
+                                               char const *name, void *data) {
+  if (__kmp_env_format) {
+    KMP_STR_BUF_PRINT_NAME;
+  } else {
+    __kmp_str_buf_print(buffer, "   %s", name);
+  }
+  if (__kmp_hw_counters_events) {
+    __kmp_str_buf_print(buffer, "='%s'\n", __kmp_hw_counters_events);
+  } else {
+    __kmp_str_buf_print(buffer, ": %s\n", KMP_I18N_STR(NotDefined));
+  }
+} // __kmp_stg_print_hw_counters_events
+
+static void __kmp_stg_parse_hw_counters_file(char const *name,
+                                             char const *value, void *data) {
+  __kmp_stg_parse_str(name, value, &__kmp_hw_counters_file);
+} // __kmp_stg_parse_hw_counters_file
+
+static void __kmp_stg_print_hw_counters_file(kmp_str_buf_t *buffer,
+                                             char const *name, void *data) {
+  if (__kmp_env_format) {
+    KMP_STR_BUF_PRINT_NAME;
+  } else {
+    __kmp_str_buf_print(buffer, "   %s", name);
+  }
+  if (__kmp_hw_counters_file) {
+    __kmp_str_buf_print(buffer, "='%s'\n", __kmp_hw_counters_file);
+  } else {
+    __kmp_str_buf_print(buffer, ": %s\n", KMP_I18N_STR(NotDefined));
+  }
+} // __kmp_stg_print_hw_counters_file
+
+// -----------------------------------------------------------------------------
+// KMP_PERF_LOCK_TIMING
+
+static void __kmp_stg_parse_perf_lock_timing(char const *name,
+                                             char const *value, void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_perf_lock_timing);
+} // __kmp_stg_parse_perf_lock_timing
+
+static void __kmp_stg_print_perf_lock_timing(kmp_str_buf_t *buffer,
+                                             char const *name, void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_perf_lock_timing);
+} // __kmp_stg_print_perf_lock_timing
+
+// -----------------------------------------------------------------------------
+// KMP_PERF_WAIT_TIMING
+
+static void __kmp_stg_parse_perf_wait_timing(char const *name,
+                                             char const *value, void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_perf_wait_timing);
+} // __kmp_stg_parse_perf_wait_timing
+
+static void __kmp_stg_print_perf_wait_timing(kmp_str_buf_t *buffer,
+                                             char const *name, void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_perf_wait_timing);
+} // __kmp_stg_print_perf_wait_timing
+
 // -----------------------------------------------------------------------------
 // KMP_HANDLE_SIGNALS
 
@@ -1591,6 +1813,33 @@ static void __kmp_stg_print_cpuinfo_file(kmp_str_buf_t *buffer,
 #endif
 } //__kmp_stg_print_cpuinfo_file
 
+// -----------------------------------------------------------------------------
+// KMP_SYSFS_ROOT
+
+static void __kmp_stg_parse_sysfs_root(char const *name, char const *value,
+                                       void *data) {
+#if KMP_AFFINITY_SUPPORTED && KMP_OS_LINUX
+  __kmp_stg_parse_str(name, value, &__kmp_sysfs_root);
+  K_DIAG(1, ("__kmp_sysfs_root == %s\n", __kmp_sysfs_root));
+#endif
+} //__kmp_stg_parse_sysfs_root
+
+static void __kmp_stg_print_sysfs_root(kmp_str_buf_t *buffer, char const *name,
+                                       void *data) {
+#if KMP_AFFINITY_SUPPORTED && KMP_OS_LINUX
+  if (__kmp_env_format) {
+    KMP_STR_BUF_PRINT_NAME;
+  } else {
+    __kmp_str_buf_print(buffer, "   %s", name);
+  }
+  if (__kmp_sysfs_root) {
+    __kmp_str_buf_print(buffer, "='%s'\n", __kmp_sysfs_root);
+  } else {
+    __kmp_str_buf_print(buffer, ": %s\n", KMP_I18N_STR(NotDefined));
+  }
+#endif
+} //__kmp_stg_print_sysfs_root
+
 // -----------------------------------------------------------------------------
 // KMP_FORCE_REDUCTION, KMP_DETERMINISTIC_REDUCTION
 
@@ -2837,6 +3086,42 @@ static void __kmp_stg_print_places(kmp_str_buf_t *buffer, char const *name,
   }
 }
 
+// -----------------------------------------------------------------------------
+// KMP_PLACE_PARTITION
+
+static void __kmp_stg_parse_place_partition(char const *name,
+                                            char const *value, void *data) {
+  int first, last;
+  char extra;
+  if (KMP_SSCANF(value, "%d:%d%c", &first, &last, &extra) != 2 || first < 0 ||
+      last < 0) {
+    KMP_WARNING(StgInvalidValue, name, value);
+    return;
+  }
+  __kmp_place_partition_first = first;
+  __kmp_place_partition_last = last;
+} // __kmp_stg_parse_place_partition
+
+static void __kmp_stg_print_place_partition(kmp_str_buf_t *buffer,
+                                            char const *name, void *data) {
+  if (__kmp_place_partition_first < 0) {
+    if (__kmp_env_format) {
+      KMP_STR_BUF_PRINT_NAME;
+    } else {
+      __kmp_str_buf_print(buffer, "   %s", name);
+    }
+    __kmp_str_buf_print(buffer, ": %s\n", KMP_I18N_STR(NotDefined));
+  } else {
+    if (__kmp_env_format) {
+      KMP_STR_BUF_PRINT_NAME_EX(name);
+    } else {
+      __kmp_str_buf_print(buffer, "   %s='", name);
+    }
+    __kmp_str_buf_print(buffer, "%d:%d'\n", __kmp_place_partition_first,
+                        __kmp_place_partition_last);
+  }
+} // __kmp_stg_print_place_partition
+
 #endif /* OMP_40_ENABLED */
 
 #if (!OMP_40_ENABLED)
@@ -2929,6 +3214,11 @@ static void __kmp_stg_parse_topology_method(char const *name, char const *value,
            __kmp_str_match("cpuinfo", 5, value)) {
     __kmp_affinity_top_method = affinity_top_method_cpuinfo;
   }
+#if KMP_OS_LINUX
+  else if (__kmp_str_match("sysfs", 2, value)) {
+    __kmp_affinity_top_method = affinity_top_method_sysfs;
+  }
+#endif /* KMP_OS_LINUX */
 #if KMP_GROUP_AFFINITY
   else if (__kmp_str_match("group", 1, value)) {
     __kmp_affinity_top_method = affinity_top_method_group;
@@ -2981,6 +3271,12 @@ static void __kmp_stg_print_topology_method(kmp_str_buf_t *buffer,
     value = "cpuinfo";
     break;
 
+#if KMP_OS_LINUX
+  case affinity_top_method_sysfs:
+    value = "sysfs";
+    break;
+#endif /* KMP_OS_LINUX */
+
 #if KMP_GROUP_AFFINITY
   case affinity_top_method_group:
     value = "group";
@@ -3603,6 +3899,95 @@ static void __kmp_stg_print_malloc_pool_incr(kmp_str_buf_t *buffer,
 
 } // _kmp_stg_print_malloc_pool_incr
 
+#if KMP_USE_BGET
+// -----------------------------------------------------------------------------
+// KMP_MALLOC_KIND
+
+static void __kmp_stg_parse_malloc_kind(char const *name, char const *value,
+                                        void *data) {
+  if (__kmp_str_match("sizeclass", 1, value) ||
+      __kmp_str_match("size_class", 1, value) ||
+      __kmp_str_match("size-class", 1, value)) {
+    __kmp_malloc_kind = kmp_malloc_sizeclass;
+  } else if (__kmp_str_match("bget", 1, value)) {
+    __kmp_malloc_kind = kmp_malloc_bget;
+  } else {
+    KMP_WARNING(StgInvalidValue, name, value);
+  }
+} // __kmp_stg_parse_malloc_kind
+
+static void __kmp_stg_print_malloc_kind(kmp_str_buf_t *buffer,
+                                        char const *name, void *data) {
+  __kmp_stg_print_str(buffer, name, __kmp_malloc_kind == kmp_malloc_sizeclass
+                                        ? "sizeclass"
+                                        : "bget");
+} // __kmp_stg_print_malloc_kind
+#endif // KMP_USE_BGET
+
+#if KMP_OS_LINUX
+// -----------------------------------------------------------------------------
+// KMP_HUGE_PAGES, KMP_HUGE_PAGES_STATS
+
+static void __kmp_stg_parse_huge_pages(char const *name, char const *value,
+                                       void *data) {
+  if (__kmp_str_match("transparent", 1, value) ||
+      __kmp_str_match("thp", 3, value) || __kmp_str_match_true(value)) {
+    __kmp_huge_pages = kmp_huge_pages_transparent;
+  } else if (__kmp_str_match("explicit", 1, value) ||
+             __kmp_str_match("hugetlb", 1, value)) {
+    __kmp_huge_pages = kmp_huge_pages_explicit;
+  } else if (__kmp_str_match("disabled", 1, value) ||
+             __kmp_str_match_false(value)) {
+    __kmp_huge_pages = kmp_huge_pages_disabled;
+  } else {
+    KMP_WARNING(StgInvalidValue, name, value);
+  }
+} // __kmp_stg_parse_huge_pages
+
+static void __kmp_stg_print_huge_pages(kmp_str_buf_t *buffer, char const *name,
+                                       void *data) {
+  static char const *const kinds[] = {"disabled", "transparent", "explicit"};
+  __kmp_stg_print_str(buffer, name, kinds[__kmp_huge_pages]);
+} // __kmp_stg_print_huge_pages
+
+static void __kmp_stg_parse_huge_pages_stats(char const *name,
+                                             char const *value, void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_huge_pages_stats);
+} // __kmp_stg_parse_huge_pages_stats
+
+static void __kmp_stg_print_huge_pages_stats(kmp_str_buf_t *buffer,
+                                             char const *name, void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_huge_pages_stats);
+} // __kmp_stg_print_huge_pages_stats
+
+// -----------------------------------------------------------------------------
+// KMP_NUMA_LOCAL_THREADS
+
+static void __kmp_stg_parse_numa_local_threads(char const *name,
+                                               char const *value, void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_numa_local_threads);
+} // __kmp_stg_parse_numa_local_threads
+
+static void __kmp_stg_print_numa_local_threads(kmp_str_buf_t *buffer,
+                                               char const *name, void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_numa_local_threads);
+} // __kmp_stg_print_numa_local_threads
+
+// -----------------------------------------------------------------------------
+// KMP_OVERSUB_CHECK
+
+static void __kmp_stg_parse_oversub_check(char const *name, char const *value,
+                                          void *data) {
+  __kmp_stg_parse_int(name, value, 0, KMP_MAX_OVERSUB_CHECK,
+                      &__kmp_oversub_check);
+} // __kmp_stg_parse_oversub_check
+
+static void __kmp_stg_print_oversub_check(kmp_str_buf_t *buffer,
+                                          char const *name, void *data) {
+  __kmp_stg_print_int(buffer, name, __kmp_oversub_check);
+} // __kmp_stg_print_oversub_check
+#endif // KMP_OS_LINUX
+
 #ifdef KMP_DEBUG
 
 // -----------------------------------------------------------------------------
@@ -3824,6 +4209,14 @@ static void __kmp_stg_parse_lock_kind(char const *name, char const *value,
     __kmp_user_lock_kind = lk_hle;
     KMP_STORE_LOCK_SEQ(hle);
   }
+#endif
+#if KMP_USE_DYNAMIC_LOCK
+  else if (__kmp_str_match("autotune", 2, value) ||
+           __kmp_str_match("auto_tune", 2, value) ||
+           __kmp_str_match("auto-tune", 2, value)) {
+    __kmp_user_lock_kind = lk_autotune;
+    KMP_STORE_LOCK_SEQ(autotune);
+  }
 #endif
   else {
     KMP_WARNING(StgInvalidValue, name, value);
@@ -3874,6 +4267,11 @@ static void __kmp_stg_print_lock_kind(kmp_str_buf_t *buffer, char const *name,
   case lk_adaptive:
     value = "adaptive";
     break;
+#endif
+#if KMP_USE_DYNAMIC_LOCK
+  case lk_autotune:
+    value = "autotune";
+    break;
 #endif
   }
 
@@ -4101,6 +4499,71 @@ static void __kmp_stg_print_speculative_statsfile(kmp_str_buf_t *buffer,
 
 #endif // KMP_USE_ADAPTIVE_LOCKS
 
+#if KMP_USE_DYNAMIC_LOCK
+
+// -----------------------------------------------------------------------------
+// KMP_AUTOTUNE_LOCK_PROPS
+
+// Parse out values for the tunable parameters from a string of the form
+// KMP_AUTOTUNE_LOCK_PROPS=window[,promote_pct[,demote_pct[,drdpa_waiters]]]
+static void __kmp_stg_parse_autotune_lock_props(const char *name,
+                                                const char *value, void *data) {
+  int props[4];
+  const char *next = value;
+  int i;
+
+  props[0] = __kmp_autotune_lock_params.window;
+  props[1] = __kmp_autotune_lock_params.promote_pct;
+  props[2] = __kmp_autotune_lock_params.demote_pct;
+  props[3] = __kmp_autotune_lock_params.drdpa_waiters;
+
+  for (i = 0; i < 4; i++) {
+    const char *buf;
+    SKIP_WS(next);
+    if (*next < '0' || *next > '9') {
+      KMP_WARNING(EnvSyntaxError, name, value);
+      return;
+    }
+    buf = next;
+    SKIP_DIGITS(next);
+    props[i] = __kmp_str_to_int(buf, *next);
+    SKIP_WS(next);
+    if (*next == '\0')
+      break;
+    if (*next != ',' || i == 3) {
+      KMP_WARNING(EnvSyntaxError, name, value);
+      return;
+    }
+    next++; // skip ','
+  }
+  // The window must be non-empty and the thresholds must leave a band where
+  // the lock keeps its current level.
+  if (props[0] < 1 || props[1] < 1 || props[1] > 100 || props[2] > props[1]) {
+    KMP_WARNING(StgInvalidValue, name, value);
+    return;
+  }
+  __kmp_autotune_lock_params.window = props[0];
+  __kmp_autotune_lock_params.promote_pct = props[1];
+  __kmp_autotune_lock_params.demote_pct = props[2];
+  __kmp_autotune_lock_params.drdpa_waiters = props[3];
+}
+
+static void __kmp_stg_print_autotune_lock_props(kmp_str_buf_t *buffer,
+                                                char const *name, void *data) {
+  if (__kmp_env_format) {
+    KMP_STR_BUF_PRINT_NAME_EX(name);
+  } else {
+    __kmp_str_buf_print(buffer, "   %s='", name);
+  }
+  __kmp_str_buf_print(buffer, "%u,%u,%u,%u'\n",
+                      __kmp_autotune_lock_params.window,
+                      __kmp_autotune_lock_params.promote_pct,
+                      __kmp_autotune_lock_params.demote_pct,
+                      __kmp_autotune_lock_params.drdpa_waiters);
+} // __kmp_stg_print_autotune_lock_props
+
+#endif // KMP_USE_DYNAMIC_LOCK
+
 // -----------------------------------------------------------------------------
 // KMP_HW_SUBSET (was KMP_PLACE_THREADS)
 
@@ -4357,6 +4820,53 @@ static void __kmp_stg_print_omp_cancellation(kmp_str_buf_t *buffer,
 
 #endif
 
+#if OMP_50_ENABLED
+
+// -----------------------------------------------------------------------------
+// OMP_ALLOCATOR sets default allocator
+
+static const struct {
+  char const *name;
+  omp_allocator_handle_t handle;
+} __kmp_stg_allocators[] = {
+    {"omp_default_mem_alloc", omp_default_mem_alloc},
+    {"omp_large_cap_mem_alloc", omp_large_cap_mem_alloc},
+    {"omp_const_mem_alloc", omp_const_mem_alloc},
+    {"omp_high_bw_mem_alloc", omp_high_bw_mem_alloc},
+    {"omp_low_lat_mem_alloc", omp_low_lat_mem_alloc},
+    {"omp_cgroup_mem_alloc", omp_cgroup_mem_alloc},
+    {"omp_pteam_mem_alloc", omp_pteam_mem_alloc},
+    {"omp_thread_mem_alloc", omp_thread_mem_alloc},
+    {"kmp_interleaved_mem_alloc", kmp_interleaved_mem_alloc},
+    {"kmp_numa_local_mem_alloc", kmp_numa_local_mem_alloc}};
+
+static void __kmp_stg_parse_allocator(char const *name, char const *value,
+                                      void *data) {
+  size_t i;
+  for (i = 0; i < sizeof(__kmp_stg_allocators) / sizeof(*__kmp_stg_allocators);
+       ++i) {
+    if (__kmp_str_match(__kmp_stg_allocators[i].name, 0, value)) {
+      __kmp_def_allocator = __kmp_stg_allocators[i].handle;
+      return;
+    }
+  }
+  KMP_WARNING(StgInvalidValue, name, value);
+} // __kmp_stg_parse_allocator
+
+static void __kmp_stg_print_allocator(kmp_str_buf_t *buffer, char const *name,
+                                      void *data) {
+  size_t i;
+  for (i = 0; i < sizeof(__kmp_stg_allocators) / sizeof(*__kmp_stg_allocators);
+       ++i) {
+    if (__kmp_stg_allocators[i].handle == __kmp_def_allocator) {
+      __kmp_stg_print_str(buffer, name, __kmp_stg_allocators[i].name);
+      return;
+    }
+  }
+} // __kmp_stg_print_allocator
+
+#endif
+
 #if OMP_50_ENABLED && LIBOMP_OMPT_SUPPORT
 
 static void __kmp_stg_parse_omp_tool_libraries(char const *name,
@@ -4446,6 +4956,35 @@ static kmp_setting_t __kmp_stg_table[] = {
     {"KMP_HOT_TEAMS_MODE", __kmp_stg_parse_hot_teams_mode,
      __kmp_stg_print_hot_teams_mode, NULL, 0, 0},
 #endif // KMP_NESTED_HOT_TEAMS
+    {"KMP_SPAWN_TREE", __kmp_stg_parse_spawn_tree, __kmp_stg_print_spawn_tree,
+     NULL, 0, 0},
+    {"KMP_TRACE", __kmp_stg_parse_trace, __kmp_stg_print_trace, NULL, 0, 0},
+    {"KMP_TRACE_FILE", __kmp_stg_parse_trace_file, __kmp_stg_print_trace_file,
+     NULL, 0, 0},
+    {"KMP_TRACE_BUFFER_SIZE", __kmp_stg_parse_trace_buffer_size,
+     __kmp_stg_print_trace_buffer_size, NULL, 0, 0},
+    {"KMP_TRACE_SIGNAL", __kmp_stg_parse_trace_signal,
+     __kmp_stg_print_trace_signal, NULL, 0, 0},
+    {"KMP_PERF_LOCK_TIMING", __kmp_stg_parse_perf_lock_timing,
+     __kmp_stg_print_perf_lock_timing, NULL, 0, 0},
+    {"KMP_PERF_WAIT_TIMING", __kmp_stg_parse_perf_wait_timing,
+     __kmp_stg_print_perf_wait_timing, NULL, 0, 0},
+    {"KMP_WAIT_PROFILE", __kmp_stg_parse_wait_profile,
+     __kmp_stg_print_wait_profile, NULL, 0, 0},
+    {"KMP_WAIT_PROFILE_INTERVAL", __kmp_stg_parse_wait_profile_interval,
+     __kmp_stg_print_wait_profile_interval, NULL, 0, 0},
+    {"KMP_WAIT_PROFILE_FILE", __kmp_stg_parse_wait_profile_file,
+     __kmp_stg_print_wait_profile_file, NULL, 0, 0},
+    {"KMP_CRITICAL_PATH", __kmp_stg_parse_critical_path,
+     __kmp_stg_print_critical_path, NULL, 0, 0},
+    {"KMP_CRITICAL_PATH_FILE", __kmp_stg_parse_critical_path_file,
+     __kmp_stg_print_critical_path_file, NULL, 0, 0},
+    {"KMP_HW_COUNTERS", __kmp_stg_parse_hw_counters,
+     __kmp_stg_print_hw_counters, NULL, 0, 0},
+    {"KMP_HW_COUNTERS_EVENTS", __kmp_stg_parse_hw_counters_events,
+     __kmp_stg_print_hw_counters_events, NULL, 0, 0},
+    {"KMP_HW_COUNTERS_FILE", __kmp_stg_parse_hw_counters_file,
+     __kmp_stg_print_hw_counters_file, NULL, 0, 0},
 
 #if KMP_HANDLE_SIGNALS
     {"KMP_HANDLE_SIGNALS", __kmp_stg_parse_handle_signals,
@@ -4517,6 +5056,8 @@ static kmp_setting_t __kmp_stg_table[] = {
      __kmp_stg_print_abort_delay, NULL, 0, 0},
     {"KMP_CPUINFO_FILE", __kmp_stg_parse_cpuinfo_file,
      __kmp_stg_print_cpuinfo_file, NULL, 0, 0},
+    {"KMP_SYSFS_ROOT", __kmp_stg_parse_sysfs_root, __kmp_stg_print_sysfs_root,
+     NULL, 0, 0},
     {"KMP_FORCE_REDUCTION", __kmp_stg_parse_force_reduction,
      __kmp_stg_print_force_reduction, NULL, 0, 0},
     {"KMP_DETERMINISTIC_REDUCTION", __kmp_stg_parse_force_reduction,
@@ -4540,6 +5081,8 @@ static kmp_setting_t __kmp_stg_table[] = {
     {"OMP_PROC_BIND", __kmp_stg_parse_proc_bind, __kmp_stg_print_proc_bind,
      NULL, 0, 0},
     {"OMP_PLACES", __kmp_stg_parse_places, __kmp_stg_print_places, NULL, 0, 0},
+    {"KMP_PLACE_PARTITION", __kmp_stg_parse_place_partition,
+     __kmp_stg_print_place_partition, NULL, 0, 0},
 #else
     {"OMP_PROC_BIND", __kmp_stg_parse_proc_bind, NULL, /* no print */ NULL, 0,
      0},
@@ -4576,6 +5119,20 @@ static kmp_setting_t __kmp_stg_table[] = {
 #endif /* USE_ITT_BUILD && USE_ITT_NOTIFY */
     {"KMP_MALLOC_POOL_INCR", __kmp_stg_parse_malloc_pool_incr,
      __kmp_stg_print_malloc_pool_incr, NULL, 0, 0},
+#if KMP_USE_BGET
+    {"KMP_MALLOC_KIND", __kmp_stg_parse_malloc_kind,
+     __kmp_stg_print_malloc_kind, NULL, 0, 0},
+#endif
+#if KMP_OS_LINUX
+    {"KMP_HUGE_PAGES", __kmp_stg_parse_huge_pages, __kmp_stg_print_huge_pages,
+     NULL, 0, 0},
+    {"KMP_HUGE_PAGES_STATS", __kmp_stg_parse_huge_pages_stats,
+     __kmp_stg_print_huge_pages_stats, NULL, 0, 0},
+    {"KMP_NUMA_LOCAL_THREADS", __kmp_stg_parse_numa_local_threads,
+     __kmp_stg_print_numa_local_threads, NULL, 0, 0},
+    {"KMP_OVERSUB_CHECK", __kmp_stg_parse_oversub_check,
+     __kmp_stg_print_oversub_check, NULL, 0, 0},
+#endif
     {"KMP_INIT_WAIT", __kmp_stg_parse_init_wait, __kmp_stg_print_init_wait,
      NULL, 0, 0},
     {"KMP_NEXT_WAIT", __kmp_stg_parse_next_wait, __kmp_stg_print_next_wait,
@@ -4606,6 +5163,10 @@ static kmp_setting_t __kmp_stg_table[] = {
      __kmp_stg_print_speculative_statsfile, NULL, 0, 0},
 #endif
 #endif // KMP_USE_ADAPTIVE_LOCKS
+#if KMP_USE_DYNAMIC_LOCK
+    {"KMP_AUTOTUNE_LOCK_PROPS", __kmp_stg_parse_autotune_lock_props,
+     __kmp_stg_print_autotune_lock_props, NULL, 0, 0},
+#endif
     {"KMP_PLACE_THREADS", __kmp_stg_parse_hw_subset, __kmp_stg_print_hw_subset,
      NULL, 0, 0},
     {"KMP_HW_SUBSET", __kmp_stg_parse_hw_subset, __kmp_stg_print_hw_subset,
@@ -4624,6 +5185,11 @@ static kmp_setting_t __kmp_stg_table[] = {
      __kmp_stg_print_omp_cancellation, NULL, 0, 0},
 #endif
 
+#if OMP_50_ENABLED
+    {"OMP_ALLOCATOR", __kmp_stg_parse_allocator, __kmp_stg_print_allocator,
+     NULL, 0, 0},
+#endif
+
 #if OMP_50_ENABLED && LIBOMP_OMPT_SUPPORT
     {"OMP_TOOL_LIBRARIES", __kmp_stg_parse_omp_tool_libraries,
      __kmp_stg_print_omp_tool_libraries, NULL, 0, 0},
@@ -4634,10 +5200,24 @@ static kmp_setting_t __kmp_stg_table[] = {
 static int const __kmp_stg_count =
     sizeof(__kmp_stg_table) / sizeof(kmp_setting_t);
 
+static int __kmp_stg_cmp(void const *_a, void const *_b);
+
+// Set once __kmp_stg_init() has sorted the table.
+static int __kmp_stg_sorted = 0;
+
 static inline kmp_setting_t *__kmp_stg_find(char const *name) {
 
   int i;
   if (name != NULL) {
+    if (__kmp_stg_sorted) {
+      // Every variable of the environment is looked up at startup, so search
+      // the sorted table instead of comparing against all of its entries.
+      kmp_setting_t key;
+      key.name = name;
+      return RCAST(kmp_setting_t *,
+                   bsearch(&key, __kmp_stg_table, __kmp_stg_count - 1,
+                           sizeof(kmp_setting_t), __kmp_stg_cmp));
+    }; // if
     for (i = 0; i < __kmp_stg_count; ++i) {
       if (strcmp(__kmp_stg_table[i].name, name) == 0) {
         return &__kmp_stg_table[i];
@@ -4674,6 +5254,7 @@ static void __kmp_stg_init(void) {
     // Sort table.
     qsort(__kmp_stg_table, __kmp_stg_count - 1, sizeof(kmp_setting_t),
           __kmp_stg_cmp);
+    __kmp_stg_sorted = 1;
 
     { // Initialize *_STACKSIZE data.
       kmp_setting_t *kmp_stacksize =
@@ -23,6 +23,9 @@
 #include <iomanip>
 #include <sstream>
 #include <stdlib.h> // for atexit
+#if KMP_OS_UNIX
+#include <dlfcn.h>
+#endif
 
 #define STRINGIZE2(x) #x
 #define STRINGIZE(x) STRINGIZE2(x)
@@ -140,6 +143,67 @@ std::string statistic::format(char unit, bool total) const {
   return result;
 }
 
+/* ************* kmp_stats_histogram member functions ************* */
+
+// Samples below SUB_BUCKETS have a bucket each. Above, the bucket is given by
+// the position of the most significant bit and the SUB_BITS bits after it.
+int kmp_stats_histogram::bucket(uint64_t sample) {
+  if (sample < SUB_BUCKETS)
+    return (int)sample;
+  int msb = 0;
+  for (int shift = 32; shift > 0; shift >>= 1)
+    if (sample >> (msb + shift))
+      msb += shift;
+  return (msb - SUB_BITS + 1) * SUB_BUCKETS +
+         (int)((sample >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+// The middle of the range of samples in the bucket.
+double kmp_stats_histogram::bucketValue(int b) {
+  if (b < SUB_BUCKETS)
+    return b;
+  int octave = b / SUB_BUCKETS;
+  double width = ldexp(1.0, octave - 1);
+  return (SUB_BUCKETS + b % SUB_BUCKETS) * width + width / 2;
+}
+
+void kmp_stats_histogram::reset() {
+  for (int b = 0; b < BUCKETS; b++)
+    counts[b] = 0;
+  sampleCount = 0;
+  minVal = std::numeric_limits<uint64_t>::max();
+  maxVal = 0;
+}
+
+kmp_stats_histogram &kmp_stats_histogram::
+operator+=(kmp_stats_histogram const &other) {
+  for (int b = 0; b < BUCKETS; b++)
+    counts[b] += other.counts[b];
+  sampleCount += other.sampleCount;
+  minVal = std::min(minVal, other.minVal);
+  maxVal = std::max(maxVal, other.maxVal);
+  return *this;
+}
+
+// The smallest sample (as the bucket middle) that at least the given percent
+// of the samples do not exceed.
+double kmp_stats_histogram::getPercentile(double percent) const {
+  if (sampleCount == 0)
+    return 0.0;
+  uint64_t rank = (uint64_t)ceil(percent / 100.0 * sampleCount);
+  if (rank < 1)
+    rank = 1;
+  uint64_t seen = 0;
+  int b;
+  for (b = 0; b < BUCKETS - 1; b++) {
+    seen += counts[b];
+    if (seen >= rank)
+      break;
+  }
+  double value = bucketValue(b);
+  return std::min(std::max(value, (double)minVal), (double)maxVal);
+}
+
 /* ************* explicitTimer member functions ************* */
 
 void explicitTimer::start(timer_e timerEnumValue) {
@@ -159,11 +223,16 @@ void explicitTimer::stop(timer_e timerEnumValue,
   tsc_tick_count finishTime = tsc_tick_count::now();
 
   // stat->addSample ((tsc_tick_count::now() - startTime).ticks());
-  stat->addSample(((finishTime - startTime) - totalPauseTime).ticks());
+  double ticks = ((finishTime - startTime) - totalPauseTime).ticks();
+  stat->addSample(ticks);
+
+  if (!stats_ptr)
+    stats_ptr = __kmp_stats_thread_ptr;
+  if (timeStat::histogram(timerEnumValue))
+    stats_ptr->getHistogram(timerEnumValue)
+        ->addSample(ticks > 0 ? (uint64_t)ticks : 0);
 
   if (timeStat::logEvent(timerEnumValue)) {
-    if (!stats_ptr)
-      stats_ptr = __kmp_stats_thread_ptr;
     stats_ptr->push_event(
         startTime.getValue() - __kmp_stats_start_time.getValue(),
         finishTime.getValue() - __kmp_stats_start_time.getValue(),
@@ -310,6 +379,30 @@ kmp_stats_list::iterator kmp_stats_list::end() {
   it.ptr = this;
   return it;
 }
+void kmp_stats_list::criticalAcquired(const void *crit, const char *psource,
+                                      tsc_tick_count start) {
+  tsc_tick_count now = tsc_tick_count::now();
+  kmp_critical_stats *stats = &_criticals[kmp_critical_key(crit, psource)];
+  stats->getWaitTime()->addSample((now - start).ticks());
+  _critical_holds.push_back(std::make_pair(stats, now));
+}
+void kmp_stats_list::criticalReleased() {
+  // Critical sections are properly nested, so the innermost one is released.
+  // The stack may be empty if the statistics were enabled while holding one.
+  if (_critical_holds.empty())
+    return;
+  std::pair<kmp_critical_stats *, tsc_tick_count> &hold =
+      _critical_holds.back();
+  hold.first->getHoldTime()->addSample(
+      (tsc_tick_count::now() - hold.second).ticks());
+  _critical_holds.pop_back();
+}
+void kmp_stats_list::resetCriticals() {
+  // Keep the entries, _critical_holds may point to them.
+  kmp_critical_stats_map::iterator it;
+  for (it = _criticals.begin(); it != _criticals.end(); it++)
+    it->second.reset();
+}
 int kmp_stats_list::size() {
   int retval;
   kmp_stats_list::iterator it;
@@ -350,10 +443,14 @@ kmp_stats_list *kmp_stats_list::iterator::operator*() const {
 
 /* *************  kmp_stats_output_module functions ************** */
 
+kmp_stats_output_module::output_format_e
+    kmp_stats_output_module::outputFormat =
+        kmp_stats_output_module::text_format;
 const char *kmp_stats_output_module::eventsFileName = NULL;
 const char *kmp_stats_output_module::plotFileName = NULL;
 int kmp_stats_output_module::printPerThreadFlag = 0;
 int kmp_stats_output_module::printPerThreadEventsFlag = 0;
+int kmp_stats_output_module::criticalStatsFlag = 0;
 
 // init() is called very near the beginning of execution time in the constructor
 // of __kmp_stats_global_output
@@ -363,6 +460,8 @@ void kmp_stats_output_module::init() {
   plotFileName = getenv("KMP_STATS_PLOT_FILE");
   char *threadStats = getenv("KMP_STATS_THREADS");
   char *threadEvents = getenv("KMP_STATS_EVENTS");
+  char *criticalStats = getenv("KMP_STATS_CRITICAL");
+  char *format = getenv("KMP_STATS_FORMAT");
 
   // set the stats output filenames based on environment variables and defaults
   if (statsFileName) {
@@ -390,6 +489,13 @@ void kmp_stats_output_module::init() {
   // , .t. , yes
   printPerThreadFlag = __kmp_str_match_true(threadStats);
   printPerThreadEventsFlag = __kmp_str_match_true(threadEvents);
+  criticalStatsFlag = __kmp_str_match_true(criticalStats);
+  if (format && __kmp_str_match("csv", 3, format))
+    outputFormat = csv_format;
+  else if (format && __kmp_str_match("json", 4, format))
+    outputFormat = json_format;
+  else
+    outputFormat = text_format;
 
   if (printPerThreadEventsFlag) {
     // assigns a color to each timer for printing
@@ -436,6 +542,27 @@ void kmp_stats_output_module::printTimerStats(FILE *statsOut,
   }
 }
 
+static const double statsPercentiles[] = {50.0, 99.0, 99.9};
+static const char *const statsPercentileNames[] = {"p50", "p99", "p999"};
+static const int numStatsPercentiles =
+    sizeof(statsPercentiles) / sizeof(statsPercentiles[0]);
+
+void kmp_stats_output_module::printPercentiles(
+    FILE *statsOut, kmp_stats_histogram *const *histograms) {
+  fprintf(statsOut, "\nPercentiles,                SampleCount,    p50,      "
+                    "  p99,      p999\n");
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1)) {
+    kmp_stats_histogram const *hist = histograms[s];
+    if (!hist)
+      continue;
+    std::string result = formatSI(hist->getCount(), 9, ' ');
+    for (int p = 0; p < numStatsPercentiles; p++)
+      result = result + std::string(", ") +
+               formatSI(hist->getPercentile(statsPercentiles[p]), 9, 'T');
+    fprintf(statsOut, "%-28s, %s\n", timeStat::name(s), result.c_str());
+  }
+}
+
 void kmp_stats_output_module::printCounterStats(FILE *statsOut,
                                                 statistic const *theStats) {
   fprintf(statsOut, "Counter,                 ThreadCount,    Min,      Mean,  "
@@ -459,6 +586,332 @@ void kmp_stats_output_module::printCounters(FILE *statsOut,
   }
 }
 
+// Name of a critical section for printing. Compilers name the lock object
+// after the critical section, recover the name from the symbol if possible.
+static std::string criticalName(const void *crit) {
+#if KMP_OS_UNIX
+  extern kmp_critical_name *__kmp_unnamed_critical_addr;
+  static const char prefix[] = ".gomp_critical_user_";
+  Dl_info info;
+
+  if (crit == __kmp_unnamed_critical_addr)
+    return "unnamed";
+  if (dladdr(crit, &info) && info.dli_sname && info.dli_saddr == crit &&
+      strncmp(info.dli_sname, prefix, sizeof(prefix) - 1) == 0) {
+    std::string name(info.dli_sname + sizeof(prefix) - 1);
+    if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".var") == 0)
+      name.erase(name.size() - 4);
+    return name.empty() ? "unnamed" : name;
+  }
+#endif
+  std::stringstream ss;
+  ss << crit;
+  return ss.str();
+}
+
+// Merged statistics of a critical section and the number of threads in it.
+typedef std::pair<kmp_critical_key, std::pair<kmp_critical_stats, int> >
+    critical_entry;
+
+static bool compareCriticalWait(const critical_entry &a,
+                                const critical_entry &b) {
+  return a.second.first.getWaitTime()->getTotal() >
+         b.second.first.getWaitTime()->getTotal();
+}
+
+// The critical sections of all threads, the most contended first.
+static void sortedCriticalStats(std::vector<critical_entry> &sorted) {
+  typedef std::map<kmp_critical_key, std::pair<kmp_critical_stats, int> >
+      merged_map;
+  merged_map merged;
+  kmp_stats_list::iterator it;
+
+  // Merge the per thread tables, counting the threads found in each entry.
+  for (it = __kmp_stats_list->begin(); it != __kmp_stats_list->end(); it++) {
+    kmp_critical_stats_map &criticals = (*it)->getCriticals();
+    kmp_critical_stats_map::iterator c;
+    for (c = criticals.begin(); c != criticals.end(); c++) {
+      if (c->second.getWaitTime()->getCount() == 0)
+        continue;
+      std::pair<kmp_critical_stats, int> &entry = merged[c->first];
+      entry.first += c->second;
+      entry.second++;
+    }
+  }
+
+  sorted.assign(merged.begin(), merged.end());
+  std::stable_sort(sorted.begin(), sorted.end(), compareCriticalWait);
+}
+
+// "name@file:line" of a critical section.
+static std::string criticalLabel(const kmp_critical_key &key) {
+  std::string name = criticalName(key.getCrit());
+  kmp_str_loc_t loc = __kmp_str_loc_init(key.getSource(), 0);
+  if (loc.file != NULL) {
+    std::stringstream ss;
+    ss << name << "@" << loc.file << ":" << loc.line;
+    name = ss.str();
+  }
+  __kmp_str_loc_free(&loc);
+  return name;
+}
+
+void kmp_stats_output_module::printCriticalStats(FILE *statsOut) {
+  std::vector<critical_entry> sorted;
+  sortedCriticalStats(sorted);
+
+  fprintf(statsOut, "\nCritical,                   ThreadCount, SampleCount, "
+                    "   Min,      Mean,       Max,     Total,        SD\n");
+  for (size_t i = 0; i < sorted.size(); i++) {
+    const kmp_critical_stats &stats = sorted[i].second.first;
+    std::string name = criticalLabel(sorted[i].first);
+    fprintf(statsOut, "%-28s, %s, %s\n", (name + "_wait").c_str(),
+            formatSI(sorted[i].second.second, 9, ' ').c_str(),
+            stats.getWaitTime()->format('T', true).c_str());
+    fprintf(statsOut, "%-28s, %s, %s\n", (name + "_hold").c_str(),
+            formatSI(sorted[i].second.second, 9, ' ').c_str(),
+            stats.getHoldTime()->format('T', true).c_str());
+  }
+}
+
+/* Machine readable output. Times are in ticks, like the samples; the header
+   gives the ticks per second where the nominal frequency is known. */
+
+static std::string csvString(const std::string &str) {
+  if (str.find_first_of(",\"\n") == std::string::npos)
+    return str;
+  std::string result = "\"";
+  for (size_t i = 0; i < str.size(); i++) {
+    if (str[i] == '"')
+      result += '"';
+    result += str[i];
+  }
+  return result + "\"";
+}
+
+static std::string jsonString(const std::string &str) {
+  std::string result = "\"";
+  for (size_t i = 0; i < str.size(); i++) {
+    char c = str[i];
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if ((unsigned char)c < 0x20) {
+      char buf[8];
+      KMP_SNPRINTF(buf, sizeof(buf), "\\u%04x", c);
+      result += buf;
+    } else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+// count, min, mean, max, total, sd of a statistic; zeros if it has no samples.
+static void statisticValues(statistic const *stat, double values[6]) {
+  bool empty = stat->getCount() == 0;
+  values[0] = (double)stat->getCount();
+  values[1] = empty ? 0.0 : stat->getMin();
+  values[2] = empty ? 0.0 : stat->getMean();
+  values[3] = empty ? 0.0 : stat->getMax();
+  values[4] = empty ? 0.0 : stat->getTotal();
+  values[5] = empty ? 0.0 : stat->getSD();
+}
+
+static void printCSVRow(FILE *statsOut, const char *thread, const char *kind,
+                        const std::string &name, statistic const *stat) {
+  double v[6];
+  statisticValues(stat, v);
+  fprintf(statsOut, "%s,%s,%s,%.0f,%.15g,%.15g,%.15g,%.15g,%.15g\n", thread,
+          kind, csvString(name).c_str(), v[0], v[1], v[2], v[3], v[4], v[5]);
+}
+
+static void printCSVCounter(FILE *statsOut, const char *thread,
+                            const char *name, uint64_t value) {
+  statistic stat;
+  stat.addSample((double)value);
+  printCSVRow(statsOut, thread, "counter", name, &stat);
+}
+
+// A percentile is a row of its own, with the value in all the columns but the
+// count, so that it compares like the totals.
+static void printCSVPercentiles(FILE *statsOut, const char *thread,
+                                const char *name,
+                                kmp_stats_histogram const *hist) {
+  for (int p = 0; p < numStatsPercentiles; p++) {
+    double value = hist->getPercentile(statsPercentiles[p]);
+    fprintf(statsOut, "%s,%s,%s,%llu,%.15g,%.15g,%.15g,%.15g,0\n", thread,
+            statsPercentileNames[p], csvString(name).c_str(),
+            (unsigned long long)hist->getCount(), value, value, value, value);
+  }
+}
+
+static void printJSONPercentiles(FILE *statsOut, const char *name,
+                                 kmp_stats_histogram const *hist, bool first) {
+  fprintf(statsOut, "%s\n      %s: {\"count\": %llu", first ? "" : ",",
+          jsonString(name).c_str(), (unsigned long long)hist->getCount());
+  for (int p = 0; p < numStatsPercentiles; p++)
+    fprintf(statsOut, ", \"%s\": %.15g", statsPercentileNames[p],
+            hist->getPercentile(statsPercentiles[p]));
+  fprintf(statsOut, "}");
+}
+
+static void printJSONStatistic(FILE *statsOut, const std::string &name,
+                               statistic const *stat, bool first) {
+  double v[6];
+  statisticValues(stat, v);
+  fprintf(statsOut, "%s\n      %s: {\"count\": %.0f, \"min\": %.15g, "
+                    "\"mean\": %.15g, \"max\": %.15g, \"total\": %.15g, "
+                    "\"sd\": %.15g}",
+          first ? "" : ",", jsonString(name).c_str(), v[0], v[1], v[2], v[3],
+          v[4], v[5]);
+}
+
+// The values of the header of the text output.
+static void runInfo(std::string &time, std::string &host, std::string &cpu,
+                    double &ticksPerSecond) {
+  std::time_t now = std::time(0);
+  char buffer[80];
+
+  std::strftime(&buffer[0], sizeof(buffer), "%c", std::localtime(&now));
+  time = buffer;
+  host = gethostname(&buffer[0], sizeof(buffer)) == 0 ? buffer : "";
+  cpu = "";
+  ticksPerSecond = 0.0;
+#if KMP_ARCH_X86 || KMP_ARCH_X86_64
+  cpu = &__kmp_cpuinfo.name[0];
+  ticksPerSecond = (double)__kmp_cpuinfo.frequency;
+#if KMP_OS_UNIX
+  if (ticksPerSecond == 0.0)
+    ticksPerSecond = (double)__kmp_ticks_per_msec * 1000.0;
+#endif
+#endif
+}
+
+void kmp_stats_output_module::printCSVStats(FILE *statsOut,
+                                            const char *heading,
+                                            statistic const *allStats,
+                                            statistic const *totalStats,
+                                            statistic const *allCounters,
+                                            kmp_stats_histogram *const *allHistograms) {
+  std::string time, host, cpu;
+  double ticksPerSecond;
+  runInfo(time, host, cpu, ticksPerSecond);
+  fprintf(statsOut, "# %s\n# Time of run: %s\n# Hostname: %s\n# CPU: %s\n"
+                    "# Ticks per second: %.0f\n",
+          heading, time.c_str(), host.c_str(), cpu.c_str(), ticksPerSecond);
+  fprintf(statsOut, "thread,kind,name,count,min,mean,max,total,sd\n");
+
+  kmp_stats_list::iterator it;
+  for (it = __kmp_stats_list->begin(); it != __kmp_stats_list->end(); it++) {
+    char thread[16];
+    KMP_SNPRINTF(thread, sizeof(thread), "%d", (*it)->getGtid());
+    for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1))
+      printCSVRow(statsOut, thread, "timer", timeStat::name(s),
+                  (*it)->getTimer(s));
+    for (counter_e c = counter_e(0); c < COUNTER_LAST; c = counter_e(c + 1))
+      printCSVCounter(statsOut, thread, counter::name(c),
+                      (*it)->getCounter(c)->getValue());
+  }
+
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1))
+    printCSVRow(statsOut, "all", "timer", timeStat::name(s), &allStats[s]);
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1))
+    if (!timeStat::noTotal(s))
+      printCSVRow(statsOut, "all", "total", timeStat::name(s), &totalStats[s]);
+  for (counter_e c = counter_e(0); c < COUNTER_LAST; c = counter_e(c + 1))
+    printCSVRow(statsOut, "all", "counter", counter::name(c), &allCounters[c]);
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1))
+    if (allHistograms[s])
+      printCSVPercentiles(statsOut, "all", timeStat::name(s), allHistograms[s]);
+
+  if (criticalStatsEnabled()) {
+    std::vector<critical_entry> sorted;
+    sortedCriticalStats(sorted);
+    for (size_t i = 0; i < sorted.size(); i++) {
+      std::string name = criticalLabel(sorted[i].first);
+      printCSVRow(statsOut, "all", "critical_wait", name,
+                  sorted[i].second.first.getWaitTime());
+      printCSVRow(statsOut, "all", "critical_hold", name,
+                  sorted[i].second.first.getHoldTime());
+    }
+  }
+}
+
+void kmp_stats_output_module::printJSONStats(FILE *statsOut,
+                                             const char *heading,
+                                             statistic const *allStats,
+                                             statistic const *totalStats,
+                                             statistic const *allCounters,
+                                             kmp_stats_histogram *const *allHistograms) {
+  std::string time, host, cpu;
+  double ticksPerSecond;
+  runInfo(time, host, cpu, ticksPerSecond);
+  fprintf(statsOut, "{\n  \"heading\": %s,\n  \"time\": %s,\n"
+                    "  \"hostname\": %s,\n  \"cpu\": %s,\n"
+                    "  \"ticks_per_second\": %.0f,\n  \"threads\": [",
+          jsonString(heading).c_str(), jsonString(time).c_str(),
+          jsonString(host).c_str(), jsonString(cpu).c_str(), ticksPerSecond);
+
+  kmp_stats_list::iterator it;
+  bool firstThread = true;
+  for (it = __kmp_stats_list->begin(); it != __kmp_stats_list->end(); it++) {
+    fprintf(statsOut, "%s\n    {\"gtid\": %d,\n     \"timers\": {",
+            firstThread ? "" : ",", (*it)->getGtid());
+    firstThread = false;
+    for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1))
+      printJSONStatistic(statsOut, timeStat::name(s), (*it)->getTimer(s),
+                         s == 0);
+    fprintf(statsOut, "},\n     \"counters\": {");
+    for (counter_e c = counter_e(0); c < COUNTER_LAST; c = counter_e(c + 1))
+      fprintf(statsOut, "%s\n      %s: %llu", c == 0 ? "" : ",",
+              jsonString(counter::name(c)).c_str(),
+              (unsigned long long)(*it)->getCounter(c)->getValue());
+    fprintf(statsOut, "}}");
+  }
+
+  fprintf(statsOut, "],\n  \"aggregate\": {\n    \"timers\": {");
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1))
+    printJSONStatistic(statsOut, timeStat::name(s), &allStats[s], s == 0);
+  fprintf(statsOut, "},\n    \"totals\": {");
+  bool first = true;
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1)) {
+    if (timeStat::noTotal(s))
+      continue;
+    printJSONStatistic(statsOut, timeStat::name(s), &totalStats[s], first);
+    first = false;
+  }
+  fprintf(statsOut, "},\n    \"counters\": {");
+  for (counter_e c = counter_e(0); c < COUNTER_LAST; c = counter_e(c + 1))
+    printJSONStatistic(statsOut, counter::name(c), &allCounters[c], c == 0);
+  fprintf(statsOut, "},\n    \"percentiles\": {");
+  first = true;
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1)) {
+    if (!allHistograms[s])
+      continue;
+    printJSONPercentiles(statsOut, timeStat::name(s), allHistograms[s], first);
+    first = false;
+  }
+  fprintf(statsOut, "}},\n  \"criticals\": [");
+
+  if (criticalStatsEnabled()) {
+    std::vector<critical_entry> sorted;
+    sortedCriticalStats(sorted);
+    for (size_t i = 0; i < sorted.size(); i++) {
+      fprintf(statsOut, "%s\n    {\"name\": %s, \"threads\": %d, \"times\": {",
+              i == 0 ? "" : ",",
+              jsonString(criticalLabel(sorted[i].first)).c_str(),
+              sorted[i].second.second);
+      printJSONStatistic(statsOut, "wait", sorted[i].second.first.getWaitTime(),
+                         true);
+      printJSONStatistic(statsOut, "hold", sorted[i].second.first.getHoldTime(),
+                         false);
+      fprintf(statsOut, "}}");
+    }
+  }
+  fprintf(statsOut, "]\n}\n");
+}
+
 void kmp_stats_output_module::printEvents(FILE *eventsOut,
                                           kmp_stats_event_vector *theEvents,
                                           int gtid) {
@@ -576,15 +1029,15 @@ void kmp_stats_output_module::printHeaderInfo(FILE *statsOut) {
 }
 
 void kmp_stats_output_module::outputStats(const char *heading) {
-  // Stop all the explicit timers in all threads
-  // Do this before declaring the local statistics because thay have
-  // constructors so will take time to create.
-  windupExplicitTimers();
-
   statistic allStats[TIMER_LAST];
   statistic totalStats[TIMER_LAST]; /* Synthesized, cross threads versions of
                                        normal timer stats */
   statistic allCounters[COUNTER_LAST];
+  kmp_stats_histogram *allHistograms[TIMER_LAST]; // merged across threads
+
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1))
+    allHistograms[s] =
+        timeStat::histogram(s) ? new kmp_stats_histogram() : NULL;
 
   FILE *statsOut =
       !outputFileName.empty() ? fopen(outputFileName.c_str(), "a+") : stderr;
@@ -596,14 +1049,16 @@ void kmp_stats_output_module::outputStats(const char *heading) {
     eventsOut = fopen(eventsFileName, "w+");
   }
 
-  printHeaderInfo(statsOut);
-  fprintf(statsOut, "%s\n", heading);
+  if (outputFormat == text_format) {
+    printHeaderInfo(statsOut);
+    fprintf(statsOut, "%s\n", heading);
+  }
   // Accumulate across threads.
   kmp_stats_list::iterator it;
   for (it = __kmp_stats_list->begin(); it != __kmp_stats_list->end(); it++) {
     int t = (*it)->getGtid();
     // Output per thread stats if requested.
-    if (printPerThreadFlag) {
+    if (printPerThreadFlag && outputFormat == text_format) {
       fprintf(statsOut, "Thread %d\n", t);
       printTimerStats(statsOut, (*it)->getTimers(), 0);
       printCounters(statsOut, (*it)->getCounters());
@@ -632,6 +1087,9 @@ void kmp_stats_output_module::outputStats(const char *heading) {
       // Add Total stats for timers that are valid in more than one thread
       if (!timeStat::noTotal(s))
         totalStats[s].addSample(threadStat->getTotal());
+
+      if (allHistograms[s])
+        *allHistograms[s] += *(*it)->getHistogram(s);
     }
 
     // Accumulate counters.
@@ -647,13 +1105,27 @@ void kmp_stats_output_module::outputStats(const char *heading) {
     fclose(eventsOut);
   }
 
-  fprintf(statsOut, "Aggregate for all threads\n");
-  printTimerStats(statsOut, &allStats[0], &totalStats[0]);
-  fprintf(statsOut, "\n");
-  printCounterStats(statsOut, &allCounters[0]);
+  if (outputFormat == csv_format) {
+    printCSVStats(statsOut, heading, &allStats[0], &totalStats[0],
+                  &allCounters[0], &allHistograms[0]);
+  } else if (outputFormat == json_format) {
+    printJSONStats(statsOut, heading, &allStats[0], &totalStats[0],
+                   &allCounters[0], &allHistograms[0]);
+  } else {
+    fprintf(statsOut, "Aggregate for all threads\n");
+    printTimerStats(statsOut, &allStats[0], &totalStats[0]);
+    printPercentiles(statsOut, &allHistograms[0]);
+    fprintf(statsOut, "\n");
+    printCounterStats(statsOut, &allCounters[0]);
+    if (criticalStatsEnabled())
+      printCriticalStats(statsOut);
+  }
 
   if (statsOut != stderr)
     fclose(statsOut);
+
+  for (timer_e s = timer_e(0); s < TIMER_LAST; s = timer_e(s + 1))
+    delete allHistograms[s];
 }
 
 /* *************  exported C functions ************** */
@@ -669,32 +1141,66 @@ void __kmp_reset_stats() {
     counter *counters = (*it)->getCounters();
     explicitTimer *eTimers = (*it)->getExplicitTimers();
 
-    for (int t = 0; t < TIMER_LAST; t++)
+    for (int t = 0; t < TIMER_LAST; t++) {
       timers[t].reset();
+      if ((*it)->getHistogram(timer_e(t)))
+        (*it)->getHistogram(timer_e(t))->reset();
+    }
 
     for (int c = 0; c < COUNTER_LAST; c++)
       counters[c].reset();
 
+    // The timers that run go on from now, so that the thread time is still
+    // partitioned after the reset.
     for (int t = 0; t < EXPLICIT_TIMER_LAST; t++)
-      eTimers[t].reset();
+      eTimers[t].restart();
 
     // reset the event vector so all previous events are "erased"
     (*it)->resetEventVector();
+
+    (*it)->resetCriticals();
   }
 }
 
-// This function will reset all stats and stop all threads' explicit timers if
-// they haven't been stopped already.
+// Print the stats and reset them. The explicit timers that are running go on,
+// only __kmp_accumulate_stats_at_exit() stops them.
 void __kmp_output_stats(const char *heading) {
   __kmp_stats_global_output->outputStats(heading);
   __kmp_reset_stats();
 }
 
+/* kmp_dump_stats() and kmp_clear_stats(): the stats of the other threads are
+   read and reset without synchronization, so this is only done while no
+   parallel region is active. Holding __kmp_forkjoin_lock keeps the roots from
+   forking meanwhile. A null heading resets the stats without printing them.
+   Returns FALSE, having done nothing, if a parallel region is active. */
+int __kmp_stats_on_demand(const char *heading) {
+  int i;
+  __kmp_acquire_bootstrap_lock(&__kmp_forkjoin_lock);
+  for (i = 0; i < __kmp_threads_capacity; i++) {
+    if (__kmp_root[i] && __kmp_root[i]->r.r_active)
+      break;
+  }
+  if (i < __kmp_threads_capacity) {
+    __kmp_release_bootstrap_lock(&__kmp_forkjoin_lock);
+    return FALSE;
+  }
+  if (heading)
+    __kmp_output_stats(heading);
+  else
+    __kmp_reset_stats();
+  __kmp_release_bootstrap_lock(&__kmp_forkjoin_lock);
+  return TRUE;
+}
+
 void __kmp_accumulate_stats_at_exit(void) {
   // Only do this once.
   if (KMP_XCHG_FIXED32(&statsPrinted, 1) != 0)
     return;
 
+  // Stop all the explicit timers in all threads. Only at exit: the timer
+  // stacks of threads that still run must stay intact for an output on demand.
+  kmp_stats_output_module::windupExplicitTimers();
   __kmp_output_stats("Statistics on exit");
 }
 
@@ -29,6 +29,7 @@
 
 #include "kmp_stats_timing.h"
 #include <limits>
+#include <map>
 #include <math.h>
 #include <new> // placement new
 #include <stdint.h>
@@ -51,8 +52,10 @@ enum stats_flags_e {
   noUnits =
       1 << 2, //!< statistic doesn't need units printed next to it in output
   notInMaster = 1 << 3, //!< statistic is valid only for non-master threads
-  logEvent = 1 << 4 //!< statistic can be logged on the event timeline when
+  logEvent = 1 << 4, //!< statistic can be logged on the event timeline when
   //! KMP_STATS_EVENTS is on (valid only for timers)
+  histogram = 1 << 5 //!< the samples are also kept in a histogram, so that the
+  //! percentiles can be printed (valid only for timers)
 };
 
 /*!
@@ -132,14 +135,20 @@ enum stats_state_e {
     macro (FOR_static_scheduling, 0, arg)                                      \
     macro (FOR_dynamic_scheduling, 0, arg)                                     \
     macro (OMP_critical, 0, arg)                                               \
-    macro (OMP_critical_wait, 0, arg)                                          \
+    macro (OMP_critical_wait, stats_flags_e::histogram, arg)                   \
+    macro (OMP_lock_wait, stats_flags_e::histogram, arg)                       \
     macro (OMP_single, 0, arg)                                                 \
     macro (OMP_master, 0, arg)                                                 \
     macro (OMP_idle, stats_flags_e::logEvent, arg)                             \
-    macro (OMP_plain_barrier, stats_flags_e::logEvent, arg)                    \
-    macro (OMP_fork_barrier, stats_flags_e::logEvent, arg)                     \
-    macro (OMP_join_barrier, stats_flags_e::logEvent, arg)                     \
+    macro (OMP_plain_barrier,                                                  \
+           stats_flags_e::logEvent | stats_flags_e::histogram, arg)            \
+    macro (OMP_fork_barrier,                                                   \
+           stats_flags_e::logEvent | stats_flags_e::histogram, arg)            \
+    macro (OMP_join_barrier,                                                   \
+           stats_flags_e::logEvent | stats_flags_e::histogram, arg)            \
+    macro (OMP_fork_call, stats_flags_e::histogram, arg)                       \
     macro (OMP_parallel, stats_flags_e::logEvent, arg)                         \
+    macro (OMP_taskwait, stats_flags_e::histogram, arg)                        \
     macro (OMP_task_immediate, 0, arg)                                         \
     macro (OMP_task_taskwait, 0, arg)                                          \
     macro (OMP_task_taskyield, 0, arg)                                         \
@@ -176,7 +185,11 @@ enum stats_state_e {
 // OMP_plain_barrier      -- Time spent in a barrier construct
 // OMP_fork_join_barrier  -- Time spent in a the fork-join barrier surrounding a
 //                           parallel region
+// OMP_fork_call          -- Time the master spends starting a parallel region
+//                           before it runs its own part of it
 // OMP_parallel           -- Time spent inside a parallel construct
+// OMP_taskwait           -- Time spent waiting in a taskwait construct, less
+//                           the tasks executed meanwhile
 // OMP_task_immediate     -- Time spent executing non-deferred tasks
 // OMP_task_taskwait      -- Time spent executing tasks inside a taskwait
 //                           construct
@@ -189,6 +202,9 @@ enum stats_state_e {
 //                           construct
 // OMP_single             -- Time spent executing a "single" region
 // OMP_master             -- Time spent executing a "master" region
+// OMP_critical_wait      -- Time spent waiting to enter a critical section
+// OMP_lock_wait          -- Time spent acquiring a lock in omp_set_lock and
+//                           omp_set_nest_lock
 // OMP_set_numthreads     -- Values passed to omp_set_num_threads
 // OMP_PARALLEL_args      -- Number of arguments passed to a parallel region
 // FOR_static_iterations  -- Number of available parallel chunks of work in a
@@ -216,8 +232,8 @@ enum stats_state_e {
 // KMP_hyper_gather       -- time in __kmp_hyper_barrier_gather
 // KMP_hyper_release      -- time in __kmp_hyper_barrier_release
 #define KMP_FOREACH_DEVELOPER_TIMER(macro, arg)                                \
-  macro(KMP_fork_call, 0, arg) macro(KMP_join_call, 0, arg) macro(             \
-      KMP_end_split_barrier, 0, arg) macro(KMP_hier_gather, 0, arg)            \
+  macro(KMP_join_call, 0, arg) macro(KMP_end_split_barrier, 0, arg)            \
+      macro(KMP_hier_gather, 0, arg)                                           \
       macro(KMP_hier_release, 0, arg) macro(KMP_hyper_gather, 0, arg)          \
           macro(KMP_hyper_release, 0, arg) macro(KMP_linear_gather, 0, arg)    \
               macro(KMP_linear_release, 0, arg) macro(KMP_tree_gather, 0, arg) \
@@ -310,6 +326,39 @@ public:
   std::string format(char unit, bool total = false) const;
 };
 
+/* A log-linear histogram of samples in the manner of HdrHistogram. Each power
+   of two is split in 16 buckets, so a percentile is off by at most 1/16 of its
+   value whatever the range of the samples, with a fixed amount of memory and
+   a few instructions per sample. Histograms add up like the statistics. */
+class kmp_stats_histogram {
+  static const int SUB_BITS = 4;
+  static const int SUB_BUCKETS = 1 << SUB_BITS;
+  static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+  uint64_t counts[BUCKETS];
+  uint64_t sampleCount;
+  uint64_t minVal;
+  uint64_t maxVal;
+
+  static int bucket(uint64_t sample);
+  static double bucketValue(int b);
+
+public:
+  kmp_stats_histogram() { reset(); }
+
+  uint64_t getCount() const { return sampleCount; }
+  double getPercentile(double percent) const;
+
+  void reset();
+  void addSample(uint64_t sample) {
+    counts[bucket(sample)]++;
+    sampleCount++;
+    minVal = sample < minVal ? sample : minVal;
+    maxVal = sample > maxVal ? sample : maxVal;
+  }
+  kmp_stats_histogram &operator+=(kmp_stats_histogram const &other);
+};
+
 struct statInfo {
   const char *name;
   uint32_t flags;
@@ -336,6 +385,9 @@ public:
   static bool logEvent(timer_e e) {
     return timerInfo[e].flags & stats_flags_e::logEvent;
   }
+  static bool histogram(timer_e e) {
+    return timerInfo[e].flags & stats_flags_e::histogram;
+  }
   static void clearEventFlags() {
     for (int i = 0; i < TIMER_LAST; i++) {
       timerInfo[i].flags &= (~(stats_flags_e::logEvent));
@@ -368,6 +420,14 @@ public:
     pauseStartTime = 0;
     totalPauseTime = 0;
   }
+  // A running (or paused) timer goes on from now, as if it started now.
+  void restart() {
+    if (startTime.getValue() == 0)
+      return;
+    startTime = tsc_tick_count::now();
+    pauseStartTime = startTime;
+    totalPauseTime = 0;
+  }
 };
 
 // Where all you need is to time a block, this is enough.
@@ -567,6 +627,53 @@ public:
   kmp_stats_event &at(int index) { return events[index]; }
 };
 
+/* ****************************************************************
+    Classes to hold per critical section statistics
+
+    These are only collected when KMP_STATS_CRITICAL is on. Every thread keeps
+    its own table keyed by the critical section name (the address of its
+    kmp_critical_name) and the source location of the construct, so recording
+    needs no synchronization. The tables are merged when the statistics are
+    printed; the number of tables holding a key is the number of distinct
+    threads that entered that critical section.
+**************************************************************** */
+class kmp_critical_key {
+  const void *crit;
+  const char *psource;
+
+public:
+  kmp_critical_key(const void *c, const char *p) : crit(c), psource(p) {}
+  const void *getCrit() const { return crit; }
+  const char *getSource() const { return psource; }
+  bool operator<(const kmp_critical_key &rhs) const {
+    if (crit != rhs.crit)
+      return std::less<const void *>()(crit, rhs.crit);
+    return std::less<const char *>()(psource, rhs.psource);
+  }
+};
+
+class kmp_critical_stats {
+  statistic waitTime; // ticks spent acquiring the critical section lock
+  statistic holdTime; // ticks the critical section lock was held
+
+public:
+  statistic *getWaitTime() { return &waitTime; }
+  statistic *getHoldTime() { return &holdTime; }
+  const statistic *getWaitTime() const { return &waitTime; }
+  const statistic *getHoldTime() const { return &holdTime; }
+  void reset() {
+    waitTime.reset();
+    holdTime.reset();
+  }
+  kmp_critical_stats &operator+=(const kmp_critical_stats &other) {
+    waitTime += other.waitTime;
+    holdTime += other.holdTime;
+    return *this;
+  }
+};
+
+typedef std::map<kmp_critical_key, kmp_critical_stats> kmp_critical_stats_map;
+
 /* ****************************************************************
     Class to implement a doubly-linked, circular, statistics list
 
@@ -581,7 +688,8 @@ public:
     The second node corresponds to thread 1's statistics and so on...
 
     Each node has a _timers, _counters, and _explicitTimers array to hold that
-    thread's statistics. The _explicitTimers point to the correct _timer and
+    thread's statistics, and a histogram for each timer with the histogram
+    flag. The _explicitTimers point to the correct _timer and
     update its statistics at every stop() call. The explicitTimers' pointers are
     set up in the constructor. Each node also has an event vector to hold that
     thread's timing events. The event vector expands as necessary and records
@@ -597,11 +705,15 @@ public:
 class kmp_stats_list {
   int gtid;
   timeStat _timers[TIMER_LAST + 1];
+  kmp_stats_histogram *_histograms[TIMER_LAST + 1];
   counter _counters[COUNTER_LAST + 1];
   explicitTimer _explicitTimers[EXPLICIT_TIMER_LAST + 1];
   partitionedTimers _partitionedTimers;
   int _nestLevel; // one per thread
   kmp_stats_event_vector _event_vector;
+  kmp_critical_stats_map _criticals;
+  // Critical sections currently held by the thread and their acquire time.
+  std::vector<std::pair<kmp_critical_stats *, tsc_tick_count> > _critical_holds;
   kmp_stats_list *next;
   kmp_stats_list *prev;
   stats_state_e state;
@@ -617,9 +729,23 @@ public:
                                getExplicitTimer(EXPLICIT_TIMER_##name));
     KMP_FOREACH_EXPLICIT_TIMER(doInit, 0);
 #undef doInit
+    for (int t = 0; t <= TIMER_LAST; t++) {
+      _histograms[t] = NULL;
+      if (t < TIMER_LAST && timeStat::histogram(timer_e(t)))
+        _histograms[t] = new (__kmp_allocate(sizeof(kmp_stats_histogram)))
+            kmp_stats_histogram();
+    }
+  }
+  ~kmp_stats_list() {
+    for (int t = 0; t < TIMER_LAST; t++)
+      if (_histograms[t])
+        __kmp_free(_histograms[t]);
   }
-  ~kmp_stats_list() {}
   inline timeStat *getTimer(timer_e idx) { return &_timers[idx]; }
+  // NULL unless the timer has the histogram flag.
+  inline kmp_stats_histogram *getHistogram(timer_e idx) {
+    return _histograms[idx];
+  }
   inline counter *getCounter(counter_e idx) { return &_counters[idx]; }
   inline explicitTimer *getExplicitTimer(explicit_timer_e idx) {
     return &_explicitTimers[idx];
@@ -632,6 +758,11 @@ public:
   inline explicitTimer *getExplicitTimers() { return _explicitTimers; }
   inline kmp_stats_event_vector &getEventVector() { return _event_vector; }
   inline void resetEventVector() { _event_vector.reset(); }
+  inline kmp_critical_stats_map &getCriticals() { return _criticals; }
+  void criticalAcquired(const void *crit, const char *psource,
+                        tsc_tick_count start);
+  void criticalReleased();
+  void resetCriticals();
   inline void incrementNestValue() { _nestLevel++; }
   inline int getNestValue() { return _nestLevel; }
   inline void decrementNestValue() { _nestLevel--; }
@@ -699,6 +830,8 @@ public:
                        events
    KMP_STATS_EVENTS_FILE -- if set, all events are outputted to this file,
                             otherwise, output is sent to "events.dat"
+   KMP_STATS_CRITICAL -- if set to "on", then record wait and hold times per
+                         critical section and print them with the statistics
 **************************************************************** */
 class kmp_stats_output_module {
 
@@ -709,12 +842,18 @@ public:
     float b;
   };
 
+  // KMP_STATS_FORMAT: the human readable tables, or every timer and counter
+  // per thread and aggregated for the tools (see tools/stats-diff.pl).
+  enum output_format_e { text_format, csv_format, json_format };
+
 private:
   std::string outputFileName;
+  static output_format_e outputFormat;
   static const char *eventsFileName;
   static const char *plotFileName;
   static int printPerThreadFlag;
   static int printPerThreadEventsFlag;
+  static int criticalStatsFlag;
   static const rgb_color globalColorArray[];
   static rgb_color timerColorInfo[];
 
@@ -726,15 +865,29 @@ private:
                               statistic const *totalStats);
   static void printCounterStats(FILE *statsOut, statistic const *theStats);
   static void printCounters(FILE *statsOut, counter const *theCounters);
+  static void printCriticalStats(FILE *statsOut);
+  static void printPercentiles(FILE *statsOut,
+                               kmp_stats_histogram *const *histograms);
+  static void printCSVStats(FILE *statsOut, const char *heading,
+                            statistic const *allStats,
+                            statistic const *totalStats,
+                            statistic const *allCounters,
+                            kmp_stats_histogram *const *allHistograms);
+  static void printJSONStats(FILE *statsOut, const char *heading,
+                             statistic const *allStats,
+                             statistic const *totalStats,
+                             statistic const *allCounters,
+                             kmp_stats_histogram *const *allHistograms);
   static void printEvents(FILE *eventsOut, kmp_stats_event_vector *theEvents,
                           int gtid);
   static rgb_color getEventColor(timer_e e) { return timerColorInfo[e]; }
-  static void windupExplicitTimers();
   bool eventPrintingEnabled() const { return printPerThreadEventsFlag; }
 
 public:
   kmp_stats_output_module() { init(); }
   void outputStats(const char *heading);
+  static void windupExplicitTimers();
+  static bool criticalStatsEnabled() { return criticalStatsFlag; }
 };
 
 #ifdef __cplusplus
@@ -744,6 +897,7 @@ void __kmp_stats_init();
 void __kmp_stats_fini();
 void __kmp_reset_stats();
 void __kmp_output_stats(const char *);
+int __kmp_stats_on_demand(const char *);
 void __kmp_accumulate_stats_at_exit(void);
 // thread local pointer to stats node within list
 extern __thread kmp_stats_list *__kmp_stats_thread_ptr;
@@ -897,12 +1051,40 @@ extern kmp_stats_output_module __kmp_stats_output;
 /*!
  * \brief resets all stats (counters to 0, timers to 0 elapsed ticks)
  *
- * \details Reset all stats for all threads.
+ * \details Reset all stats for all threads. The timers that are running go on
+ * as if they started at the reset.
  *
  * @ingroup STATS_GATHERING
 */
 #define KMP_RESET_STATS() __kmp_reset_stats()
 
+/*!
+ * \brief Starts timing the acquisition of a critical section.
+ *
+ * @param start name of the variable which holds the start time stamp
+ *
+ * \details KMP_CRITICAL_STATS_ACQUIRING(start) must be followed by
+ * KMP_CRITICAL_STATS_ACQUIRED(start, loc, crit) once the lock is held and by
+ * KMP_CRITICAL_STATS_RELEASED() when the lock is released. Nothing is recorded
+ * unless KMP_STATS_CRITICAL is on.
+ *
+ * @ingroup STATS_GATHERING
+*/
+#define KMP_CRITICAL_STATS_ACQUIRING(start)                                    \
+  int64_t start = kmp_stats_output_module::criticalStatsEnabled()              \
+                      ? tsc_tick_count::now().getValue()                       \
+                      : 0
+
+#define KMP_CRITICAL_STATS_ACQUIRED(start, loc, crit)                          \
+  ((start) ? __kmp_stats_thread_ptr->criticalAcquired(                         \
+                 (crit), (loc) ? (loc)->psource : NULL, (start))               \
+           : (void)0)
+
+#define KMP_CRITICAL_STATS_RELEASED()                                          \
+  (kmp_stats_output_module::criticalStatsEnabled()                             \
+       ? __kmp_stats_thread_ptr->criticalReleased()                            \
+       : (void)0)
+
 #if (KMP_DEVELOPER_STATS)
 #define KMP_TIME_DEVELOPER_BLOCK(n) KMP_TIME_BLOCK(n)
 #define KMP_COUNT_DEVELOPER_VALUE(n, v) KMP_COUNT_VALUE(n, v)
@@ -931,6 +1113,9 @@ extern kmp_stats_output_module __kmp_stats_output;
 
 #define KMP_OUTPUT_STATS(heading_string) ((void)0)
 #define KMP_RESET_STATS() ((void)0)
+#define KMP_CRITICAL_STATS_ACQUIRING(start) ((void)0)
+#define KMP_CRITICAL_STATS_ACQUIRED(start, loc, crit) ((void)0)
+#define KMP_CRITICAL_STATS_RELEASED() ((void)0)
 
 #define KMP_TIME_DEVELOPER_BLOCK(n) ((void)0)
 #define KMP_COUNT_DEVELOPER_VALUE(n, v) ((void)0)
@@ -226,6 +226,20 @@ void __kmp_str_buf_print_size(kmp_str_buf_t *buf, size_t size) {
   __kmp_str_buf_print(buf, "%" KMP_SIZE_T_SPEC "%s", size, names[u]);
 } // __kmp_str_buf_print_size
 
+void __kmp_str_buf_write(kmp_str_buf_t const *buffer, char const *file) {
+  FILE *out = stderr;
+  if (file != NULL) {
+    out = fopen(file, "w");
+    if (out == NULL)
+      out = stderr;
+  }
+  fputs(buffer->str, out);
+  if (out != stderr)
+    fclose(out);
+  else
+    fflush(out);
+} // __kmp_str_buf_write
+
 void __kmp_str_fname_init(kmp_str_fname_t *fname, char const *path) {
   fname->path = NULL;
   fname->dir = NULL;
@@ -334,6 +348,15 @@ void __kmp_str_loc_free(kmp_str_loc_t *loc) {
   loc->func = NULL;
 } // kmp_str_loc_free
 
+void __kmp_str_buf_print_loc(kmp_str_buf_t *buffer, char const *psource) {
+  kmp_str_loc_t loc = __kmp_str_loc_init(psource, 0);
+  if (loc.file == NULL || strcmp(loc.file, "unknown") == 0)
+    __kmp_str_buf_print(buffer, "unknown");
+  else
+    __kmp_str_buf_print(buffer, "%s (%s:%d)", loc.func, loc.file, loc.line);
+  __kmp_str_loc_free(&loc);
+} // __kmp_str_buf_print_loc
+
 /* This function is intended to compare file names. On Windows* OS file names
    are case-insensitive, so functions performs case-insensitive comparison. On
    Linux* OS it performs case-sensitive comparison. Note: The function returns
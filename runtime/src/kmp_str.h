@@ -57,6 +57,9 @@ void __kmp_str_buf_vprint(kmp_str_buf_t *buffer, char const *format,
                           va_list args);
 void __kmp_str_buf_print(kmp_str_buf_t *buffer, char const *format, ...);
 void __kmp_str_buf_print_size(kmp_str_buf_t *buffer, size_t size);
+// Writes the buffer to the file, or to stderr if file is NULL or cannot be
+// opened.
+void __kmp_str_buf_write(kmp_str_buf_t const *buffer, char const *file);
 
 /* File name parser.
    Usage:
@@ -102,6 +105,8 @@ struct kmp_str_loc {
 typedef struct kmp_str_loc kmp_str_loc_t;
 kmp_str_loc_t __kmp_str_loc_init(char const *psource, int init_fname);
 void __kmp_str_loc_free(kmp_str_loc_t *loc);
+// Prints "func (file:line)" of psource, "unknown" if it has no file.
+void __kmp_str_buf_print_loc(kmp_str_buf_t *buffer, char const *psource);
 
 int __kmp_str_eqf(char const *lhs, char const *rhs);
 char *__kmp_str_format(char const *format, ...);
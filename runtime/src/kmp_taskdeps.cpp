@@ -16,6 +16,7 @@
 //#define KMP_SUPPORT_GRAPH_OUTPUT 1
 
 #include "kmp.h"
+#include "kmp_critical_path.h"
 #include "kmp_io.h"
 #include "kmp_wait_release.h"
 #if OMPT_SUPPORT
@@ -43,6 +44,7 @@ static void __kmp_init_node(kmp_depnode_t *node) {
   node->dn.successors = NULL;
   __kmp_init_lock(&node->dn.lock);
   node->dn.nrefs = 1; // init creates the first reference to the node
+  node->dn.cp = NULL;
 #ifdef KMP_SUPPORT_GRAPH_OUTPUT
   node->dn.id = KMP_TEST_THEN_INC32(&kmp_node_id_seed);
 #endif
@@ -60,6 +62,8 @@ static inline void __kmp_node_deref(kmp_info_t *thread, kmp_depnode_t *node) {
   kmp_int32 n = KMP_TEST_THEN_DEC32(CCAST(kmp_int32 *, &node->dn.nrefs)) - 1;
   if (n == 0) {
     KMP_ASSERT(node->dn.nrefs == 0);
+    if (node->dn.cp != NULL)
+      __kmp_free(node->dn.cp);
 #if USE_FAST_MEMORY
     __kmp_fast_free(thread, node);
 #else
@@ -260,6 +264,9 @@ __kmp_process_deps(kmp_int32 gtid, kmp_depnode_t *node, kmp_dephash_t *hash,
         __kmp_dephash_find(thread, hash, dep->base_addr);
     kmp_depnode_t *last_out = info->last_out;
 
+    if (__kmp_critical_path)
+      __kmp_critical_path_deps(gtid, node, task, info, dep->flags.out);
+
     if (dep->flags.out && info->last_ins) {
       for (kmp_depnode_list_t *p = info->last_ins; p; p = p->next) {
         kmp_depnode_t *indep = p->node;
@@ -415,6 +422,8 @@ void __kmp_release_deps(kmp_int32 gtid, kmp_taskdata_t *task) {
   kmp_depnode_list_t *next;
   for (kmp_depnode_list_t *p = node->dn.successors; p; p = next) {
     kmp_depnode_t *successor = p->node;
+    if (__kmp_critical_path)
+      __kmp_critical_path_release(gtid, node, successor);
     kmp_int32 npredecessors =
         KMP_TEST_THEN_DEC32(CCAST(kmp_int32 *, &successor->dn.npredecessors)) -
         1;
@@ -568,6 +577,8 @@ kmp_int32 __kmpc_omp_task_with_deps(ident_t *loc_ref, kmp_int32 gtid,
 #endif
 
     __kmp_init_node(node);
+    if (__kmp_critical_path) // the fields are unused otherwise
+      __kmp_critical_path_node(node);
     new_taskdata->td_depnode = node;
 
     if (__kmp_check_deps(gtid, node, new_task, current_task->td_dephash,
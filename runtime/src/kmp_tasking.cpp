@@ -14,9 +14,11 @@
 
 
 #include "kmp.h"
+#include "kmp_critical_path.h"
 #include "kmp_i18n.h"
 #include "kmp_itt.h"
 #include "kmp_stats.h"
+#include "kmp_trace.h"
 #include "kmp_wait_release.h"
 
 #if OMPT_SUPPORT
@@ -440,6 +442,7 @@ static void __kmp_task_start(kmp_int32 gtid, kmp_task_t *task,
   taskdata->td_flags.executing = 1;
   KMP_DEBUG_ASSERT(taskdata->td_flags.complete == 0);
   KMP_DEBUG_ASSERT(taskdata->td_flags.freed == 0);
+  KMP_CRITICAL_PATH_START(taskdata);
 
   // GEH TODO: shouldn't we pass some sort of location identifier here?
   // APT: yes, we will pass location here.
@@ -574,6 +577,8 @@ static void __ompt_enabled_task_begin_if0(ident_t *loc_ref, kmp_int32 gtid,
 // task: task thunk for the started task.
 void __kmpc_omp_task_begin_if0(ident_t *loc_ref, kmp_int32 gtid,
                                kmp_task_t *task) {
+  KMP_PERF_INC(__kmp_threads[gtid], tasks_executed);
+  KMP_PERF_INC(__kmp_threads[gtid], tasks_inlined);
 #if OMPT_SUPPORT
   if (UNLIKELY(ompt_enabled.enabled)) {
     __ompt_enabled_task_begin_if0(loc_ref, gtid, task,
@@ -645,6 +650,7 @@ static void __kmp_free_task(kmp_int32 gtid, kmp_taskdata_t *taskdata,
   KMP_DEBUG_ASSERT(TCR_4(taskdata->td_allocated_child_tasks) == 0 ||
                    taskdata->td_flags.task_serial == 1);
   KMP_DEBUG_ASSERT(TCR_4(taskdata->td_incomplete_child_tasks) == 0);
+  KMP_CRITICAL_PATH_FLUSH(taskdata, kmp_cp_task, taskdata->td_ident);
 
   taskdata->td_flags.freed = 1;
   ANNOTATE_HAPPENS_BEFORE(taskdata);
@@ -730,6 +736,7 @@ static void __kmp_task_finish(kmp_int32 gtid, kmp_task_t *task,
                 gtid, taskdata, resumed_task));
 
   KMP_DEBUG_ASSERT(taskdata->td_flags.tasktype == TASK_EXPLICIT);
+  KMP_CRITICAL_PATH_STOP(taskdata);
 
 // Pop task from stack if tied
 #ifdef BUILD_TIED_TASK_STACK
@@ -767,6 +774,9 @@ static void __kmp_task_finish(kmp_int32 gtid, kmp_task_t *task,
   taskdata->td_flags.complete = 1; // mark the task as completed
   KMP_DEBUG_ASSERT(taskdata->td_flags.started == 1);
   KMP_DEBUG_ASSERT(taskdata->td_flags.freed == 0);
+  // Before the parent can see the task complete
+  if (__kmp_critical_path)
+    __kmp_critical_path_done(gtid, taskdata);
 
   // Only need to keep track of count if team parallel and tasking not
   // serialized
@@ -974,6 +984,7 @@ void __kmp_init_implicit_task(ident_t *loc_ref, kmp_info_t *this_thr,
     task->td_taskgroup = NULL; // An implicit task does not have taskgroup
     task->td_dephash = NULL;
 #endif
+    task->td_cp_graph = NULL;
     __kmp_push_current_task_to_thread(this_thr, team, tid);
   } else {
     KMP_DEBUG_ASSERT(task->td_incomplete_child_tasks == 0);
@@ -1199,6 +1210,11 @@ kmp_task_t *__kmp_task_alloc(ident_t *loc_ref, kmp_int32 gtid,
   taskdata->td_dephash = NULL;
   taskdata->td_depnode = NULL;
 #endif
+  if (__kmp_critical_path) { // the fields are unused otherwise
+    taskdata->td_cp_graph = NULL;
+    taskdata->td_cp_time = 0;
+    __kmp_critical_path_alloc(parent_task);
+  }
 
 // Only need to keep track of child task counts if team parallel and tasking not
 // serialized or if it is a proxy task
@@ -1224,6 +1240,7 @@ kmp_task_t *__kmp_task_alloc(ident_t *loc_ref, kmp_int32 gtid,
   KA_TRACE(20, ("__kmp_task_alloc(exit): T#%d created task %p parent=%p\n",
                 gtid, taskdata, taskdata->td_parent));
   ANNOTATE_HAPPENS_BEFORE(task);
+  KMP_TRACE_EVENT(thread, kmp_trace_task_create, 0, task, task->routine);
 
 #if OMPT_SUPPORT
   if (__builtin_expect(ompt_enabled.enabled,0)) __ompt_task_init(taskdata, gtid);
@@ -1326,6 +1343,7 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
     oldInfo = thread->th.ompt_thread_info;
     thread->th.ompt_thread_info.wait_id = 0;
     thread->th.ompt_thread_info.state = (thread->th.th_team_serialized)?omp_state_work_serial:omp_state_work_parallel;
+    thread->th.ompt_thread_info.ident = taskdata->td_ident;
     taskdata->ompt_task_info.frame.exit_runtime_frame =
         OMPT_GET_FRAME_ADDRESS(0);
   }
@@ -1392,6 +1410,9 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
     if (__builtin_expect(ompt_enabled.enabled,0)) __ompt_task_start(task, current_task, gtid);
 #endif
 
+    KMP_PERF_INC(__kmp_threads[gtid], tasks_executed);
+    KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_task_begin, 0, task,
+                    task->routine);
 #ifdef KMP_GOMP_COMPAT
     if (taskdata->td_flags.native) {
       ((void (*)(void *))(*(task->routine)))(task->shareds);
@@ -1400,6 +1421,7 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
     {
       (*(task->routine))(gtid, task);
     }
+    KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_task_end, 0, task, 0);
     KMP_POP_PARTITIONED_TIMER();
 
 #if OMPT_SUPPORT
@@ -1482,6 +1504,7 @@ kmp_int32 __kmpc_omp_task_parts(ident_t *loc_ref, kmp_int32 gtid,
   if (__kmp_push_task(gtid, new_task) == TASK_NOT_PUSHED) // if cannot defer
   { // Execute this task immediately
     kmp_taskdata_t *current_task = __kmp_threads[gtid]->th.th_current_task;
+    KMP_PERF_INC(__kmp_threads[gtid], tasks_inlined);
     new_taskdata->td_flags.task_serial = 1;
     __kmp_invoke_task(gtid, new_task, current_task);
   }
@@ -1526,6 +1549,7 @@ kmp_int32 __kmp_omp_task(kmp_int32 gtid, kmp_task_t *new_task,
 #endif
   { // Execute this task immediately
     kmp_taskdata_t *current_task = __kmp_threads[gtid]->th.th_current_task;
+    KMP_PERF_INC(__kmp_threads[gtid], tasks_inlined);
     if (serialize_immediate)
       new_taskdata->td_flags.task_serial = 1;
     __kmp_invoke_task(gtid, new_task, current_task);
@@ -1598,6 +1622,7 @@ static kmp_int32 __ompt_enabled_taskwait(ident_t *loc_ref, kmp_int32 gtid,
   kmp_info_t *thread;
   int thread_finished = FALSE;
   KMP_SET_THREAD_STATE_BLOCK(TASKWAIT);
+  KMP_TIME_PARTITIONED_BLOCK(OMP_taskwait);
 
   KA_TRACE(10, ("__kmpc_omp_taskwait(enter): T#%d loc=%p\n", gtid, loc_ref));
 
@@ -1612,6 +1637,10 @@ static kmp_int32 __ompt_enabled_taskwait(ident_t *loc_ref, kmp_int32 gtid,
     my_parallel_data = &(thread->th.th_team->t.ompt_team_info.parallel_data);
 
     taskdata->ompt_task_info.frame.reenter_runtime_frame = frame_address;
+    omp_state_t prev_state = thread->th.ompt_thread_info.state;
+    ident_t *prev_ident = thread->th.ompt_thread_info.ident;
+    thread->th.ompt_thread_info.state = omp_state_wait_taskwait;
+    thread->th.ompt_thread_info.ident = loc_ref;
 
     if (ompt_enabled.ompt_callback_sync_region) {
       ompt_callbacks.ompt_callback(ompt_callback_sync_region)(
@@ -1633,6 +1662,7 @@ static kmp_int32 __ompt_enabled_taskwait(ident_t *loc_ref, kmp_int32 gtid,
     taskdata->td_taskwait_counter += 1;
     taskdata->td_taskwait_ident = loc_ref;
     taskdata->td_taskwait_thread = gtid + 1;
+    KMP_TRACE_EVENT(thread, kmp_trace_taskwait_begin, 0, loc_ref, 0);
 
 #if USE_ITT_BUILD
     void *itt_sync_obj = __kmp_itt_taskwait_object(gtid);
@@ -1661,10 +1691,12 @@ static kmp_int32 __ompt_enabled_taskwait(ident_t *loc_ref, kmp_int32 gtid,
     if (itt_sync_obj != NULL)
       __kmp_itt_taskwait_finished(gtid, itt_sync_obj);
 #endif /* USE_ITT_BUILD */
+    KMP_TRACE_EVENT(thread, kmp_trace_taskwait_end, 0, 0, 0);
 
     // Debugger:  The taskwait is completed. Location remains, but thread is
     // negated.
     taskdata->td_taskwait_thread = -taskdata->td_taskwait_thread;
+    KMP_CRITICAL_PATH_FLUSH(taskdata, kmp_cp_taskwait, loc_ref);
 
     if (ompt_enabled.ompt_callback_sync_region_wait) {
       ompt_callbacks.ompt_callback(ompt_callback_sync_region_wait)(
@@ -1677,6 +1709,8 @@ static kmp_int32 __ompt_enabled_taskwait(ident_t *loc_ref, kmp_int32 gtid,
           my_task_data, return_address);
     }
     taskdata->ompt_task_info.frame.reenter_runtime_frame = NULL;
+    thread->th.ompt_thread_info.state = prev_state;
+    thread->th.ompt_thread_info.ident = prev_ident;
 
     ANNOTATE_HAPPENS_AFTER(taskdata);
   }
@@ -1702,6 +1736,7 @@ kmp_int32 __kmpc_omp_taskwait(ident_t *loc_ref, kmp_int32 gtid) {
   kmp_info_t *thread;
   int thread_finished = FALSE;
   KMP_SET_THREAD_STATE_BLOCK(TASKWAIT);
+  KMP_TIME_PARTITIONED_BLOCK(OMP_taskwait);
 
   KA_TRACE(10, ("__kmpc_omp_taskwait(enter): T#%d loc=%p\n", gtid, loc_ref));
 
@@ -1717,6 +1752,7 @@ kmp_int32 __kmpc_omp_taskwait(ident_t *loc_ref, kmp_int32 gtid) {
     taskdata->td_taskwait_counter += 1;
     taskdata->td_taskwait_ident = loc_ref;
     taskdata->td_taskwait_thread = gtid + 1;
+    KMP_TRACE_EVENT(thread, kmp_trace_taskwait_begin, 0, loc_ref, 0);
 
 #if USE_ITT_BUILD
     void *itt_sync_obj = __kmp_itt_taskwait_object(gtid);
@@ -1745,10 +1781,12 @@ kmp_int32 __kmpc_omp_taskwait(ident_t *loc_ref, kmp_int32 gtid) {
     if (itt_sync_obj != NULL)
       __kmp_itt_taskwait_finished(gtid, itt_sync_obj);
 #endif /* USE_ITT_BUILD */
+    KMP_TRACE_EVENT(thread, kmp_trace_taskwait_end, 0, 0, 0);
 
     // Debugger:  The taskwait is completed. Location remains, but thread is
     // negated.
     taskdata->td_taskwait_thread = -taskdata->td_taskwait_thread;
+    KMP_CRITICAL_PATH_FLUSH(taskdata, kmp_cp_taskwait, loc_ref);
 
     ANNOTATE_HAPPENS_AFTER(taskdata);
   }
@@ -2066,6 +2104,8 @@ void __kmpc_end_taskgroup(ident_t *loc, int gtid) {
   ompt_data_t my_task_data;
   ompt_data_t my_parallel_data;
   void * codeptr;
+  omp_state_t prev_state = omp_state_undefined;
+  ident_t *prev_ident = NULL;
   if (__builtin_expect(ompt_enabled.enabled,0))
   {
     team = thread->th.th_team;
@@ -2082,6 +2122,7 @@ void __kmpc_end_taskgroup(ident_t *loc, int gtid) {
   KMP_SET_THREAD_STATE_BLOCK(TASKGROUP);
 
   if (__kmp_tasking_mode != tskm_immediate_exec) {
+    KMP_TRACE_EVENT(thread, kmp_trace_taskwait_begin, 1, loc, 0);
 #if USE_ITT_BUILD
     // For ITT the taskgroup wait is similar to taskwait until we need to
     // distinguish them
@@ -2091,6 +2132,12 @@ void __kmpc_end_taskgroup(ident_t *loc, int gtid) {
 #endif /* USE_ITT_BUILD */
 
 #if OMPT_SUPPORT && OMPT_OPTIONAL
+    if (__builtin_expect(ompt_enabled.enabled, 0)) {
+      prev_state = thread->th.ompt_thread_info.state;
+      prev_ident = thread->th.ompt_thread_info.ident;
+      thread->th.ompt_thread_info.state = omp_state_wait_taskgroup;
+      thread->th.ompt_thread_info.ident = loc;
+    }
     if (__builtin_expect(ompt_enabled.ompt_callback_sync_region_wait,0)) {
       ompt_callbacks.ompt_callback(ompt_callback_sync_region_wait)(
           ompt_sync_region_taskgroup,
@@ -2126,12 +2173,17 @@ void __kmpc_end_taskgroup(ident_t *loc, int gtid) {
             &(my_task_data),
             codeptr);
     }
+    if (__builtin_expect(ompt_enabled.enabled, 0)) {
+      thread->th.ompt_thread_info.state = prev_state;
+      thread->th.ompt_thread_info.ident = prev_ident;
+    }
 #endif
 
 #if USE_ITT_BUILD
     if (itt_sync_obj != NULL)
       __kmp_itt_taskwait_finished(gtid, itt_sync_obj);
 #endif /* USE_ITT_BUILD */
+    KMP_TRACE_EVENT(thread, kmp_trace_taskwait_end, 0, 0, 0);
   }
   KMP_DEBUG_ASSERT(taskgroup->count == 0);
 
@@ -2143,6 +2195,7 @@ void __kmpc_end_taskgroup(ident_t *loc, int gtid) {
   // Restore parent taskgroup for the current task
   taskdata->td_taskgroup = taskgroup->parent;
   __kmp_thread_free(thread, taskgroup);
+  KMP_CRITICAL_PATH_FLUSH(taskdata, kmp_cp_taskgroup, loc);
 
   KA_TRACE(10, ("__kmpc_end_taskgroup(exit): T#%d task %p finished waiting\n",
                 gtid, taskdata));
@@ -2361,6 +2414,9 @@ static kmp_task_t *__kmp_steal_task(kmp_info_t *victim, kmp_int32 gtid,
        victim_td->td.td_deque_tail));
 
   task = KMP_TASKDATA_TO_TASK(taskdata);
+  KMP_PERF_INC(__kmp_threads[gtid], tasks_stolen);
+  KMP_TRACE_EVENT(__kmp_threads[gtid], kmp_trace_task_steal,
+                  __kmp_gtid_from_thread(victim), task, 0);
   return task;
 }
 
@@ -2752,8 +2808,8 @@ static void __kmp_alloc_task_deque(kmp_info_t *thread,
   // Allocate space for task deque, and zero the deque
   // Cannot use __kmp_thread_calloc() because threads not around for
   // kmp_reap_task_team( ).
-  thread_data->td.td_deque = (kmp_taskdata_t **)__kmp_allocate(
-      INITIAL_TASK_DEQUE_SIZE * sizeof(kmp_taskdata_t *));
+  thread_data->td.td_deque = (kmp_taskdata_t **)__kmp_allocate_thread_owned(
+      thread, INITIAL_TASK_DEQUE_SIZE * sizeof(kmp_taskdata_t *));
   thread_data->td.td_deque_size = INITIAL_TASK_DEQUE_SIZE;
 }
 
@@ -2770,8 +2826,8 @@ static void __kmp_realloc_task_deque(kmp_info_t *thread,
                 "%d] for thread_data %p\n",
                 __kmp_gtid_from_thread(thread), size, new_size, thread_data));
 
-  kmp_taskdata_t **new_deque =
-      (kmp_taskdata_t **)__kmp_allocate(new_size * sizeof(kmp_taskdata_t *));
+  kmp_taskdata_t **new_deque = (kmp_taskdata_t **)__kmp_allocate_thread_owned(
+      thread, new_size * sizeof(kmp_taskdata_t *));
 
   int i, j;
   for (i = thread_data->td.td_deque_head, j = 0; j < size;
@@ -3526,6 +3582,11 @@ kmp_task_t *__kmp_task_dup_alloc(kmp_info_t *thread, kmp_task_t *task_src) {
   taskdata->td_taskgroup =
       parent_task
           ->td_taskgroup; // task inherits the taskgroup from the parent task
+  if (__kmp_critical_path) { // the fields are unused otherwise
+    taskdata->td_cp_graph = NULL;
+    taskdata->td_cp_time = 0;
+    __kmp_critical_path_alloc(parent_task);
+  }
 
   // Only need to keep track of child task counts if team parallel and tasking
   // not serialized
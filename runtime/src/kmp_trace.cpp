@@ -0,0 +1,352 @@
+/*
+ * kmp_trace.cpp -- Per-thread event ring buffers and their dump to a file.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp_trace.h"
+#include "kmp_i18n.h"
+#include "kmp_str.h"
+#include "kmp_wrapper_getpid.h"
+
+#include <fcntl.h>
+#if KMP_OS_WINDOWS
+#include <io.h>
+#define open _open
+#define write _write
+#define close _close
+#else
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#include <stdio.h> // rename()
+
+int __kmp_trace_enabled = FALSE;
+char const *__kmp_trace_file = NULL;
+int __kmp_trace_buffer_size = 65536;
+int __kmp_trace_signal = 0;
+
+// The buffers of all threads that ever recorded an event. A buffer is never
+// released for another thread, so that the events of reaped workers are in the
+// file, too.
+static kmp_thread_slot_t *volatile __kmp_trace_buffers = NULL;
+static volatile kmp_int32 __kmp_trace_nbuffers = 0;
+static kmp_uint64 __kmp_trace_capacity;
+// Everything the dump needs is prepared in advance: it only calls open, write,
+// close and rename, and reads the buffers while their threads go on. The file
+// is written under a temporary name and renamed, so that a reader never sees
+// it half written.
+static char *__kmp_trace_path = NULL;
+static char *__kmp_trace_tmp_path = NULL;
+static kmp_uint64 __kmp_trace_start_ticks, __kmp_trace_start_nsec;
+static kmp_uint64 __kmp_trace_start_mono_nsec;
+static volatile kmp_int32 __kmp_trace_dumping = 0;
+
+// Source locations of the dumped events; an open-addressing hash set of the
+// ident_t pointers that is static rather than on the stack of the handler.
+#define KMP_TRACE_MAX_STRINGS 4096
+static kmp_uint64 __kmp_trace_idents[KMP_TRACE_MAX_STRINGS];
+
+// The clock of perf record -k CLOCK_MONOTONIC, 0 if there is none.
+static kmp_uint64 __kmp_trace_mono_nsec(void) {
+#if KMP_OS_UNIX && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+    return KMP_NSEC_PER_SEC * (kmp_uint64)ts.tv_sec + ts.tv_nsec;
+#endif
+  return 0;
+}
+
+#if KMP_OS_UNIX
+static struct sigaction __kmp_trace_old_action;
+static int __kmp_trace_installed_signal = 0;
+
+// The writer thread waits for KMP_TRACE_SIGNAL on a pipe: write() is safe in a
+// handler, and the dump runs beside the OpenMP threads instead of in them.
+static pthread_t __kmp_trace_writer;
+static pid_t __kmp_trace_writer_pid = 0; // 0 while there is no writer
+static int __kmp_trace_pipe[2] = {-1, -1};
+
+static void *__kmp_trace_writer_loop(void *arg) {
+  sigset_t all;
+  char c;
+  // Signals for the process are not for this thread.
+  sigfillset(&all);
+  pthread_sigmask(SIG_BLOCK, &all, NULL);
+  // A 0 byte from __kmp_trace_fini() ends the thread, a 1 asks for a dump.
+  for (;;) {
+    long rc = (long)read(__kmp_trace_pipe[0], &c, 1);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    if (rc <= 0 || c == 0)
+      break;
+    __kmp_trace_dump();
+  }
+  return NULL;
+}
+
+static void __kmp_trace_close_pipe(void) {
+  for (int i = 0; i < 2; ++i) {
+    if (__kmp_trace_pipe[i] >= 0)
+      close(__kmp_trace_pipe[i]);
+    __kmp_trace_pipe[i] = -1;
+  }
+}
+
+static void __kmp_trace_start_writer(void) {
+  // The pipe of a parent before fork() is not for this process.
+  __kmp_trace_close_pipe();
+  if (pipe(__kmp_trace_pipe) != 0)
+    return;
+  for (int i = 0; i < 2; ++i)
+    fcntl(__kmp_trace_pipe[i], F_SETFD, FD_CLOEXEC);
+  if (pthread_create(&__kmp_trace_writer, NULL, __kmp_trace_writer_loop,
+                     NULL) != 0) {
+    __kmp_trace_close_pipe();
+    return;
+  }
+  __kmp_trace_writer_pid = getpid();
+}
+
+static void __kmp_trace_stop_writer(void) {
+  if (__kmp_trace_writer_pid != getpid())
+    return;
+  char c = 0;
+  while (write(__kmp_trace_pipe[1], &c, 1) < 0 && errno == EINTR)
+    ;
+  pthread_join(__kmp_trace_writer, NULL);
+  __kmp_trace_writer_pid = 0;
+  __kmp_trace_close_pipe();
+}
+
+// Only wakes the writer thread up; then passes the signal on to the handler it
+// replaced.
+static void __kmp_trace_signal_handler(int signum, siginfo_t *info,
+                                       void *context) {
+  int saved_errno = errno;
+  char c = 1;
+  if (__kmp_trace_pipe[1] >= 0 && write(__kmp_trace_pipe[1], &c, 1) < 0) {
+    // The pipe is full, the dumps asked for already cover this one.
+  }
+  errno = saved_errno;
+  if (__kmp_trace_old_action.sa_flags & SA_SIGINFO) {
+    if (__kmp_trace_old_action.sa_sigaction != NULL)
+      __kmp_trace_old_action.sa_sigaction(signum, info, context);
+  } else if (__kmp_trace_old_action.sa_handler != SIG_DFL &&
+             __kmp_trace_old_action.sa_handler != SIG_IGN) {
+    __kmp_trace_old_action.sa_handler(signum);
+  }
+}
+#endif
+
+void __kmp_trace_init(void) {
+  if (!__kmp_trace_enabled)
+    return;
+  __kmp_trace_capacity = 1;
+  while (__kmp_trace_capacity < (kmp_uint64)__kmp_trace_buffer_size)
+    __kmp_trace_capacity <<= 1;
+  if (__kmp_trace_path == NULL) {
+    if (__kmp_trace_file != NULL)
+      __kmp_trace_path = __kmp_str_format("%s", __kmp_trace_file);
+    else
+      __kmp_trace_path = __kmp_str_format("kmp_trace.%d.bin", (int)getpid());
+    __kmp_trace_tmp_path = __kmp_str_format("%s.tmp", __kmp_trace_path);
+  }
+  __kmp_trace_start_ticks = KMP_TRACE_NOW();
+  __kmp_trace_start_nsec = __kmp_now_nsec();
+  __kmp_trace_start_mono_nsec = __kmp_trace_mono_nsec();
+#if KMP_OS_UNIX
+  if (__kmp_trace_signal > 0 && __kmp_trace_installed_signal == 0) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = __kmp_trace_signal_handler;
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(__kmp_trace_signal, &action, &__kmp_trace_old_action) == 0)
+      __kmp_trace_installed_signal = __kmp_trace_signal;
+  }
+  // A child of fork() has no writer; it starts its own.
+  if (__kmp_trace_installed_signal != 0 && __kmp_trace_writer_pid != getpid())
+    __kmp_trace_start_writer();
+#endif
+  KA_TRACE(10, ("__kmp_trace_init: %d records per thread, file %s\n",
+                (int)__kmp_trace_capacity, __kmp_trace_path));
+}
+
+void __kmp_trace_fini(void) {
+  if (!__kmp_trace_enabled)
+    return;
+#if KMP_OS_UNIX
+  if (__kmp_trace_installed_signal != 0) {
+    sigaction(__kmp_trace_installed_signal, &__kmp_trace_old_action, NULL);
+    __kmp_trace_installed_signal = 0;
+  }
+  // Waits for a dump of the writer, which would make this one a no-op.
+  __kmp_trace_stop_writer();
+#endif
+  __kmp_trace_dump();
+  // The events that threads of other roots record from now on are not
+  // written anywhere.
+  __kmp_trace_enabled = FALSE;
+}
+
+kmp_trace_buffer_t *__kmp_trace_attach(kmp_info_t *thr) {
+  size_t size = sizeof(kmp_trace_buffer_t) +
+                (size_t)(__kmp_trace_capacity - 1) * sizeof(kmp_trace_record_t);
+  // Not __kmp_allocate(): the pages are touched only as the ring fills up.
+  kmp_trace_buffer_t *buf = (kmp_trace_buffer_t *)KMP_INTERNAL_MALLOC(size);
+  if (buf == NULL)
+    KMP_FATAL(MemoryAllocFailed);
+  buf->count = 0;
+  buf->mask = __kmp_trace_capacity - 1;
+  buf->id = KMP_TEST_THEN_INC32(&__kmp_trace_nbuffers);
+  // Called by the thread itself, on its first event.
+  buf->os_tid = (kmp_int64)__kmp_gettid();
+  __kmp_thread_slot_push(&__kmp_trace_buffers, &buf->slot,
+                         thr->th.th_info.ds.ds_gtid);
+  thr->th.th_trace = buf;
+  return buf;
+}
+
+// The ident_t of an event, 0 if it has none.
+static kmp_uint64 __kmp_trace_ident(kmp_trace_record_t const *rec) {
+  switch (rec->event) {
+  case kmp_trace_fork:
+  case kmp_trace_join:
+  case kmp_trace_barrier_begin:
+  case kmp_trace_taskwait_begin:
+    return rec->a0;
+  case kmp_trace_lock_wait:
+    return rec->a1;
+  }
+  return 0;
+}
+
+static int __kmp_trace_write(int fd, void const *data, size_t size) {
+  char const *ptr = (char const *)data;
+  while (size > 0) {
+    long rc = (long)write(fd, ptr, size);
+    if (rc < 0) {
+      if (errno == EINTR)
+        continue;
+      return 0;
+    }
+    ptr += rc;
+    size -= (size_t)rc;
+  }
+  return 1;
+}
+
+static kmp_uint32 __kmp_trace_collect_idents(kmp_trace_buffer_t *buffers) {
+  kmp_uint32 nidents = 0;
+  memset(__kmp_trace_idents, 0, sizeof(__kmp_trace_idents));
+  for (kmp_trace_buffer_t *buf = buffers; buf;
+       buf = (kmp_trace_buffer_t *)buf->slot.next) {
+    kmp_uint64 count = buf->count;
+    kmp_uint64 first = count > buf->mask ? count - buf->mask - 1 : 0;
+    for (kmp_uint64 i = first; i < count; ++i) {
+      ident_t const *loc =
+          (ident_t const *)__kmp_trace_ident(&buf->records[i & buf->mask]);
+      if (loc == NULL || loc->psource == NULL)
+        continue;
+      kmp_uint64 key = (kmp_uint64)loc;
+      kmp_uint32 h = (kmp_uint32)((key >> 3) * 0x9E3779B1u);
+      for (kmp_uint32 j = 0; j < KMP_TRACE_MAX_STRINGS; ++j) {
+        kmp_uint64 *slot =
+            &__kmp_trace_idents[(h + j) & (KMP_TRACE_MAX_STRINGS - 1)];
+        if (*slot == key)
+          break;
+        if (*slot == 0) {
+          // Keep the table half empty; locations beyond that stay unnamed.
+          if (nidents < KMP_TRACE_MAX_STRINGS / 2) {
+            *slot = key;
+            ++nidents;
+          }
+          break;
+        }
+      }
+    }
+  }
+  return nidents;
+}
+
+void __kmp_trace_dump(void) {
+  if (__kmp_trace_path == NULL ||
+      !KMP_COMPARE_AND_STORE_ACQ32(&__kmp_trace_dumping, 0, 1))
+    return;
+  int fd = open(__kmp_trace_tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd >= 0) {
+    // Buffers of threads that start meanwhile are pushed in front of this one
+    // and are not written.
+    kmp_trace_buffer_t *buffers = (kmp_trace_buffer_t *)__kmp_trace_buffers;
+    kmp_trace_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, KMP_TRACE_MAGIC, sizeof(header.magic));
+    header.version = KMP_TRACE_VERSION;
+    header.record_size = sizeof(kmp_trace_record_t);
+    for (kmp_trace_buffer_t *buf = buffers; buf;
+         buf = (kmp_trace_buffer_t *)buf->slot.next)
+      header.nthreads++;
+    header.nstrings = __kmp_trace_collect_idents(buffers);
+    header.pid = getpid();
+    header.start_ticks = __kmp_trace_start_ticks;
+    header.start_nsec = __kmp_trace_start_nsec;
+    header.end_ticks = KMP_TRACE_NOW();
+    header.end_nsec = __kmp_now_nsec();
+    header.start_mono_nsec = __kmp_trace_start_mono_nsec;
+    header.end_mono_nsec = __kmp_trace_mono_nsec();
+    int ok = __kmp_trace_write(fd, &header, sizeof(header));
+
+    for (kmp_trace_buffer_t *buf = buffers; ok && buf;
+         buf = (kmp_trace_buffer_t *)buf->slot.next) {
+      kmp_trace_thread_t thread;
+      thread.gtid = buf->slot.gtid;
+      thread.id = buf->id;
+      thread.os_tid = buf->os_tid;
+      thread.total = buf->count;
+      thread.count = KMP_MIN(thread.total, buf->mask + 1);
+      ok = __kmp_trace_write(fd, &thread, sizeof(thread));
+      // Oldest first: the tail of the ring, then its head.
+      kmp_uint64 start = (thread.total - thread.count) & buf->mask;
+      kmp_uint64 tail = KMP_MIN(thread.count, buf->mask + 1 - start);
+      if (ok)
+        ok = __kmp_trace_write(fd, &buf->records[start],
+                               tail * sizeof(kmp_trace_record_t));
+      if (ok)
+        ok = __kmp_trace_write(fd, &buf->records[0],
+                               (thread.count - tail) *
+                                   sizeof(kmp_trace_record_t));
+    }
+
+    for (kmp_uint32 i = 0; ok && i < KMP_TRACE_MAX_STRINGS; ++i) {
+      if (__kmp_trace_idents[i] == 0)
+        continue;
+      char const *psource = ((ident_t const *)__kmp_trace_idents[i])->psource;
+      kmp_trace_string_t string;
+      string.key = __kmp_trace_idents[i];
+      string.length = KMP_STRLEN(psource);
+      ok = __kmp_trace_write(fd, &string, sizeof(string)) &&
+           __kmp_trace_write(fd, psource, (size_t)string.length);
+    }
+    close(fd);
+#if KMP_OS_WINDOWS
+    remove(__kmp_trace_path); // rename() does not replace a file
+#endif
+    if (ok)
+      rename(__kmp_trace_tmp_path, __kmp_trace_path);
+    else
+      remove(__kmp_trace_tmp_path);
+  }
+  KMP_ST_REL32(&__kmp_trace_dumping, 0);
+}
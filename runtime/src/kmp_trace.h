@@ -0,0 +1,154 @@
+#ifndef KMP_TRACE_H
+#define KMP_TRACE_H
+
+/** @file kmp_trace.h
+ * Always-available event tracer with per-thread ring buffers.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp.h"
+
+#include <atomic>
+
+/* Unlike the statistics, the tracer is part of every build and costs a single
+   predictable branch per event while it is off (KMP_TRACE=false, the default).
+   When it is on, each thread appends fixed-size records to its own ring
+   buffer, without locks or atomic operations; once the buffer is full the
+   oldest records are overwritten. The buffers are written to KMP_TRACE_FILE
+   at exit, and when the process receives KMP_TRACE_SIGNAL (none by default):
+   the handler only wakes a writer thread up and chains to the previous
+   handler, and the writer dumps the buffers while the OpenMP threads go on.
+   tools/trace-converter.pl turns the file into Chrome trace JSON that
+   chrome://tracing and Perfetto load.
+
+   The events are those that the ITT notifications report to Intel tools, so
+   the timeline is there without an ITT collector. The file also records the
+   CLOCK_MONOTONIC time and the kernel thread ids, which `perf record -k
+   CLOCK_MONOTONIC` uses as well: the converter can print the events in the
+   time base of `perf script`, to line up the OpenMP phases with the samples
+   of the hardware counters.
+
+   File layout (host byte order):
+     kmp_trace_header_t
+     for each thread: kmp_trace_thread_t, then its records, oldest first
+     for each source location: kmp_trace_string_t, then the string bytes */
+
+enum kmp_trace_event_t {
+  kmp_trace_none = 0,
+  kmp_trace_fork, // a0: ident_t, a1: microtask, arg: team size
+  kmp_trace_join, // a0: ident_t, arg: team size
+  kmp_trace_barrier_begin, // a0: ident_t, arg: barrier_type
+  kmp_trace_barrier_end, // arg: barrier_type
+  kmp_trace_task_create, // a0: task, a1: task routine
+  kmp_trace_task_begin, // a0: task, a1: task routine
+  kmp_trace_task_end, // a0: task
+  kmp_trace_task_steal, // a0: task, arg: gtid of the victim
+  kmp_trace_lock_wait, // a0: lock or critical name, a1: ident_t
+  kmp_trace_lock_acquired, // a0: lock or critical name
+  kmp_trace_lock_released, // a0: lock or critical name
+  kmp_trace_taskwait_begin, // a0: ident_t, arg: 0 taskwait, 1 end of taskgroup
+  kmp_trace_taskwait_end,
+  kmp_trace_last
+};
+
+typedef struct kmp_trace_record {
+  kmp_uint64 time; // ticks of KMP_TRACE_NOW()
+  kmp_uint32 event; // kmp_trace_event_t
+  kmp_uint32 arg;
+  kmp_uint64 a0;
+  kmp_uint64 a1;
+} kmp_trace_record_t;
+
+#define KMP_TRACE_MAGIC "KMPTRACE"
+#define KMP_TRACE_VERSION 2
+
+typedef struct kmp_trace_header {
+  char magic[8]; // KMP_TRACE_MAGIC
+  kmp_uint32 version; // KMP_TRACE_VERSION
+  kmp_uint32 record_size; // sizeof(kmp_trace_record_t)
+  kmp_uint32 nthreads; // number of kmp_trace_thread_t blocks
+  kmp_uint32 nstrings; // number of kmp_trace_string_t blocks
+  kmp_int64 pid;
+  // Two samples of the clock and of the wall time in nanoseconds, taken at
+  // initialization and when the file is written, relate ticks and time.
+  kmp_uint64 start_ticks, start_nsec;
+  kmp_uint64 end_ticks, end_nsec;
+  // CLOCK_MONOTONIC at the same points, 0 where there is no such clock.
+  kmp_uint64 start_mono_nsec, end_mono_nsec;
+} kmp_trace_header_t;
+
+typedef struct kmp_trace_thread {
+  kmp_int32 gtid;
+  kmp_int32 id; // unique even if a gtid is reused by a later thread
+  kmp_int64 os_tid; // the thread id of the system, as perf reports it
+  kmp_uint64 total; // records ever written; only the last ones are kept
+  kmp_uint64 count; // records that follow
+} kmp_trace_thread_t;
+
+typedef struct kmp_trace_string {
+  kmp_uint64 key; // the ident_t the string belongs to
+  kmp_uint64 length; // bytes that follow, without a terminating NUL
+} kmp_trace_string_t;
+
+typedef struct kmp_trace_buffer {
+  kmp_thread_slot_t slot; // in the list of all buffers, for the dump
+  volatile kmp_uint64 count; // records written so far, only by the owner
+  kmp_uint64 mask; // capacity - 1, the capacity is a power of two
+  kmp_int32 id;
+  kmp_int64 os_tid;
+  kmp_trace_record_t records[1];
+} kmp_trace_buffer_t;
+
+extern kmp_uint64 __kmp_now_nsec();
+#if KMP_ARCH_X86 || KMP_ARCH_X86_64
+#define KMP_TRACE_NOW() __kmp_hardware_timestamp()
+#else
+#define KMP_TRACE_NOW() __kmp_now_nsec()
+#endif
+
+extern int __kmp_trace_enabled;
+extern char const *__kmp_trace_file;
+extern int __kmp_trace_buffer_size;
+extern int __kmp_trace_signal;
+
+extern void __kmp_trace_init(void);
+extern void __kmp_trace_fini(void);
+extern void __kmp_trace_dump(void);
+extern kmp_trace_buffer_t *__kmp_trace_attach(kmp_info_t *thr);
+
+static inline void __kmp_trace_record(kmp_info_t *thr, kmp_uint32 event,
+                                      kmp_uint32 arg, kmp_uint64 a0,
+                                      kmp_uint64 a1) {
+  kmp_trace_buffer_t *buf = thr->th.th_trace;
+  if (buf == NULL)
+    buf = __kmp_trace_attach(thr);
+  kmp_uint64 count = buf->count;
+  kmp_trace_record_t *rec = &buf->records[count & buf->mask];
+  rec->time = KMP_TRACE_NOW();
+  rec->event = event;
+  rec->arg = arg;
+  rec->a0 = a0;
+  rec->a1 = a1;
+  // Publish the record only when it is complete, for a dump by another thread
+  std::atomic_thread_fence(std::memory_order_release);
+  buf->count = count + 1;
+}
+
+#define KMP_TRACE_EVENT(thr, event, arg, a0, a1)                               \
+  do {                                                                         \
+    if (__kmp_trace_enabled)                                                   \
+      __kmp_trace_record((thr), (event), (kmp_uint32)(arg), (kmp_uint64)(a0),  \
+                         (kmp_uint64)(a1));                                    \
+  } while (0)
+
+#endif // KMP_TRACE_H
@@ -134,6 +134,7 @@ void __kmp_query_cpuid(kmp_cpuinfo_t *p) {
   p->initialized = 1;
 
   p->sse2 = 1; // Assume SSE2 by default.
+  p->cx16 = 0;
 
   __kmp_x86_cpuid(0, 0, &buf);
 
@@ -174,6 +175,7 @@ void __kmp_query_cpuid(kmp_cpuinfo_t *p) {
     }; // for
 
     p->sse2 = (buf.edx >> 26) & 1;
+    p->cx16 = (buf.ecx >> 13) & 1;
 
 #ifdef KMP_DEBUG
 
@@ -407,3 +409,26 @@ void __kmp_expand_file_name(char *result, size_t rlen, char *pattern) {
 
   *pos = '\0';
 }
+
+// A released record of the list for the thread gtid, NULL if there is none.
+kmp_thread_slot_t *__kmp_thread_slot_reuse(kmp_thread_slot_t *volatile *list,
+                                           int gtid) {
+  for (kmp_thread_slot_t *slot = *list; slot; slot = slot->next) {
+    if (slot->gtid == gtid && slot->in_use == 0 &&
+        KMP_COMPARE_AND_STORE_ACQ32(&slot->in_use, 0, 1))
+      return slot;
+  }
+  return NULL;
+}
+
+// Adds a new record, initialized but for the header, to the list.
+void __kmp_thread_slot_push(kmp_thread_slot_t *volatile *list,
+                            kmp_thread_slot_t *slot, int gtid) {
+  kmp_thread_slot_t *head;
+  slot->gtid = gtid;
+  slot->in_use = 1;
+  do {
+    head = *list;
+    slot->next = head;
+  } while (!KMP_COMPARE_AND_STORE_PTR(list, head, slot));
+}
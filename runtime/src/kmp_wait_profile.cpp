@@ -0,0 +1,281 @@
+/*
+ * kmp_wait_profile.cpp -- Sampler of the wait states and its flat profile.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp_wait_profile.h"
+#include "kmp_i18n.h"
+#include "kmp_str.h"
+#include "kmp_wrapper_getpid.h"
+
+#if KMP_OS_UNIX
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#endif
+
+extern kmp_uint64 __kmp_now_nsec();
+
+int __kmp_wait_profile = FALSE;
+int __kmp_wait_profile_interval = 1000; // microseconds
+char const *__kmp_wait_profile_file = NULL;
+
+#if KMP_OS_UNIX && OMPT_SUPPORT
+// Samples per state and location, written only by the sampler thread. An
+// open-addressing table of the (location, state) pairs; once it is 3/4 full
+// the samples of new pairs go to the overflow counter of their state.
+#define KMP_WAIT_PROFILE_ENTRIES 4096
+
+typedef struct kmp_wait_entry {
+  ident_t *loc;
+  kmp_int32 state;
+  kmp_int32 used;
+  kmp_uint64 samples;
+} kmp_wait_entry_t;
+
+static kmp_wait_entry_t *__kmp_wait_entries = NULL;
+static kmp_uint32 __kmp_wait_nentries = 0;
+static kmp_uint64 __kmp_wait_overflow[kmp_wait_last];
+static kmp_uint64 __kmp_wait_nsamples = 0; // rounds of the sampler
+static kmp_uint64 __kmp_wait_nthread_samples = 0;
+static int __kmp_wait_max_threads = 0;
+static kmp_uint64 __kmp_wait_start_nsec, __kmp_wait_end_nsec;
+
+static char const *__kmp_wait_state_names[kmp_wait_last] = {
+    "work", "barrier", "taskwait", "lock", "overhead", "idle"};
+
+static void __kmp_wait_profile_count(kmp_int32 state, ident_t *loc) {
+  kmp_uint64 key = (kmp_uint64)(kmp_uintptr_t)loc;
+  kmp_uint32 h = (kmp_uint32)(((key >> 3) + state) * 0x9E3779B1u);
+  for (kmp_uint32 j = 0; j < KMP_WAIT_PROFILE_ENTRIES; ++j) {
+    kmp_wait_entry_t *e =
+        &__kmp_wait_entries[(h + j) & (KMP_WAIT_PROFILE_ENTRIES - 1)];
+    if (e->used && e->loc == loc && e->state == state) {
+      e->samples++;
+      return;
+    }
+    if (!e->used) {
+      if (__kmp_wait_nentries >= KMP_WAIT_PROFILE_ENTRIES / 4 * 3)
+        break;
+      e->used = 1;
+      e->loc = loc;
+      e->state = state;
+      e->samples = 1;
+      __kmp_wait_nentries++;
+      return;
+    }
+  }
+  __kmp_wait_overflow[state]++;
+}
+
+static int __kmp_wait_profile_state(omp_state_t state) {
+  switch (state) {
+  case omp_state_work_serial:
+  case omp_state_work_parallel:
+  case omp_state_work_reduction:
+    return kmp_wait_work;
+  case omp_state_wait_barrier:
+  case omp_state_wait_barrier_implicit_parallel:
+  case omp_state_wait_barrier_implicit_workshare:
+  case omp_state_wait_barrier_implicit:
+  case omp_state_wait_barrier_explicit:
+    return kmp_wait_barrier;
+  case omp_state_wait_taskwait:
+  case omp_state_wait_taskgroup:
+    return kmp_wait_taskwait;
+  case omp_state_wait_mutex:
+  case omp_state_wait_lock:
+  case omp_state_wait_critical:
+  case omp_state_wait_atomic:
+  case omp_state_wait_ordered:
+    return kmp_wait_lock;
+  case omp_state_overhead:
+    return kmp_wait_overhead;
+  case omp_state_idle:
+    return kmp_wait_idle;
+  default:
+    return -1;
+  }
+}
+
+// The threads leave __kmp_threads only with __kmp_forkjoin_lock held. The
+// sampler skips the round while a fork holds it, and never waits for it, as
+// __kmp_wait_profile_fini() joins the sampler with the lock held.
+static void __kmp_wait_profile_sample(void) {
+  int nthreads = 0;
+  if (!__kmp_test_bootstrap_lock(&__kmp_forkjoin_lock))
+    return;
+  for (int i = 0; i < __kmp_threads_capacity; ++i) {
+    kmp_info_t *thr = __kmp_threads[i];
+    if (thr == NULL)
+      continue;
+    // The state may be newer than the location; that is noise, not a fault,
+    // as both locations are valid.
+    int state = __kmp_wait_profile_state(
+        (omp_state_t)TCR_4(thr->th.ompt_thread_info.state));
+    ident_t *loc = (ident_t *)TCR_PTR(thr->th.ompt_thread_info.ident);
+    if (state < 0)
+      continue;
+    __kmp_wait_profile_count(state, loc);
+    nthreads++;
+  }
+  __kmp_release_bootstrap_lock(&__kmp_forkjoin_lock);
+  __kmp_wait_nsamples++;
+  __kmp_wait_nthread_samples += nthreads;
+  if (nthreads > __kmp_wait_max_threads)
+    __kmp_wait_max_threads = nthreads;
+}
+
+static pthread_t __kmp_wait_sampler;
+static pid_t __kmp_wait_sampler_pid = 0; // 0 while there is no sampler
+static volatile int __kmp_wait_sampler_done = 0;
+
+static void *__kmp_wait_profile_sampler(void *arg) {
+  sigset_t all;
+  struct timespec interval;
+  // Signals for the process are not for this thread.
+  sigfillset(&all);
+  pthread_sigmask(SIG_BLOCK, &all, NULL);
+  interval.tv_sec = __kmp_wait_profile_interval / 1000000;
+  interval.tv_nsec = (__kmp_wait_profile_interval % 1000000) * 1000;
+  __kmp_wait_start_nsec = __kmp_now_nsec();
+  while (!TCR_4(__kmp_wait_sampler_done)) {
+    nanosleep(&interval, NULL);
+    __kmp_wait_profile_sample();
+  }
+  __kmp_wait_end_nsec = __kmp_now_nsec();
+  return NULL;
+}
+
+static int __kmp_wait_entry_compare(const void *a, const void *b) {
+  kmp_uint64 sa = ((const kmp_wait_entry_t *)a)->samples;
+  kmp_uint64 sb = ((const kmp_wait_entry_t *)b)->samples;
+  return sa < sb ? 1 : sa > sb ? -1 : 0;
+}
+
+static void __kmp_wait_profile_print(void) {
+  kmp_str_buf_t buffer;
+  kmp_uint64 by_state[kmp_wait_last];
+  double total = (double)__kmp_wait_nthread_samples;
+  // The sampler sleeps at least the interval, the times use the actual one.
+  double ms_per_sample = __kmp_wait_profile_interval / 1000.0;
+  kmp_uint32 n = 0;
+
+  // Compact the used entries to the front and sort them.
+  memset(by_state, 0, sizeof(by_state));
+  for (kmp_uint32 i = 0; i < KMP_WAIT_PROFILE_ENTRIES; ++i) {
+    if (!__kmp_wait_entries[i].used)
+      continue;
+    by_state[__kmp_wait_entries[i].state] += __kmp_wait_entries[i].samples;
+    __kmp_wait_entries[n++] = __kmp_wait_entries[i];
+  }
+  qsort(__kmp_wait_entries, n, sizeof(kmp_wait_entry_t),
+        __kmp_wait_entry_compare);
+  if (total == 0)
+    total = 1;
+  if (__kmp_wait_nsamples > 0)
+    ms_per_sample = (__kmp_wait_end_nsec - __kmp_wait_start_nsec) / 1e6 /
+                    __kmp_wait_nsamples;
+
+  __kmp_str_buf_init(&buffer);
+  __kmp_str_buf_print(&buffer,
+                      "# OpenMP wait profile of process %d: %llu samples "
+                      "every %.0f us of up to %d threads\n",
+                      (int)getpid(), (unsigned long long)__kmp_wait_nsamples,
+                      ms_per_sample * 1000, __kmp_wait_max_threads);
+  __kmp_str_buf_print(&buffer, "%-9s %10s %7s %12s  %s\n", "State", "Samples",
+                      "Percent", "Time (ms)", "Location");
+  for (int s = 0; s < kmp_wait_last; ++s) {
+    kmp_uint64 samples = by_state[s] + __kmp_wait_overflow[s];
+    __kmp_str_buf_print(&buffer, "%-9s %10llu %6.2f%% %12.1f  (all)\n",
+                        __kmp_wait_state_names[s], (unsigned long long)samples,
+                        100.0 * samples / total, samples * ms_per_sample);
+  }
+  for (kmp_uint32 i = 0; i < n; ++i) {
+    kmp_wait_entry_t *e = &__kmp_wait_entries[i];
+    __kmp_str_buf_print(&buffer, "%-9s %10llu %6.2f%% %12.1f  ",
+                        __kmp_wait_state_names[e->state],
+                        (unsigned long long)e->samples,
+                        100.0 * e->samples / total, e->samples * ms_per_sample);
+    if (e->loc == NULL) // idle
+      __kmp_str_buf_print(&buffer, "-");
+    else
+      __kmp_str_buf_print_loc(&buffer, e->loc->psource);
+    __kmp_str_buf_print(&buffer, "\n");
+  }
+  for (int s = 0; s < kmp_wait_last; ++s) {
+    if (__kmp_wait_overflow[s] == 0)
+      continue;
+    __kmp_str_buf_print(&buffer, "%-9s %10llu %6.2f%% %12.1f  (other)\n",
+                        __kmp_wait_state_names[s],
+                        (unsigned long long)__kmp_wait_overflow[s],
+                        100.0 * __kmp_wait_overflow[s] / total,
+                        __kmp_wait_overflow[s] * ms_per_sample);
+  }
+
+  __kmp_str_buf_write(&buffer, __kmp_wait_profile_file);
+  __kmp_str_buf_free(&buffer);
+}
+#endif // KMP_OS_UNIX && OMPT_SUPPORT
+
+// Called after ompt_pre_init(); ompt_post_init() turns the OMPT states on,
+// if no tool did.
+void __kmp_wait_profile_init(void) {
+  if (!__kmp_wait_profile)
+    return;
+#if KMP_OS_UNIX && OMPT_SUPPORT
+  // A child of fork() has no sampler; it starts its own profile.
+  if (__kmp_wait_sampler_pid == getpid())
+    return;
+  if (__kmp_wait_entries == NULL) {
+    __kmp_wait_entries = (kmp_wait_entry_t *)KMP_INTERNAL_MALLOC(
+        KMP_WAIT_PROFILE_ENTRIES * sizeof(kmp_wait_entry_t));
+    if (__kmp_wait_entries == NULL)
+      KMP_FATAL(MemoryAllocFailed);
+  }
+  memset(__kmp_wait_entries, 0,
+         KMP_WAIT_PROFILE_ENTRIES * sizeof(kmp_wait_entry_t));
+  memset(__kmp_wait_overflow, 0, sizeof(__kmp_wait_overflow));
+  __kmp_wait_nentries = 0;
+  __kmp_wait_nsamples = 0;
+  __kmp_wait_nthread_samples = 0;
+  __kmp_wait_max_threads = 0;
+  __kmp_wait_sampler_done = 0;
+  if (pthread_create(&__kmp_wait_sampler, NULL, __kmp_wait_profile_sampler,
+                     NULL) != 0) {
+    __kmp_wait_profile = FALSE;
+    return;
+  }
+  __kmp_wait_sampler_pid = getpid();
+  KA_TRACE(10, ("__kmp_wait_profile_init: sampling every %d us\n",
+                __kmp_wait_profile_interval));
+#else
+  // No sampler on this OS, or no OMPT states to sample.
+  KMP_WARNING(WaitProfileNotSupported);
+  __kmp_wait_profile = FALSE;
+#endif
+}
+
+void __kmp_wait_profile_fini(void) {
+  if (!__kmp_wait_profile)
+    return;
+#if KMP_OS_UNIX && OMPT_SUPPORT
+  if (__kmp_wait_sampler_pid != getpid())
+    return;
+  TCW_4(__kmp_wait_sampler_done, 1);
+  pthread_join(__kmp_wait_sampler, NULL);
+  __kmp_wait_sampler_pid = 0;
+  __kmp_wait_profile_print();
+#endif
+  __kmp_wait_profile = FALSE;
+}
@@ -0,0 +1,49 @@
+#ifndef KMP_WAIT_PROFILE_H
+#define KMP_WAIT_PROFILE_H
+
+/** @file kmp_wait_profile.h
+ * Sampling profiler of the wait states of the OpenMP threads.
+ */
+
+
+//===----------------------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "kmp.h"
+
+/* With KMP_WAIT_PROFILE=true a sampler thread reads the OMPT state of all
+   threads and the ident_t of the construct they entered it in
+   (th.ompt_thread_info) every KMP_WAIT_PROFILE_INTERVAL microseconds. At
+   exit the samples are written to KMP_WAIT_PROFILE_FILE (stderr by default)
+   as a flat profile of the time per state and source location, the most
+   frequent first. The runtime keeps the states for OMPT tools; the profile
+   turns them on when there is no tool, so it costs what OMPT costs, and
+   unlike the stats it needs no special build. Without OMPT_SUPPORT there is
+   no profile. */
+
+// The OMPT states, grouped.
+enum kmp_wait_state_t {
+  kmp_wait_work = 0, // running user code; ident_t of the region or task
+  kmp_wait_barrier, // ident_t of the barrier, or of the region at the join
+  kmp_wait_taskwait, // taskwait or the end of a taskgroup
+  kmp_wait_lock, // critical section, ordered or omp_set_[nest_]lock
+  kmp_wait_overhead, // in the runtime, e.g. forking or getting a chunk
+  kmp_wait_idle, // a worker waiting for the next parallel region
+  kmp_wait_last
+};
+
+extern int __kmp_wait_profile;
+extern int __kmp_wait_profile_interval;
+extern char const *__kmp_wait_profile_file;
+
+extern void __kmp_wait_profile_init(void);
+extern void __kmp_wait_profile_fini(void);
+
+#endif // KMP_WAIT_PROFILE_H
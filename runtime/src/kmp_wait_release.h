@@ -120,6 +120,7 @@ static inline void __ompt_implicit_task_end(kmp_info_t *this_thr,
 #endif
       // return to idle state
       this_thr->th.ompt_thread_info.state = omp_state_idle;
+      this_thr->th.ompt_thread_info.ident = NULL;
     } else {
       this_thr->th.ompt_thread_info.state = omp_state_overhead;
     }
@@ -154,6 +155,8 @@ __kmp_wait_template(kmp_info_t *this_thr, C *flag,
   th_gtid = this_thr->th.th_info.ds.ds_gtid;
   KA_TRACE(20,
            ("__kmp_wait_sleep: T#%d waiting for flag(%p)\n", th_gtid, flag));
+  KMP_PERF_WAIT_BEGIN(perf_start);
+  kmp_uint64 perf_sleep = 0;
 #if KMP_STATS_ENABLED
   stats_state_e thread_state = KMP_GET_THREAD_STATE();
 #endif
@@ -332,7 +335,11 @@ final_spin=FALSE)
     // TODO: Should it be number of cores instead of thread contexts? Like:
     // KMP_YIELD(TCR_4(__kmp_nth) > __kmp_ncores);
     // Need performance improvement data to make the change...
-    if (oversubscribed) {
+    if (oversubscribed
+#if KMP_OS_LINUX
+        || TCR_4(__kmp_sys_oversubscribed)
+#endif
+        ) {
       KMP_YIELD(1);
     } else {
       KMP_YIELD_SPIN(spins);
@@ -376,17 +383,28 @@ final_spin=FALSE)
     if ((task_team != NULL) && TCR_4(task_team->tt.tt_found_tasks))
       continue;
 
+#if KMP_OS_LINUX
+    // Other processes wait for the processor: sleep without spinning for the
+    // rest of the blocktime, unless KMP_BLOCKTIME was set explicitly.
+    if (__kmp_env_blocktime || !TCR_4(__kmp_sys_oversubscribed))
+#endif
+    {
 #if KMP_USE_MONITOR
-    // If we have waited a bit more, fall asleep
-    if (TCR_4(__kmp_global.g.g_time.dt.t_value) < hibernate)
-      continue;
+      // If we have waited a bit more, fall asleep
+      if (TCR_4(__kmp_global.g.g_time.dt.t_value) < hibernate)
+        continue;
 #else
-    if (KMP_BLOCKING(hibernate_goal, poll_count++))
-      continue;
+      if (KMP_BLOCKING(hibernate_goal, poll_count++))
+        continue;
 #endif
+    }
 
     KF_TRACE(50, ("__kmp_wait_sleep: T#%d suspend time reached\n", th_gtid));
+    KMP_PERF_WAIT_BEGIN(perf_suspend);
     flag->suspend(th_gtid);
+    if (__kmp_perf_wait_timing)
+      perf_sleep += KMP_PERF_NOW() - perf_suspend;
+    KMP_PERF_INC(this_thr, sleeps);
 
     if (TCR_4(__kmp_global.g.g_done)) {
       if (__kmp_global.g.g_abort)
@@ -427,6 +445,10 @@ final_spin=FALSE)
   }
 #endif
 
+  if (__kmp_perf_wait_timing) {
+    KMP_PERF_ADD(this_thr, sleep_time, perf_sleep);
+    KMP_PERF_ADD(this_thr, spin_time, KMP_PERF_NOW() - perf_start - perf_sleep);
+  }
   KMP_FSYNC_SPIN_ACQUIRED(CCAST(typename C::flag_t *, spin));
 }
 
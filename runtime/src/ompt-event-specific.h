@@ -51,16 +51,19 @@
 #define ompt_callback_implicit_task_implemented ompt_event_MAY_ALWAYS
 
 /*----------------------------------------------------------------------------
- | Target Related Events (not yet implemented)
+ | Target Related Events (dispatched by libomptarget, if it registered)
  +--------------------------------------------------------------------------*/
 
-#define ompt_callback_target_implemented ompt_event_UNIMPLEMENTED
-#define ompt_callback_target_data_op_implemented ompt_event_UNIMPLEMENTED
-#define ompt_callback_target_submit_implemented ompt_event_UNIMPLEMENTED
-#define ompt_callback_device_initialize_implemented ompt_event_UNIMPLEMENTED
-#define ompt_callback_device_finalize_implemented ompt_event_UNIMPLEMENTED
+#define ompt_event_TARGET                                                      \
+  (libomptarget_ompt_fns ? ompt_event_MAY_ALWAYS : ompt_event_UNIMPLEMENTED)
 
-#define ompt_callback_target_map_implemented ompt_event_UNIMPLEMENTED
+#define ompt_callback_target_implemented ompt_event_TARGET
+#define ompt_callback_target_data_op_implemented ompt_event_TARGET
+#define ompt_callback_target_submit_implemented ompt_event_TARGET
+#define ompt_callback_device_initialize_implemented ompt_event_TARGET
+#define ompt_callback_device_finalize_implemented ompt_event_TARGET
+
+#define ompt_callback_target_map_implemented ompt_event_TARGET
 
 /*----------------------------------------------------------------------------
  | Optional Events (blame shifting)
@@ -18,6 +18,7 @@
  ****************************************************************************/
 
 #include "ompt-specific.cpp"
+#include "kmp_wait_profile.h"
 
 /*****************************************************************************
  * macros
@@ -82,6 +83,11 @@ ompt_callbacks_internal_t ompt_callbacks;
 
 static ompt_fns_t *ompt_fns = NULL;
 
+// Set when libomptarget registered through ompt_libomp_connect()
+ompt_fns_t *libomptarget_ompt_fns = NULL;
+// libomptarget was initialized with the lookup function of the tool
+static int libomptarget_ompt_initialized = 0;
+
 /*****************************************************************************
  * forward declarations
  ****************************************************************************/
@@ -315,6 +321,11 @@ void ompt_post_init() {
   //--------------------------------------------------
   if (ompt_fns) {
     ompt_enabled.enabled = !!ompt_fns->initialize(ompt_fn_lookup, ompt_fns);
+    // libomptarget sees the target callbacks the tool just registered
+    if (ompt_enabled.enabled && libomptarget_ompt_fns)
+      libomptarget_ompt_initialized =
+          libomptarget_ompt_fns->initialize(ompt_fn_lookup,
+                                            libomptarget_ompt_fns);
 
     ompt_thread_t *root_thread = ompt_get_thread();
 
@@ -334,16 +345,50 @@ void ompt_post_init() {
 
     ompt_set_thread_state(root_thread, omp_state_work_serial);
   }
+
+  // KMP_WAIT_PROFILE samples the states, which are kept only while OMPT is
+  // enabled; without a tool no callback is.
+  if (__kmp_wait_profile && !ompt_enabled.enabled) {
+    ompt_fns = NULL; // a tool that declined is not finalized either
+    memset(&ompt_enabled, 0, sizeof(ompt_enabled));
+    ompt_enabled.enabled = 1;
+    ompt_set_thread_state(ompt_get_thread(), omp_state_work_serial);
+  }
 }
 
 void ompt_fini() {
   if (ompt_enabled.enabled) {
-    ompt_fns->finalize(ompt_fns);
+    // The device finalize events of libomptarget precede the tool's finalize
+    if (libomptarget_ompt_initialized)
+      libomptarget_ompt_fns->finalize(libomptarget_ompt_fns);
+    if (ompt_fns)
+      ompt_fns->finalize(ompt_fns);
   }
+  libomptarget_ompt_initialized = 0;
 
   memset(&ompt_enabled, 0, sizeof(ompt_enabled));
 }
 
+/* libomptarget does not see the tool: it hands its own ompt_fns_t to the host
+ * runtime when it is loaded. From then on the target callbacks are reported
+ * as implemented, and once the tool is initialized, libomptarget is
+ * initialized with the same lookup function, so that it finds the registered
+ * target callbacks through ompt_get_callback(). Nothing is initialized if no
+ * tool is active. */
+_OMP_EXTERN void ompt_libomp_connect(ompt_fns_t *fns) {
+  if (!fns)
+    return;
+  __kmp_acquire_bootstrap_lock(&__kmp_initz_lock);
+  if (!libomptarget_ompt_fns) {
+    libomptarget_ompt_fns = fns;
+    // Loaded after the tool was initialized: the tool saw no target callback
+    if (TCR_4(__kmp_init_serial) && ompt_enabled.enabled && ompt_fns)
+      libomptarget_ompt_initialized =
+          fns->initialize(ompt_fn_lookup, fns);
+  }
+  __kmp_release_bootstrap_lock(&__kmp_initz_lock);
+}
+
 /*****************************************************************************
  * interface operations
  ****************************************************************************/
@@ -72,6 +72,7 @@ typedef struct {
   void *return_address; /* stored here on entry of runtime */
   omp_state_t state;
   ompt_wait_id_t wait_id;
+  ident_t *ident; /* construct of the state, for KMP_WAIT_PROFILE */
   int ompt_task_yielded;
   void *idle_frame;
 } ompt_thread_info_t;
@@ -103,6 +104,9 @@ int __kmp_control_tool(uint64_t command, uint64_t modifier, void *arg);
 
 extern ompt_callbacks_active_t ompt_enabled;
 
+// The ompt_fns_t of libomptarget, NULL unless it registered
+extern ompt_fns_t *libomptarget_ompt_fns;
+
 #if KMP_OS_WINDOWS
 #define UNLIKELY(x) (x)
 #define OMPT_NOINLINE __declspec(noinline)
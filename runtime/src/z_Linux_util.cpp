@@ -120,16 +120,24 @@ void __kmp_affinity_determine_capable(const char *env_var) {
 // Check and see if the OS supports thread affinity.
 
 #define KMP_CPU_SET_SIZE_LIMIT (1024 * 1024)
+#define KMP_CPU_SET_SIZE_INITIAL 4096
 
   int gCode;
   int sCode;
-  unsigned char *buf;
-  buf = (unsigned char *)KMP_INTERNAL_MALLOC(KMP_CPU_SET_SIZE_LIMIT);
+  unsigned char *buf = NULL;
+  unsigned char initial_buf[KMP_CPU_SET_SIZE_INITIAL];
 
   // If Linux* OS:
   // If the syscall fails or returns a suggestion for the size,
   // then we don't have to search for an appropriate size.
-  gCode = syscall(__NR_sched_getaffinity, 0, KMP_CPU_SET_SIZE_LIMIT, buf);
+  // A small buffer on the stack holds the mask of up to 32K procs; the large
+  // one is only allocated if the kernel needs more.
+  gCode = syscall(__NR_sched_getaffinity, 0, KMP_CPU_SET_SIZE_INITIAL,
+                  initial_buf);
+  if (gCode < 0 && errno == EINVAL) {
+    buf = (unsigned char *)KMP_INTERNAL_MALLOC(KMP_CPU_SET_SIZE_LIMIT);
+    gCode = syscall(__NR_sched_getaffinity, 0, KMP_CPU_SET_SIZE_LIMIT, buf);
+  }
   KA_TRACE(30, ("__kmp_affinity_determine_capable: "
                 "initial getaffinity call returned %d errno = %d\n",
                 gCode, errno));
@@ -195,6 +203,9 @@ void __kmp_affinity_determine_capable(const char *env_var) {
   // until we succeed, or reach an upper bound on the search.
   KA_TRACE(30, ("__kmp_affinity_determine_capable: "
                 "searching for proper set size\n"));
+  if (buf == NULL) {
+    buf = (unsigned char *)KMP_INTERNAL_MALLOC(KMP_CPU_SET_SIZE_LIMIT);
+  }
   int size;
   for (size = 1; size <= KMP_CPU_SET_SIZE_LIMIT; size *= 2) {
     gCode = syscall(__NR_sched_getaffinity, 0, size, buf);
@@ -516,6 +527,8 @@ static void *__kmp_launch_worker(void *thr) {
   KMP_SET_THREAD_STATE(IDLE);
   KMP_INIT_PARTITIONED_TIMERS(OMP_idle);
 #endif
+  // Before binding, so that the new threads do not inherit this thread's mask
+  __kmp_spawn_workers((kmp_info_t *)thr);
 
 #if USE_ITT_BUILD
   __kmp_itt_thread_name(gtid);
@@ -1341,6 +1354,15 @@ static void __kmp_atfork_child(void) {
   __kmp_init_bootstrap_lock(&__kmp_stdio_lock);
   __kmp_init_bootstrap_lock(&__kmp_console_lock);
 
+  __kmp_async_reset();
+#if KMP_USE_BGET
+  __kmp_atfork_sizeclass();
+#endif
+#if KMP_OS_LINUX
+  __kmp_atfork_arena();
+  __kmp_oversub_reset();
+#endif
+
   /* This is necessary to make sure no stale data is left around */
   /* AC: customers complain that we use unsafe routines in the atfork
      handler. Mathworks: dlsym() is unsafe. We call dlsym and dlopen
@@ -1463,6 +1485,9 @@ static inline void __kmp_suspend_template(int th_gtid, C *flag) {
           KMP_TEST_THEN_DEC32(&__kmp_thread_pool_active_nth);
           KMP_DEBUG_ASSERT(TCR_4(__kmp_thread_pool_active_nth) >= 0);
         }
+#if KMP_OS_LINUX
+        KMP_TEST_THEN_INC32(&__kmp_nth_sleeping);
+#endif
         deactivated = TRUE;
       }
 
@@ -1515,6 +1540,9 @@ static inline void __kmp_suspend_template(int th_gtid, C *flag) {
     // Mark the thread as active again (if it was previous marked as inactive)
     if (deactivated) {
       th->th.th_active = TRUE;
+#if KMP_OS_LINUX
+      KMP_TEST_THEN_DEC32(&__kmp_nth_sleeping);
+#endif
       if (TCR_4(th->th.th_in_pool)) {
         KMP_TEST_THEN_INC32(&__kmp_thread_pool_active_nth);
         th->th.th_active_in_pool = TRUE;
@@ -2315,6 +2343,194 @@ finish: // Clean up and exit.
 
 #endif // USE_LOAD_BALANCE
 
+#if KMP_OS_LINUX
+
+// The system load sampler thread and its state, only it updates the samples.
+static pthread_t __kmp_oversub_thread;
+static int __kmp_oversub_running = FALSE; // the thread exists
+static int __kmp_oversub_stop = FALSE; // asks it to end
+static pthread_mutex_t __kmp_oversub_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t __kmp_oversub_cond = PTHREAD_COND_INITIALIZER;
+static kmp_int64 __kmp_oversub_last = 0; // time of the last sample
+static kmp_uint64 __kmp_oversub_delay = 0; // run queue delay then
+static kmp_uint64 __kmp_oversub_steal = 0; // steal ticks of /proc/stat
+static kmp_uint64 __kmp_oversub_total = 0; // all ticks of /proc/stat
+
+// Reads the beginning of a /proc file into buffer, returns FALSE on error.
+static int __kmp_read_proc_file(char const *path, char *buffer, int size) {
+  int fd = open(path, O_RDONLY);
+  int len;
+  if (fd < 0)
+    return FALSE;
+  len = read(fd, buffer, size - 1);
+  close(fd);
+  if (len <= 0)
+    return FALSE;
+  buffer[len] = '\0';
+  return TRUE;
+}
+
+// Samples the system load and sets __kmp_sys_oversubscribed when other
+// processes compete for the processors the runtime spins on. Called every
+// KMP_OVERSUB_CHECK milliseconds by the sampler thread, never by the threads
+// of the teams. Three signals are used:
+//   - the runnable threads of /proc/loadavg that are not ours,
+//   - the share of time the sampler spent waiting in a run queue after its
+//     wake-up (/proc/thread-self/schedstat), which also covers our own
+//     threads,
+//   - the share of CPU time stolen by the hypervisor (/proc/stat).
+// Any of them over its high mark turns the state on, all of them under their
+// low mark turn it off again, so that the waiting policy does not flap. While
+// the state is on, waiting threads yield and suspend without spinning for the
+// blocktime, and teams of a dyn-var region are cut to __kmp_sys_free_procs.
+static void __kmp_check_oversubscription(void) {
+  char buffer[256];
+  kmp_int64 now, last;
+  int running, ours, others, free_procs;
+  int delay_pct = 0, steal_pct = 0;
+  int high, low;
+
+  now = (kmp_int64)__kmp_now_nsec();
+  last = __kmp_oversub_last;
+  __kmp_oversub_last = now;
+
+  // Runnable threads of the system, minus the sampler and the threads of this
+  // process that are not suspended.
+  running = 0;
+  if (__kmp_read_proc_file("/proc/loadavg", buffer, sizeof(buffer)))
+    KMP_SSCANF(buffer, "%*f %*f %*f %d/", &running);
+  ours = TCR_4(__kmp_nth) - TCR_4(__kmp_nth_sleeping);
+  others = running - 1 - (ours > 0 ? ours : 0);
+  if (others < 0)
+    others = 0;
+
+  // Run queue delay of the sampler since its previous sample
+  if (__kmp_read_proc_file("/proc/thread-self/schedstat", buffer,
+                           sizeof(buffer))) {
+    unsigned long long run_ns, delay_ns;
+    if (KMP_SSCANF(buffer, "%llu %llu", &run_ns, &delay_ns) == 2) {
+      if (last != 0 && now > last && delay_ns >= __kmp_oversub_delay)
+        delay_pct = (int)(100 * (delay_ns - __kmp_oversub_delay) /
+                          (kmp_uint64)(now - last));
+      __kmp_oversub_delay = delay_ns;
+    }
+  }
+
+  // Stolen share of all CPU ticks since the previous sample
+  if (__kmp_read_proc_file("/proc/stat", buffer, sizeof(buffer))) {
+    unsigned long long t[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    if (KMP_SSCANF(buffer, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &t[0], &t[1], &t[2], &t[3], &t[4], &t[5], &t[6],
+                   &t[7]) >= 4) {
+      kmp_uint64 total = t[0] + t[1] + t[2] + t[3] + t[4] + t[5] + t[6] + t[7];
+      if (__kmp_oversub_total != 0 && total > __kmp_oversub_total)
+        steal_pct = (int)(100 * (t[7] - __kmp_oversub_steal) /
+                          (total - __kmp_oversub_total));
+      __kmp_oversub_steal = t[7];
+      __kmp_oversub_total = total;
+    }
+  }
+
+  free_procs = __kmp_xproc - others;
+  if (steal_pct > 0)
+    free_procs -= (__kmp_xproc * steal_pct + 99) / 100;
+  // A team keeps at least its master, but on a single processor the one
+  // process holding it is an oversubscription as well.
+  TCW_4(__kmp_sys_free_procs, free_procs < 1 ? 1 : free_procs);
+
+  // The runtime wants __kmp_avail_proc processors. Another process holding
+  // more than an eighth of them, or 10% of delay or steal, is an
+  // oversubscription; it is over once all of them are free and delay and
+  // steal are below 2%.
+  high = __kmp_avail_proc - __kmp_avail_proc / 8;
+  low = __kmp_avail_proc;
+  if (!TCR_4(__kmp_sys_oversubscribed)) {
+    if (free_procs < high || delay_pct > 10 || steal_pct > 10) {
+      KA_TRACE(10, ("__kmp_check_oversubscription: oversubscribed: "
+                    "%d other runnable threads, delay %d%%, steal %d%%\n",
+                    others, delay_pct, steal_pct));
+      TCW_4(__kmp_sys_oversubscribed, TRUE);
+    }
+  } else if (free_procs >= low && delay_pct < 2 && steal_pct < 2) {
+    KA_TRACE(10, ("__kmp_check_oversubscription: no longer oversubscribed\n"));
+    TCW_4(__kmp_sys_oversubscribed, FALSE);
+  }
+}
+
+static void *__kmp_oversub_main(void *arg) {
+  sigset_t mask;
+  struct timespec deadline;
+
+  // Signals of the program go to its own threads.
+  sigfillset(&mask);
+  pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+  pthread_mutex_lock(&__kmp_oversub_mutex);
+  while (!__kmp_oversub_stop) {
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += __kmp_oversub_check / 1000;
+    deadline.tv_nsec += (long)(__kmp_oversub_check % 1000) * 1000000;
+    if (deadline.tv_nsec >= KMP_NSEC_PER_SEC) {
+      deadline.tv_nsec -= KMP_NSEC_PER_SEC;
+      ++deadline.tv_sec;
+    }
+    while (!__kmp_oversub_stop &&
+           pthread_cond_timedwait(&__kmp_oversub_cond, &__kmp_oversub_mutex,
+                                  &deadline) != ETIMEDOUT)
+      ;
+    if (__kmp_oversub_stop)
+      break;
+    pthread_mutex_unlock(&__kmp_oversub_mutex);
+    __kmp_check_oversubscription();
+    pthread_mutex_lock(&__kmp_oversub_mutex);
+  }
+  pthread_mutex_unlock(&__kmp_oversub_mutex);
+  return arg;
+}
+
+// Starts the sampler thread if KMP_OVERSUB_CHECK is set, called once the
+// runtime is ready to fork teams.
+void __kmp_oversub_init(void) {
+  int status;
+
+  if (__kmp_oversub_check <= 0 || __kmp_oversub_running)
+    return;
+  __kmp_oversub_stop = FALSE;
+  __kmp_oversub_last = 0;
+  status = pthread_create(&__kmp_oversub_thread, NULL, __kmp_oversub_main,
+                          NULL);
+  if (status != 0) {
+    // The waiting policy just stays as it is.
+    KA_TRACE(10, ("__kmp_oversub_init: pthread_create failed: %d\n", status));
+    return;
+  }
+  __kmp_oversub_running = TRUE;
+}
+
+// Stops and joins the sampler thread at shutdown.
+void __kmp_oversub_fini(void) {
+  if (!__kmp_oversub_running)
+    return;
+  pthread_mutex_lock(&__kmp_oversub_mutex);
+  __kmp_oversub_stop = TRUE;
+  pthread_cond_signal(&__kmp_oversub_cond);
+  pthread_mutex_unlock(&__kmp_oversub_mutex);
+  pthread_join(__kmp_oversub_thread, NULL);
+  __kmp_oversub_running = FALSE;
+  TCW_4(__kmp_sys_oversubscribed, FALSE);
+}
+
+// The sampler does not exist in the child of fork(); it is started again with
+// the parallel initialization of the child.
+void __kmp_oversub_reset(void) {
+  pthread_mutex_init(&__kmp_oversub_mutex, NULL);
+  pthread_cond_init(&__kmp_oversub_cond, NULL);
+  __kmp_oversub_running = FALSE;
+  TCW_4(__kmp_sys_oversubscribed, FALSE);
+}
+
+#endif // KMP_OS_LINUX
+
 #if !(KMP_ARCH_X86 || KMP_ARCH_X86_64 || KMP_MIC ||                            \
       ((KMP_OS_LINUX || KMP_OS_DARWIN) && KMP_ARCH_AARCH64) || KMP_ARCH_PPC64)
 
@@ -905,6 +905,7 @@ void *__stdcall __kmp_launch_worker(void *arg) {
         "reference: http://support.microsoft.com/kb/118816"
 //__kmp_gtid = gtid;
 #endif
+  __kmp_spawn_workers(this_thr);
 
 #if USE_ITT_BUILD
   __kmp_itt_thread_name(gtid);
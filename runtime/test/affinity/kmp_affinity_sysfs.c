@@ -0,0 +1,182 @@
+// RUN: %libomp-compile && %libomp-run make %t.sys
+// REQUIRES: linux
+// RUN: env KMP_SYSFS_ROOT=%t.sys KMP_TOPOLOGY_METHOD=sysfs OMP_PLACES=threads %libomp-run threads
+// RUN: env KMP_SYSFS_ROOT=%t.sys KMP_TOPOLOGY_METHOD=sysfs OMP_PLACES=cores %libomp-run cores
+// RUN: env KMP_SYSFS_ROOT=%t.sys KMP_TOPOLOGY_METHOD=sysfs OMP_PLACES=sockets %libomp-run sockets
+// RUN: env KMP_SYSFS_ROOT=%t.sys KMP_TOPOLOGY_METHOD=sysfs KMP_AFFINITY=compact KMP_FORKJOIN_BARRIER_PATTERN=hier,hier KMP_PLAIN_BARRIER_PATTERN=hier,hier %libomp-run hier
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+// The fake sysfs tree describes the procs this process may run on, the k-th
+// of them being thread k%2 of a core, with two cores per L2 cache, two L2
+// caches per L3 cache, two L3 caches per NUMA node and two nodes per package.
+#define PROCS_PER_CORE 2
+#define PROCS_PER_L2 4
+#define PROCS_PER_L3 8
+#define PROCS_PER_NODE 16
+#define PROCS_PER_PACKAGE 32
+
+static int nprocs;
+static int procs[CPU_SETSIZE];
+
+static void get_procs() {
+  cpu_set_t set;
+  int i;
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+    perror("sched_getaffinity");
+    exit(1);
+  }
+  for (i = 0; i < CPU_SETSIZE; i++)
+    if (CPU_ISSET(i, &set))
+      procs[nprocs++] = i;
+}
+
+static void make_dirs(char *path) {
+  char *p;
+  for (p = path + 1; *p; p++) {
+    if (*p == '/') {
+      *p = '\0';
+      mkdir(path, 0755);
+      *p = '/';
+    }
+  }
+}
+
+static void write_file(const char *root, const char *name, const char *fmt,
+                       ...) {
+  char path[1024];
+  va_list args;
+  FILE *f;
+  snprintf(path, sizeof(path), "%s/%s", root, name);
+  make_dirs(path);
+  f = fopen(path, "w");
+  if (f == NULL) {
+    perror(path);
+    exit(1);
+  }
+  va_start(args, fmt);
+  vfprintf(f, fmt, args);
+  va_end(args);
+  fclose(f);
+}
+
+// Write the ids of the procs [first, first + size) to root/name.
+static void write_list(const char *root, const char *name, int first,
+                       int size) {
+  char buf[8 * CPU_SETSIZE];
+  int k, len = 0;
+  buf[0] = '\0';
+  for (k = first; k < first + size && k < nprocs; k++)
+    len += sprintf(buf + len, "%s%d", k > first ? "," : "", procs[k]);
+  write_file(root, name, "%s\n", buf);
+}
+
+static void write_cache(const char *root, int cpu, int index, int level,
+                        const char *type, int first, int size) {
+  char name[256];
+  snprintf(name, sizeof(name), "devices/system/cpu/cpu%d/cache/index%d/level",
+           cpu, index);
+  write_file(root, name, "%d\n", level);
+  snprintf(name, sizeof(name), "devices/system/cpu/cpu%d/cache/index%d/type",
+           cpu, index);
+  write_file(root, name, "%s\n", type);
+  snprintf(name, sizeof(name),
+           "devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+  write_list(root, name, first, size);
+}
+
+static void make_tree(const char *root) {
+  char name[256], nodes[64];
+  int k, cpu;
+  for (k = 0; k < nprocs; k++) {
+    int core = k / PROCS_PER_CORE * PROCS_PER_CORE;
+    int l2 = k / PROCS_PER_L2 * PROCS_PER_L2;
+    int l3 = k / PROCS_PER_L3 * PROCS_PER_L3;
+    cpu = procs[k];
+    snprintf(name, sizeof(name),
+             "devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    write_file(root, name, "%d\n", k / PROCS_PER_PACKAGE);
+    snprintf(name, sizeof(name), "devices/system/cpu/cpu%d/topology/core_id",
+             cpu);
+    write_file(root, name, "%d\n",
+               k % PROCS_PER_PACKAGE / PROCS_PER_CORE);
+    snprintf(name, sizeof(name),
+             "devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    write_list(root, name, core, PROCS_PER_CORE);
+
+    write_cache(root, cpu, 0, 1, "Data", core, PROCS_PER_CORE);
+    write_cache(root, cpu, 1, 1, "Instruction", core, PROCS_PER_CORE);
+    write_cache(root, cpu, 2, 2, "Unified", l2, PROCS_PER_L2);
+    write_cache(root, cpu, 3, 3, "Unified", l3, PROCS_PER_L3);
+  }
+  for (k = 0; k < nprocs; k += PROCS_PER_NODE) {
+    snprintf(name, sizeof(name), "devices/system/node/node%d/cpulist",
+             k / PROCS_PER_NODE);
+    write_list(root, name, k, PROCS_PER_NODE);
+  }
+  snprintf(nodes, sizeof(nodes), "0-%d", (nprocs - 1) / PROCS_PER_NODE);
+  write_file(root, "devices/system/node/online", "%s\n", nodes);
+}
+
+// Check that the places have the expected number of procs each.
+static int check_places(int procs_per_place) {
+  int p, total = 0, err = 0;
+  int nplaces = omp_get_num_places();
+  int expected = (nprocs + procs_per_place - 1) / procs_per_place;
+  if (nplaces != expected) {
+    fprintf(stderr, "error: %d places, expected %d\n", nplaces, expected);
+    return 1;
+  }
+  for (p = 0; p < nplaces; p++) {
+    int n = omp_get_place_num_procs(p);
+    if (n < 1 || n > procs_per_place) {
+      fprintf(stderr, "error: place %d has %d procs\n", p, n);
+      err++;
+    }
+    total += n;
+  }
+  if (total != nprocs) {
+    fprintf(stderr, "error: places cover %d procs, expected %d\n", total,
+            nprocs);
+    err++;
+  }
+  return err;
+}
+
+int main(int argc, char **argv) {
+  get_procs();
+  if (argc > 2 && !strcmp(argv[1], "make")) {
+    make_tree(argv[2]);
+    return 0;
+  }
+  if (argc > 1 && !strcmp(argv[1], "threads"))
+    return check_places(1);
+  if (argc > 1 && !strcmp(argv[1], "cores"))
+    return check_places(PROCS_PER_CORE);
+  if (argc > 1 && !strcmp(argv[1], "sockets"))
+    return check_places(PROCS_PER_PACKAGE);
+  if (argc > 1 && !strcmp(argv[1], "hier")) {
+    int i, sum = 0;
+    for (i = 0; i < 10; i++) {
+      #pragma omp parallel num_threads(nprocs) reduction(+:sum)
+      {
+        #pragma omp barrier
+        sum += 1;
+      }
+    }
+    if (sum != 10 * nprocs) {
+      fprintf(stderr, "error: sum = %d, expected %d\n", sum, 10 * nprocs);
+      return 1;
+    }
+    return 0;
+  }
+  fprintf(stderr, "usage: %s make <dir> | threads | cores | sockets | hier\n",
+          argv[0]);
+  return 1;
+}
@@ -0,0 +1,120 @@
+// REQUIRES: linux
+// RUN: %libomp-compile
+// RUN: env OMP_PLACES='{0},{0},{0},{0}' OMP_PROC_BIND=close %libomp-run
+// RUN: env OMP_PLACES='{0},{0},{0},{0}' OMP_PROC_BIND=spread %libomp-run
+// RUN: env OMP_PLACES='{0},{0},{0},{0}' OMP_PROC_BIND=close KMP_PLACE_PARTITION=3:0 %libomp-run 3 0
+// RUN: env OMP_PROC_BIND=false %libomp-run none
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+static int in_partition(int place, int first, int last)
+{
+  if (first <= last)
+    return place >= first && place <= last;
+  return place >= first || place <= last;
+}
+
+// The root has a partition of nplaces places and every thread of a team is
+// bound inside it. With spread binding the threads get sub-partitions, so only
+// their places are checked.
+static int check_team(int nthreads, int first, int last, int nplaces)
+{
+  int err = 0;
+  if (omp_get_partition_num_places() != nplaces) {
+    printf("partition of %d places, expected %d\n",
+           omp_get_partition_num_places(), nplaces);
+    err++;
+  }
+  #pragma omp parallel num_threads(nthreads) shared(err)
+  {
+    int place = omp_get_place_num();
+    if (!in_partition(place, first, last)) {
+      #pragma omp critical
+      {
+        printf("T#%d: place %d, expected [%d,%d]\n", omp_get_thread_num(),
+               place, first, last);
+        err++;
+      }
+    }
+  }
+  return err;
+}
+
+int main(int argc, char **argv)
+{
+  int err = 0;
+
+  if (argc > 1 && strcmp(argv[1], "none") == 0) {
+    // Without places there is nothing to partition.
+    if (kmp_set_place_partition(0, 0) != -1) {
+      printf("partition accepted without places\n");
+      return 1;
+    }
+    return 0;
+  }
+  if (omp_get_num_places() != 4) {
+    printf("expected 4 places, got %d\n", omp_get_num_places());
+    return 1;
+  }
+
+  // Partition requested with KMP_PLACE_PARTITION
+  if (argc > 2) {
+    int first = atoi(argv[1]), last = atoi(argv[2]);
+    err += check_team(4, first, last, 2);
+    if (kmp_set_place_partition(0, 3) != 0) {
+      printf("full partition rejected\n");
+      err++;
+    }
+  }
+
+  // Hot team threads move into the new partition at the next fork, and the
+  // master right away.
+  err += check_team(4, 0, 3, 4);
+  if (kmp_set_place_partition(1, 2) != 0) {
+    printf("partition [1,2] rejected\n");
+    err++;
+  }
+  if (!in_partition(omp_get_place_num(), 1, 2)) {
+    printf("master still on place %d\n", omp_get_place_num());
+    err++;
+  }
+  err += check_team(4, 1, 2, 2);
+
+  // The default team size does not exceed the procs of the partition, which
+  // all map to proc 0.
+  #pragma omp parallel
+  #pragma omp single
+  if (omp_get_num_threads() != 1) {
+    printf("default team of %d threads\n", omp_get_num_threads());
+    err++;
+  }
+
+  // Partitions wrap around the end of the place list.
+  if (kmp_set_place_partition(3, 0) != 0) {
+    printf("partition [3,0] rejected\n");
+    err++;
+  }
+  err += check_team(3, 3, 0, 2);
+
+  // Invalid ranges and calls from inside a parallel region are rejected.
+  if (kmp_set_place_partition(0, 4) != -1 ||
+      kmp_set_place_partition(-1, 2) != -1) {
+    printf("invalid partition accepted\n");
+    err++;
+  }
+  #pragma omp parallel num_threads(2) shared(err)
+  #pragma omp master
+  if (kmp_set_place_partition(0, 3) != -1) {
+    printf("partition changed inside a parallel region\n");
+    err++;
+  }
+
+  if (kmp_set_place_partition(0, 3) != 0) {
+    printf("full partition rejected\n");
+    err++;
+  }
+  err += check_team(4, 0, 3, 4);
+  return err;
+}
@@ -0,0 +1,108 @@
+// RUN: %libomp-compile
+// RUN: %libomp-run
+// RUN: env KMP_BLOCKTIME=0 KMP_PERF_LOCK_TIMING=true KMP_PERF_WAIT_TIMING=true %libomp-run
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "omp_testsuite.h"
+#include "omp_my_sleep.h"
+
+#define NUM_THREADS 4
+#define NTASKS 64
+
+static int check(int cond, const char *what)
+{
+  if (!cond)
+    printf("failed: %s\n", what);
+  return !cond;
+}
+
+int main()
+{
+  kmp_perf_counters_t before, after, master;
+  omp_lock_t lock;
+  int i, n, err = 0, sum = 0;
+
+  n = kmp_get_perf_counters(-1, &before, sizeof(before));
+  err += check(n >= 0, "kmp_get_perf_counters(-1) before the first region");
+
+  omp_init_lock(&lock);
+  #pragma omp parallel num_threads(NUM_THREADS) shared(sum)
+  {
+    #pragma omp single
+    for (i = 0; i < NTASKS; i++) {
+      #pragma omp task shared(sum)
+      {
+        #pragma omp atomic
+        sum++;
+      }
+    }
+    #pragma omp for schedule(monotonic: dynamic, 1)
+    for (i = 0; i < 100; i++) {
+      #pragma omp atomic
+      sum++;
+    }
+    #pragma omp critical
+    sum++;
+    omp_set_lock(&lock);
+    sum++;
+    omp_unset_lock(&lock);
+    #pragma omp barrier
+  }
+  omp_destroy_lock(&lock);
+  // Let the workers fall asleep with KMP_BLOCKTIME=0.
+  my_sleep(0.1);
+  #pragma omp parallel num_threads(NUM_THREADS)
+  {
+    #pragma omp barrier
+  }
+  if (sum != NTASKS + 100 + 2 * NUM_THREADS) {
+    printf("sum = %d\n", sum);
+    return 1;
+  }
+
+  n = kmp_get_perf_counters(-1, &after, sizeof(after));
+  err += check(n >= NUM_THREADS, "threads counted");
+  err += check(after.forks - before.forks == 2, "forks");
+  err += check(after.joins - before.joins == 2, "joins");
+  err += check(after.barriers - before.barriers >= 3 * NUM_THREADS, "barriers");
+  if (getenv("KMP_PERF_WAIT_TIMING") != NULL)
+    err += check(after.barrier_ns > before.barrier_ns, "barrier_ns");
+  else
+    err += check(after.barrier_ns == 0 && after.spin_ns == 0 &&
+                     after.sleep_ns == 0, "barrier_ns without timing");
+  err += check(after.tasks_executed - before.tasks_executed >= NTASKS,
+               "tasks_executed");
+  err += check(after.dispatch_chunks - before.dispatch_chunks == 100,
+               "dispatch_chunks");
+  err += check(after.lock_acquires - before.lock_acquires ==
+                   2 * NUM_THREADS, "lock_acquires");
+  if (getenv("KMP_BLOCKTIME") != NULL)
+    err += check(after.sleeps > before.sleeps && after.sleep_ns > 0, "sleeps");
+  if (getenv("KMP_PERF_LOCK_TIMING") != NULL)
+    err += check(after.lock_wait_ns > before.lock_wait_ns, "lock_wait_ns");
+  else
+    err += check(after.lock_wait_ns == 0, "lock_wait_ns without timing");
+
+  // The master is thread 0; its counters are part of the sum.
+  n = kmp_get_perf_counters(0, &master, sizeof(master));
+  err += check(n == 1, "kmp_get_perf_counters(0)");
+  err += check(master.forks == after.forks && master.joins == after.joins,
+               "forks of the master");
+  err += check(master.barriers <= after.barriers, "barriers of the master");
+  err += check(kmp_get_perf_counters(1 << 20, &master, sizeof(master)) == -1,
+               "invalid thread");
+
+  // A smaller structure only receives its leading fields.
+  {
+    unsigned long long partial[3] = {0, 0, 12345};
+    kmp_get_perf_counters(-1, (kmp_perf_counters_t *)partial,
+                          2 * sizeof(partial[0]));
+    err += check(partial[0] >= after.forks && partial[2] == 12345,
+                 "partial structure");
+  }
+
+  if (err == 0)
+    printf("passed\n");
+  return err;
+}
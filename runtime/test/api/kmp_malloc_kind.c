@@ -0,0 +1,129 @@
+// RUN: %libomp-compile
+// RUN: env KMP_MALLOC_KIND=sizeclass %libomp-run
+// RUN: env KMP_MALLOC_KIND=bget %libomp-run
+#include <stdio.h>
+#include <string.h>
+#include <omp.h>
+#include "omp_testsuite.h"
+
+#define NUM_THREADS 4
+#define NUM_BLOCKS 256
+
+size_t sizes[] = {1, 8, 16, 17, 255, 257, 1000, 4096, 16384, 16385, 65536,
+                  200000};
+
+// Allocate blocks of all sizes, check they do not overlap and release them
+int test_sizes()
+{
+  int err = 0;
+  #pragma omp parallel num_threads(NUM_THREADS) shared(err)
+  {
+    int n = sizeof(sizes) / sizeof(sizes[0]);
+    unsigned char *p[sizeof(sizes) / sizeof(sizes[0])];
+    int i, rep;
+    for (rep = 0; rep < 10; rep++) {
+      for (i = 0; i < n; i++) {
+        p[i] = (unsigned char *)kmp_malloc(sizes[i]);
+        if (p[i] == NULL) {
+          #pragma omp atomic
+          err++;
+          continue;
+        }
+        memset(p[i], i, sizes[i]);
+      }
+      for (i = 0; i < n; i++) {
+        size_t j;
+        if (p[i] == NULL)
+          continue;
+        for (j = 0; j < sizes[i]; j++)
+          if (p[i][j] != (unsigned char)i)
+            break;
+        if (j != sizes[i]) {
+          printf("block of %d bytes overwritten\n", (int)sizes[i]);
+          #pragma omp atomic
+          err++;
+        }
+        kmp_free(p[i]);
+      }
+    }
+  }
+  return !err;
+}
+
+int test_calloc_realloc()
+{
+  int err = 0;
+  #pragma omp parallel num_threads(NUM_THREADS) shared(err)
+  {
+    size_t size, i;
+    unsigned char *p = (unsigned char *)kmp_calloc(100, 100);
+    for (i = 0; p != NULL && i < 10000; i++)
+      if (p[i] != 0)
+        break;
+    if (p == NULL || i != 10000) {
+      #pragma omp atomic
+      err++;
+    }
+    kmp_free(p);
+
+    // Grow and shrink through the size classes into large blocks and back
+    p = (unsigned char *)kmp_malloc(10);
+    memset(p, 0x5a, 10);
+    for (size = 20; size < 300000; size *= 3) {
+      p = (unsigned char *)kmp_realloc(p, size);
+      if (p == NULL || p[0] != 0x5a || p[9] != 0x5a) {
+        #pragma omp atomic
+        err++;
+        break;
+      }
+    }
+    if (p != NULL) {
+      p = (unsigned char *)kmp_realloc(p, 12);
+      if (p == NULL || p[0] != 0x5a || p[9] != 0x5a) {
+        #pragma omp atomic
+        err++;
+      }
+      kmp_free(p);
+    }
+  }
+  return !err;
+}
+
+// Blocks are allocated by one thread and released by the next one
+int test_cross_thread()
+{
+  int err = 0;
+  static void *blocks[NUM_THREADS][NUM_BLOCKS];
+  #pragma omp parallel num_threads(NUM_THREADS) shared(blocks, err)
+  {
+    int i, rep, n = omp_get_num_threads();
+    int tid = omp_get_thread_num();
+    for (rep = 0; rep < 20; rep++) {
+      for (i = 0; i < NUM_BLOCKS; i++) {
+        blocks[tid][i] = kmp_malloc(16 + (i * 37 + rep) % 2000);
+        if (blocks[tid][i] == NULL) {
+          #pragma omp atomic
+          err++;
+        }
+      }
+      #pragma omp barrier
+      for (i = 0; i < NUM_BLOCKS; i++)
+        kmp_free(blocks[(tid + 1) % n][i]);
+      #pragma omp barrier
+    }
+  }
+  return !err;
+}
+
+int main()
+{
+  int i;
+  int num_failed=0;
+
+  for(i = 0; i < REPETITIONS; i++) {
+    if(!test_sizes() || !test_calloc_realloc() || !test_cross_thread()) {
+      num_failed++;
+    }
+  }
+  return num_failed;
+}
@@ -0,0 +1,114 @@
+// RUN: %libomp-compile-and-run
+// RUN: env OMP_PROC_BIND=spread %libomp-run
+// RUN: env OMP_NUM_THREADS=3 %libomp-run
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "omp_testsuite.h"
+
+#define SIZE (8 << 20)
+
+// Sizes and offsets that do not fall on page boundaries
+size_t sizes[] = {1, 100, 4096, 4097, 65536 + 17, SIZE - 64};
+size_t chunks[] = {0, 1, 4096, 3 * 4096 + 1};
+
+int check_node(char *buf, size_t size)
+{
+  int node = kmp_get_memory_node(buf, size);
+  if (node < -1) {
+    printf("bad node %d\n", node);
+    return 0;
+  }
+  return 1;
+}
+
+int test_first_touch(char *buf)
+{
+  size_t i, j, k;
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    for (j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++) {
+      char *p = buf + 63;
+      for (k = 0; k < sizes[i]; k++)
+        p[k] = (char)(k * 7);
+      kmp_parallel_first_touch(p, sizes[i], chunks[j]);
+      for (k = 0; k < sizes[i]; k++) {
+        if (p[k] != (char)(k * 7)) {
+          printf("first_touch %d/%d: byte %d changed\n", (int)sizes[i],
+                 (int)chunks[j], (int)k);
+          return 0;
+        }
+      }
+      if (!check_node(p, sizes[i]))
+        return 0;
+    }
+  }
+  return 1;
+}
+
+int test_memset_memcpy(char *buf, char *src)
+{
+  size_t i, k;
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    char *p = buf + 5;
+    memset(buf, 0, SIZE);
+    kmp_parallel_memset(p, 0x5a, sizes[i]);
+    if (buf[4] != 0 || p[sizes[i]] != 0) {
+      printf("memset %d: wrote outside the buffer\n", (int)sizes[i]);
+      return 0;
+    }
+    for (k = 0; k < sizes[i]; k++) {
+      if (p[k] != 0x5a) {
+        printf("memset %d: byte %d not set\n", (int)sizes[i], (int)k);
+        return 0;
+      }
+    }
+    kmp_parallel_memcpy(p, src + 3, sizes[i]);
+    if (buf[4] != 0 || p[sizes[i]] != 0 ||
+        memcmp(p, src + 3, sizes[i]) != 0) {
+      printf("memcpy %d: bad copy\n", (int)sizes[i]);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Inside a parallel region the buffer is handled by a nested region
+int test_nested(char *buf)
+{
+  int err = 0;
+  #pragma omp parallel num_threads(2) shared(err)
+  {
+    char *p = buf + omp_get_thread_num() * (SIZE / 2);
+    int k;
+    kmp_parallel_memset(p, 1 + omp_get_thread_num(), SIZE / 2);
+    for (k = 0; k < SIZE / 2; k++) {
+      if (p[k] != 1 + omp_get_thread_num()) {
+        #pragma omp atomic
+        err++;
+        break;
+      }
+    }
+  }
+  return !err;
+}
+
+int main()
+{
+  int i;
+  int num_failed=0;
+  char *buf = (char *)malloc(SIZE);
+  char *src = (char *)malloc(SIZE);
+
+  for (i = 0; i < SIZE; i++)
+    src[i] = (char)(i % 251);
+  for(i = 0; i < REPETITIONS; i++) {
+    if(!test_first_touch(buf) || !test_memset_memcpy(buf, src) ||
+       !test_nested(buf)) {
+      num_failed++;
+    }
+  }
+  free(buf);
+  free(src);
+  return num_failed;
+}
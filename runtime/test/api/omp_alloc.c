@@ -0,0 +1,189 @@
+// RUN: %libomp-compile-and-run
+// RUN: env OMP_ALLOCATOR=kmp_numa_local_mem_alloc %libomp-run
+// RUN: env KMP_AFFINITY=compact OMP_ALLOCATOR=omp_large_cap_mem_alloc %libomp-run
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <omp.h>
+#include "omp_testsuite.h"
+
+#define NUM_THREADS 4
+
+omp_allocator_handle_t allocators[] = {
+  omp_default_mem_alloc, omp_large_cap_mem_alloc, omp_const_mem_alloc,
+  omp_high_bw_mem_alloc, omp_low_lat_mem_alloc, omp_cgroup_mem_alloc,
+  omp_pteam_mem_alloc, omp_thread_mem_alloc, kmp_interleaved_mem_alloc,
+  kmp_numa_local_mem_alloc, omp_null_allocator};
+
+size_t sizes[] = {1, 24, 4096, 100000, 4 << 20};
+
+// Allocate, fill and free blocks of every size with the allocator
+int check_allocator(omp_allocator_handle_t allocator)
+{
+  int i;
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    char *p = (char *)omp_alloc(sizes[i], allocator);
+    if (p == NULL || ((uintptr_t)p & (sizeof(void *) - 1))) {
+      printf("allocator %d: bad block %p of %d bytes\n", (int)allocator, p,
+             (int)sizes[i]);
+      return 0;
+    }
+    memset(p, i, sizes[i]);
+    omp_free(p, allocator);
+  }
+  return 1;
+}
+
+int test_predefined()
+{
+  int err = 0;
+  #pragma omp parallel num_threads(NUM_THREADS) shared(err)
+  {
+    int i;
+    for (i = 0; i < sizeof(allocators) / sizeof(allocators[0]); i++) {
+      if (!check_allocator(allocators[i])) {
+        #pragma omp atomic
+        err++;
+      }
+    }
+  }
+  return !err;
+}
+
+int test_traits()
+{
+  int err = 0;
+  void *p, *q;
+  omp_allocator_handle_t a;
+  omp_alloctrait_t align[] = {{omp_atk_alignment, 4096}};
+  omp_alloctrait_t pool[] = {{omp_atk_pool_size, 4096},
+                             {omp_atk_fallback, omp_atv_null_fb}};
+  omp_alloctrait_t fb[] = {{omp_atk_pool_size, 4096},
+                           {omp_atk_fallback, omp_atv_allocator_fb},
+                           {omp_atk_fb_data, omp_large_cap_mem_alloc}};
+  omp_alloctrait_t placed[] = {{omp_atk_partition, omp_atv_blocked},
+                               {omp_atk_pinned, omp_atv_true}};
+  omp_alloctrait_t bad[] = {{omp_atk_alignment, 24}};
+
+  a = omp_init_allocator(omp_default_mem_space, 1, align);
+  p = omp_alloc(100, a);
+  if (p == NULL || ((uintptr_t)p & 4095)) {
+    printf("alignment: %p\n", p);
+    err++;
+  }
+  omp_free(p, a);
+  omp_destroy_allocator(a);
+
+  // The second block does not fit in the pool until the first is freed
+  a = omp_init_allocator(omp_default_mem_space, 2, pool);
+  p = omp_alloc(3000, a);
+  q = omp_alloc(3000, a);
+  if (p == NULL || q != NULL) {
+    printf("pool: %p %p\n", p, q);
+    err++;
+  }
+  omp_free(p, a);
+  q = omp_alloc(3000, a);
+  if (q == NULL) {
+    printf("pool: not released\n");
+    err++;
+  }
+  omp_free(q, omp_null_allocator);
+  omp_destroy_allocator(a);
+
+  a = omp_init_allocator(omp_default_mem_space, 3, fb);
+  p = omp_alloc(3000, a);
+  q = omp_alloc(3000, a);
+  if (p == NULL || q == NULL) {
+    printf("fallback: %p %p\n", p, q);
+    err++;
+  }
+  omp_free(p, a);
+  omp_free(q, a);
+  omp_destroy_allocator(a);
+
+  // Pinning may be refused by the memlock limit, the default memory is used
+  // then.
+  a = omp_init_allocator(omp_large_cap_mem_space, 2, placed);
+  if (!check_allocator(a))
+    err++;
+  omp_destroy_allocator(a);
+
+  if (omp_init_allocator(omp_default_mem_space, 1, bad) != omp_null_allocator) {
+    printf("invalid alignment accepted\n");
+    err++;
+  }
+  return !err;
+}
+
+// Blocks are freed by another thread than the one allocating them
+int test_cross_thread()
+{
+  int err = 0;
+  void *blocks[NUM_THREADS];
+  #pragma omp parallel num_threads(NUM_THREADS) shared(blocks, err)
+  {
+    int i, n = omp_get_num_threads();
+    int tid = omp_get_thread_num();
+    for (i = 0; i < 100; i++) {
+      blocks[tid] = omp_alloc(64 + i, omp_thread_mem_alloc);
+      if (blocks[tid] == NULL) {
+        #pragma omp atomic
+        err++;
+      } else {
+        memset(blocks[tid], tid, 64 + i);
+      }
+      #pragma omp barrier
+      omp_free(blocks[(tid + 1) % n], omp_null_allocator);
+      #pragma omp barrier
+    }
+  }
+  return !err;
+}
+
+int test_default_allocator()
+{
+  int err = 0;
+  void *p;
+  omp_allocator_handle_t def = omp_get_default_allocator();
+  if (def == omp_null_allocator)
+    err++;
+  omp_set_default_allocator(kmp_interleaved_mem_alloc);
+  if (omp_get_default_allocator() != kmp_interleaved_mem_alloc)
+    err++;
+  p = omp_alloc(1 << 20, omp_null_allocator);
+  if (p == NULL)
+    err++;
+  else
+    memset(p, 0, 1 << 20);
+  omp_free(p, omp_null_allocator);
+  // def-allocator-var is inherited by the workers at every fork, whatever
+  // they set in an earlier region.
+  #pragma omp parallel num_threads(4) reduction(+:err)
+  {
+    if (omp_get_default_allocator() != kmp_interleaved_mem_alloc)
+      err++;
+    omp_set_default_allocator(omp_large_cap_mem_alloc);
+  }
+  omp_set_default_allocator(def);
+  #pragma omp parallel num_threads(4) reduction(+:err)
+  {
+    if (omp_get_default_allocator() != def)
+      err++;
+  }
+  return !err;
+}
+
+int main()
+{
+  int i;
+  int num_failed=0;
+
+  for(i = 0; i < REPETITIONS; i++) {
+    if(!test_predefined() || !test_traits() || !test_cross_thread() ||
+       !test_default_allocator()) {
+      num_failed++;
+    }
+  }
+  return num_failed;
+}
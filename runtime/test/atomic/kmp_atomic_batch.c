@@ -0,0 +1,75 @@
+// RUN: %libomp-compile-and-run
+// RUN: env KMP_ATOMIC_MODE=1 %libomp-run
+#include <stdio.h>
+#include "omp_testsuite.h"
+
+// Compares the batched entry points with the element-wise ones on a
+// histogram with many repeated bins.
+typedef long long kmp_int64;
+void __kmpc_atomic_float8_add(void *id_ref, int gtid, double *lhs, double rhs);
+void __kmpc_atomic_float8_add_batch(void *id_ref, int gtid, double *base,
+                                    int n, const kmp_int64 *idx,
+                                    const double *val);
+void __kmpc_atomic_fixed4_add(void *id_ref, int gtid, int *lhs, int rhs);
+void __kmpc_atomic_fixed4_add_batch(void *id_ref, int gtid, int *base, int n,
+                                    const kmp_int64 *idx, const int *val);
+int __kmpc_global_thread_num(void *id_ref);
+
+#define NBINS 37
+#define NVALS 1000
+
+int test_kmp_atomic_batch()
+{
+  static double ref[NBINS], hist[NBINS];
+  static int iref[NBINS], ihist[NBINS];
+  int i, errors = 0;
+
+  for (i = 0; i < NBINS; i++) {
+    ref[i] = hist[i] = 0.0;
+    iref[i] = ihist[i] = 0;
+  }
+
+  #pragma omp parallel
+  {
+    int gtid = __kmpc_global_thread_num(NULL);
+    kmp_int64 idx[NVALS];
+    double val[NVALS];
+    int ival[NVALS];
+    int j, n;
+
+    // Batches of varying length, including ones too short to be combined.
+    for (n = 1; n <= NVALS; n = n * 3 + 1) {
+      for (j = 0; j < n; j++) {
+        idx[j] = (j * j + omp_get_thread_num()) % NBINS;
+        val[j] = (double)(j % 5);
+        ival[j] = j % 7 - 3;
+        __kmpc_atomic_float8_add(NULL, gtid, &ref[idx[j]], val[j]);
+        __kmpc_atomic_fixed4_add(NULL, gtid, &iref[idx[j]], ival[j]);
+      }
+      __kmpc_atomic_float8_add_batch(NULL, gtid, hist, n, idx, val);
+      __kmpc_atomic_fixed4_add_batch(NULL, gtid, ihist, n, idx, ival);
+    }
+  }
+
+  for (i = 0; i < NBINS; i++) {
+    if (hist[i] != ref[i] || ihist[i] != iref[i]) {
+      fprintf(stderr, "bin %d: %g/%d, expected %g/%d\n", i, hist[i], ihist[i],
+              ref[i], iref[i]);
+      errors++;
+    }
+  }
+  return errors == 0;
+}
+
+int main()
+{
+  int i;
+  int num_failed = 0;
+
+  for (i = 0; i < REPETITIONS; i++) {
+    if (!test_kmp_atomic_batch()) {
+      num_failed++;
+    }
+  }
+  return num_failed;
+}
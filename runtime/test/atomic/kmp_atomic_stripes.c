@@ -0,0 +1,88 @@
+// RUN: %libomp-compile -lm
+// RUN: %libomp-run
+// RUN: env KMP_ATOMIC_MODE=1 %libomp-run
+#include <stdio.h>
+#include <complex.h>
+#include "omp_testsuite.h"
+
+// Calls the runtime entry points directly, as the Intel compiler does for
+// atomics on types without native support.
+typedef double _Complex kmp_cmplx64;
+void __kmpc_atomic_cmplx8_add(void *id_ref, int gtid, kmp_cmplx64 *lhs,
+                              kmp_cmplx64 rhs);
+kmp_cmplx64 __kmpc_atomic_cmplx8_sub_cpt(void *id_ref, int gtid,
+                                         kmp_cmplx64 *lhs, kmp_cmplx64 rhs,
+                                         int flag);
+kmp_cmplx64 __kmpc_atomic_cmplx8_rd(void *id_ref, int gtid, kmp_cmplx64 *loc);
+void __kmpc_atomic_float10_add(void *id_ref, int gtid, long double *lhs,
+                               long double rhs);
+int __kmpc_global_thread_num(void *id_ref);
+
+#define N 8
+
+// The unaligned members take the lock path, the aligned ones may be updated
+// with a 16-byte compare and swap; both must stay atomic.
+struct targets {
+  double pad;
+  kmp_cmplx64 unaligned[N];
+} __attribute__((aligned(16)));
+
+int test_kmp_atomic_stripes()
+{
+  static kmp_cmplx64 aligned[N] __attribute__((aligned(16)));
+  static struct targets t;
+  static long double ld[N];
+  int i, errors = 0;
+
+  for (i = 0; i < N; i++) {
+    aligned[i] = t.unaligned[i] = 0;
+    ld[i] = 0;
+  }
+
+  #pragma omp parallel
+  {
+    int gtid = __kmpc_global_thread_num(NULL);
+    int j;
+    #pragma omp for
+    for (j = 0; j < LOOPCOUNT * N; j++) {
+      int k = j % N;
+      __kmpc_atomic_cmplx8_add(NULL, gtid, &aligned[k], 1.0 + 2.0 * I);
+      __kmpc_atomic_cmplx8_sub_cpt(NULL, gtid, &t.unaligned[k], 1.0 - 1.0 * I,
+                                   1);
+      __kmpc_atomic_float10_add(NULL, gtid, &ld[k], 1.0L);
+      (void)__kmpc_atomic_cmplx8_rd(NULL, gtid, &aligned[k]);
+    }
+  }
+
+  for (i = 0; i < N; i++) {
+    if (creal(aligned[i]) != LOOPCOUNT || cimag(aligned[i]) != 2 * LOOPCOUNT) {
+      fprintf(stderr, "aligned[%d] = %g%+gi\n", i, creal(aligned[i]),
+              cimag(aligned[i]));
+      errors++;
+    }
+    if (creal(t.unaligned[i]) != -LOOPCOUNT ||
+        cimag(t.unaligned[i]) != LOOPCOUNT) {
+      fprintf(stderr, "unaligned[%d] = %g%+gi\n", i, creal(t.unaligned[i]),
+              cimag(t.unaligned[i]));
+      errors++;
+    }
+    if (ld[i] != LOOPCOUNT) {
+      fprintf(stderr, "ld[%d] = %Lg\n", i, ld[i]);
+      errors++;
+    }
+  }
+  return errors == 0;
+}
+
+int main()
+{
+  int i;
+  int num_failed = 0;
+
+  for (i = 0; i < REPETITIONS; i++) {
+    if (!test_kmp_atomic_stripes()) {
+      num_failed++;
+    }
+  }
+  return num_failed;
+}
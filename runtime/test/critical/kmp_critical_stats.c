@@ -0,0 +1,137 @@
+// REQUIRES: stats
+// RUN: %libomp-compile
+// RUN: env KMP_STATS_CRITICAL=on KMP_STATS_FORMAT=json KMP_STATS_FILE=%t.json %libomp-run %t.json
+// RUN: env KMP_STATS_FORMAT=json KMP_STATS_FILE=%t.json %libomp-run %t.json
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "omp_testsuite.h"
+
+#define NUM_THREADS 2
+
+// A critical section of the report: its name and thread count, then the
+// wait and hold times.
+typedef struct {
+  char name[1024];
+  int threads;
+  unsigned long long count[2];
+  double total[2];
+} critical_row_t;
+
+int test_kmp_critical_stats()
+{
+  int sum = 0;
+  int named = 0;
+  int i;
+
+  #pragma omp parallel num_threads(NUM_THREADS)
+  {
+    #pragma omp for
+    for (i = 0; i < LOOPCOUNT; i++) {
+      #pragma omp critical
+      sum++;
+      #pragma omp critical(counter)
+      named++;
+    }
+  }
+  return (sum == LOOPCOUNT && named == LOOPCOUNT);
+}
+
+// Checks a critical section, entered LOOPCOUNT times per repetition by each
+// of the threads.
+static int check_critical(const critical_row_t *row)
+{
+  int i;
+  if (row->threads != NUM_THREADS) {
+    printf("%s: %d threads\n", row->name, row->threads);
+    return 1;
+  }
+  for (i = 0; i < 2; i++) {
+    if (row->count[i] != LOOPCOUNT * REPETITIONS || row->total[i] <= 0) {
+      printf("%s: %s count %llu, total %g\n", row->name, i ? "hold" : "wait",
+             row->count[i], row->total[i]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  char name[4096], line[4096];
+  critical_row_t rows[3], *row = NULL;
+  const char *dot;
+  int enabled = getenv("KMP_STATS_CRITICAL") != NULL;
+  int nrows = 0, unnamed = -1, counter = -1;
+  int i;
+  int num_failed = 0;
+  FILE *f;
+
+  for (i = 0; i < REPETITIONS; i++) {
+    if (!test_kmp_critical_stats()) {
+      num_failed++;
+    }
+  }
+  // Outside of the parallel region only.
+  kmp_dump_stats();
+
+  // The runtime appends the pid to the name: base-pid.suffix
+  dot = strrchr(argv[1], '.');
+  snprintf(name, sizeof(name), "%.*s-%d%s", (int)(dot - argv[1]), argv[1],
+           (int)getpid(), dot);
+  f = fopen(name, "r");
+  if (f == NULL) {
+    printf("no statistics in %s\n", name);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    critical_row_t next;
+    if (sscanf(line, " {\"name\": \"%1023[^\"]\", \"threads\": %d,", next.name,
+               &next.threads) == 2) {
+      row = &rows[nrows < 3 ? nrows : 2];
+      *row = next;
+      row->count[0] = row->count[1] = 0;
+      row->total[0] = row->total[1] = 0;
+      nrows++;
+    } else if (row != NULL) {
+      sscanf(line, " \"wait\": {\"count\": %llu, \"min\": %*f, \"mean\": %*f, "
+                   "\"max\": %*f, \"total\": %lf",
+             &row->count[0], &row->total[0]);
+      sscanf(line, " \"hold\": {\"count\": %llu, \"min\": %*f, \"mean\": %*f, "
+                   "\"max\": %*f, \"total\": %lf",
+             &row->count[1], &row->total[1]);
+    }
+  }
+  fclose(f);
+  unlink(name);
+
+  if (!enabled) {
+    if (nrows != 0) {
+      printf("%s: %d critical sections without KMP_STATS_CRITICAL\n", name,
+             nrows);
+      return 1;
+    }
+    return num_failed;
+  }
+  // The unnamed section is reported as such, the named one by the name of
+  // its lock, or by its address if the executable does not export the symbol.
+  for (i = 0; i < nrows && i < 3; i++) {
+    if (!strncmp(rows[i].name, "unnamed@", 8))
+      unnamed = i;
+    else
+      counter = i;
+  }
+  if (nrows != 2 || unnamed < 0 || counter < 0) {
+    printf("%s: %d critical sections\n", name, nrows);
+    return 1;
+  }
+  if (strncmp(rows[counter].name, "counter@", 8) &&
+      strncmp(rows[counter].name, "0x", 2)) {
+    printf("%s: unexpected critical section %s\n", name, rows[counter].name);
+    return 1;
+  }
+  num_failed += check_critical(&rows[unnamed]);
+  num_failed += check_critical(&rows[counter]);
+  return num_failed;
+}
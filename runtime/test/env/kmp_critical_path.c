@@ -0,0 +1,83 @@
+// RUN: %libomp-compile
+// RUN: env KMP_CRITICAL_PATH=true KMP_CRITICAL_PATH_FILE=%t.txt %libomp-run %t.txt
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "omp_run_child.h"
+#include "omp_my_sleep.h"
+
+// A chain of 4 tasks of 50 ms next to 8 independent tasks of 20 ms. The third
+// link is created after the second has finished, there is no edge between
+// them in the runtime, but it is on the path all the same.
+static int work(void *arg)
+{
+  int x = 0;
+  #pragma omp parallel num_threads(4)
+  #pragma omp single
+  {
+    int i;
+    for (i = 0; i < 4; i++) {
+      if (i == 2)
+        my_sleep(0.3);
+      #pragma omp task depend(inout: x) shared(x)
+      {
+        my_sleep(0.05);
+        x++;
+      }
+    }
+    for (i = 0; i < 8; i++) {
+      #pragma omp task
+      my_sleep(0.02);
+    }
+    #pragma omp taskwait
+  }
+  if (x != 4) {
+    printf("x = %d\n", x);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  char line[1024], sync[64], location[256];
+  unsigned long graphs = 0, tasks = 0, path_tasks = 0;
+  double work_ms = 0, span_ms = 0, parallelism = 0;
+  int found = 0;
+  FILE *f;
+
+  if (run_child(work, NULL, argv[1]) != 0)
+    return 1;
+
+  f = fopen(argv[1], "r");
+  if (f == NULL) {
+    printf("no profile in %s\n", argv[1]);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    if (found == 1) {
+      // The column headers of the entry points.
+      found++;
+    } else if (found == 2) {
+      // The entry point that contributes most to the path.
+      sscanf(line, "%lu", &path_tasks);
+      break;
+    } else if (sscanf(line, "%63s %lu %lu %lf %lf %lf %255s", sync, &graphs,
+                      &tasks, &work_ms, &span_ms, &parallelism,
+                      location) == 7 &&
+               !strcmp(sync, "taskwait")) {
+      found = 1;
+    }
+  }
+  fclose(f);
+
+  // Work is 4 * 50 + 8 * 20 ms, the span is the chain; allow for slow sleeps.
+  if (found != 2 || graphs != 1 || tasks != 12 || span_ms < 190 ||
+      work_ms < span_ms + 150 || path_tasks != 4) {
+    printf("graphs %lu, tasks %lu, work %.1f ms, span %.1f ms, path %lu\n",
+           graphs, tasks, work_ms, span_ms, path_tasks);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,167 @@
+// REQUIRES: linux
+// RUN: %libomp-compile
+// RUN: env KMP_HUGE_PAGES=transparent KMP_HUGE_PAGES_STATS=1 %libomp-run %t.txt stats
+// RUN: env KMP_HUGE_PAGES=explicit KMP_HUGE_PAGES_STATS=1 %libomp-run %t.txt stats
+// RUN: env KMP_HUGE_PAGES=transparent OMP_PROC_BIND=spread %libomp-run %t.txt
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "omp_testsuite.h"
+#include "omp_run_child.h"
+
+// The internal structures come from the huge page arena: grow and shrink the
+// teams so that they are reallocated, and fill the task deques past their
+// initial size.
+int test_kmp_huge_pages()
+{
+  int nthreads, ntasks = 0, sum = 0;
+  int err = 0;
+
+  omp_set_nested(1);
+  for (nthreads = 1; nthreads <= 32; nthreads *= 2) {
+    int count = 0;
+    #pragma omp parallel num_threads(nthreads) shared(count)
+    {
+      #pragma omp atomic
+      count++;
+      #pragma omp parallel num_threads(2)
+      {
+        #pragma omp atomic
+        sum++;
+      }
+    }
+    if (count != nthreads) {
+      printf("team of %d threads has %d threads\n", nthreads, count);
+      err++;
+    }
+  }
+  if (sum != 2 * (1 + 2 + 4 + 8 + 16 + 32)) {
+    printf("nested teams: %d\n", sum);
+    err++;
+  }
+
+  #pragma omp parallel num_threads(4) shared(ntasks)
+  #pragma omp single
+  {
+    int i;
+    for (i = 0; i < 10000; i++) {
+      #pragma omp task shared(ntasks)
+      {
+        #pragma omp atomic
+        ntasks++;
+      }
+    }
+  }
+  if (ntasks != 10000) {
+    printf("tasks: %d\n", ntasks);
+    err++;
+  }
+  return !err;
+}
+
+// Sum of the fields of /proc/self/smaps named field, in kB.
+static long smaps_total(const char *field)
+{
+  char line[256];
+  long total = 0, kb;
+  size_t len = strlen(field);
+  FILE *f = fopen("/proc/self/smaps", "r");
+
+  if (f == NULL)
+    return -1;
+  while (fgets(line, sizeof(line), f))
+    if (!strncmp(line, field, len) && line[len] == ':' &&
+        sscanf(line + len + 1, "%ld", &kb) == 1)
+      total += kb;
+  fclose(f);
+  return total;
+}
+
+// Transparent huge pages are there unless the system turned them off.
+static int thp_enabled()
+{
+  char line[256];
+  FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  int enabled = 0;
+
+  if (f == NULL)
+    return 0;
+  if (fgets(line, sizeof(line), f))
+    enabled = strstr(line, "[never]") == NULL;
+  fclose(f);
+  return enabled;
+}
+
+// The arena maps explicit huge pages or falls back to transparent ones: the
+// internal structures must sit in either kind.
+static int check_huge_pages()
+{
+  long hugetlb = smaps_total("Private_Hugetlb");
+  long thp = smaps_total("AnonHugePages");
+
+  if (hugetlb > 0 || thp > 0 || (hugetlb == 0 && !thp_enabled()))
+    return 1;
+  printf("no huge pages in use: Private_Hugetlb %ld kB, AnonHugePages %ld kB\n",
+         hugetlb, thp);
+  return 0;
+}
+
+// The statistics are printed on stderr at exit, one line with the chunks and
+// one with the allocations per arena in use.
+static int check_stats(const char *file)
+{
+  char line[1024];
+  unsigned long long count;
+  int node, chunk_lines = 0, alloc_lines = 0;
+  FILE *f = fopen(file, "r");
+
+  if (f == NULL) {
+    printf("no output in %s\n", file);
+    return 0;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "OMP: Info: arena node %d: %llu", &node, &count) != 2 ||
+        count == 0)
+      continue;
+    if (strstr(line, " chunks ("))
+      chunk_lines++;
+    else if (strstr(line, " allocations,"))
+      alloc_lines++;
+  }
+  fclose(f);
+  if (chunk_lines == 0 || chunk_lines != alloc_lines) {
+    printf("arena statistics: %d lines of chunks, %d of allocations\n",
+           chunk_lines, alloc_lines);
+    return 0;
+  }
+  return 1;
+}
+
+// Runs in a child, the statistics are printed when it exits.
+static int run_tests(void *file)
+{
+  int i;
+  int num_failed=0;
+
+  if (!freopen((const char *)file, "w", stderr))
+    return 1;
+  for(i = 0; i < REPETITIONS; i++) {
+    if(!test_kmp_huge_pages()) {
+      num_failed++;
+    }
+  }
+  if (!check_huge_pages())
+    num_failed++;
+  return num_failed;
+}
+
+int main(int argc, char **argv)
+{
+  int num_failed = run_child(run_tests, argv[1], NULL);
+
+  if (num_failed < 0)
+    return 1;
+  if (argc > 2 && !strcmp(argv[2], "stats") && !check_stats(argv[1]))
+    num_failed++;
+  return num_failed;
+}
@@ -0,0 +1,110 @@
+// RUN: %libomp-compile
+// RUN: env KMP_HW_COUNTERS=true KMP_HW_COUNTERS_EVENTS=task-clock,nosuchevent KMP_HW_COUNTERS_FILE=%t.txt %libomp-run %t.txt
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "omp_run_child.h"
+
+#define REGIONS 10
+
+static int work(void *arg)
+{
+  int r;
+  for (r = 0; r < REGIONS; r++) {
+    #pragma omp parallel num_threads(2)
+    {
+      volatile int i, x = 0;
+      for (i = 0; i < 100000; i++)
+        x += i;
+      #pragma omp barrier
+    }
+  }
+  return 0;
+}
+
+static int find_column(char *line, const char *name)
+{
+  char *buf, *s = strtok_r(line, " \n", &buf);
+  int i;
+  for (i = 0; s != NULL; s = strtok_r(NULL, " \n", &buf), i++)
+    if (!strcmp(s, name))
+      return i;
+  return -1;
+}
+
+static unsigned long long get_column(char *line, int column)
+{
+  char *buf, *s = strtok_r(line, " \n", &buf);
+  int i;
+  for (i = 0; s != NULL && i < column; i++)
+    s = strtok_r(NULL, " \n", &buf);
+  return s ? strtoull(s, NULL, 10) : 0;
+}
+
+// Whether the report refuses task-clock because perf events are not allowed
+// (perf_event_paranoid, a seccomp filter) or not there at all.
+static int task_clock_refused(const char *line)
+{
+  static const int errors[] = {EACCES, EPERM, ENOSYS};
+  char refused[256];
+  int i;
+  for (i = 0; i < sizeof(errors) / sizeof(errors[0]); i++) {
+    snprintf(refused, sizeof(refused), " task-clock (%s)", strerror(errors[i]));
+    if (strstr(line, refused))
+      return 1;
+  }
+  return 0;
+}
+
+// The hardware events may not exist here (a virtual machine) or be refused
+// (perf_event_paranoid), the software task-clock is in the report all the same
+// unless the environment does not support perf events at all.
+int main(int argc, char **argv)
+{
+  char line[1024];
+  unsigned long long instances;
+  int counted = 0, nothing = 0, unknown = 0, refused = 0, rows = 0;
+  int column = -1;
+  FILE *f;
+
+  if (run_child(work, NULL, argv[1]) != 0)
+    return 1;
+
+  f = fopen(argv[1], "r");
+  if (f == NULL) {
+    printf("no report in %s\n", argv[1]);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    if (!strncmp(line, "# Counted:", 10)) {
+      counted = strstr(line, " task-clock") != NULL;
+      nothing = !strcmp(line, "# Counted: nothing\n");
+    } else if (!strncmp(line, "# Not counted:", 14)) {
+      unknown = strstr(line, "nosuchevent (unknown event)") != NULL;
+      refused = task_clock_refused(line);
+    }
+    else if (!strncmp(line, "Thread ", 7))
+      column = find_column(line, "task-clock");
+    else if (!strncmp(line, "all ", 4) && column > 0) {
+      // all, the phase, the instances and the events.
+      if (sscanf(line, "%*s %*s %llu", &instances) != 1 ||
+          instances != REGIONS || get_column(line, column) == 0)
+        break;
+      rows++;
+    }
+  }
+  fclose(f);
+
+  if (nothing && refused && unknown) {
+    printf("perf events are not supported here\n");
+    return 0;
+  }
+  // One row of the work and one of the barriers.
+  if (!counted || !unknown || rows != 2) {
+    printf("counted %d, unknown %d, rows %d\n", counted, unknown, rows);
+    return 1;
+  }
+  return 0;
+}
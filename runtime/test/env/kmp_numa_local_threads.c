@@ -0,0 +1,69 @@
+// REQUIRES: linux
+// RUN: %libomp-compile
+// RUN: env OMP_PLACES=cores OMP_PROC_BIND=spread %libomp-run
+// RUN: env KMP_AFFINITY=compact %libomp-run
+// RUN: env KMP_NUMA_LOCAL_THREADS=false OMP_PROC_BIND=close %libomp-run
+#include <stdio.h>
+#include "omp_testsuite.h"
+
+#define N 10000
+
+// Per-thread structures move with the threads when their place changes: the
+// teams alternate between spread and close binding, and use the private
+// dispatch buffers and the task deques of the threads.
+int test_kmp_numa_local_threads()
+{
+  int iter, ntasks = 0;
+  int err = 0;
+
+  for (iter = 0; iter < 8; iter++) {
+    long sum = 0;
+    int i;
+    if (iter % 2) {
+      #pragma omp parallel for proc_bind(spread) num_threads(4) \
+          schedule(monotonic: dynamic, 7) reduction(+ : sum)
+      for (i = 0; i < N; i++)
+        sum += i;
+    } else {
+      #pragma omp parallel for proc_bind(close) num_threads(4) \
+          schedule(monotonic: guided) reduction(+ : sum)
+      for (i = 0; i < N; i++)
+        sum += i;
+    }
+    if (sum != (long)N * (N - 1) / 2) {
+      printf("iteration %d: sum %ld\n", iter, sum);
+      err++;
+    }
+  }
+
+  #pragma omp parallel num_threads(4) shared(ntasks)
+  #pragma omp single
+  {
+    int i;
+    for (i = 0; i < N; i++) {
+      #pragma omp task shared(ntasks)
+      {
+        #pragma omp atomic
+        ntasks++;
+      }
+    }
+  }
+  if (ntasks != N) {
+    printf("tasks: %d\n", ntasks);
+    err++;
+  }
+  return !err;
+}
+
+int main()
+{
+  int i;
+  int num_failed=0;
+
+  for(i = 0; i < REPETITIONS; i++) {
+    if(!test_kmp_numa_local_threads()) {
+      num_failed++;
+    }
+  }
+  return num_failed;
+}
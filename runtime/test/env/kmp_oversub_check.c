@@ -0,0 +1,79 @@
+// RUN: %libomp-compile -lpthread
+// REQUIRES: linux
+// RUN: env OMP_DYNAMIC=true KMP_OVERSUB_CHECK=10 %libomp-run
+// RUN: env OMP_DYNAMIC=true KMP_OVERSUB_CHECK=10 KMP_DYNAMIC_MODE=random %libomp-run
+// RUN: env KMP_OVERSUB_CHECK=10 KMP_BLOCKTIME=infinite %libomp-run
+// RUN: env KMP_OVERSUB_CHECK=0 %libomp-run
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "omp_testsuite.h"
+
+#define N 2000
+
+static volatile int stop;
+
+// Busy threads that the runtime does not know about, i.e. another load
+static void *hog(void *arg)
+{
+  while (!stop)
+    ;
+  return arg;
+}
+
+// Teams still synchronize correctly while the runtime waits passively
+static int run_regions(int nthreads)
+{
+  int i, err = 0;
+  for (i = 0; i < 20; i++) {
+    long sum = 0;
+    int j;
+    #pragma omp parallel for num_threads(nthreads) reduction(+ : sum) \
+        schedule(monotonic: dynamic, 16)
+    for (j = 0; j < N; j++)
+      sum += j;
+    if (sum != (long)N * (N - 1) / 2) {
+      printf("sum %ld\n", sum);
+      err++;
+    }
+  }
+  return err;
+}
+
+int main()
+{
+  int nprocs = omp_get_num_procs();
+  int nhogs = 2 * nprocs;
+  int i, err = 0, size = 0;
+  pthread_t *hogs = (pthread_t *)malloc(nhogs * sizeof(pthread_t));
+
+  err += run_regions(4);
+  for (i = 0; i < nhogs; i++)
+    pthread_create(&hogs[i], NULL, hog, NULL);
+  // Let a few samples see the load
+  for (i = 0; i < 5; i++) {
+    usleep(20000);
+    err += run_regions(4);
+  }
+
+  // With dyn-var set, the team gets no more threads than the other processes
+  // leave free.
+  #pragma omp parallel num_threads(4)
+  #pragma omp master
+  size = omp_get_num_threads();
+  if (omp_get_dynamic() && size > 1) {
+    printf("team of %d threads with %d busy threads on %d procs\n", size,
+           nhogs, nprocs);
+    err++;
+  }
+
+  stop = 1;
+  for (i = 0; i < nhogs; i++)
+    pthread_join(hogs[i], NULL);
+  free(hogs);
+  usleep(20000);
+  err += run_regions(4);
+  return err;
+}
@@ -0,0 +1,107 @@
+// REQUIRES: linux
+// RUN: %libomp-compile
+// RUN: env KMP_OVERSUB_CHECK=10 %libomp-run passive
+// RUN: env KMP_OVERSUB_CHECK=10 KMP_BLOCKTIME=1000 %libomp-run spin
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <omp.h>
+
+#define MAX_HOGS 64
+#define SAMPLES 10
+
+// Number of the other threads of this process that are running or runnable.
+static int runnable_threads()
+{
+  char path[64], stat[256], *state;
+  int count = 0;
+  long self = syscall(SYS_gettid);
+  struct dirent *entry;
+  DIR *dir = opendir("/proc/self/task");
+
+  if (dir == NULL)
+    return -1;
+  while ((entry = readdir(dir)) != NULL) {
+    FILE *f;
+    if (entry->d_name[0] == '.' || atol(entry->d_name) == self)
+      continue;
+    snprintf(path, sizeof(path), "/proc/self/task/%s/stat", entry->d_name);
+    f = fopen(path, "r");
+    if (f == NULL)
+      continue;
+    // pid (comm) state ...
+    if (fgets(stat, sizeof(stat), f) && (state = strrchr(stat, ')')) != NULL &&
+        state[1] == ' ' && state[2] == 'R')
+      count++;
+    fclose(f);
+  }
+  closedir(dir);
+  return count;
+}
+
+// Samples taken while the master sleeps after a parallel region, i.e. while
+// the worker waits at the fork barrier, in which another thread was running.
+static int spinning_samples()
+{
+  int i, spinning = 0;
+  #pragma omp parallel num_threads(2)
+  {
+    volatile int j, x = 0;
+    for (j = 0; j < 1000; j++)
+      x += j;
+  }
+  for (i = 0; i < SAMPLES; i++) {
+    usleep(20000);
+    if (runnable_threads() > 0)
+      spinning++;
+  }
+  return spinning;
+}
+
+// Under a load of other processes the workers suspend at once, unless the
+// blocktime was set explicitly: then they spin for it as they always do.
+int main(int argc, char **argv)
+{
+  pid_t hogs[MAX_HOGS];
+  int nhogs = 2 * sysconf(_SC_NPROCESSORS_ONLN);
+  int i, spin = argc > 1 && !strcmp(argv[1], "spin");
+  int spinning;
+
+  if (nhogs > MAX_HOGS)
+    nhogs = MAX_HOGS;
+  // The load comes from other processes, which the runtime does not count as
+  // its own threads.
+  for (i = 0; i < nhogs; i++) {
+    hogs[i] = fork();
+    if (hogs[i] == 0) {
+      for (;;)
+        ;
+    }
+  }
+  omp_set_dynamic(0);
+  spinning_samples();
+  // Let the sampler see the load
+  usleep(200000);
+  spinning = spinning_samples();
+
+  for (i = 0; i < nhogs; i++) {
+    if (hogs[i] > 0) {
+      kill(hogs[i], SIGKILL);
+      waitpid(hogs[i], NULL, 0);
+    }
+  }
+
+  // The samples cover 200 ms of the 1000 ms blocktime; the sampler thread
+  // is runnable only for a moment every 10 ms.
+  if (spin ? spinning < SAMPLES / 2 : spinning > SAMPLES / 2) {
+    printf("%s: another thread was running in %d of %d samples\n",
+           spin ? "spin" : "passive", spinning, SAMPLES);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+// RUN: %libomp-compile
+// RUN: %libomp-run
+// RUN: env KMP_SPAWN_TREE=false %libomp-run
+// RUN: env KMP_HOT_TEAMS_MAX_LEVEL=2 KMP_HOT_TEAMS_MODE=1 %libomp-run
+// RUN: env OMP_PLACES='{0},{0},{0},{0}' OMP_PROC_BIND=spread %libomp-run
+#include <stdio.h>
+#include <string.h>
+#include <omp.h>
+
+#define MAX_THREADS 64
+
+// New workers create other new workers as they start. Every team gets all of
+// its threads, whether the hot team grows, the threads come from the pool or a
+// nested team needs new ones.
+static int check_team(int nthreads, int nested)
+{
+  int seen[MAX_THREADS];
+  int i, err = 0;
+
+  memset(seen, 0, sizeof(seen));
+  #pragma omp parallel num_threads(nthreads) shared(seen, err)
+  {
+    if (omp_get_num_threads() != nthreads) {
+      #pragma omp critical
+      err++;
+    }
+    #pragma omp atomic
+    seen[omp_get_thread_num()]++;
+    if (nested) {
+      #pragma omp parallel num_threads(nested) shared(err)
+      if (omp_get_num_threads() != nested) {
+        #pragma omp critical
+        err++;
+      }
+    }
+  }
+  for (i = 0; i < nthreads; i++) {
+    if (seen[i] != 1) {
+      printf("team of %d: thread %d ran %d times\n", nthreads, i, seen[i]);
+      err++;
+    }
+  }
+  return err;
+}
+
+int main()
+{
+  static const int sizes[] = {2, 5, 17, 64, 3, 33, 64};
+  int i, err = 0;
+
+  omp_set_nested(1);
+  omp_set_dynamic(0);
+  for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+    err += check_team(sizes[i], 0);
+  err += check_team(4, 3);
+  err += check_team(8, 5);
+  if (err)
+    printf("%d errors\n", err);
+  return err;
+}
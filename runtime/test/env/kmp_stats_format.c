@@ -0,0 +1,58 @@
+// REQUIRES: stats
+// RUN: %libomp-compile
+// RUN: env KMP_STATS_FORMAT=csv KMP_STATS_FILE=%t.csv %libomp-run %t .csv
+// RUN: env KMP_STATS_FORMAT=json KMP_STATS_FILE=%t.json %libomp-run %t .json
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+
+int main(int argc, char **argv)
+{
+  char name[4096], line[4096];
+  int sum = 0, i, header = 0, aggregate = 0, threads = 0;
+  FILE *f;
+
+  #pragma omp parallel num_threads(2)
+  {
+    #pragma omp for
+    for (i = 0; i < 100; i++) {
+      #pragma omp atomic
+      sum++;
+    }
+  }
+  kmp_dump_stats();
+
+  // The runtime appends the pid to the name: base-pid.suffix
+  snprintf(name, sizeof(name), "%s-%d%s", argv[1], (int)getpid(), argv[2]);
+  f = fopen(name, "r");
+  if (f == NULL) {
+    printf("no statistics in %s\n", name);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    if (!strcmp(argv[2], ".csv")) {
+      if (!strcmp(line, "thread,kind,name,count,min,mean,max,total,sd\n"))
+        header++;
+      else if (!strncmp(line, "all,timer,OMP_parallel,", 23))
+        aggregate++;
+      else if (!strncmp(line, "1,counter,", 10))
+        threads++;
+    } else {
+      if (!strcmp(line, "{\n"))
+        header++;
+      else if (strstr(line, "\"aggregate\": {"))
+        aggregate++;
+      else if (strstr(line, "{\"gtid\": 1,"))
+        threads++;
+    }
+  }
+  fclose(f);
+  unlink(name);
+  if (header != 1 || aggregate != 1 || threads == 0) {
+    printf("%s: header %d, aggregate %d, threads %d\n", name, header, aggregate,
+           threads);
+    return 1;
+  }
+  return sum != 100;
+}
@@ -0,0 +1,72 @@
+// REQUIRES: stats
+// RUN: %libomp-compile
+// RUN: env KMP_STATS_FORMAT=csv KMP_STATS_FILE=%t.csv %libomp-run %t .csv
+// RUN: env KMP_STATS_FORMAT=json KMP_STATS_FILE=%t.json %libomp-run %t .json
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+
+#define BARRIERS 100
+
+static void barriers(int n)
+{
+  #pragma omp parallel num_threads(2)
+  {
+    int i;
+    for (i = 0; i < n; i++) {
+      #pragma omp barrier
+    }
+  }
+}
+
+// The barriers before kmp_clear_stats() must not show in the percentiles.
+int main(int argc, char **argv)
+{
+  char name[4096], line[4096];
+  unsigned long long count = 0;
+  double p[3] = {0, 0, 0};
+  int found = 0;
+  FILE *f;
+
+  barriers(3 * BARRIERS);
+  kmp_clear_stats();
+  barriers(BARRIERS);
+  kmp_dump_stats();
+
+  snprintf(name, sizeof(name), "%s-%d%s", argv[1], (int)getpid(), argv[2]);
+  f = fopen(name, "r");
+  if (f == NULL) {
+    printf("no statistics in %s\n", name);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    const char *key = "\"OMP_plain_barrier\": {\"count\": ";
+    char *s;
+    if (!strcmp(argv[2], ".csv")) {
+      int i;
+      const char *kinds[3] = {"all,p50,", "all,p99,", "all,p999,"};
+      for (i = 0; i < 3; i++) {
+        size_t len = strlen(kinds[i]);
+        if (!strncmp(line, kinds[i], len) &&
+            sscanf(line + len, "OMP_plain_barrier,%llu,%lf", &count, &p[i]) ==
+                2)
+          found++;
+      }
+    } else if ((s = strstr(line, key)) != NULL &&
+               sscanf(s + strlen(key), "%llu, \"p50\": %lf, \"p99\": %lf, "
+                                       "\"p999\": %lf",
+                      &count, &p[0], &p[1], &p[2]) == 4) {
+      found = 3;
+    }
+  }
+  fclose(f);
+  unlink(name);
+  if (found != 3 || count != 2 * BARRIERS || p[0] <= 0 || p[0] > p[1] ||
+      p[1] > p[2]) {
+    printf("%s: found %d, count %llu, p50 %g, p99 %g, p999 %g\n", name, found,
+           count, p[0], p[1], p[2]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+// RUN: %libomp-compile
+// RUN: env KMP_TRACE=true KMP_TRACE_FILE=%t.bin %libomp-run %t.bin
+// RUN: env KMP_TRACE=true KMP_TRACE_FILE=%t.bin KMP_TRACE_BUFFER_SIZE=16 %libomp-run %t.bin
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <omp.h>
+
+// The layout written by the runtime, see kmp_trace.h.
+typedef struct {
+  char magic[8];
+  uint32_t version, record_size, nthreads, nstrings;
+  int64_t pid;
+  uint64_t start_ticks, start_nsec, end_ticks, end_nsec;
+  uint64_t start_mono_nsec, end_mono_nsec;
+} header_t;
+
+typedef struct {
+  int32_t gtid, id;
+  int64_t os_tid;
+  uint64_t total, count;
+} thread_t;
+
+typedef struct {
+  uint64_t time;
+  uint32_t event, arg;
+  uint64_t a0, a1;
+} record_t;
+
+enum { ev_fork = 1, ev_join, ev_barrier_begin, ev_barrier_end, ev_task_create,
+       ev_task_begin, ev_task_end, ev_task_steal, ev_lock_wait,
+       ev_lock_acquired, ev_lock_released, ev_taskwait_begin, ev_taskwait_end,
+       ev_last };
+
+#define NTASKS 100
+
+static volatile sig_atomic_t signalled = 0;
+
+static void handler(int signum)
+{
+  signalled = 1;
+}
+
+static void work(int *count)
+{
+  #pragma omp atomic
+  (*count)++;
+}
+
+int main(int argc, char **argv)
+{
+  int count = 0, err = 0;
+  unsigned i, t, nevents[ev_last] = {0};
+  uint64_t total = 0;
+  header_t header;
+  char signum[16];
+  FILE *f;
+
+  // The file of an earlier run must not count.
+  unlink(argv[1]);
+  // The runtime takes the signal over when it starts, and passes it on.
+  snprintf(signum, sizeof(signum), "%d", SIGUSR2);
+  setenv("KMP_TRACE_SIGNAL", signum, 1);
+  signal(SIGUSR2, handler);
+
+  #pragma omp parallel num_threads(2) shared(count)
+  {
+    #pragma omp single
+    {
+      for (i = 0; i < NTASKS; i++) {
+        #pragma omp task shared(count)
+        work(&count);
+      }
+      #pragma omp taskwait
+    }
+    #pragma omp critical
+    count++;
+  }
+  #pragma omp parallel num_threads(2)
+  {
+    #pragma omp barrier
+  }
+  if (count != NTASKS + 2) {
+    printf("count = %d\n", count);
+    return 1;
+  }
+
+  // The file is written at exit, and by a thread of the runtime after
+  // KMP_TRACE_SIGNAL; it appears complete under its name.
+  raise(SIGUSR2);
+  if (!signalled) {
+    printf("the signal was not passed on\n");
+    return 1;
+  }
+  for (i = 0; i < 1000 && (f = fopen(argv[1], "rb")) == NULL; i++)
+    usleep(10000);
+  if (!f) {
+    printf("no trace file %s\n", argv[1]);
+    return 1;
+  }
+  if (fread(&header, sizeof(header), 1, f) != 1 ||
+      memcmp(header.magic, "KMPTRACE", 8) || header.version != 2 ||
+      header.record_size != sizeof(record_t)) {
+    printf("bad header\n");
+    return 1;
+  }
+  if (header.nthreads < 2 || header.end_ticks <= header.start_ticks ||
+      header.end_mono_nsec <= header.start_mono_nsec) {
+    printf("nthreads = %u\n", header.nthreads);
+    err++;
+  }
+  for (t = 0; t < header.nthreads; t++) {
+    thread_t thread;
+    uint64_t last = 0, r;
+    if (fread(&thread, sizeof(thread), 1, f) != 1 ||
+        thread.count > thread.total || thread.os_tid <= 0) {
+      printf("bad thread block\n");
+      return 1;
+    }
+    total += thread.total;
+    for (r = 0; r < thread.count; r++) {
+      record_t rec;
+      if (fread(&rec, sizeof(rec), 1, f) != 1 || rec.event == 0 ||
+          rec.event >= ev_last || rec.time < last) {
+        printf("bad record %u of thread %d\n", (unsigned)r, thread.gtid);
+        return 1;
+      }
+      last = rec.time;
+      nevents[rec.event]++;
+    }
+  }
+  for (t = 0; t < header.nstrings; t++) {
+    uint64_t key_length[2];
+    char psource[1024];
+    if (fread(key_length, sizeof(key_length), 1, f) != 1 ||
+        key_length[1] >= sizeof(psource) ||
+        fread(psource, 1, key_length[1], f) != key_length[1]) {
+      printf("bad string\n");
+      return 1;
+    }
+  }
+  fclose(f);
+
+  // With small buffers only the last records are kept.
+  if (total < 2 * NTASKS) {
+    printf("only %u events\n", (unsigned)total);
+    err++;
+  }
+  if (getenv("KMP_TRACE_BUFFER_SIZE") == NULL) {
+    if (nevents[ev_fork] != 2 || nevents[ev_join] != 2 ||
+        nevents[ev_task_create] != NTASKS || nevents[ev_task_begin] != NTASKS ||
+        nevents[ev_task_end] != NTASKS || nevents[ev_lock_wait] != 2 ||
+        nevents[ev_lock_acquired] != 2 || nevents[ev_lock_released] != 2 ||
+        nevents[ev_taskwait_begin] != 1 || nevents[ev_taskwait_end] != 1 ||
+        nevents[ev_barrier_begin] != nevents[ev_barrier_end]) {
+      for (t = 1; t < ev_last; t++)
+        printf("event %u: %u\n", t, nevents[t]);
+      err++;
+    }
+  }
+  return err;
+}
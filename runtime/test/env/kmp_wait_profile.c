@@ -0,0 +1,78 @@
+// REQUIRES: ompt
+// RUN: %libomp-compile
+// RUN: env KMP_WAIT_PROFILE=true KMP_WAIT_PROFILE_FILE=%t.txt %libomp-run %t.txt
+// RUN: env KMP_WAIT_PROFILE=true KMP_WAIT_PROFILE_FILE=%t.txt KMP_BLOCKTIME=0 %libomp-run %t.txt
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "omp_run_child.h"
+#include "omp_my_sleep.h"
+
+// The entry points take the ident_t that compilers other than GCC generate,
+// pass one with a known location.
+typedef struct {
+  int reserved_1, flags, reserved_2, reserved_3;
+  const char *psource;
+} ident_t;
+typedef int kmp_critical_name[8];
+
+extern int __kmpc_global_thread_num(ident_t *);
+extern void __kmpc_barrier(ident_t *, int);
+extern void __kmpc_critical(ident_t *, int, kmp_critical_name *);
+extern void __kmpc_end_critical(ident_t *, int, kmp_critical_name *);
+
+static ident_t barrier_loc = {0, 2, 0, 0, ";kmp_wait_profile.c;imbalance;42;1;;"};
+static ident_t critical_loc = {0, 2, 0, 0, ";kmp_wait_profile.c;contended;50;1;;"};
+static kmp_critical_name crit;
+
+// Runs in a child, the profile is written when it exits.
+static int work(void *arg)
+{
+  #pragma omp parallel num_threads(4)
+  {
+    int gtid = __kmpc_global_thread_num(&barrier_loc);
+    if (omp_get_thread_num() == 0)
+      my_sleep(0.3);
+    __kmpc_barrier(&barrier_loc, gtid);
+    __kmpc_critical(&critical_loc, gtid, &crit);
+    my_sleep(0.05);
+    __kmpc_end_critical(&critical_loc, gtid, &crit);
+  }
+  return 0;
+}
+
+// Samples of the state at the location, -1 if there is no such line.
+static long samples(const char *file, const char *state, const char *location)
+{
+  char line[1024], name[64];
+  long n = -1, count;
+  FILE *f = fopen(file, "r");
+  if (f == NULL)
+    return -1;
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "%63s %ld", name, &count) == 2 && !strcmp(name, state) &&
+        strstr(line, location))
+      n = count;
+  }
+  fclose(f);
+  return n;
+}
+
+int main(int argc, char **argv)
+{
+  long barrier, lock;
+
+  if (run_child(work, NULL, argv[1]) != 0)
+    return 1;
+
+  barrier = samples(argv[1], "barrier", "imbalance (kmp_wait_profile.c:42)");
+  lock = samples(argv[1], "lock", "contended (kmp_wait_profile.c:50)");
+  // Three threads wait 0.3 s in the barrier and at least 0.15 s in total for
+  // the critical section, allow for a slow sampler.
+  if (barrier < 10 || lock < 5) {
+    printf("barrier: %ld samples, lock: %ld samples\n", barrier, lock);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,64 @@
+// RUN: %libomp-compile
+// RUN: env KMP_LOCK_KIND=autotune %libomp-run
+// RUN: env KMP_LOCK_KIND=autotune KMP_AUTOTUNE_LOCK_PROPS=4,10,5,2 %libomp-run
+// RUN: env KMP_AUTOTUNE_LOCK_PROPS=4,10,5,8 %libomp-run
+#include <stdio.h>
+#include "omp_testsuite.h"
+
+// Alternate contended and uncontended phases so that the lock goes through
+// promotions and demotions while it is in use.
+int test_omp_lock_autotune(omp_lock_t *lck)
+{
+  int nr_threads_in_single = 0;
+  int result = 0;
+  int nr_iterations = 0;
+  int nr_tested = 0;
+  int i, phase;
+
+  for (phase = 0; phase < 4; phase++) {
+    int contended = (phase % 2 == 0);
+    #pragma omp parallel shared(lck) num_threads(contended ? 8 : 1)
+    {
+      #pragma omp for
+      for(i = 0; i < LOOPCOUNT; i++) {
+        omp_set_lock(lck);
+        #pragma omp flush
+        nr_threads_in_single++;
+        #pragma omp flush
+        nr_iterations++;
+        nr_threads_in_single--;
+        result = result + nr_threads_in_single;
+        omp_unset_lock(lck);
+      }
+      while (!omp_test_lock(lck)) {}
+      nr_tested++;
+      omp_unset_lock(lck);
+    }
+  }
+
+  return ((result == 0) && (nr_iterations == 4 * LOOPCOUNT) &&
+          (nr_tested == 4 * 8 / 2 + 2));
+}
+
+int main()
+{
+  int i;
+  int num_failed=0;
+  omp_lock_t lck;
+
+  for(i = 0; i < REPETITIONS; i++) {
+    // Autotuned lock selected by KMP_LOCK_KIND
+    omp_init_lock(&lck);
+    if(!test_omp_lock_autotune(&lck)) {
+      num_failed++;
+    }
+    omp_destroy_lock(&lck);
+    // Autotuned lock selected by hint
+    omp_init_lock_with_hint(&lck, kmp_lock_hint_autotune);
+    if(!test_omp_lock_autotune(&lck)) {
+      num_failed++;
+    }
+    omp_destroy_lock(&lck);
+  }
+  return num_failed;
+}
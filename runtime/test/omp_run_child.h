@@ -0,0 +1,33 @@
+#ifndef RUN_CHILD_H
+#define RUN_CHILD_H
+
+/*! Utility function for the tests of reports that the runtime writes at exit:
+ *  the work runs in a child process, the parent stays out of OpenMP, so that
+ *  the child starts the runtime, and reads the report once the child is
+ *  gone. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Removes the report, if any, left by an earlier run, then runs child(arg) in
+// a child process, which exits with its return value. Returns that exit
+// status, or -1 if the child did not run or did not exit.
+static int run_child(int (*child)(void *), void *arg, const char *report) {
+  int status;
+  pid_t pid;
+
+  if (report)
+    unlink(report);
+  pid = fork();
+  if (pid == 0)
+    exit(child(arg));
+  if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+    printf("the child failed\n");
+    return -1;
+  }
+  return WEXITSTATUS(status);
+}
+
+#endif // RUN_CHILD_H
@@ -697,6 +697,11 @@ int ompt_initialize(
   register_callback(ompt_callback_task_dependence);
   register_callback(ompt_callback_thread_begin);
   register_callback(ompt_callback_thread_end);
+  // A tool header that includes this one may register more callbacks, like
+  // the target callbacks of libomptarget/test/ompt/target_callback.h.
+#ifdef register_extra_callbacks
+  register_extra_callbacks();
+#endif
   printf("0: NULL_POINTER=%p\n", (void*)NULL);
   return 1; //success
 }
@@ -0,0 +1,135 @@
+// RUN: %libomp-compile-and-run
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <omp.h>
+#include "omp_testsuite.h"
+
+#define NUM_REGIONS 4
+#define NUM_THREADS 2
+
+typedef struct {
+  int count;
+  int team_size;
+  int in_parallel;
+} region_data_t;
+
+static void region_body(void *arg) {
+  region_data_t *data = (region_data_t *)arg;
+  #pragma omp atomic
+  data->count++;
+  if (omp_get_thread_num() == 0) {
+    data->team_size = omp_get_num_threads();
+    data->in_parallel = omp_in_parallel();
+  }
+}
+
+int test_kmp_parallel_async()
+{
+  int i, r, err = 0;
+  region_data_t data[NUM_REGIONS];
+  kmp_async_handle_t handles[NUM_REGIONS];
+
+  // Launch several regions at once and overlap them with serial work
+  for (r = 0; r < 3; r++) {
+    for (i = 0; i < NUM_REGIONS; i++) {
+      data[i].count = 0;
+      data[i].team_size = 0;
+      data[i].in_parallel = 0;
+      handles[i] = kmp_parallel_async(region_body, &data[i], NUM_THREADS);
+    }
+    // The caller is not part of any launched team
+    if (omp_in_parallel()) {
+      fprintf(stderr, "error: caller is in parallel\n");
+      err++;
+    }
+    for (i = 0; i < NUM_REGIONS; i++) {
+      kmp_async_wait(handles[i]);
+      if (data[i].count != data[i].team_size ||
+          data[i].team_size != NUM_THREADS || !data[i].in_parallel) {
+        fprintf(stderr, "error: region %d ran %d times on %d threads\n", i,
+                data[i].count, data[i].team_size);
+        err++;
+      }
+    }
+  }
+
+  // Polling must eventually observe completion
+  data[0].count = 0;
+  handles[0] = kmp_parallel_async(region_body, &data[0], NUM_THREADS);
+  while (!kmp_async_test(handles[0]))
+    ;
+  if (data[0].count != NUM_THREADS) {
+    fprintf(stderr, "error: polled region ran %d times\n", data[0].count);
+    err++;
+  }
+  kmp_async_wait(handles[0]);
+
+  // Regular parallel regions still work on the caller's own team
+  data[0].count = 0;
+  #pragma omp parallel num_threads(NUM_THREADS)
+  region_body(&data[0]);
+  if (data[0].count != NUM_THREADS) {
+    fprintf(stderr, "error: regular region ran %d times\n", data[0].count);
+    err++;
+  }
+  return err == 0;
+}
+
+static volatile int go;
+
+static void wait_for_caller(void *arg) {
+  double start = omp_get_wtime();
+  // Only returns early if the caller is still running after the launch.
+  while (!go && omp_get_wtime() - start < 10.0)
+    ;
+  if (omp_get_thread_num() == 0)
+    *(int *)arg = go;
+}
+
+// The region runs while the caller goes on: it waits for a flag that the
+// caller only sets after kmp_parallel_async() has returned.
+int test_kmp_parallel_async_concurrent()
+{
+  int seen = 0;
+  kmp_async_handle_t handle;
+
+  go = 0;
+  handle = kmp_parallel_async(wait_for_caller, &seen, NUM_THREADS);
+  go = 1;
+  kmp_async_wait(handle);
+  if (!seen) {
+    fprintf(stderr, "error: the region did not run concurrently\n");
+    return 0;
+  }
+  return 1;
+}
+
+int main()
+{
+  int i;
+  int num_failed=0;
+  int status;
+  pid_t pid;
+
+  // The child exits with idle launchers, which the runtime must stop and
+  // join at shutdown rather than hang or crash.
+  pid = fork();
+  if (pid == 0) {
+    for(i = 0; i < REPETITIONS; i++) {
+      if(!test_kmp_parallel_async()) {
+        num_failed++;
+      }
+    }
+    if (!test_kmp_parallel_async_concurrent())
+      num_failed++;
+    exit(num_failed);
+  }
+  alarm(60);
+  if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+    fprintf(stderr, "error: the child did not exit cleanly\n");
+    return 1;
+  }
+  return WEXITSTATUS(status);
+}
@@ -0,0 +1,256 @@
+#!/usr/bin/perl
+
+#
+#//===----------------------------------------------------------------------===//
+#//
+#//                     The LLVM Compiler Infrastructure
+#//
+#// This file is dual licensed under the MIT and the University of Illinois Open
+#// Source Licenses. See LICENSE.txt for details.
+#//
+#//===----------------------------------------------------------------------===//
+#
+
+use strict;
+use warnings;
+
+use FindBin;
+use lib "$FindBin::Bin/lib";
+
+use JSON::PP;
+
+use tools;
+
+our $VERSION = "0.001";
+
+my $threshold = 10;
+my $min_total = 0;
+my $watch     = "barrier|_bar\$|task|scheduling";
+my $all;
+
+# Split a CSV line, the fields may be quoted.
+sub split_csv($) {
+    my ( $line ) = @_;
+    my @fields;
+    while ( $line =~ m{\G(?:"((?:[^"]|"")*)"|([^,]*))(,|\z)}gc ) {
+        my $field = defined( $1 ) ? $1 : $2;
+        $field =~ s{""}{"}g;
+        push( @fields, $field );
+        last if $3 eq "";
+    }; # while
+    return @fields;
+}; # sub split_csv
+
+# Returns a hash "kind:name" => { count => ..., total => ... } of the aggregate
+# statistics of the last output in the file.
+sub load($) {
+    my ( $file ) = @_;
+    my $bulk = read_file( $file );
+    my %stats;
+    if ( $bulk =~ m{\A\s*\{} ) {
+        my $json = JSON::PP->new();
+        my @docs = $json->incr_parse( $bulk );
+        @docs or runtime_error( "\"$file\": no statistics found" );
+        my $doc = $docs[ -1 ];
+        my %kinds = ( timers => "timer", totals => "total", counters => "counter" );
+        foreach my $group ( keys( %kinds ) ) {
+            my $values = $doc->{ aggregate }->{ $group } or next;
+            foreach my $name ( keys( %$values ) ) {
+                $stats{ "$kinds{ $group }:$name" } = $values->{ $name };
+            }; # foreach $name
+        }; # foreach $group
+        foreach my $name ( keys( %{ $doc->{ aggregate }->{ percentiles } || {} } ) ) {
+            my $values = $doc->{ aggregate }->{ percentiles }->{ $name };
+            foreach my $kind ( grep( $_ ne "count", keys( %$values ) ) ) {
+                $stats{ "$kind:$name" } = { count => $values->{ count }, total => $values->{ $kind } };
+            }; # foreach $kind
+        }; # foreach $name
+        foreach my $critical ( @{ $doc->{ criticals } || [] } ) {
+            foreach my $time ( keys( %{ $critical->{ times } } ) ) {
+                $stats{ "critical_$time:$critical->{ name }" } = $critical->{ times }->{ $time };
+            }; # foreach $time
+        }; # foreach $critical
+    } else {
+        my @columns;
+        foreach my $line ( split( "\n", $bulk ) ) {
+            if ( $line =~ m{\A#} or $line eq "" ) {
+                next;
+            }; # if
+            my @fields = split_csv( $line );
+            if ( $fields[ 0 ] eq "thread" ) {
+                # A new output begins, only the last one counts.
+                @columns = @fields;
+                %stats = ();
+                next;
+            }; # if
+            @columns or runtime_error( "\"$file\" is neither CSV nor JSON statistics of the runtime" );
+            my %row;
+            @row{ @columns } = @fields;
+            if ( $row{ thread } eq "all" ) {
+                $stats{ "$row{ kind }:$row{ name }" } = \%row;
+            }; # if
+        }; # foreach $line
+        @columns or runtime_error( "\"$file\": no statistics found" );
+    }; # if
+    return \%stats;
+}; # sub load
+
+sub diff($$) {
+    my ( $base_file, $new_file ) = @_;
+    my $base = load( $base_file );
+    my $new  = load( $new_file );
+    my %keys = map( ( $_ => 1 ), keys( %$base ), keys( %$new ) );
+    my $regressions = 0;
+    my @rows;
+    foreach my $key ( sort( keys( %keys ) ) ) {
+        my ( $kind, $name ) = split( ":", $key, 2 );
+        my $old = $base->{ $key } ? $base->{ $key }->{ total } : 0;
+        my $cur = $new->{ $key } ? $new->{ $key }->{ total } : 0;
+        my $change;
+        if ( $old != 0 ) {
+            $change = ( $cur - $old ) / $old * 100;
+        } elsif ( $cur != 0 ) {
+            $change = 9**9**9;    # Appeared.
+        } else {
+            $change = 0;
+        }; # if
+        my $significant = abs( $change ) >= $threshold
+            && ( $kind eq "counter" or ( $old > $cur ? $old : $cur ) >= $min_total );
+        my $regression = $significant && $change > 0 && $kind ne "counter" && $name =~ m{$watch}i;
+        if ( $regression ) {
+            ++ $regressions;
+        }; # if
+        if ( $significant or $all ) {
+            push( @rows, [ $regression ? "!!" : "", $kind, $name, $old, $cur,
+                           $change == 9**9**9 ? "new" : sprintf( "%+.1f%%", $change ) ] );
+        }; # if
+    }; # foreach $key
+    if ( @rows ) {
+        printf( "%-2s %-13s %-40s %16s %16s %9s\n", "", "Kind", "Name", "Base total", "New total",
+                "Change" );
+        foreach my $row ( @rows ) {
+            printf( "%-2s %-13s %-40s %16.6g %16.6g %9s\n", @$row );
+        }; # foreach $row
+    }; # if
+    info( "$regressions regression(s) of watched timers above $threshold%" );
+    return $regressions;
+}; # sub diff
+
+get_options(
+    "threshold=f" => \$threshold,
+    "min-total=f" => \$min_total,
+    "watch=s"     => \$watch,
+    "all"         => \$all,
+);
+
+if ( @ARGV != 2 ) {
+    cmdline_error( "Two statistics files expected" );
+}; # if
+
+exit( diff( $ARGV[ 0 ], $ARGV[ 1 ] ) ? 1 : 0 );
+
+__END__
+
+=pod
+
+=head1 NAME
+
+B<stats-diff.pl> -- Compare the statistics of two runs of the OpenMP runtime.
+
+=head1 SYNOPSIS
+
+B<stats-diff.pl> I<option>... I<base> I<new>
+
+=head1 DESCRIPTION
+
+A runtime built with C<LIBOMP_STATS=on> writes its statistics to C<KMP_STATS_FILE>, as CSV or JSON if
+C<KMP_STATS_FORMAT> is C<csv> or C<json>. The script compares the aggregate totals of the timers and
+counters of two such files, which need not be in the same format, and prints those that changed by
+at least the threshold. Timers grow worse when their total grows; those whose names match the watch
+pattern (barriers, tasks and loop scheduling by default) are marked C<!!> and make the exit status
+1, so that a regression pipeline fails on them.
+
+The percentiles (C<p50>, C<p99> and C<p999>) of the wait timers are compared like the totals, so a
+longer tail of barrier waits is a regression even if the total did not move.
+
+The timers are in ticks of the time stamp counter, so compare runs on the same machine. If a file
+holds several outputs (e.g. of C<kmp_dump_stats()>), the last one is compared.
+
+=head1 OPTIONS
+
+=over
+
+=item B<--threshold=>I<percent>
+
+The smallest relative change reported, 10 by default.
+
+=item B<--min-total=>I<ticks>
+
+Ignore timers whose totals are below this number of ticks in both runs, 0 by default.
+
+=item B<--watch=>I<regexp>
+
+The timers whose growth is a regression (case-insensitive), C<barrier|_bar$|task|scheduling> by
+default.
+
+=item B<--all>
+
+Print all timers and counters, not only those that changed.
+
+=item Standard Options
+
+=over
+
+=item B<--doc>
+
+=item B<--manual>
+
+Print full help message and exit.
+
+=item B<--help>
+
+Print short help message and exit.
+
+=item B<--usage>
+
+Print very short usage message and exit.
+
+=item B<--verbose>
+
+Do print informational messages.
+
+=item B<--version>
+
+Print program version and exit.
+
+=item B<--quiet>
+
+Work quiet, do not print informational messages.
+
+=back
+
+=back
+
+=head1 ARGUMENTS
+
+=over
+
+=item I<base>
+
+The statistics of the reference run.
+
+=item I<new>
+
+The statistics of the run to check.
+
+=back
+
+=head1 EXAMPLES
+
+    $ KMP_STATS_FORMAT=csv KMP_STATS_FILE=base.csv ./app
+    $ KMP_STATS_FORMAT=csv KMP_STATS_FILE=new.csv ./app
+    $ stats-diff.pl --threshold=5 base-*.csv new-*.csv
+
+=cut
+
+# end of file #
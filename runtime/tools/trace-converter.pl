@@ -0,0 +1,416 @@
+#!/usr/bin/perl
+
+#
+#//===----------------------------------------------------------------------===//
+#//
+#//                     The LLVM Compiler Infrastructure
+#//
+#// This file is dual licensed under the MIT and the University of Illinois Open
+#// Source Licenses. See LICENSE.txt for details.
+#//
+#//===----------------------------------------------------------------------===//
+#
+
+use strict;
+use warnings;
+
+use FindBin;
+use lib "$FindBin::Bin/lib";
+
+use tools;
+
+our $VERSION = "0.001";
+
+# Layout of the file, see kmp_trace.h.
+my $header_format = "a8 L L L L q Q Q Q Q Q Q";
+my $header_size   = 80;
+my $thread_format = "l l q Q Q";
+my $thread_size   = 32;
+my $record_format = "Q L L Q Q";
+my $string_format = "Q Q";
+my $string_size   = 16;
+
+my @event_names = qw(
+    none fork join barrier_begin barrier_end task_create task_begin task_end
+    task_steal lock_wait lock_acquired lock_released taskwait_begin taskwait_end
+);
+my @barrier_names = ( "plain barrier", "fork/join barrier", "reduction barrier" );
+
+my $output;
+my $format = "chrome";
+my $clock  = "start";
+
+sub read_bytes($$) {
+    my ( $fh, $size ) = @_;
+    my $data = "";
+    if ( $size > 0 ) {
+        my $got = read( $fh, $data, $size );
+        defined( $got ) and $got == $size or runtime_error( "Unexpected end of the trace file" );
+    }; # if
+    return $data;
+}; # sub read_bytes
+
+sub json_string($) {
+    my ( $str ) = @_;
+    $str =~ s{(["\\])}{\\$1}g;
+    $str =~ s{([\x00-\x1f])}{sprintf( "\\u%04x", ord( $1 ) )}ge;
+    return "\"$str\"";
+}; # sub json_string
+
+# ";file;routine;line;column;;" -> "routine (file:line)"
+sub location($$) {
+    my ( $strings, $key ) = @_;
+    if ( not $key ) {
+        return undef;
+    }; # if
+    my $psource = $strings->{ $key };
+    if ( not defined( $psource ) ) {
+        return sprintf( "0x%x", $key );
+    }; # if
+    my ( undef, $file, $routine, $line ) = split( ";", $psource );
+    if ( not defined( $routine ) or $routine eq "unknown" ) {
+        return undef;
+    }; # if
+    return sprintf( "%s (%s:%s)", $routine, $file, $line );
+}; # sub location
+
+# The events of all threads as lines in the manner of `perf script`, ordered by
+# time: the thread id of the system, the time in seconds, the event and what it
+# is about. With --clock=monotonic they sort together with the output of
+# `perf script` of a `perf record -k CLOCK_MONOTONIC`.
+sub timeline($$$$$) {
+    my ( $threads, $strings, $start_ticks, $scale, $origin ) = @_;
+    my @lines;
+    foreach my $thread ( @$threads ) {
+        foreach my $record ( @{ $thread->{ records } } ) {
+            my ( $time, $type, $arg, $a0, $a1 ) = @$record;
+            my $name = $type < @event_names ? $event_names[ $type ] : "event $type";
+            my $what;
+            if ( $name eq "fork" ) {
+                $what = sprintf( "%d threads, microtask 0x%x", $arg, $a1 );
+                $a1 = $a0;
+            } elsif ( $name eq "join" ) {
+                $what = "$arg threads";
+                $a1 = $a0;
+            } elsif ( $name eq "barrier_begin" ) {
+                $what = $arg < @barrier_names ? $barrier_names[ $arg ] : "barrier";
+                $a1 = $a0;
+            } elsif ( $name eq "barrier_end" ) {
+                $what = $arg < @barrier_names ? $barrier_names[ $arg ] : "barrier";
+                $a1 = 0;
+            } elsif ( $name eq "taskwait_begin" ) {
+                $what = $arg ? "taskgroup end" : "taskwait";
+                $a1 = $a0;
+            } elsif ( $name eq "task_create" or $name eq "task_begin" ) {
+                $what = sprintf( "task 0x%x, routine 0x%x", $a0, $a1 );
+                $a1 = 0;
+            } elsif ( $name eq "task_end" ) {
+                $what = sprintf( "task 0x%x", $a0 );
+            } elsif ( $name eq "task_steal" ) {
+                $what = sprintf( "task 0x%x from T#%d", $a0, $arg );
+                $a1 = 0;
+            } elsif ( $name =~ m{\Alock_} ) {
+                $what = sprintf( "lock 0x%x", $a0 );
+                $a1 = 0 if $name ne "lock_wait";
+            } else {
+                $what = "";
+                $a1 = 0;
+            }; # if
+            my $loc = $a1 ? location( $strings, $a1 ) : undef;
+            $what .= " at $loc" if defined( $loc );
+            my $usec = $origin + ( $time - $start_ticks ) * $scale;
+            push( @lines, [ $usec, sprintf( "%8d %13.6f: omp:%s:%s\n", $thread->{ os_tid },
+                                            $usec / 1e6, $name, $what ne "" ? " $what" : "" ) ] );
+        }; # foreach $record
+    }; # foreach $thread
+    my $text = join( "", map( $_->[ 1 ], sort( { $a->[ 0 ] <=> $b->[ 0 ] } @lines ) ) );
+    if ( defined( $output ) ) {
+        write_file( $output, \$text );
+    } else {
+        print( $text );
+    }; # if
+}; # sub timeline
+
+sub convert($) {
+    my ( $file ) = @_;
+    my $fh;
+    open( $fh, "<", $file ) or runtime_error( "Cannot open \"$file\": $!" );
+    binmode( $fh );
+
+    my ( $magic, $version, $record_size, $nthreads, $nstrings, $pid,
+         $start_ticks, $start_nsec, $end_ticks, $end_nsec, $start_mono_nsec, $end_mono_nsec ) =
+        unpack( $header_format, read_bytes( $fh, $header_size ) );
+    $magic eq "KMPTRACE" or runtime_error( "\"$file\" is not a trace file of the OpenMP runtime" );
+    $version == 2 or runtime_error( "\"$file\": unsupported version $version" );
+    $record_size >= 32 or runtime_error( "\"$file\": records of $record_size bytes are too small" );
+
+    # Microseconds per tick, and the time of the first tick.
+    my $scale = 0.001;
+    if ( $end_ticks > $start_ticks and $end_nsec > $start_nsec ) {
+        $scale = ( $end_nsec - $start_nsec ) / ( $end_ticks - $start_ticks ) / 1000;
+    }; # if
+    my $origin = 0;
+    if ( $clock eq "monotonic" ) {
+        $start_mono_nsec or runtime_error( "\"$file\": the system had no monotonic clock" );
+        $origin = $start_mono_nsec / 1000;
+    }; # if
+
+    my @threads;
+    for ( my $i = 0; $i < $nthreads; ++ $i ) {
+        my ( $gtid, $id, $os_tid, $total, $count ) =
+            unpack( $thread_format, read_bytes( $fh, $thread_size ) );
+        my @records;
+        for ( my $r = 0; $r < $count; ++ $r ) {
+            push( @records, [ unpack( $record_format, read_bytes( $fh, $record_size ) ) ] );
+        }; # for
+        if ( $id >= 0 ) {
+            push( @threads, { gtid => $gtid, id => $id, os_tid => $os_tid, lost => $total - $count,
+                              records => \@records } );
+        }; # if
+    }; # for
+    my %strings;
+    for ( my $i = 0; $i < $nstrings; ++ $i ) {
+        my ( $key, $length ) = unpack( $string_format, read_bytes( $fh, $string_size ) );
+        $strings{ $key } = read_bytes( $fh, $length );
+    }; # for
+    close( $fh );
+
+    if ( $format eq "perf" ) {
+        timeline( \@threads, \%strings, $start_ticks, $scale, $origin );
+        return;
+    }; # if
+
+    my @events;
+    my $event = sub {
+        my ( $ph, $name, $tid, $ts, %extra ) = @_;
+        my $json = sprintf( "{\"ph\":\"%s\",\"name\":%s,\"pid\":%d,\"tid\":%d,\"ts\":%.3f",
+                            $ph, json_string( $name ), $pid, $tid, $ts );
+        foreach my $key ( sort( keys( %extra ) ) ) {
+            $json .= ",\"$key\":$extra{ $key }";
+        }; # foreach
+        push( @events, $json . "}" );
+    };
+
+    # A task is created on one thread and may begin on another one; the flow
+    # arrows link the two. The runtime reuses the memory of finished tasks, so
+    # a beginning belongs to the latest earlier creation of its address.
+    my %creations;
+    my $next_flow = 0;
+    foreach my $thread ( @threads ) {
+        foreach my $record ( @{ $thread->{ records } } ) {
+            if ( $record->[ 1 ] == 5 ) {    # task_create
+                push( @{ $creations{ $record->[ 3 ] } }, [ $record->[ 0 ], ++ $next_flow ] );
+                $record->[ 2 ] = $next_flow;
+            }; # if
+        }; # foreach $record
+    }; # foreach $thread
+    foreach my $list ( values( %creations ) ) {
+        @$list = sort( { $a->[ 0 ] <=> $b->[ 0 ] } @$list );
+    }; # foreach $list
+    my $flow_of = sub {
+        my ( $task, $time ) = @_;
+        my $list = $creations{ $task } or return undef;
+        my ( $lo, $hi ) = ( 0, scalar( @$list ) );    # The answer is before $hi.
+        while ( $lo < $hi ) {
+            my $mid = int( ( $lo + $hi ) / 2 );
+            if ( $list->[ $mid ]->[ 0 ] <= $time ) {
+                $lo = $mid + 1;
+            } else {
+                $hi = $mid;
+            }; # if
+        }; # while
+        return $lo > 0 ? $list->[ $lo - 1 ]->[ 1 ] : undef;
+    };
+
+    foreach my $thread ( sort( { $a->{ id } <=> $b->{ id } } @threads ) ) {
+        my $tid = $thread->{ id };
+        my $label = $thread->{ gtid } >= 0 ? "OMP thread $thread->{ gtid }" : "OMP thread";
+        $label .= " (tid $thread->{ os_tid })";
+        $event->( "M", "thread_name", $tid, 0, args => "{\"name\":" . json_string( $label ) . "}" );
+        $event->( "M", "thread_sort_index", $tid, 0, args => "{\"sort_index\":$tid}" );
+        if ( $thread->{ lost } > 0 ) {
+            $event->( "i", "$thread->{ lost } older events overwritten", $tid, 0, s => "\"t\"" );
+        }; # if
+        # Records of the beginnings whose ends are still expected, so that the
+        # ends of scopes that began before the oldest record are dropped.
+        my @open;
+        foreach my $record ( @{ $thread->{ records } } ) {
+            my ( $time, $type, $arg, $a0, $a1 ) = @$record;
+            my $ts = $origin + ( $time - $start_ticks ) * $scale;
+            my $name = $type < @event_names ? $event_names[ $type ] : "event $type";
+            if ( $name eq "fork" ) {
+                my $loc = location( \%strings, $a0 );
+                $event->( "B", "parallel" . ( defined( $loc ) ? " $loc" : "" ), $tid, $ts,
+                          args => sprintf( "{\"threads\":%d,\"microtask\":\"0x%x\"}", $arg, $a1 ) );
+                push( @open, $name );
+            } elsif ( $name eq "barrier_begin" ) {
+                my $loc = location( \%strings, $a0 );
+                my $kind = $arg < @barrier_names ? $barrier_names[ $arg ] : "barrier";
+                $event->( "B", $kind . ( defined( $loc ) ? " $loc" : "" ), $tid, $ts );
+                push( @open, $name );
+            } elsif ( $name eq "task_begin" ) {
+                $event->( "B", sprintf( "task 0x%x", $a1 ), $tid, $ts,
+                          args => sprintf( "{\"task\":\"0x%x\"}", $a0 ) );
+                my $flow = $flow_of->( $a0, $time );
+                if ( defined( $flow ) ) {
+                    $event->( "f", "task", $tid, $ts, id => $flow, cat => "\"task\"", bp => "\"e\"" );
+                }; # if
+                push( @open, $name );
+            } elsif ( $name eq "lock_wait" ) {
+                my $loc = location( \%strings, $a1 );
+                $event->( "B", sprintf( "lock wait 0x%x", $a0 ) . ( defined( $loc ) ? " $loc" : "" ),
+                          $tid, $ts );
+                push( @open, $name );
+            } elsif ( $name eq "taskwait_begin" ) {
+                my $loc = location( \%strings, $a0 );
+                $event->( "B", ( $arg ? "taskgroup end" : "taskwait" ) . ( defined( $loc ) ? " $loc" : "" ),
+                          $tid, $ts );
+                push( @open, $name );
+            } elsif ( $name eq "join" or $name eq "barrier_end" or $name eq "task_end"
+                      or $name eq "lock_acquired" or $name eq "taskwait_end" ) {
+                if ( @open ) {
+                    pop( @open );
+                    $event->( "E", "", $tid, $ts );
+                }; # if
+            } elsif ( $name eq "task_create" ) {
+                $event->( "i", "create task", $tid, $ts, s => "\"t\"",
+                          args => sprintf( "{\"task\":\"0x%x\",\"routine\":\"0x%x\"}", $a0, $a1 ) );
+                $event->( "s", "task", $tid, $ts, id => $arg, cat => "\"task\"" );
+            } elsif ( $name eq "lock_released" ) {
+                $event->( "i", sprintf( "release lock 0x%x", $a0 ), $tid, $ts, s => "\"t\"" );
+            } elsif ( $name eq "task_steal" ) {
+                $event->( "i", "steal from T#$arg", $tid, $ts, s => "\"t\"",
+                          args => sprintf( "{\"task\":\"0x%x\"}", $a0 ) );
+            }; # if
+        }; # foreach $record
+    }; # foreach $thread
+
+    my $json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n" . join( ",\n", @events ) . "\n]}\n";
+    if ( defined( $output ) ) {
+        write_file( $output, \$json );
+    } else {
+        print( $json );
+    }; # if
+}; # sub convert
+
+get_options(
+    "output|o=s" => \$output,
+    "format=s"   => \$format,
+    "clock=s"    => \$clock,
+);
+
+$format =~ m{\A(?:chrome|perf)\z} or cmdline_error( "Unknown format \"$format\"" );
+$clock =~ m{\A(?:start|monotonic)\z} or cmdline_error( "Unknown clock \"$clock\"" );
+
+if ( @ARGV != 1 ) {
+    cmdline_error( "Exactly one trace file expected" );
+}; # if
+
+convert( $ARGV[ 0 ] );
+
+exit( 0 );
+
+__END__
+
+=pod
+
+=head1 NAME
+
+B<trace-converter.pl> -- Convert a trace of the OpenMP runtime to Chrome trace JSON or a timeline.
+
+=head1 SYNOPSIS
+
+B<trace-converter.pl> I<option>... I<file>
+
+=head1 DESCRIPTION
+
+The runtime writes the events of all threads to a binary file if C<KMP_TRACE> is set (see
+F<kmp_trace.h>). The script converts that file to the JSON format of the Chrome trace viewer, which
+C<chrome://tracing> and Perfetto (L<https://ui.perfetto.dev>) load. Parallel regions, barriers, tasks
+taskwaits and lock waits become nested slices of the thread that ran them, task creations are
+linked to the beginnings of the tasks with flow arrows.
+
+With B<--format=perf> the events are printed one per line instead, ordered by time, in the manner
+of C<perf script>: the thread id of the system, the time in seconds and the event. The runtime
+records the time of C<CLOCK_MONOTONIC> too, so with B<--clock=monotonic> the lines sort together with
+those of C<perf script> for a C<perf record -k CLOCK_MONOTONIC> of the same run, which puts the
+samples of the hardware counters in the OpenMP phases they fell in. This needs neither ITT nor any
+tool beyond C<perf>.
+
+=head1 OPTIONS
+
+=over
+
+=item B<--output=>I<file>
+
+=item B<-o> I<file>
+
+Write the output to I<file>. By default it is written to the standard output.
+
+=item B<--format=>I<chrome>|I<perf>
+
+Write Chrome trace JSON (the default) or a timeline of text lines like those of C<perf script>.
+
+=item B<--clock=>I<start>|I<monotonic>
+
+Count the time from the start of the runtime (the default) or give the time of C<CLOCK_MONOTONIC>,
+the clock of C<perf record -k CLOCK_MONOTONIC>.
+
+=item Standard Options
+
+=over
+
+=item B<--doc>
+
+=item B<--manual>
+
+Print full help message and exit.
+
+=item B<--help>
+
+Print short help message and exit.
+
+=item B<--usage>
+
+Print very short usage message and exit.
+
+=item B<--verbose>
+
+Do print informational messages.
+
+=item B<--version>
+
+Print program version and exit.
+
+=item B<--quiet>
+
+Work quiet, do not print informational messages.
+
+=back
+
+=back
+
+=head1 ARGUMENTS
+
+=over
+
+=item I<file>
+
+The trace written by the runtime, C<kmp_trace.>I<pid>C<.bin> unless C<KMP_TRACE_FILE> names
+another one.
+
+=back
+
+=head1 EXAMPLES
+
+    $ KMP_TRACE=true KMP_TRACE_FILE=app.bin ./app
+    $ trace-converter.pl -o app.json app.bin
+
+    $ KMP_TRACE=true KMP_TRACE_FILE=app.bin perf record -k CLOCK_MONOTONIC -e cycles ./app
+    $ perf script -F tid,time,event,sym > perf.txt
+    $ trace-converter.pl --format=perf --clock=monotonic -o omp.txt app.bin
+    $ sort -k2,2n perf.txt omp.txt | less
+
+=cut
+
+# end of file #